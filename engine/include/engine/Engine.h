@@ -12,6 +12,11 @@
 #define TARGET_FPS 60
 #define TARGET_FPS_NS_D (1000000000.0 / TARGET_FPS)
 
+/// The number of frames that are rendered in headless mode before the benchmark starts, so that loading is not measured
+#define HEADLESS_WARMUP_FRAMES 60
+/// The number of frames that are benchmarked in headless mode when --headless-frames is not given
+#define HEADLESS_DEFAULT_FRAMES 600
+
 #define STR(x) #x
 #define TO_STR(x) STR(x)
 
@@ -55,6 +60,12 @@ void DestroyEngine();
  */
 bool EngineShouldQuit();
 
+/**
+ * Check if the engine was started with --headless, in which case it renders to SDL's offscreen video driver instead of
+ * a window on the display, benchmarks a fixed number of frames, and then quits
+ */
+bool IsHeadless();
+
 //
 // PRIVATE FUNCTIONS
 //
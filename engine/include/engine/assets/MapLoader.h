@@ -9,6 +9,10 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#define MAP_ASSET_VERSION 2
+/// The last map version that stored full float UVs and 32-bit indices, which is converted on load
+#define MAP_ASSET_VERSION_FLOAT_UVS 1
+
 /**
  * Load a map asset
  * @param map The map to load into
@@ -0,0 +1,51 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_MAPMODELLOADER_H
+#define GAME_MAPMODELLOADER_H
+
+#include <engine/assets/DataReader.h>
+#include <engine/structs/Map.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Quantize a value in the range [0, 1] to an unsigned normalized 16-bit integer
+ * @param value The value to quantize, which will be clamped to [0, 1]
+ * @return The quantized value
+ */
+uint16_t QuantizeUnorm16(float value);
+
+/**
+ * Expand an unsigned normalized 16-bit integer back into the range [min, max]
+ * @param value The quantized value
+ * @param min The value that 0 expands to
+ * @param max The value that @c UINT16_MAX expands to
+ * @return The expanded value
+ */
+float DequantizeUnorm16(uint16_t value, float min, float max);
+
+/**
+ * Read the vertices and indices of a map model stored with float UVs and 32-bit indices, converting the lightmap UVs
+ * to the quantized runtime layout
+ * @param reader The reader positioned at the vertex count of the model
+ * @param model The model to read into
+ * @param bytesRemaining The number of bytes remaining in the asset
+ * @return Whether the model was read successfully
+ */
+bool ReadFloatMapModel(DataReader *reader, MapModel *model, size_t *bytesRemaining);
+
+/**
+ * Read the vertices and indices of a map model stored with quantized UVs and optionally 16-bit indices.
+ * UVs are stored as unorm16 relative to the bounds written before the vertices, while lightmap UVs are stored as
+ * unorm16 relative to the lightmap atlas and are kept quantized.
+ * @param reader The reader positioned at the vertex count of the model
+ * @param model The model to read into
+ * @param bytesRemaining The number of bytes remaining in the asset
+ * @return Whether the model was read successfully
+ */
+bool ReadQuantizedMapModel(DataReader *reader, MapModel *model, size_t *bytesRemaining);
+
+#endif //GAME_MAPMODELLOADER_H
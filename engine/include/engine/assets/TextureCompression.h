@@ -0,0 +1,59 @@
+//
+// Created by droc101 on 10/18/26.
+//
+
+#ifndef GAME_TEXTURECOMPRESSION_H
+#define GAME_TEXTURECOMPRESSION_H
+
+#include <engine/assets/TextureLoader.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The width and height of a block in every block compressed pixel format
+#define TEXTURE_BLOCK_SIZE 4
+
+/**
+ * Check whether a pixel format stores its pixels as 4x4 blocks
+ * @param format The pixel format to check
+ */
+bool IsBlockCompressedPixelFormat(ImagePixelFormat format);
+
+/**
+ * Get the format that a block compressed pixel format decompresses to
+ * @param format The block compressed pixel format
+ * @return @c PIXEL_FORMAT_RGBA16F for HDR formats, @c PIXEL_FORMAT_RGBA8 otherwise
+ */
+ImagePixelFormat GetDecompressedPixelFormat(ImagePixelFormat format);
+
+/**
+ * Get the size of the pixel data of a single image level
+ * @param format The pixel format of the data
+ * @param width The width of the image in pixels
+ * @param height The height of the image in pixels
+ * @return The size of the pixel data in bytes
+ */
+size_t GetPixelDataSize(ImagePixelFormat format, size_t width, size_t height);
+
+/**
+ * Decompress block compressed pixel data on the CPU
+ * @param format The block compressed pixel format of @c pixelData
+ * @param width The width of the image in pixels
+ * @param height The height of the image in pixels
+ * @param pixelData The block compressed pixel data
+ * @return The pixel data in the format given by @c GetDecompressedPixelFormat, which must be freed
+ */
+uint8_t *DecompressPixelData(ImagePixelFormat format, size_t width, size_t height, const uint8_t *pixelData);
+
+/**
+ * Compress pixel data on the CPU.
+ * This is a simple reference encoder meant for round-trip testing and for tools, not for quality.
+ * @param format The block compressed pixel format to compress to
+ * @param width The width of the image in pixels
+ * @param height The height of the image in pixels
+ * @param pixelData The pixel data in the format given by @c GetDecompressedPixelFormat
+ * @return The block compressed pixel data, which must be freed
+ */
+uint8_t *CompressPixelData(ImagePixelFormat format, size_t width, size_t height, const uint8_t *pixelData);
+
+#endif //GAME_TEXTURECOMPRESSION_H
@@ -9,7 +9,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define TEXTURE_ASSET_VERSION 2
+#define TEXTURE_ASSET_VERSION 3
+/// The last texture version without a stored mip chain, which is still accepted
+#define TEXTURE_ASSET_VERSION_NO_MIPS 2
 
 /// The maximum number of textures that can be loaded in any one execution of the game
 #define MAX_TEXTURES 512
@@ -26,6 +28,16 @@ enum ImagePixelFormat {
     PIXEL_FORMAT_RGBA8,
 	/// RGBA, Float16 per channel
     PIXEL_FORMAT_RGBA16F,
+	/// BC1 block compressed RGB with 1 bit alpha, 8 bytes per 4x4 block
+    PIXEL_FORMAT_BC1,
+	/// BC3 block compressed RGBA, 16 bytes per 4x4 block
+    PIXEL_FORMAT_BC3,
+	/// BC5 block compressed RG, 16 bytes per 4x4 block
+    PIXEL_FORMAT_BC5,
+	/// BC7 block compressed RGBA, 16 bytes per 4x4 block
+    PIXEL_FORMAT_BC7,
+	/// BC6H block compressed unsigned HDR RGB, 16 bytes per 4x4 block
+    PIXEL_FORMAT_BC6H,
 };
 
 struct Image
@@ -45,13 +57,19 @@ struct Image
 	bool repeat;
 	/// Whether to generate mipmaps for this texture
 	bool mipmaps;
+	/// The number of mip levels stored in @c pixelData, where 1 means only the base level is stored
+	uint8_t mipLevels;
 
 	/// The name of the image
 	char *name;
-	/// The pixel data of the image
+	/// The pixel data of the image, with every stored mip level tightly packed from largest to smallest
 	uint8_t *pixelData;
 };
 
+/// Incremented every time the texture loader is destroyed, which frees every loaded image. Anything that keeps image
+/// pointers across frames compares this to know when it has to load them again.
+extern uint32_t textureLoaderGeneration;
+
 /**
  * Generate a "missing texture"
  * @param src The image to populate
@@ -59,7 +77,12 @@ struct Image
 void GenFallbackImage(Image *src);
 
 /**
- * Load an image from disk, falling back to a cached version if possible
+ * Initialize the texture loader
+ */
+void InitTextureLoader();
+
+/**
+ * Load an image from disk, falling back to a cached version if possible. This can be called from any thread.
  * @param asset The asset to load the image from
  * @return The loaded image, or a 64x64 fallback image if it failed
  */
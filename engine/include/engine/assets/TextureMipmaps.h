@@ -0,0 +1,46 @@
+//
+// Created by droc101 on 10/18/26.
+//
+
+#ifndef GAME_TEXTUREMIPMAPS_H
+#define GAME_TEXTUREMIPMAPS_H
+
+#include <engine/assets/TextureLoader.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Get the number of levels in a full mip chain, down to and including 1x1
+ * @param width The width of the base level in pixels
+ * @param height The height of the base level in pixels
+ */
+uint8_t GetFullMipLevelCount(size_t width, size_t height);
+
+/**
+ * Get the size of the pixel data of a tightly packed mip chain
+ * @param format The pixel format of the data
+ * @param width The width of the base level in pixels
+ * @param height The height of the base level in pixels
+ * @param levelCount The number of levels in the chain
+ * @return The size of the pixel data in bytes
+ */
+size_t GetMipChainDataSize(ImagePixelFormat format, size_t width, size_t height, uint8_t levelCount);
+
+/**
+ * Generate a full mip chain on the CPU using a gamma-correct box filter.
+ * RGBA8 color channels are averaged in linear space, while alpha and RGBA16F data is averaged directly.
+ * Block compressed data is decompressed, filtered, and compressed again with the reference encoder.
+ * @param format The pixel format of the data
+ * @param width The width of the base level in pixels
+ * @param height The height of the base level in pixels
+ * @param pixelData The pixel data of the base level
+ * @param levelCount Where to write the number of levels generated
+ * @return Every level of the mip chain tightly packed from largest to smallest, which must be freed
+ */
+uint8_t *GenerateMipChain(ImagePixelFormat format,
+						  size_t width,
+						  size_t height,
+						  const uint8_t *pixelData,
+						  uint8_t *levelCount);
+
+#endif //GAME_TEXTUREMIPMAPS_H
@@ -11,6 +11,9 @@
 // Enable or disable recording highest and lowest frame times (has a performance impact)
 // #define BENCHMARK_RECORD_HIGH_LOW_TIMES
 
+// Enable or disable timing the build and box queries of the map cluster BVH when the benchmark finishes
+#define BENCHMARK_MAP_BVH
+
 /**
  * Record the start time of the frame for benchmarking
  */
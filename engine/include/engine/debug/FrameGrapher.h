@@ -39,6 +39,9 @@
 /// Enable or disable the 2nd graph line for linear time
 #define FRAMEGRAPH_SHOW_LINEAR_TIME_GRAPH
 
+/// Enable or disable showing the time of each render pass, as a line on the graph and as text above the frame rate
+#define FRAMEGRAPH_SHOW_PASS_TIMES
+
 /// Disable to draw the graph
 /// Drawing the graph has a significant performance impact
 #define FRAMEGRAPH_FPS_ONLY
@@ -47,7 +50,7 @@
 #define FRAMEGRAPH_NSPF (1000000000.0 / FRAMEGRAPH_THRESHOLD_GOOD)
 
 /**
- * Update the frame graph with the time it took to render the frame
+ * Update the frame graph with the time it took to render the frame, along with the pass times in @c renderStats
  * @param ns nanoseconds the frame took
  */
 void FrameGraphUpdate(uint64_t ns);
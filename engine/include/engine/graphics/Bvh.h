@@ -0,0 +1,87 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_BVH_H
+#define GAME_BVH_H
+
+#include <engine/graphics/Culling.h>
+#include <engine/structs/List.h>
+#include <joltc/Math/Vector3.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct BvhNode BvhNode;
+
+typedef struct Bvh Bvh;
+
+/// A node of a bounding volume hierarchy, which covers a contiguous range of @c Bvh::items
+struct BvhNode
+{
+	/// The center of the bounding box of every item under this node
+	Vector3 center;
+	/// The half size of the bounding box of every item under this node
+	Vector3 extents;
+	/// The index in @c Bvh::items of the first item under this node
+	uint32_t firstItem;
+	/// The number of items under this node
+	uint32_t itemCount;
+	/// The index of the first of the two children of this node, which are next to each other, or 0 for leaves
+	uint32_t firstChild;
+};
+
+/// A bounding volume hierarchy over axis-aligned bounding boxes, split at the median along the longest axis
+struct Bvh
+{
+	/// The nodes, with the root node first
+	BvhNode *nodes;
+	/// The number of nodes
+	size_t nodeCount;
+	/// The indices of the items, ordered so that the items under each node are next to each other
+	uint32_t *items;
+	/// The center of the bounding box of each item, indexed by item index
+	Vector3 *itemCenters;
+	/// The half size of the bounding box of each item, indexed by item index
+	Vector3 *itemExtents;
+	/// The number of items
+	size_t itemCount;
+};
+
+/**
+ * Build a bounding volume hierarchy
+ * @param bvh The hierarchy to build, which must be empty
+ * @param centers The center of the bounding box of each item
+ * @param extents The half size of the bounding box of each item
+ * @param itemCount The number of items
+ * @param maxLeafItems The maximum number of items in a leaf
+ */
+void BvhBuild(Bvh *bvh, const Vector3 *centers, const Vector3 *extents, size_t itemCount, uint32_t maxLeafItems);
+
+/**
+ * Free the arrays of a bounding volume hierarchy
+ * @param bvh The hierarchy to free
+ * @note This does NOT free the bvh pointer itself
+ */
+void BvhFree(Bvh *bvh);
+
+/**
+ * Find the items that intersect a frustum. Subtrees that are entirely inside or outside of the frustum are accepted or
+ * rejected without testing the items in them.
+ * @param bvh The hierarchy
+ * @param frustum The frustum
+ * @param visible An array with space for @c bvh->itemCount entries, which is set to 1 for items that intersect the
+ *                frustum and 0 for items that are outside of it
+ * @return The number of items that intersect the frustum
+ */
+size_t BvhQueryFrustum(const Bvh *bvh, const Frustum *frustum, uint8_t *visible);
+
+/**
+ * Find the items that overlap an axis-aligned box
+ * @param bvh The hierarchy
+ * @param center The center of the box
+ * @param extents The half size of the box
+ * @param items A @c LIST_UINT32 list that the index of each overlapping item is added to
+ */
+void BvhQueryBox(const Bvh *bvh, const Vector3 *center, const Vector3 *extents, List *items);
+
+#endif //GAME_BVH_H
@@ -0,0 +1,185 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_CULLING_H
+#define GAME_CULLING_H
+
+#include <cglm/types.h>
+#include <engine/structs/Camera.h>
+#include <joltc/Math/Vector3.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The number of bounding boxes that are tested at once, which the capacity of @c CullingBounds is a multiple of
+#define CULLING_BATCH_SIZE 4
+
+/// The width of the software depth buffer that occluders are drawn into, which must be a power of two
+#define OCCLUSION_BUFFER_WIDTH 256
+/// The height of the software depth buffer that occluders are drawn into, which must be a power of two
+#define OCCLUSION_BUFFER_HEIGHT 128
+/// The number of levels in the hierarchical depth buffer, where each level is half the size of the one before it
+#define OCCLUSION_BUFFER_LEVELS 7
+/// The number of texels across every level of the hierarchical depth buffer
+#define OCCLUSION_BUFFER_TEXELS (OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT * 4 / 3)
+
+/// The smallest area of a map triangle that is used as an occluder
+#define OCCLUDER_MIN_AREA 2.0f
+/// The maximum number of occluder triangles per map, where the largest triangles are kept
+#define OCCLUDER_MAX_TRIANGLES 4096
+
+typedef struct Map Map;
+
+typedef struct Frustum Frustum;
+
+typedef struct CullingBounds CullingBounds;
+
+typedef struct OcclusionBuffer OcclusionBuffer;
+
+/// The planes of a view frustum, with normals pointing inwards
+struct Frustum
+{
+	/// The left, right, bottom, top, near and far planes, as (normal.x, normal.y, normal.z, distance)
+	vec4 planes[6];
+};
+
+/**
+ * World space axis-aligned bounding boxes, with each component stored in its own array so that a batch of boxes can be
+ * tested against a plane at once
+ */
+struct CullingBounds
+{
+	float *centerX;
+	float *centerY;
+	float *centerZ;
+	float *extentX;
+	float *extentY;
+	float *extentZ;
+	/// The number of boxes
+	size_t count;
+	/// The number of boxes that the arrays have space for
+	size_t capacity;
+};
+
+/// A low resolution depth buffer of the occluders seen by a camera, which bounding boxes can be tested against
+struct OcclusionBuffer
+{
+	/// The view projection matrix that the occluders were drawn with
+	mat4 viewProjectionMatrix;
+	/**
+	 * Every level of the depth buffer, from largest to smallest. The first level holds the depth of the occluders, and
+	 * each texel of the levels after it holds the furthest depth of the four texels it covers in the level before it.
+	 */
+	float depth[OCCLUSION_BUFFER_TEXELS];
+	/// The number of occluder triangles that faced the camera and were inside the depth buffer
+	size_t trianglesDrawn;
+};
+
+/**
+ * Get the view and projection matrices of a camera
+ * @param camera The camera
+ * @param aspectRatio The width of the viewport divided by its height
+ * @param viewMatrix Where to write the matrix that transforms world space into view space
+ * @param projectionMatrix Where to write the matrix that transforms view space into clip space
+ */
+void CameraMatrices(const Camera *camera, float aspectRatio, mat4 *viewMatrix, mat4 *projectionMatrix);
+
+/**
+ * Get the matrix that transforms world space into the clip space of a camera
+ * @param camera The camera
+ * @param aspectRatio The width of the viewport divided by its height
+ * @param viewProjectionMatrix Where to write the matrix
+ */
+void CameraViewProjectionMatrix(const Camera *camera, float aspectRatio, mat4 *viewProjectionMatrix);
+
+/**
+ * Extract the frustum planes from a view projection matrix
+ * @param viewProjectionMatrix The matrix, as returned by @c CameraViewProjectionMatrix
+ * @param frustum Where to write the frustum
+ */
+void FrustumFromMatrix(mat4 viewProjectionMatrix, Frustum *frustum);
+
+/**
+ * Get the frustum of a camera
+ * @param camera The camera
+ * @param aspectRatio The width of the viewport divided by its height
+ * @param frustum Where to write the frustum
+ */
+void CameraFrustum(const Camera *camera, float aspectRatio, Frustum *frustum);
+
+/**
+ * Get the world space axis-aligned bounding box of a model space box
+ * @param transformMatrix The model matrix
+ * @param origin The center of the box in model space
+ * @param extents The half size of the box in model space
+ * @param worldCenter Where to write the center of the world space box
+ * @param worldExtents Where to write the half size of the world space box
+ */
+void TransformBoundingBox(mat4 transformMatrix,
+						  const Vector3 *origin,
+						  const Vector3 *extents,
+						  Vector3 *worldCenter,
+						  Vector3 *worldExtents);
+
+/**
+ * Change the number of boxes, keeping the existing ones. New boxes are left empty and are always culled.
+ * @param bounds The bounds to resize
+ * @param count The new number of boxes
+ */
+void CullingBoundsResize(CullingBounds *bounds, size_t count);
+
+/**
+ * Set one of the boxes
+ * @param bounds The bounds
+ * @param index The index of the box
+ * @param center The center of the box in world space
+ * @param extents The half size of the box in world space
+ */
+void CullingBoundsSet(CullingBounds *bounds, size_t index, const Vector3 *center, const Vector3 *extents);
+
+/**
+ * Free the arrays of the bounds
+ * @param bounds The bounds to free
+ * @note This does NOT free the bounds pointer itself
+ */
+void CullingBoundsFree(CullingBounds *bounds);
+
+/**
+ * Test every box against a frustum
+ * @param frustum The frustum
+ * @param bounds The boxes
+ * @param visible An array with space for @c bounds->count entries, which is set to 1 for boxes that intersect the
+ *                frustum and 0 for boxes that are outside of it
+ * @return The number of boxes that intersect the frustum
+ */
+size_t CullBoundingBoxes(const Frustum *frustum, const CullingBounds *bounds, uint8_t *visible);
+
+/**
+ * Pick the triangles of the map geometry that are large enough to be worth drawing as occluders, and store them in the
+ * map. Every map material is assumed to be opaque.
+ * @param map The map, which must still have the vertices and indices of its models
+ */
+void ExtractOccluders(Map *map);
+
+/**
+ * Clear an occlusion buffer and draw occluder triangles into it. Each pixel whose center a triangle covers is written
+ * with the furthest depth of the triangle within the pixel, and @c TestOcclusion grows boxes by a pixel to account for
+ * the coverage, so the buffer never hides anything that is actually visible.
+ * @param buffer The buffer to draw into
+ * @param viewProjectionMatrix The view projection matrix of the camera
+ * @param vertices The vertices of the triangles, with three vertices for each triangle
+ * @param triangleCount The number of triangles
+ */
+void DrawOccluders(OcclusionBuffer *buffer, mat4 viewProjectionMatrix, const Vector3 *vertices, size_t triangleCount);
+
+/**
+ * Test the boxes that are marked as visible against an occlusion buffer
+ * @param buffer The buffer, as drawn by @c DrawOccluders
+ * @param bounds The boxes
+ * @param visible An array with @c bounds->count entries, where the entries of boxes that are fully hidden behind the
+ *                occluders are set to 0
+ * @return The number of boxes that were hidden
+ */
+size_t TestOcclusion(const OcclusionBuffer *buffer, const CullingBounds *bounds, uint8_t *visible);
+
+#endif //GAME_CULLING_H
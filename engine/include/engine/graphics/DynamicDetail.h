@@ -0,0 +1,71 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_DYNAMICDETAIL_H
+#define GAME_DYNAMICDETAIL_H
+
+#include <stdint.h>
+
+/// How much of each new frame time goes into the smoothed frame time
+#define DYNAMIC_DETAIL_SMOOTHING 0.1
+/// The number of frames in a row that have to be over the target before the detail scale is lowered
+#define DYNAMIC_DETAIL_DECREASE_FRAMES 8
+/// The number of frames in a row that have to be under the target before the detail scale is raised, which is longer
+/// than @c DYNAMIC_DETAIL_DECREASE_FRAMES so that dropped frames are fixed quickly but detail comes back slowly
+#define DYNAMIC_DETAIL_INCREASE_FRAMES 60
+/// How much the detail scale is raised by at a time
+#define DYNAMIC_DETAIL_INCREASE_STEP 0.05f
+
+typedef struct DynamicDetailSettings DynamicDetailSettings;
+
+typedef struct DynamicDetailController DynamicDetailController;
+
+/// The limits that a dynamic detail controller works within
+struct DynamicDetailSettings
+{
+	/// The frame time to aim for, in nanoseconds
+	uint64_t targetFrameNs;
+	/// The lowest detail scale
+	float minScale;
+	/// The highest detail scale
+	float maxScale;
+	/**
+	 * How far the smoothed frame time can be from the target, as a fraction of the target, before the scale changes.
+	 * Frame times inside of this band leave the scale alone, which keeps it from going back and forth every frame.
+	 */
+	float hysteresis;
+};
+
+/// Adjusts a detail scale so that the frame time stays close to a target
+struct DynamicDetailController
+{
+	/// The current detail scale
+	float scale;
+	/// The exponential moving average of the frame time in nanoseconds, or 0 before the first frame
+	double smoothedFrameNs;
+	/// The number of frames in a row that the smoothed frame time has been over the hysteresis band
+	uint32_t slowFrames;
+	/// The number of frames in a row that the smoothed frame time has been under the hysteresis band
+	uint32_t fastFrames;
+};
+
+/**
+ * Set up a dynamic detail controller
+ * @param controller The controller to set up
+ * @param scale The detail scale to start at
+ */
+void DynamicDetailInit(DynamicDetailController *controller, float scale);
+
+/**
+ * Give a dynamic detail controller the time of a frame. When the smoothed frame time has been over the hysteresis band
+ * for long enough, the scale is lowered in proportion to how far over the target it is. When it has been under the band
+ * for long enough, the scale is raised by @c DYNAMIC_DETAIL_INCREASE_STEP.
+ * @param controller The controller
+ * @param settings The limits to work within
+ * @param frameNs The time that the frame took, in nanoseconds
+ * @return The new detail scale, which is always between the minimum and maximum scale of the settings
+ */
+float DynamicDetailUpdate(DynamicDetailController *controller, const DynamicDetailSettings *settings, uint64_t frameNs);
+
+#endif //GAME_DYNAMICDETAIL_H
@@ -12,9 +12,18 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/// The number of slots in the text layout cache, which must be a power of two
+#define TEXT_LAYOUT_CACHE_SLOTS 1024
+/// The most strings that the text layout cache holds, which keeps the hash table at most half full
+#define TEXT_LAYOUT_CACHE_MAX_ENTRIES (TEXT_LAYOUT_CACHE_SLOTS / 2)
+/// The number of frames that a layout stays in the cache without being drawn
+#define TEXT_LAYOUT_CACHE_MAX_AGE 60
+
 typedef enum FontHorizontalAlign FontHorizontalAlign;
 typedef enum FontVerticalAlign FontVerticalAlign;
 
+typedef struct TextLayoutCacheStats TextLayoutCacheStats;
+
 enum FontHorizontalAlign
 {
 	FONT_HALIGN_LEFT,
@@ -29,9 +38,23 @@ enum FontVerticalAlign
 	FONT_VALIGN_BOTTOM
 };
 
+/// How well the text layout cache worked during one frame
+struct TextLayoutCacheStats
+{
+	/// The number of strings that were drawn from a cached layout
+	size_t hits;
+	/// The number of strings that had to be laid out
+	size_t misses;
+	/// The number of layouts in the cache at the end of the frame
+	size_t layouts;
+};
+
 extern Font *smallFont;
 extern Font *largeFont;
 
+/// The text layout cache stats of the last frame
+extern TextLayoutCacheStats textLayoutCacheStats;
+
 /**
  * Draw a string of text to the screen
  * @param pos Top left position of the text
@@ -84,7 +107,8 @@ Vector2 MeasureTextNChars(const char *str, uint32_t size, const Font *font, size
 void TextGetLine(const char *str, int line, char *out, size_t outBufferSize, bool convertToUppercase);
 
 /**
- * Draw a string of text to the screen with alignment
+ * Draw a string of text to the screen with alignment. The glyph quads are cached by the string, font, size, alignment
+ * and rectangle, so drawing the same text in the same place again only copies the cached quads.
  * @param str String to draw
  * @param size Font size
  * @param color Font color
@@ -103,6 +127,12 @@ void DrawTextAligned(const char *str,
 					 FontVerticalAlign vAlign,
 					 const Font *font);
 
+/**
+ * Start a new frame of the text layout cache, removing the layouts that have not been drawn for
+ * @c TEXT_LAYOUT_CACHE_MAX_AGE frames
+ */
+void TrimTextLayoutCache();
+
 /**
  * Initialize common fonts
  */
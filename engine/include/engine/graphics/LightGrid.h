@@ -0,0 +1,113 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_LIGHTGRID_H
+#define GAME_LIGHTGRID_H
+
+#include <cglm/types.h>
+#include <engine/structs/Light.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The number of columns of the light grid across the screen, which must be a multiple of @c LIGHT_GRID_BATCH_SIZE
+#define LIGHT_GRID_WIDTH 16
+/// The number of rows of the light grid down the screen
+#define LIGHT_GRID_HEIGHT 8
+/// The number of depth slices of the light grid
+#define LIGHT_GRID_DEPTH 24
+/// The number of cells in the light grid
+#define LIGHT_GRID_CELLS (LIGHT_GRID_WIDTH * LIGHT_GRID_HEIGHT * LIGHT_GRID_DEPTH)
+/// The view space depth where the first depth slice ends, after which the slices get exponentially deeper
+#define LIGHT_GRID_NEAR_Z 0.5f
+/// The maximum number of point lights that are assigned to the grid, where lights after this are ignored
+#define LIGHT_GRID_MAX_LIGHTS 1024
+/// The maximum number of light indices across every cell, where the lights that don't fit are left out of the cells
+#define LIGHT_GRID_MAX_INDICES 32768
+/// The number of cells that a light is tested against at once
+#define LIGHT_GRID_BATCH_SIZE 4
+
+typedef struct LightGridLight LightGridLight;
+
+typedef struct LightGridCell LightGridCell;
+
+typedef struct LightGrid LightGrid;
+
+/// A point light packed into two vectors, which is the std430 layout that a shader would read it in
+struct LightGridLight
+{
+	/// The world space position of the light in xyz, and its range in w
+	vec4 positionRange;
+	/// The color of the light multiplied by its brightness scale in xyz, and its attenuation in w
+	vec4 colorAttenuation;
+};
+
+/// The range of @c LightGrid::indices that holds the lights affecting one cell
+struct LightGridCell
+{
+	/// The index in @c LightGrid::indices of the first light of the cell
+	uint32_t firstIndex;
+	/// The number of lights affecting the cell
+	uint32_t lightCount;
+};
+
+/**
+ * A grid of view space frustum cells, each with a list of the point lights whose range reaches into it. The cells are
+ * indexed by (slice * LIGHT_GRID_HEIGHT + row) * LIGHT_GRID_WIDTH + column, where the column and row split the
+ * framebuffer into equal tiles starting from the top left, and the slice is given by @c LightGridSlice.
+ */
+struct LightGrid
+{
+	/// The view space bounding box of each cell, which only changes with the projection
+	float cellMinimumX[LIGHT_GRID_CELLS];
+	float cellMinimumY[LIGHT_GRID_CELLS];
+	float cellMinimumZ[LIGHT_GRID_CELLS];
+	float cellMaximumX[LIGHT_GRID_CELLS];
+	float cellMaximumY[LIGHT_GRID_CELLS];
+	float cellMaximumZ[LIGHT_GRID_CELLS];
+	/// The horizontal and vertical scale of the projection that the cell bounding boxes were computed for
+	float projectionScaleX;
+	float projectionScaleY;
+
+	/// The lights that were assigned, in the order they were given
+	LightGridLight lights[LIGHT_GRID_MAX_LIGHTS];
+	/// The number of lights in @c lights
+	size_t lightCount;
+	/// The light range of each cell
+	LightGridCell cells[LIGHT_GRID_CELLS];
+	/// The indices in @c lights of the lights affecting each cell, with the lights of each cell next to each other
+	uint32_t indices[LIGHT_GRID_MAX_INDICES];
+	/// The number of entries in @c indices
+	size_t indexCount;
+	/// The number of cell and light pairs that did not fit in @c indices this frame
+	size_t droppedIndexCount;
+
+	/// The cell of each cell and light pair found while building, before they are sorted into @c indices
+	uint16_t pairCells[LIGHT_GRID_MAX_INDICES];
+	/// The light of each cell and light pair found while building
+	uint16_t pairLights[LIGHT_GRID_MAX_INDICES];
+};
+
+/**
+ * Get the depth slice of the light grid that a view space depth falls into
+ * @param viewZ The view space depth
+ * @return The index of the slice
+ */
+size_t LightGridSlice(float viewZ);
+
+/**
+ * Assign point lights to the cells of a light grid. Lights that are entirely behind the camera or past the far plane
+ * are left out.
+ * @param grid The grid to build, which must be zeroed before it is built for the first time
+ * @param viewMatrix The view matrix of the camera
+ * @param projectionMatrix The left handed perspective projection matrix of the camera
+ * @param lights The point lights
+ * @param lightCount The number of point lights
+ */
+void LightGridBuild(LightGrid *grid,
+					mat4 viewMatrix,
+					mat4 projectionMatrix,
+					const PointLight *lights,
+					size_t lightCount);
+
+#endif //GAME_LIGHTGRID_H
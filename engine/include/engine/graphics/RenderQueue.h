@@ -0,0 +1,199 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_RENDERQUEUE_H
+#define GAME_RENDERQUEUE_H
+
+#include <engine/assets/TextureLoader.h>
+#include <engine/structs/Camera.h>
+#include <engine/structs/Color.h>
+#include <engine/structs/Map.h>
+#include <joltc/Math/Vector3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The number of command buffers that frames are recorded into in turn. One is recorded by the main thread while the
+ * others hold frames that were handed to the render thread, so the main thread can get up to two frames ahead.
+ */
+#define RENDER_QUEUE_BUFFER_COUNT 3
+
+typedef enum RenderCommandType RenderCommandType;
+
+typedef struct RenderCommand RenderCommand;
+
+typedef struct RenderCommandBuffer RenderCommandBuffer;
+
+/// The kinds of drawing that can be recorded into a @c RenderCommandBuffer
+enum RenderCommandType
+{
+	RENDER_COMMAND_COLORED_QUAD,
+	RENDER_COMMAND_TEXTURED_QUAD,
+	RENDER_COMMAND_TEXTURED_QUAD_REGION,
+	RENDER_COMMAND_COLORED_QUADS_BATCHED,
+	RENDER_COMMAND_TEXTURED_QUADS_BATCHED,
+	RENDER_COMMAND_LINE,
+	RENDER_COMMAND_RECT_OUTLINE,
+	RENDER_COMMAND_UI_TRIANGLES,
+	RENDER_COMMAND_JOLT_DEBUG_LINE,
+	RENDER_COMMAND_JOLT_DEBUG_TRIANGLE,
+	RENDER_COMMAND_MAP,
+};
+
+/**
+ * One recorded draw call, holding copies of its arguments. Textures are resolved to images when the command is
+ * recorded, since the texture loader can only load new images on the main thread. Arrays of vertices and indices are
+ * copied into the data of the command buffer, and are referred to by their offset into it.
+ */
+struct RenderCommand
+{
+	RenderCommandType type;
+	union
+	{
+		/// Used by @c RENDER_COMMAND_COLORED_QUAD, @c RENDER_COMMAND_TEXTURED_QUAD and
+		/// @c RENDER_COMMAND_TEXTURED_QUAD_REGION, where the region is only used by the last of them
+		struct
+		{
+			int32_t x;
+			int32_t y;
+			int32_t w;
+			int32_t h;
+			int32_t regionX;
+			int32_t regionY;
+			int32_t regionW;
+			int32_t regionH;
+			const Image *image;
+			Color color;
+		} quad;
+		/// Used by @c RENDER_COMMAND_COLORED_QUADS_BATCHED and @c RENDER_COMMAND_TEXTURED_QUADS_BATCHED
+		struct
+		{
+			size_t verticesOffset;
+			int32_t quadCount;
+			const Image *image;
+			Color color;
+		} batchedQuads;
+		/// Used by @c RENDER_COMMAND_LINE and @c RENDER_COMMAND_RECT_OUTLINE, where a rectangle outline is stored
+		/// as its position in @c startX and @c startY and its size in @c endX and @c endY
+		struct
+		{
+			int32_t startX;
+			int32_t startY;
+			int32_t endX;
+			int32_t endY;
+			int32_t thickness;
+			Color color;
+		} line;
+		/// Used by @c RENDER_COMMAND_UI_TRIANGLES
+		struct
+		{
+			size_t verticesOffset;
+			size_t vertexCount;
+			size_t indicesOffset;
+			size_t indexCount;
+			const Image *image;
+			Color color;
+		} uiTriangles;
+		/// Used by @c RENDER_COMMAND_JOLT_DEBUG_LINE and @c RENDER_COMMAND_JOLT_DEBUG_TRIANGLE, where a line only uses
+		/// the first two vertices
+		struct
+		{
+			Vector3 vertices[3];
+			uint32_t color;
+		} joltDebug;
+		/// Used by @c RENDER_COMMAND_MAP
+		struct
+		{
+			Map *map;
+			/// A copy of the camera, since the main thread keeps moving it while the frame is rendered
+			Camera camera;
+			/// Whether @c camera is a copy of the player's camera, the only camera that the viewmodel is drawn for
+			bool isPlayerCamera;
+			/// A copy of the parts of the map that change while it is played
+			MapRenderState state;
+		} map;
+	};
+};
+
+/// The draw calls of one frame, in the order that they were made
+struct RenderCommandBuffer
+{
+	RenderCommand *commands;
+	size_t commandCount;
+	size_t commandCapacity;
+	/// The vertex and index arrays that the commands refer to
+	uint8_t *data;
+	size_t dataSize;
+	size_t dataCapacity;
+};
+
+/**
+ * Start recording a new frame into the next command buffer, clearing what it held before. The frame that last used the
+ * buffer must have finished executing.
+ */
+void RenderQueueBegin();
+
+/**
+ * Add a command to the end of the command buffer that is being recorded
+ * @param type The type of the command
+ * @return The command, whose type is set and whose arguments must be filled in by the caller. The pointer is only valid
+ *         until the next command is added.
+ */
+RenderCommand *RenderQueueAddCommand(RenderCommandType type);
+
+/**
+ * Copy an array into the data of the command buffer that is being recorded
+ * @param data The array to copy
+ * @param size The size of the array in bytes
+ * @return The offset of the copy into the data of the command buffer
+ */
+size_t RenderQueueAddData(const void *data, size_t size);
+
+/**
+ * Record commands into another command buffer instead of the frame until @c RenderQueueEndCapture is called, so that
+ * they can be replayed into later frames with @c RenderQueueReplay. The commands hold image pointers, so a capture must
+ * not be replayed after the texture loader has been destroyed.
+ * @param buffer The command buffer to record into, which is cleared first
+ */
+void RenderQueueBeginCapture(RenderCommandBuffer *buffer);
+
+/**
+ * Go back to recording commands into the frame
+ */
+void RenderQueueEndCapture();
+
+/**
+ * Copy the commands of a captured command buffer into the command buffer that is being recorded
+ * @param buffer The captured command buffer
+ */
+void RenderQueueReplay(const RenderCommandBuffer *buffer);
+
+/**
+ * Free the commands and data of a command buffer
+ * @param buffer The command buffer to free
+ */
+void RenderQueueFreeBuffer(RenderCommandBuffer *buffer);
+
+/**
+ * Move on to the next command buffer, so that the buffer that was being recorded can be executed while the next frame
+ * is recorded. The buffers are used in turn, so the buffer returned by this call is not reused until
+ * @c RENDER_QUEUE_BUFFER_COUNT more frames have been recorded.
+ * @return The command buffer that was being recorded
+ */
+const RenderCommandBuffer *RenderQueueSwap();
+
+/**
+ * Replay the commands of a command buffer into the renderer. This must be called between @c VK_FrameStart and
+ * @c VK_FrameEnd, from the thread that renders.
+ * @param buffer The command buffer to replay
+ */
+void RenderQueueExecute(const RenderCommandBuffer *buffer);
+
+/**
+ * Free every command buffer
+ */
+void RenderQueueDestroy();
+
+#endif //GAME_RENDERQUEUE_H
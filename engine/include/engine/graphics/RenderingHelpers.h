@@ -49,8 +49,77 @@ enum RendererQueuedAction
 	QUEUED_ACTION_TOGGLE_VSYNC = 1 << 4,
 };
 
+typedef enum RenderPassTiming RenderPassTiming;
+
+/// The passes of a frame whose CPU recording time is measured separately
+enum RenderPassTiming
+{
+	RENDER_PASS_TIMING_SKY,
+	RENDER_PASS_TIMING_MAP,
+	RENDER_PASS_TIMING_ACTORS,
+	RENDER_PASS_TIMING_WALLS,
+	RENDER_PASS_TIMING_VIEWMODEL,
+	RENDER_PASS_TIMING_UI,
+	RENDER_PASS_TIMING_COUNT,
+};
+
+typedef struct RenderStats RenderStats;
+
+/// Counters describing the work done by the renderer during the current frame, reset when the render thread starts it
+struct RenderStats
+{
+	/// The number of actor instance data entries written to the GPU
+	uint32_t instancesWritten;
+	/// The number of bytes of actor instance data written to the GPU
+	uint32_t instanceBytesWritten;
+	/// The number of actors that were drawn
+	uint32_t visibleActors;
+	/// The number of visible actors that were not drawn because they are outside the camera frustum
+	uint32_t culledActors;
+	/// The number of visible actors that were not drawn because they are hidden behind occluders
+	uint32_t occludedActors;
+	/// The number of map clusters that were drawn
+	uint32_t visibleMapClusters;
+	/// The number of map clusters that were not drawn because they are outside the camera frustum
+	uint32_t culledMapClusters;
+	/// The number of map clusters that were not drawn because they are hidden behind occluders
+	uint32_t occludedMapClusters;
+	/// The number of occluder triangles drawn into the occlusion buffer
+	uint32_t occluderTriangles;
+	/// The time spent drawing occluders into the occlusion buffer, in nanoseconds
+	uint64_t occluderDrawNs;
+	/// The time spent testing actors and map clusters against the occlusion buffer, in nanoseconds
+	uint64_t occlusionTestNs;
+	/// The number of textures that were uploaded to the GPU
+	uint32_t textureUploads;
+	/// The number of bytes of pixel data that were uploaded to the GPU for textures
+	uint64_t textureUploadBytes;
+	/// The time the CPU spent recording and submitting texture uploads, in nanoseconds
+	uint64_t textureUploadNs;
+	/// The number of bytes of texture mip levels that are resident on the GPU
+	uint64_t textureResidentBytes;
+	/// The time the CPU spent preparing and recording the commands of each pass, in nanoseconds
+	uint64_t passNs[RENDER_PASS_TIMING_COUNT];
+	/// The time the render thread spent waiting in lunaBeginFrame, in nanoseconds. This covers the GPU finishing the
+	/// frame that last used the same command buffer and a swapchain image becoming available, so a frame that spends
+	/// a large part of its time here is limited by the GPU or by presentation rather than by the CPU.
+	uint64_t gpuWaitNs;
+	/// The time the render thread spent on the frame from starting it to submitting it, in nanoseconds. This includes
+	/// @c gpuWaitNs, so it grows both when recording the frame is slow and when the GPU is.
+	uint64_t frameNs;
+};
+
 extern RendererQueuedAction rendererQueuedActions;
 
+/// The stats of the frame that the render thread is rendering, which only the renderer may use
+extern RenderStats renderStats;
+
+/// The stats of the last frame that the render thread finished, which is what the main thread reads
+extern RenderStats lastRenderStats;
+
+/// The name of each pass in @c RenderPassTiming, for the frame graph and benchmark output
+extern const char *const renderPassTimingNames[RENDER_PASS_TIMING_COUNT];
+
 /**
  * Set the main window
  * @param w The window to use
@@ -135,12 +204,13 @@ bool RenderInit();
 void RenderDestroy();
 
 /**
- * Run tasks that need to be run before any drawing can be done
+ * Run tasks that need to be run before any drawing can be done, and start recording the draw calls of the frame
+ * @return Whether the frame can be drawn, which is false while the window is minimized
  */
 bool FrameStart();
 
 /**
- * Run tasks needed to present the frame to the screen, as well as swapping the framebuffers
+ * Hand the recorded draw calls of the frame to the render thread, which renders and presents them
  */
 void FrameEnd();
 
@@ -195,6 +265,20 @@ float Y_TO_NDC(float y);
  */
 void LoadMapModels(Map *map);
 
+/**
+ * Let the renderer know that an actor has been added to the current map
+ * @param actor The actor that was added
+ * @note The map's actor list must be locked
+ */
+void NotifyActorAdded(Actor *actor);
+
+/**
+ * Let the renderer know that an actor is being removed from the current map, before it is freed
+ * @param actor The actor that is being removed
+ * @note The map's actor list must be locked
+ */
+void NotifyActorRemoved(Actor *actor);
+
 /**
  * Convert a color uint32_t (0xAARRGGBB) to a Color vec4 (RGBA 0-1)
  * @param argb The color uint32_t
@@ -0,0 +1,82 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_STAGINGRING_H
+#define GAME_STAGINGRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The most allocations that can be live in a staging ring at once
+#define STAGING_RING_MAX_REGIONS 64
+/// The alignment of every allocation made from a staging ring
+#define STAGING_RING_ALIGNMENT 16
+
+typedef struct StagingRingRegion StagingRingRegion;
+typedef struct StagingRing StagingRing;
+
+/// A live allocation in a staging ring
+struct StagingRingRegion
+{
+	/// The position in the ring just past the end of the allocation, counting every byte ever allocated
+	uint64_t end;
+	/// The serial of the upload that reads the allocation
+	uint64_t serial;
+};
+
+/**
+ * A persistent block of memory that upload data is staged in, which is handed out front to back and wraps around once
+ * the uploads that read the oldest allocations have completed. This avoids a heap allocation for every upload.
+ */
+struct StagingRing
+{
+	/// The memory of the ring
+	uint8_t *memory;
+	/// The size of @c memory in bytes
+	size_t capacity;
+	/// The position that the next allocation starts at or after, counting every byte ever allocated
+	uint64_t head;
+	/// The position of the oldest byte that is still in use
+	uint64_t tail;
+	/// The live allocations from oldest to newest, stored as a circular queue
+	StagingRingRegion regions[STAGING_RING_MAX_REGIONS];
+	/// The index in @c regions of the oldest live allocation
+	size_t firstRegion;
+	/// The number of live allocations
+	size_t regionCount;
+};
+
+/**
+ * Allocate the memory of a staging ring
+ * @param ring The ring to set up
+ * @param capacity The size of the ring in bytes
+ */
+void StagingRingInit(StagingRing *ring, size_t capacity);
+
+/**
+ * Free the memory of a staging ring
+ * @param ring The ring to free
+ */
+void StagingRingDestroy(StagingRing *ring);
+
+/**
+ * Allocate contiguous memory from a staging ring. The memory stays valid until @c StagingRingRelease is called with a
+ * pending serial past @p serial.
+ * @param ring The ring to allocate from
+ * @param bytes The number of bytes to allocate
+ * @param serial The serial of the upload that reads the memory, which must not be less than that of any earlier
+ *  allocation
+ * @return The allocated memory, or @c NULL if the ring does not have enough free space, in which case the caller has
+ *  to stage the data somewhere else
+ */
+void *StagingRingAllocate(StagingRing *ring, size_t bytes, uint64_t serial);
+
+/**
+ * Free every allocation of a staging ring that is read by an upload which has completed
+ * @param ring The ring to free allocations from
+ * @param pendingSerial The serial of the oldest upload that may not have completed yet
+ */
+void StagingRingRelease(StagingRing *ring, uint64_t pendingSerial);
+
+#endif //GAME_STAGINGRING_H
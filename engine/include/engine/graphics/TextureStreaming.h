@@ -0,0 +1,104 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_TEXTURESTREAMING_H
+#define GAME_TEXTURESTREAMING_H
+
+#include <engine/assets/TextureLoader.h>
+#include <joltc/Math/Vector3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The most mip levels that a streamed texture can have, which is enough for a 32768x32768 texture
+#define TEXTURE_STREAMING_MAX_LEVELS 16
+/// The largest width or height of the level that every streamed texture keeps resident no matter the budget
+#define TEXTURE_STREAMING_RESIDENT_SIZE 64
+/// How much of the screen size of a texture is kept from one frame to the next, so textures that briefly go out of
+/// view are not evicted right away
+#define TEXTURE_STREAMING_SCREEN_SIZE_DECAY 0.95f
+/// The most textures that get more detailed levels uploaded in one frame
+#define TEXTURE_STREAMING_UPLOADS_PER_FRAME 4
+
+typedef struct StreamedTexture StreamedTexture;
+
+/**
+ * The residency state of one texture. Levels are numbered like mip levels, so a texture with level 2 resident has every
+ * level from 2 down to its smallest level on the GPU.
+ */
+struct StreamedTexture
+{
+	/// The number of bytes of the mip chain starting at each level and going down to the smallest level
+	size_t chainBytes[TEXTURE_STREAMING_MAX_LEVELS];
+	/// The larger of the width and height of the base level in pixels
+	size_t baseSize;
+	/// The number of levels that can be streamed
+	uint8_t levelCount;
+	/// The most detailed level that is always resident
+	uint8_t lowestLevel;
+	/// The most detailed level that is on the GPU
+	uint8_t residentLevel;
+	/// The most detailed level that should be on the GPU, as set by @c TextureStreamingPlan
+	uint8_t targetLevel;
+	/// The largest size in pixels that the texture has recently covered on the screen, which is its priority
+	float screenSize;
+};
+
+/**
+ * Set up the residency state of a texture, with only its always resident levels on the GPU
+ * @param texture The texture to set up
+ * @param format The pixel format that the texture is uploaded in
+ * @param width The width of the base level in pixels
+ * @param height The height of the base level in pixels
+ * @param levelCount The number of mip levels that are uploaded
+ * @param streamed Whether the detailed levels can be left out, otherwise the whole chain is always resident
+ */
+void StreamedTextureInit(StreamedTexture *texture,
+						 ImagePixelFormat format,
+						 size_t width,
+						 size_t height,
+						 uint8_t levelCount,
+						 bool streamed);
+
+/**
+ * Record that a texture covers some part of the screen this frame
+ * @param texture The texture
+ * @param screenSize The size in pixels that the texture covers
+ */
+void StreamedTextureSeen(StreamedTexture *texture, float screenSize);
+
+/**
+ * Get the most detailed level that a texture needs for its screen size, which is the level whose size is closest to
+ * the screen size without being smaller than it
+ * @param texture The texture
+ * @return The level
+ */
+uint8_t StreamedTextureWantedLevel(const StreamedTexture *texture);
+
+/**
+ * Get the size in pixels that a bounding box covers on the screen
+ * @param cameraPosition The position of the camera
+ * @param pixelScale The height of the viewport in pixels divided by the height of the view at a distance of one
+ * @param center The center of the box
+ * @param extents The half size of the box
+ * @return The size in pixels, measured from the nearest point of the sphere around the box so that it is never
+ *         underestimated, and capped at the size of the sphere seen from its own radius away
+ */
+float BoundsScreenSize(const Vector3 *cameraPosition, float pixelScale, const Vector3 *center, const Vector3 *extents);
+
+/**
+ * Pick the target level of every texture so that the resident bytes fit in a budget. Every texture gets its always
+ * resident levels, then textures are given one more level at a time in order of screen size until they reach the level
+ * they want or the budget runs out. Textures that already have more levels than they want keep them while the budget
+ * allows, so they are only evicted when another texture needs the space. The screen sizes are decayed afterward.
+ * @param textures The textures
+ * @param textureCount The number of textures
+ * @param budgetBytes The most bytes that can be resident, or 0 for no limit
+ * @param order An array with space for @c textureCount entries, where the indices of the textures are written from
+ *              highest to lowest screen size
+ * @return The number of bytes that are resident once every texture is at its target level
+ */
+size_t TextureStreamingPlan(StreamedTexture *textures, size_t textureCount, size_t budgetBytes, uint32_t *order);
+
+#endif //GAME_TEXTURESTREAMING_H
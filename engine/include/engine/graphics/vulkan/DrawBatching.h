@@ -0,0 +1,42 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_DRAWBATCHING_H
+#define GAME_DRAWBATCHING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+
+/**
+ * Pack the draw commands of the visible clusters to the front of an array of draw commands that is kept between frames.
+ * Every cluster has its own range of the index buffer, so a command is identified by its first index.
+ * @param drawInfo The draw commands of every cluster
+ * @param drawInfoClusters The index of the cluster that each command in @c drawInfo draws
+ * @param drawCount The number of commands in @c drawInfo
+ * @param clustersVisible Whether each cluster is visible, indexed using a cluster index
+ * @param visibleDrawInfo The commands packed by the last call, which are packed again
+ * @param visibleDrawCount The number of commands at the front of @c visibleDrawInfo, which is updated
+ * @return The index in @c visibleDrawInfo of the first command that is different from the last call, or @c SIZE_MAX if
+ *  every command is the same. Commands past the new visible count are not included.
+ */
+size_t CompactDrawInfo(const VkDrawIndexedIndirectCommand *drawInfo,
+					   const uint32_t *drawInfoClusters,
+					   size_t drawCount,
+					   const uint8_t *clustersVisible,
+					   VkDrawIndexedIndirectCommand *visibleDrawInfo,
+					   size_t *visibleDrawCount);
+
+/**
+ * Join two triangles into a quad that is drawn by the indices in the UI index buffer, which are the triangles 0, 1, 2
+ * and 0, 2, 3 of the quad
+ * @param first The first triangle
+ * @param second The second triangle
+ * @param quad Where to write the vertex indices of the quad
+ * @return Whether the triangles share an edge with the same winding, and so could be joined
+ */
+bool JoinTrianglesIntoQuad(const uint32_t first[3], const uint32_t second[3], uint32_t quad[4]);
+
+#endif //GAME_DRAWBATCHING_H
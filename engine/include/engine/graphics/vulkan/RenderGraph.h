@@ -0,0 +1,179 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_RENDERGRAPH_H
+#define GAME_RENDERGRAPH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+
+/// The most passes that a render graph can have
+#define RENDER_GRAPH_MAX_PASSES 32
+/// The most resources that a render graph can have
+#define RENDER_GRAPH_MAX_RESOURCES 32
+/// The most resources that one pass can access
+#define RENDER_GRAPH_MAX_PASS_ACCESSES 8
+/// The most barriers that a compiled render graph can have, which is enough for every access of every pass
+#define RENDER_GRAPH_MAX_BARRIERS (RENDER_GRAPH_MAX_PASSES * RENDER_GRAPH_MAX_PASS_ACCESSES)
+
+typedef enum RenderGraphAccessType RenderGraphAccessType;
+
+typedef struct RenderGraphResource RenderGraphResource;
+
+typedef struct RenderGraphPass RenderGraphPass;
+
+typedef struct RenderGraphBarrier RenderGraphBarrier;
+
+typedef struct RenderGraph RenderGraph;
+
+/// The ways that a pass can use an image, each of which has a fixed pipeline stage, access mask and layout
+enum RenderGraphAccessType
+{
+	/// Drawn to as a color attachment
+	RENDER_GRAPH_ACCESS_COLOR_WRITE,
+	/// Depth tested and written as a depth attachment
+	RENDER_GRAPH_ACCESS_DEPTH_WRITE,
+	/// Depth tested as a read only depth attachment
+	RENDER_GRAPH_ACCESS_DEPTH_READ,
+	/// Written by the multisample resolve at the end of a render pass
+	RENDER_GRAPH_ACCESS_RESOLVE_WRITE,
+	/// Sampled in a fragment shader
+	RENDER_GRAPH_ACCESS_SAMPLED_READ,
+	/// Handed to the presentation engine
+	RENDER_GRAPH_ACCESS_PRESENT,
+};
+
+/// An image that passes read or write
+struct RenderGraphResource
+{
+	/// The name used in the schedule dump
+	const char *name;
+	VkFormat format;
+	VkSampleCountFlagBits samples;
+	/**
+	 * Whether the contents of the image are only needed within the frame. The memory of transient resources whose
+	 * lifetimes don't overlap can be shared, and other resources, such as swapchain images, are never aliased.
+	 */
+	bool transient;
+};
+
+/// A step of the frame and the resources it uses
+struct RenderGraphPass
+{
+	/// The name used in the schedule dump
+	const char *name;
+	/// The index of each resource that the pass accesses
+	uint8_t resources[RENDER_GRAPH_MAX_PASS_ACCESSES];
+	/// How the pass accesses each resource in @c resources
+	RenderGraphAccessType accessTypes[RENDER_GRAPH_MAX_PASS_ACCESSES];
+	/// The number of resources that the pass accesses
+	uint8_t accessCount;
+	/// The render pass group that the pass was put in by @c RenderGraphCompile
+	uint8_t group;
+};
+
+/// A pipeline barrier on one resource that has to be recorded before a pass
+struct RenderGraphBarrier
+{
+	/// The index of the pass that the barrier is recorded before
+	uint8_t pass;
+	/// The index of the resource that the barrier is for
+	uint8_t resource;
+	VkPipelineStageFlags srcStageMask;
+	VkAccessFlags srcAccessMask;
+	VkPipelineStageFlags dstStageMask;
+	VkAccessFlags dstAccessMask;
+	VkImageLayout oldLayout;
+	VkImageLayout newLayout;
+};
+
+/**
+ * A declared frame, made of passes that run in the order they are added. Compiling the graph merges passes that only
+ * use attachments into render pass groups, finds the barriers that are actually needed between passes, and assigns
+ * transient resources to shared memory.
+ */
+struct RenderGraph
+{
+	RenderGraphResource resources[RENDER_GRAPH_MAX_RESOURCES];
+	size_t resourceCount;
+	RenderGraphPass passes[RENDER_GRAPH_MAX_PASSES];
+	size_t passCount;
+
+	/// The barriers between passes, in the order that they are recorded
+	RenderGraphBarrier barriers[RENDER_GRAPH_MAX_BARRIERS];
+	size_t barrierCount;
+	/// The number of barriers there would be with a barrier before every access of a resource after its first one
+	size_t conservativeBarrierCount;
+	/// The number of render pass groups
+	size_t groupCount;
+	/**
+	 * The dependency between the end of the previous frame and the start of this one, covering the last access to
+	 * every resource and the first access to every resource. Presenting is left out because the swapchain semaphores
+	 * already order it.
+	 */
+	VkSubpassDependency externalDependency;
+	/// The index of the memory that each resource is placed in
+	uint8_t resourceMemory[RENDER_GRAPH_MAX_RESOURCES];
+	/// The number of separate memory allocations that the resources need
+	size_t memoryCount;
+};
+
+/**
+ * Clear a render graph so that passes and resources can be added to it
+ * @param graph The graph to clear
+ */
+void RenderGraphInit(RenderGraph *graph);
+
+/**
+ * Add a resource to a render graph
+ * @param graph The graph
+ * @param name The name used in the schedule dump, which must stay valid for as long as the graph is used
+ * @param format The format of the image
+ * @param samples The sample count of the image
+ * @param transient Whether the contents of the image are only needed within the frame
+ * @return The index of the resource
+ */
+uint8_t RenderGraphAddResource(RenderGraph *graph,
+							   const char *name,
+							   VkFormat format,
+							   VkSampleCountFlagBits samples,
+							   bool transient);
+
+/**
+ * Add a pass to the end of a render graph
+ * @param graph The graph
+ * @param name The name used in the schedule dump, which must stay valid for as long as the graph is used
+ * @return The index of the pass
+ */
+uint8_t RenderGraphAddPass(RenderGraph *graph, const char *name);
+
+/**
+ * Declare that a pass uses a resource
+ * @param graph The graph
+ * @param pass The index of the pass
+ * @param resource The index of the resource
+ * @param accessType How the pass uses the resource
+ */
+void RenderGraphPassAccess(RenderGraph *graph, uint8_t pass, uint8_t resource, RenderGraphAccessType accessType);
+
+/**
+ * Group the passes, find the barriers between them, compute the external dependency, and assign memory to the
+ * resources. This only reads the declared passes and resources, so it can be run without a device.
+ * @param graph The graph to compile
+ */
+void RenderGraphCompile(RenderGraph *graph);
+
+/**
+ * Write a human readable schedule of a compiled render graph, listing each group with its passes and barriers, where
+ * each resource is placed, and the external dependency
+ * @param graph The compiled graph
+ * @param buffer The buffer to write to, which is always null terminated
+ * @param bufferSize The size of the buffer in bytes
+ * @return The length of the whole schedule, which may be longer than what fit in the buffer
+ */
+size_t RenderGraphDumpSchedule(const RenderGraph *graph, char *buffer, size_t bufferSize);
+
+#endif //GAME_RENDERGRAPH_H
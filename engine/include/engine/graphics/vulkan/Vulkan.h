@@ -5,6 +5,7 @@
 #ifndef GAME_VULKAN_H
 #define GAME_VULKAN_H
 
+#include <engine/assets/TextureLoader.h>
 #include <engine/graphics/Drawing.h>
 #include <engine/graphics/RenderingHelpers.h> // NOLINT(*-include-cleaner)
 #include <engine/structs/Camera.h>
@@ -33,6 +34,13 @@ bool VK_PreInit();
 
 bool VK_Init(SDL_Window *window);
 
+/**
+ * Handle the actions in @c rendererQueuedActions. This must only be called while the main thread is waiting for the
+ * frame to finish, since the actions reload resources that the main thread uses.
+ * @return Whether the actions were handled successfully
+ */
+bool VK_HandleQueuedActions();
+
 bool VK_FrameStart();
 
 /**
@@ -41,9 +49,11 @@ bool VK_FrameStart();
  *  any command buffers, present to the screen, or even begin the actual rendering process.
  * @param map The map to render
  * @param camera The camera from which the map should be rendered
+ * @param state The lighting, fog and viewmodel of the map as of when the frame was queued
+ * @param isPlayerCamera Whether @c camera is the player's camera, in which case the viewmodel is drawn
  * @return @c VK_SUCCESS if the map was rendered successfully, or a meaningful result code otherwise
  */
-bool VK_RenderMap(Map *map, const Camera *camera);
+bool VK_RenderMap(Map *map, const Camera *camera, const MapRenderState *state, bool isPlayerCamera);
 
 bool VK_FrameEnd();
 
@@ -58,13 +68,15 @@ void VK_Minimize();
 
 void VK_Restore();
 
+bool VK_IsMinimized();
+
 void VK_DrawColoredQuad(int x, int y, int w, int h, Color color);
 
 void VK_DrawColoredQuadsBatched(const float *vertices, int quadCount, Color color);
 
-void VK_DrawTexturedQuad(int x, int y, int w, int h, const char *texture);
+void VK_DrawTexturedQuad(int x, int y, int w, int h, const Image *image);
 
-void VK_DrawTexturedQuadMod(int x, int y, int w, int h, const char *texture, const Color *color);
+void VK_DrawTexturedQuadMod(int x, int y, int w, int h, const Image *image, const Color *color);
 
 void VK_DrawTexturedQuadRegion(int x,
 							   int y,
@@ -74,7 +86,7 @@ void VK_DrawTexturedQuadRegion(int x,
 							   int regionY,
 							   int regionW,
 							   int regionH,
-							   const char *texture);
+							   const Image *image);
 
 void VK_DrawTexturedQuadRegionMod(int x,
 								  int y,
@@ -84,16 +96,16 @@ void VK_DrawTexturedQuadRegionMod(int x,
 								  int regionY,
 								  int regionW,
 								  int regionH,
-								  const char *texture,
+								  const Image *image,
 								  Color color);
 
-void VK_DrawTexturedQuadsBatched(const float *vertices, int quadCount, const char *texture, Color color);
+void VK_DrawTexturedQuadsBatched(const float *vertices, int quadCount, const Image *image, Color color);
 
 void VK_DrawLine(int startX, int startY, int endX, int endY, int thickness, Color color);
 
 void VK_DrawRectOutline(int x, int y, int w, int h, int thickness, Color color);
 
-void VK_DrawUiTriangles(const UiTriangleArray *triangleArray, const char *texture, Color color);
+void VK_DrawUiTriangles(const UiTriangleArray *triangleArray, const Image *image, Color color);
 
 void VK_DrawJoltDebugRendererLine(const Vector3 *from, const Vector3 *to, uint32_t color);
 
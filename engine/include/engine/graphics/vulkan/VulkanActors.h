@@ -5,13 +5,50 @@
 #ifndef GAME_VULKANACTORS_H
 #define GAME_VULKANACTORS_H
 
+#include <engine/graphics/Culling.h>
+#include <engine/structs/Actor.h>
 #include <engine/structs/List.h>
+#include <joltc/Math/Vector3.h>
 #include <vulkan/vulkan_core.h>
 
 void InitActorLoadingVariables();
 
 VkResult LoadActors(const LockingList *actors);
 
-VkResult UpdateActors();
+/**
+ * Bring the actor instance data up to date and cull the actor instances against the camera frustum and occluders.
+ * Only instances of visible actors inside the frustum that are not hidden behind occluders are drawn, and only their
+ * instance data is written to the GPU. The screen sizes of the drawn instances are reported to texture streaming while
+ * the actor list is still locked, since the main thread can remove actors at any other time.
+ * @param frustum The frustum of the camera that the actors are drawn with
+ * @param occlusionBuffer The occluders seen by the camera
+ * @param cameraPosition The position of the camera
+ * @param pixelScale The height of the viewport in pixels divided by the height of the view at a distance of one
+ */
+VkResult UpdateActors(const Frustum *frustum,
+					  const OcclusionBuffer *occlusionBuffer,
+					  const Vector3 *cameraPosition,
+					  float pixelScale);
+
+/**
+ * Queue an actor that was added to the loaded map to be given an instance at the start of the next frame.
+ * The map's actor list must be locked by the caller.
+ * @param actor The actor that was added
+ */
+void RegisterActorInstance(Actor *actor);
+
+/**
+ * Release the instance of an actor that is being removed from the loaded map.
+ * The map's actor list must be locked by the caller, and the actor must not be freed before this is called.
+ * @param actor The actor that is being removed
+ */
+void UnregisterActorInstance(Actor *actor);
+
+/**
+ * Mark the instance data of every actor as dirty, so that all of it is written again next frame.
+ * This must be called whenever texture indices may have changed.
+ */
+void InvalidateActorInstanceData();
+
 
 #endif //GAME_VULKANACTORS_H
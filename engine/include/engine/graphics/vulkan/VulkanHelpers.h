@@ -9,6 +9,7 @@
 #include <engine/assets/ModelLoader.h>
 #include <engine/assets/ShaderLoader.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/graphics/TextureStreaming.h>
 #include <engine/structs/Camera.h>
 #include <engine/structs/Color.h>
 #include <engine/structs/List.h>
@@ -26,8 +27,21 @@
 #ifdef JPH_DEBUG_RENDERER
 #define MAX_DEBUG_DRAW_VERTICES_INIT 1024
 #endif
+/// The number of command buffers that image uploads take turns recording into
+#define UPLOAD_COMMAND_BUFFER_COUNT 8
+/// The size of the ring that texture pixel data is staged in when it has to be converted before being uploaded
+#define TEXTURE_STAGING_RING_BYTES (64 * 1024 * 1024)
 
-#define FRAMES_IN_FLIGHT 1
+/**
+ * The number of frames that the CPU can record while the GPU is still working on earlier ones. This is set with the
+ * FRAMES_IN_FLIGHT CMake cache variable.
+ */
+#ifndef FRAMES_IN_FLIGHT
+#define FRAMES_IN_FLIGHT 2
+#endif
+static_assert(FRAMES_IN_FLIGHT >= 2 && FRAMES_IN_FLIGHT <= 3, "FRAMES_IN_FLIGHT must be 2 or 3");
+/// A bitmask with a bit set for every frame in flight, for tracking which frames' copies of a buffer are out of date
+#define ALL_FRAMES_IN_FLIGHT_BITS ((1u << FRAMES_IN_FLIGHT) - 1)
 
 #define SizeofMember(Type, member) (sizeof(((Type *)0)->member))
 
@@ -88,11 +102,6 @@ enum VendorIDs
 	QUALCOMM = 0x5143,
 };
 
-enum PendingTasksBitFlags
-{
-	PENDING_TASK_UI_BUFFERS_RESIZE_BIT = 1 << 0,
-};
-
 typedef struct CameraUniform
 {
 	mat4 transform;
@@ -155,13 +164,19 @@ typedef struct ModelInstanceData
 	uint32_t textureIndex;
 } ModelInstanceData;
 
+/// The per-actor part of an actor model instance, which is shared by every material slot of the actor's model
 typedef struct ActorModelInstanceData
 {
 	mat4 transformMatrix;
 	vec4 modColor;
-	vec4 materialColor;
+} ActorModelInstanceData;
+
+/// The per-material slot part of an actor model instance, which is stored at the same index as its ActorModelInstanceData
+typedef struct ActorModelMaterialData
+{
+	Color materialColor;
 	uint32_t textureIndex;
-} __attribute__((aligned(32))) ActorModelInstanceData;
+} ActorModelMaterialData;
 
 typedef struct ActorWallInstanceData
 {
@@ -176,14 +191,26 @@ typedef struct ActorWallInstanceData
 	Color modColor;
 } ActorWallInstanceData;
 
+/// The number of quads in the UI index buffer, which is as many as 16-bit indices can address. A UI with more quads
+/// than this is drawn in several draws, each starting at a later vertex of the vertex buffer.
+#define UI_INDEXED_QUADS ((UINT16_MAX + 1) / 4)
+
 typedef struct UiBuffer
 {
-	LunaBuffer vertexBuffer;
+	/// The vertex buffer of each frame in flight, since the UI is written in full every frame
+	LunaBuffer vertexBuffers[FRAMES_IN_FLIGHT];
+	/// The number of quads that the vertex buffer of each frame in flight has space for
+	uint32_t bufferQuads[FRAMES_IN_FLIGHT];
+	/// The index buffer that every frame in flight shares. Every UI element is drawn as quads, so this only holds the
+	/// 16-bit indices of @c UI_INDEXED_QUADS consecutive quads. It is created at that size and written by the first
+	/// frame, and it never changes after that, so no frame in flight can be reading it while it is written.
 	LunaBuffer indexBuffer;
+	/// Whether the indices of @c indexBuffer have been written
+	bool indexBufferWritten;
 	uint32_t allocatedQuads;
 	uint32_t freeQuads;
+	/// The vertices of the quads drawn this frame, four for each quad
 	UiVertex *vertexData;
-	uint32_t *indexData;
 } UiBuffer;
 
 typedef struct UniformBuffers
@@ -202,7 +229,9 @@ typedef struct UniformBuffers
  * individually dispatched draw calls if it were not using indirect draw.
  *
  * Vertex and index data does not need to be duplicated for each frame in flight due to the fact that it is in local
- * space and only the instance data should be changing on a frame-to-frame basis.
+ * space and only the instance data should be changing on a frame-to-frame basis. The instance data and draw info are
+ * duplicated, since the GPU can still be reading the copy of an earlier frame while the next frame is being recorded.
+ * Each copy is only written while its own frame is being recorded, and is brought up to date from the CPU-side data.
  */
 typedef struct ModelBuffer
 {
@@ -210,14 +239,39 @@ typedef struct ModelBuffer
 	LunaBuffer vertices;
 	/// A buffer containing the index data to use along-side the per-vertex data
 	LunaBuffer indices;
-	/// A buffer containing the instance data for each instance of each model section
-	LunaBuffer instanceData; //[FRAMES_IN_FLIGHT];
-	/// A buffer containing the VkDrawIndexedIndirectCommand structures required for the shaded materials draw call
-	LunaBuffer shadedDrawInfo; //[FRAMES_IN_FLIGHT];
-	/// A buffer containing the VkDrawIndexedIndirectCommand structures required for the unshaded materials draw call
-	LunaBuffer unshadedDrawInfo; //[FRAMES_IN_FLIGHT];
+	/// A buffer for each frame in flight containing the instance data for each instance of each model section
+	LunaBuffer instanceData[FRAMES_IN_FLIGHT];
+	/// A buffer for each frame in flight containing the VkDrawIndexedIndirectCommand structures required for the shaded
+	/// materials draw call
+	LunaBuffer shadedDrawInfo[FRAMES_IN_FLIGHT];
+	/// A buffer for each frame in flight containing the VkDrawIndexedIndirectCommand structures required for the
+	/// unshaded materials draw call
+	LunaBuffer unshadedDrawInfo[FRAMES_IN_FLIGHT];
 } ModelBuffer;
 
+typedef struct ActorModelBuffer
+{
+	/// A buffer containing per-vertex data
+	LunaBuffer vertices;
+	/// A buffer containing the index data to use along-side the per-vertex data
+	LunaBuffer indices;
+	/// A buffer for each frame in flight containing the ActorModelInstanceData for each actor instance
+	LunaBuffer instanceData[FRAMES_IN_FLIGHT];
+	/// The number of material slot indices that have the buffers below
+	uint32_t materialSlotCount;
+	/// For each frame in flight and material slot index, a buffer containing the ActorModelMaterialData for each actor
+	/// instance
+	LunaBuffer *materialData[FRAMES_IN_FLIGHT];
+	/// For each frame in flight and material slot index, a buffer containing the VkDrawIndexedIndirectCommand
+	/// structures for the shaded draw
+	LunaBuffer *shadedDrawInfo[FRAMES_IN_FLIGHT];
+	/// For each frame in flight and material slot index, a buffer containing the VkDrawIndexedIndirectCommand
+	/// structures for the unshaded draw
+	LunaBuffer *unshadedDrawInfo[FRAMES_IN_FLIGHT];
+	/// For each material slot index, the number of draw commands in use in the draw info buffers
+	uint32_t *drawCounts;
+} ActorModelBuffer;
+
 typedef struct SkyBuffer
 {
 	LunaBuffer vertices;
@@ -228,13 +282,13 @@ typedef struct ActorWallBuffer
 {
 	/// A buffer of the 12 ActorWallVertex values corresponding to the two faces of the quad
 	LunaBuffer vertices;
-	/// A buffer containing the ActorWallInstanceData for each shaded actor wall
-	LunaBuffer shadedInstanceData;
-	/// The number of shaded actor walls in the map
+	/// A buffer for each frame in flight containing the ActorWallInstanceData for each shaded actor wall
+	LunaBuffer shadedInstanceData[FRAMES_IN_FLIGHT];
+	/// The number of shaded actor walls drawn this frame, as of when their instance data was written
 	uint32_t shadedInstanceCount;
-	/// A buffer containing the ActorWallInstanceData for each unshaded actor wall
-	LunaBuffer unshadedInstanceData;
-	/// The number of unshaded actor walls in the map
+	/// A buffer for each frame in flight containing the ActorWallInstanceData for each unshaded actor wall
+	LunaBuffer unshadedInstanceData[FRAMES_IN_FLIGHT];
+	/// The number of unshaded actor walls drawn this frame, as of when their instance data was written
 	uint32_t unshadedInstanceCount;
 } ActorWallBuffer;
 
@@ -256,10 +310,10 @@ typedef struct DebugDrawBuffer
 
 typedef struct Buffers
 {
-	UiBuffer ui; //[FRAMES_IN_FLIGHT];
-	UniformBuffers uniforms; //[FRAMES_IN_FLIGHT];
+	UiBuffer ui;
+	UniformBuffers uniforms;
 	ModelBuffer viewmodel;
-	ModelBuffer actorModels;
+	ActorModelBuffer actorModels;
 	ModelBuffer map;
 	SkyBuffer sky;
 	ActorWallBuffer actorWalls;
@@ -312,11 +366,31 @@ typedef struct DescriptorSetLayouts
 extern bool minimized;
 extern LunaDevice device;
 extern VkPhysicalDeviceProperties physicalDeviceProperties;
+/// Whether BC1-BC7 block compressed textures can be sampled directly, otherwise they are decompressed on the CPU
+extern bool textureCompressionBCSupported;
 extern uint32_t queueFamilyIndex;
 extern VkQueue queue;
 extern LunaCommandPool commandPool;
+/// The command buffer of each frame in flight
+extern LunaCommandBuffer commandBuffers[FRAMES_IN_FLIGHT];
+/// The index in @c commandBuffers of the frame that is being recorded
+extern uint32_t currentFrame;
+/// The command buffer of the frame that is being recorded, which is also used for writes outside of a frame
 extern LunaCommandBuffer commandBuffer;
-extern LunaCommandBuffer secondaryCommandBuffer;
+/// The number of frames that have been submitted to the GPU
+extern uint64_t submittedFrames;
+/// Whether the command buffer of the current frame is being recorded, which means no pending frame uses its resources
+extern bool recordingFrame;
+/// The command buffers that image uploads are recorded into, in the order given by @c NextUploadCommandBuffer
+extern LunaCommandBuffer uploadCommandBuffers[UPLOAD_COMMAND_BUFFER_COUNT];
+/// The number of uploads that have been recorded with @c NextUploadCommandBuffer, which is the serial of the next one
+extern uint64_t issuedUploads;
+/**
+ * Waited on and signaled by every frame and image upload submission, which keeps them in submission order on the GPU.
+ * This is not a swapchain semaphore. Luna acquires the swapchain image in @c lunaBeginFrame and presents it in
+ * @c lunaEndFrame with semaphores of its own, and neither call takes semaphores from the caller, so the
+ * acquire and render finished semaphores can't be made per frame in flight from here.
+ */
 extern LunaSemaphore semaphore;
 extern VkSurfaceKHR surface;
 extern VkExtent2D swapChainExtent;
@@ -325,11 +399,15 @@ extern LunaRenderPass renderPass;
 extern uint32_t imageAssetIdToIndexMap[MAX_TEXTURES];
 extern TextureSamplers textureSamplers;
 extern LockingList textures;
+/// The residency state of each texture, indexed like @c textures
+extern StreamedTexture streamedTextures[MAX_TEXTURES];
+/// The image that each texture is uploaded from, indexed like @c textures
+extern const Image *streamedTextureImages[MAX_TEXTURES];
 extern LunaDescriptorSetLayout descriptorSetLayout;
-extern LunaDescriptorSet descriptorSet;
+/// One descriptor set per frame in flight, so a descriptor that frames in flight still use is never rewritten
+extern LunaDescriptorSet descriptorSets[FRAMES_IN_FLIGHT];
 extern Buffers buffers;
 extern Pipelines pipelines;
-extern uint32_t pendingTasks; // Bits set with PendingTasksBitFlags
 extern uint32_t skyTextureIndex;
 #pragma endregion variables
 
@@ -337,6 +415,48 @@ bool ClearTextureCache();
 
 void ClearModelCache();
 
+/**
+ * Get the command buffer to record the next image upload into. Uploads take turns using the buffers, so recording an
+ * upload only has to wait for the GPU to finish the upload from @c UPLOAD_COMMAND_BUFFER_COUNT uploads ago, rather than
+ * for the upload right before it.
+ * @return The command buffer
+ */
+LunaCommandBuffer NextUploadCommandBuffer();
+
+/**
+ * Destroy an image once every frame that is currently in flight has finished with it
+ * @param image The image to destroy
+ */
+void DestroyImageWhenRetired(LunaImage image);
+
+/**
+ * Destroy a sampler once every frame that is currently in flight has finished with it
+ * @param sampler The sampler to destroy
+ */
+void DestroySamplerWhenRetired(LunaSampler sampler);
+
+/**
+ * Destroy the images and samplers that were released before the oldest frame that the GPU may still be working on.
+ * This must be called once @c lunaBeginFrame has waited for the command buffer of the frame being recorded.
+ */
+void DestroyRetiredResources();
+
+/**
+ * Count the frame that was just submitted and move on to the command buffer of the next frame in flight
+ */
+void AdvanceFrame();
+
+/**
+ * Make sure that the copy of a per-frame buffer that belongs to the frame being recorded can hold a number of bytes,
+ * replacing it with a larger buffer if it can't. This is only safe for the copy of @c currentFrame, since
+ * @c lunaBeginFrame has waited for the last frame that used it. The contents of a replaced buffer must be written
+ * again.
+ * @param buffer The copy of the buffer for @c currentFrame
+ * @param bytes The number of bytes that the buffer has to hold
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+VkResult EnsureFrameBufferSize(LunaBuffer *buffer, size_t bytes);
+
 VkResult CreateShaderModule(const char *path, ShaderType shaderType, LunaShaderModule *shaderModule);
 
 uint32_t TextureIndex(const char *texture);
@@ -347,6 +467,13 @@ VkResult UpdateCameraUniform(const Camera *camera);
 
 VkResult UpdateViewModelMatrix(const Viewmodel *viewmodel);
 
+/**
+ * Record that a texture covers the whole screen this frame, so that texture streaming keeps every mip level of it. This
+ * is used for the UI, the viewmodel and the sky, which are drawn close to the camera no matter where it is.
+ * @param textureIndex The index of the texture
+ */
+void RequestFullTextureDetail(uint32_t textureIndex);
+
 void EnsureSpaceForUiElements(size_t quadCount);
 
 void DrawRectInternal(float ndcStartX,
@@ -30,6 +30,6 @@ bool CreateTextureSamplers();
 
 bool CreateBuffers();
 
-bool CreateDescriptorSet();
+bool CreateDescriptorSets();
 
 #endif //VULKANINTERNAL_H
@@ -12,4 +12,28 @@ VkResult ResizeDebugDrawBuffers();
 
 bool LoadTexture(const Image *image);
 
+/**
+ * Free the ring that converted texture pixel data is staged in
+ */
+void DestroyTextureStagingRing();
+
+/**
+ * Note that every texture slot is free to be reused, while frames in flight may still sample the textures that the
+ * slots held before
+ */
+void ReleaseTextureSlots();
+
+/**
+ * Decide which mip levels of each texture should be resident given the screen sizes recorded this frame and the
+ * texture budget, then evict levels that are over the budget and upload the most needed missing levels
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+VkResult StreamTextures();
+
+/**
+ * Write the texture slots whose images were replaced since the descriptor set of the current frame was last written.
+ * This has to be called while the current frame is being recorded, since the descriptor set is not pending then.
+ */
+void WriteDirtyTextureDescriptors();
+
 #endif //VULKANRESOURCES_H
@@ -81,6 +81,9 @@ struct Actor
 	/// The color modifier of the actor's model
 	Color modColor;
 
+	/// The index of the renderer's instance slot for this actor, or @c UINT32_MAX if it has not been given one
+	uint32_t instanceSlot;
+
 	/// Flags used to provide more information about the actor
 	uint32_t flags;
 
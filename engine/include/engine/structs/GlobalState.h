@@ -56,6 +56,8 @@ struct GlobalState
 
 	/// Game options
 	Options options;
+	/// The scale that dynamic detail applies to the LOD distance multiplier, which is 1 when it is disabled
+	float detailScale;
 
 	/// The path to the executable
 	char executablePath[261];
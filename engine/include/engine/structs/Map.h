@@ -6,6 +6,7 @@
 #define GAME_MAP_H
 
 #include <engine/assets/MapMaterialLoader.h>
+#include <engine/graphics/Bvh.h>
 #include <engine/structs/Actor.h>
 #include <engine/structs/Camera.h>
 #include <engine/structs/Color.h>
@@ -20,19 +21,14 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/// The maximum number of triangles in a map cluster
+#define MAP_CLUSTER_MAX_TRIANGLES 256
+
 typedef struct Map Map;
 typedef struct MapVertex MapVertex;
 typedef struct MapModel MapModel;
-
-typedef enum MapChangeFlags MapChangeFlags;
-
-enum MapChangeFlags
-{
-	MAP_LIGHT_CHANGED = 1 << 1,
-	MAP_EXPOSURE_CHANGED = 1 << 1,
-	MAP_FOG_CHANGED = 1 << 2,
-	MAP_VIEWMODEL_CHANGED = 1 << 3
-};
+typedef struct MapCluster MapCluster;
+typedef struct MapRenderState MapRenderState;
 
 struct MapVertex
 {
@@ -40,8 +36,8 @@ struct MapVertex
 	Vector3 position;
 	/// The UV coordinate
 	Vector2 uv;
-	/// The Lightmap UV coordinate
-	Vector2 lightmapUv;
+	/// The lightmap UV coordinate, stored as unorm16 relative to the lightmap atlas
+	uint16_t lightmapUv[2];
 };
 
 struct MapModel
@@ -56,6 +52,23 @@ struct MapModel
 	uint32_t indexCount;
 	/// The indices in this model
 	uint32_t *indices;
+	/// Whether every index in this model fits in 16 bits
+	bool shortIndices;
+};
+
+/// A spatially compact group of triangles from one map model, which is culled and drawn on its own
+struct MapCluster
+{
+	/// The index of the map model that this cluster is part of
+	size_t model;
+	/// The index in the model's indices of the first index of this cluster
+	uint32_t firstIndex;
+	/// The number of indices in this cluster
+	uint32_t indexCount;
+	/// The center of the world space bounding box of this cluster
+	Vector3 center;
+	/// The half size of the world space bounding box of this cluster
+	Vector3 extents;
 };
 
 struct Map
@@ -73,6 +86,16 @@ struct Map
 	size_t modelCount;
 	/// The map models
 	MapModel *models;
+	/// The number of clusters that the map models are split into
+	size_t clusterCount;
+	/// The clusters of every map model, ordered by model
+	MapCluster *clusters;
+	/// A bounding volume hierarchy over the bounding boxes of @c clusters
+	Bvh clusterBvh;
+	/// The number of triangles in @c occluderVertices
+	size_t occluderTriangleCount;
+	/// The large map triangles that are drawn for occlusion culling, with three vertices for each triangle
+	Vector3 *occluderVertices;
 
 	List joltBodies;
 
@@ -106,8 +129,6 @@ struct Map
 	/// A pointer to the I/O proxy actor, if it exists
 	Actor *ioProxy;
 
-	MapChangeFlags changeFlags;
-
 	/// The view model
 	Viewmodel viewmodel;
 
@@ -124,6 +145,26 @@ struct Map
 	PointLight *pointLights;
 };
 
+/// The parts of a map that change while it is played and are read when it is rendered. Each frame gets its own copy,
+/// since the main thread keeps changing the map while the render thread renders the frame.
+struct MapRenderState
+{
+	/// The color of the fog
+	Color fogColor;
+	/// The distance from the player at which the fog begins to fade in
+	float fogStart;
+	/// The distance from the player at which the fog is fully opaque
+	float fogEnd;
+
+	/// The global light color. The alpha channel is ignored.
+	Color lightColor;
+	/// HDR tonemapping exposure
+	float exposure;
+
+	/// The view model
+	Viewmodel viewmodel;
+};
+
 /**
  * Create a default empty map
  * @return Blank map
@@ -183,6 +224,13 @@ Actor *GetActorByName(const char *name, const Map *map);
  */
 void GetActorsByName(const char *name, const Map *map, List *actors);
 
+/**
+ * Copy the parts of a map that the renderer reads every frame
+ * @param map The map to copy from
+ * @param state Where to write the copy
+ */
+void GetMapRenderState(const Map *map, MapRenderState *state);
+
 /**
  * Renders a map from a given camera, including actor UI and physics debug.
  * @param map The map to render
@@ -72,6 +72,16 @@ struct Options
 	OptionsAnisotropy anisotropy;
 	/// The FPS cap, or 0 for no cap
 	uint16_t maxFps;
+	/// The most MiB of texture mip levels to keep on the GPU, or 0 for no limit
+	uint16_t textureBudgetMiB;
+	/// Whether to lower the LOD distance multiplier when frames take longer than the target frame time
+	bool dynamicDetail;
+	/// The lowest scale that dynamic detail can apply to the LOD distance multiplier
+	float dynamicDetailMinScale;
+	/// The highest scale that dynamic detail can apply to the LOD distance multiplier
+	float dynamicDetailMaxScale;
+	/// How far the frame time can be from the target, as a fraction of the target, before dynamic detail reacts
+	float dynamicDetailHysteresis;
 
 	/* Audio */
 
@@ -0,0 +1,36 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_RENDERTHREAD_H
+#define GAME_RENDERTHREAD_H
+
+/**
+ * Start the render thread, which executes the frames recorded by the main thread so that the main thread can update
+ * and record the next frame at the same time. With --serial-render, the main thread waits for every frame to finish
+ * before going on, which makes the order of everything the same as if there were no render thread.
+ */
+void RenderThreadInit();
+
+/**
+ * Wait for every frame that was handed to the render thread to finish, then stop the render thread
+ */
+void RenderThreadDestroy();
+
+/**
+ * Hand the frame that was recorded since @c FrameStart to the render thread. The render thread renders the frames it is
+ * handed in order, and up to two can be waiting or rendering at once, so the main thread can update and record the
+ * next frame while the render thread catches up. If two frames are already queued, this first waits for the older one
+ * to finish. Frames that have renderer actions queued are always waited for, along with every frame before them,
+ * since handling the actions reloads resources that the main thread uses.
+ */
+void RenderThreadSubmitFrame();
+
+/**
+ * Wait for every frame that was handed to the render thread to finish. This must be called on the main thread before
+ * changing anything that the renderer reads outside of the recorded commands, such as the loaded map, the viewport
+ * size, or the loaded assets.
+ */
+void RenderThreadWaitIdle();
+
+#endif //GAME_RENDERTHREAD_H
@@ -0,0 +1,41 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_RENDERWORKERS_H
+#define GAME_RENDERWORKERS_H
+
+#include <stddef.h>
+
+/// The most render worker threads that are started, not counting the main thread
+#define RENDER_WORKERS_MAX_THREADS 7
+
+/**
+ * A function that does one piece of a job
+ * @param data The data that was given to @c RenderWorkersRun
+ * @param index The index of the piece, from 0 up to the count given to @c RenderWorkersRun
+ */
+typedef void (*RenderJobFunction)(void *data, size_t index);
+
+/**
+ * Start the render worker threads. The number of threads is one less than the number of logical cores, up to
+ * @c RENDER_WORKERS_MAX_THREADS, and can be set with --render-workers, where 0 runs every job on the main thread.
+ */
+void RenderWorkersInit();
+
+/**
+ * Stop the render worker threads and wait for them to exit
+ */
+void RenderWorkersDestroy();
+
+/**
+ * Call a function once for each index from 0 up to a count, spread over the render worker threads and the calling
+ * thread, and wait for every call to finish. Only one job can run at a time, so this must only be called from the
+ * render thread. The calls run in no particular order and must not record commands, since Luna is not thread safe.
+ * @param function The function to call
+ * @param data The data to pass to every call
+ * @param count The number of calls
+ */
+void RenderWorkersRun(RenderJobFunction function, void *data, size_t count);
+
+#endif //GAME_RENDERWORKERS_H
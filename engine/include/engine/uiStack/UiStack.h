@@ -5,6 +5,7 @@
 #ifndef GAME_UISTACK_H
 #define GAME_UISTACK_H
 
+#include <engine/graphics/RenderQueue.h>
 #include <engine/structs/List.h>
 #include <engine/structs/Vector2.h>
 #include <stdbool.h>
@@ -63,6 +64,21 @@ struct Control
 
 	/// Extra data for the control
 	void *controlData;
+
+	/// Whether something that the control draws, such as its value or text, has changed since it was last drawn
+	bool dirty;
+	/// The draw commands of the control from the last time it was drawn, which are replayed until it has to be redrawn
+	RenderCommandBuffer geometry;
+	/// The state that @c geometry was drawn with
+	ControlState drawnState;
+	/// Whether @c geometry includes the focus border
+	bool drawnFocused;
+	/// The anchored position that @c geometry was drawn at
+	Vector2 drawnPosition;
+	/// The scaled window size that @c geometry was drawn with, since its vertices are in normalized device coordinates
+	Vector2 drawnWindowSize;
+	/// The value of @c textureLoaderGeneration when @c geometry was drawn, since it holds image pointers
+	uint32_t drawnTextureGeneration;
 };
 
 struct UiStack
@@ -77,6 +93,11 @@ struct UiStack
 
 	/// The control that has keyboard focus
 	uint32_t focusedControl;
+
+	/// The scaled window size that the anchored positions of the controls were calculated for
+	Vector2 layoutWindowSize;
+	/// Whether the anchored positions of the controls have to be calculated again, even if the window size is the same
+	bool layoutDirty;
 };
 
 /**
@@ -92,14 +113,16 @@ UiStack *CreateUiStack();
 void DestroyUiStack(UiStack *stack);
 
 /**
- * Process the UiStack
+ * Process the UiStack. The anchored positions of the controls are only calculated again when the window size changes
+ * or a control is added.
  * @param stack The UiStack to process
  * @return Whether the mouse is over a control
  */
 bool ProcessUiStack(UiStack *stack);
 
 /**
- * Draw the UiStack
+ * Draw the UiStack. Each control is only drawn again if it is dirty or its state, focus, or position changed, and
+ * otherwise the draw commands from the last time it was drawn are replayed.
  * @warning Call @c ProcessUiStack before calling this
  * @param stack The UiStack to draw
  */
@@ -119,6 +142,13 @@ Vector2 CalculateControlPosition(const Control *control);
  */
 Control *CreateEmptyControl();
 
+/**
+ * Mark a control as needing to be drawn again, which must be done after changing anything it draws other than its
+ * state, focus, or position, such as its value or text
+ * @param control The control to mark
+ */
+void MarkControlDirty(Control *control);
+
 /**
  * Add a control to the UiStack
  * @param stack The UiStack to add the control to
@@ -131,7 +161,7 @@ void UiStackPush(UiStack *stack, Control *control);
  * @param stack The UiStack to remove the control from
  * @param control The control to remove
  */
-void UiStackRemove(UiStack *stack, const Control *control);
+void UiStackRemove(UiStack *stack, Control *control);
 
 /**
  * Check if the mouse is in a rectangle
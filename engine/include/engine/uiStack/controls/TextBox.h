@@ -24,6 +24,8 @@ struct TextBoxData
 	TextBoxCallback callback;
 	TextInput input;
 	bool isActive;
+	/// Whether the blinking cursor was shown when the text box was last updated
+	bool cursorVisible;
 };
 
 Control *CreateTextBoxControl(const char *placeholder,
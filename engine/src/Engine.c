@@ -11,6 +11,7 @@
 #include <engine/debug/FrameGrapher.h>
 #include <engine/Engine.h>
 #include <engine/graphics/Drawing.h>
+#include <engine/graphics/DynamicDetail.h>
 #include <engine/graphics/Font.h>
 #include <engine/graphics/RenderingHelpers.h>
 #include <engine/helpers/Arguments.h>
@@ -27,6 +28,8 @@
 #include <engine/subsystem/TextInputSystem.h>
 #include <engine/subsystem/threads/LodThread.h>
 #include <engine/subsystem/threads/PhysicsThread.h>
+#include <engine/subsystem/threads/RenderThread.h>
+#include <engine/subsystem/threads/RenderWorkers.h>
 #include <engine/subsystem/Timing.h>
 #include <SDL3/SDL_error.h>
 #include <SDL3/SDL_events.h>
@@ -53,7 +56,10 @@ EXPORT_SYM int AmdPowerXpressRequestHighPerformance = 1;
 static SDL_Surface *windowIcon;
 static SDL_Event event;
 static bool shouldQuit = false;
+static bool headless = false;
+static size_t headlessFrameCount = 0;
 static double lastFrameTime = TARGET_FPS_NS_D;
+static DynamicDetailController detailController;
 
 void ExecPathInit(const int argc, const char *argv[])
 {
@@ -124,6 +130,17 @@ void InitSDL()
 	}
 #endif
 
+	headless = HasCliArg("--headless");
+	if (headless)
+	{
+#ifndef BENCHMARK_SYSTEM_ENABLE
+		Error("--headless needs the frame benchmark system, which is disabled in FrameBenchmark.h");
+#endif
+		// The offscreen driver creates Vulkan surfaces with VK_EXT_headless_surface, so no display is needed
+		SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+		SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+	}
+
 	if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD | SDL_INIT_JOYSTICK | SDL_INIT_HAPTIC))
 	{
 		LogError("SDL_Init Error: %s\n", SDL_GetError());
@@ -152,7 +169,10 @@ void WindowAndRenderInit()
 		Error("Failed to create window.");
 	}
 	SetDwmWindowAttribs(window);
-	if (HasCliArg("--fullscreen"))
+	if (headless)
+	{
+		GetState()->options.fullscreen = false;
+	} else if (HasCliArg("--fullscreen"))
 	{
 		GetState()->options.fullscreen = true;
 	} else if (HasCliArg("--windowed"))
@@ -261,6 +281,7 @@ void InitEngine(const int argc, const char *argv[], const RegisterGameActorsFunc
 	RegisterActors(RegisterGameActors);
 
 	InitState();
+	DynamicDetailInit(&detailController, GetState()->detailScale);
 	PhysicsThreadInit();
 
 	if (!RenderPreInit())
@@ -274,7 +295,7 @@ void InitEngine(const int argc, const char *argv[], const RegisterGameActorsFunc
 
 	InitCommonFonts();
 
-	if (GetState()->options.enableDiscordRpc)
+	if (GetState()->options.enableDiscordRpc && !headless)
 	{
 		DiscordInit();
 	}
@@ -282,10 +303,35 @@ void InitEngine(const int argc, const char *argv[], const RegisterGameActorsFunc
 	InitDPrintConsole();
 
 	LodThreadInit();
+	RenderWorkersInit();
+	RenderThreadInit();
 
 	SDL_ShowWindow(GetGameWindow());
 }
 
+/**
+ * Count a frame rendered in headless mode, starting the benchmark once the warmup frames are done and quitting once
+ * the benchmarked frames are done
+ */
+static void HeadlessFrameEnd()
+{
+	headlessFrameCount++;
+	const size_t benchmarkFrames = (size_t)max(GetCliArgInt("--headless-frames", HEADLESS_DEFAULT_FRAMES), 1);
+	if (headlessFrameCount == HEADLESS_WARMUP_FRAMES)
+	{
+#ifdef BENCHMARK_SYSTEM_ENABLE
+		BenchToggle();
+#endif
+	} else if (headlessFrameCount == HEADLESS_WARMUP_FRAMES + benchmarkFrames)
+	{
+#ifdef BENCHMARK_SYSTEM_ENABLE
+		BenchToggle();
+#endif
+		LogInfo("Rendered %zu headless frames, quitting\n", headlessFrameCount);
+		shouldQuit = true;
+	}
+}
+
 void EngineIteration()
 {
 	while (GetState()->freezeEvents)
@@ -337,7 +383,7 @@ void EngineIteration()
 	}
 #endif
 
-	if (state->gameState->enableRelativeMouseMode)
+	if (state->gameState->enableRelativeMouseMode && !headless)
 	{
 		// warp the mouse to the center of the screen
 		const Vector2 realWndSize = ActualWindowSize();
@@ -368,6 +414,10 @@ void EngineIteration()
 #ifdef BENCHMARK_SYSTEM_ENABLE
 	BenchFrameEnd();
 #endif
+	if (headless)
+	{
+		HeadlessFrameEnd();
+	}
 
 	if (IsLowFPSModeEnabled())
 	{
@@ -375,7 +425,28 @@ void EngineIteration()
 	}
 
 	const uint64_t actualFrameTime = GetTimeNs() - frameStart;
-	if (GetState()->options.maxFps != 0)
+	if (state->options.dynamicDetail)
+	{
+		// The detail scale only changes how much the renderer has to do, so it follows the time the render thread took
+		// for its last finished frame, which includes waiting for the GPU, rather than the time of this thread. The
+		// target is the frame time of the FPS cap. Until the render thread has finished a frame there is nothing to go
+		// on, so the scale is left alone.
+		const DynamicDetailSettings detailSettings = {
+			.targetFrameNs = state->options.maxFps != 0 ? 1000000000 / (uint64_t)state->options.maxFps
+														: (uint64_t)TARGET_FPS_NS_D,
+			.minScale = state->options.dynamicDetailMinScale,
+			.maxScale = state->options.dynamicDetailMaxScale,
+			.hysteresis = state->options.dynamicDetailHysteresis,
+		};
+		if (lastRenderStats.frameNs != 0)
+		{
+			state->detailScale = DynamicDetailUpdate(&detailController, &detailSettings, lastRenderStats.frameNs);
+		}
+	} else
+	{
+		state->detailScale = 1.0f;
+	}
+	if (GetState()->options.maxFps != 0 && !headless)
 	{
 		const uint64_t targetFrameTime = 1000000000 / (uint64_t)GetState()->options.maxFps;
 		if (targetFrameTime > actualFrameTime)
@@ -392,10 +463,12 @@ void EngineIteration()
 void DestroyEngine()
 {
 	SDL_HideWindow(GetGameWindow());
+	RenderThreadDestroy();
 	DestroyDPrintConsole();
 	DiscordDestroy();
 	PhysicsThreadTerminate();
 	LodThreadDestroy();
+	RenderWorkersDestroy();
 	InputDestroy();
 	DestroyGlobalState();
 	DestroySoundSystem();
@@ -417,3 +490,8 @@ bool EngineShouldQuit()
 {
 	return shouldQuit;
 }
+
+bool IsHeadless()
+{
+	return headless;
+}
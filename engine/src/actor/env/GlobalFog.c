@@ -58,7 +58,6 @@ static void GlobalFogUpdate(Actor *this, double /*delta*/)
 		GetState()->map->fogColor = data->fogColor;
 		GetState()->map->fogStart = data->fogStart;
 		GetState()->map->fogEnd = data->fogEnd;
-		GetState()->map->changeFlags |= MAP_FOG_CHANGED;
 		data->startOn = false;
 	}
 
@@ -72,7 +71,6 @@ static void GlobalFogUpdate(Actor *this, double /*delta*/)
 		GetState()->map->fogColor.g = lerp(interpolationPreviousColor.g, data->fogColor.g, interpolationFactor);
 		GetState()->map->fogColor.b = lerp(interpolationPreviousColor.b, data->fogColor.b, interpolationFactor);
 		GetState()->map->fogColor.a = lerp(interpolationPreviousColor.a, data->fogColor.a, interpolationFactor);
-		GetState()->map->changeFlags |= MAP_FOG_CHANGED;
 		if (ticksIntoInterpolation == data->interpolationTicks)
 		{
 			interpolatingActor = NULL;
@@ -89,7 +87,6 @@ static void GlobalFogSetHandler(Actor *this, const Actor * /*sender*/, const Par
 		GetState()->map->fogColor = data->fogColor;
 		GetState()->map->fogStart = data->fogStart;
 		GetState()->map->fogEnd = data->fogEnd;
-		GetState()->map->changeFlags |= MAP_FOG_CHANGED;
 	} else
 	{
 		interpolatingActor = this;
@@ -107,7 +104,6 @@ static void GlobalFogSetInstantHandler(Actor *this, const Actor * /*sender*/, co
 	GetState()->map->fogColor = data->fogColor;
 	GetState()->map->fogStart = data->fogStart;
 	GetState()->map->fogEnd = data->fogEnd;
-	GetState()->map->changeFlags |= MAP_FOG_CHANGED;
 }
 
 void GlobalFogDestroy(Actor *this)
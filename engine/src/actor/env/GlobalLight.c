@@ -46,7 +46,6 @@ static void GlobalLightUpdate(Actor *this, double /*delta*/)
 	if (data->startOn)
 	{
 		GetState()->map->lightColor = data->lightColor;
-		GetState()->map->changeFlags |= MAP_LIGHT_CHANGED;
 		data->startOn = false;
 	}
 
@@ -58,7 +57,6 @@ static void GlobalLightUpdate(Actor *this, double /*delta*/)
 		GetState()->map->lightColor.g = lerp(interpolationPreviousColor.g, data->lightColor.g, interpolationFactor);
 		GetState()->map->lightColor.b = lerp(interpolationPreviousColor.b, data->lightColor.b, interpolationFactor);
 		GetState()->map->lightColor.a = lerp(interpolationPreviousColor.a, data->lightColor.a, interpolationFactor);
-		GetState()->map->changeFlags |= MAP_LIGHT_CHANGED;
 		if (ticksIntoInterpolation == data->interpolationTicks)
 		{
 			interpolatingActor = NULL;
@@ -73,7 +71,6 @@ static void GlobalLightSetHandler(Actor *this, const Actor * /*sender*/, const P
 	{
 		interpolatingActor = NULL; // stop any existing interpolation, but don't start a new one
 		GetState()->map->lightColor = data->lightColor;
-		GetState()->map->changeFlags |= MAP_LIGHT_CHANGED;
 	} else
 	{
 		interpolatingActor = this;
@@ -87,7 +84,6 @@ static void GlobalLightSetInstantHandler(Actor *this, const Actor * /*sender*/,
 	const GlobalLightData *data = this->extraData;
 	interpolatingActor = NULL; // stop any existing interpolation, but don't start a new one
 	GetState()->map->lightColor = data->lightColor;
-	GetState()->map->changeFlags |= MAP_LIGHT_CHANGED;
 }
 
 void GlobalLightDestroy(Actor *this)
@@ -135,6 +135,7 @@ void AssetCacheInit()
 {
 	LogDebug("Initializing asset cache...\n");
 	AssetCache_init(assetCache);
+	InitTextureLoader();
 	InitModelLoader();
 }
 
@@ -7,8 +7,12 @@
 #include <engine/assets/DataReader.h>
 #include <engine/assets/MapLoader.h>
 #include <engine/assets/MapMaterialLoader.h>
+#include <engine/assets/MapModelLoader.h>
 #include <engine/assets/ModelLoader.h>
+#include <engine/graphics/Bvh.h>
+#include <engine/graphics/Culling.h>
 #include <engine/graphics/RenderingHelpers.h>
+#include <engine/helpers/MathEx.h>
 #include <engine/physics/Physics.h>
 #include <engine/physics/PlayerPhysics.h>
 #include <engine/structs/Actor.h>
@@ -21,6 +25,8 @@
 #include <engine/structs/Map.h>
 #include <engine/structs/Vector2.h>
 #include <engine/subsystem/Error.h>
+#include <engine/subsystem/Logging.h>
+#include <engine/subsystem/Timing.h>
 #include <joltc/enums.h>
 #include <joltc/joltc.h>
 #include <joltc/Math/Quat.h>
@@ -30,6 +36,7 @@
 #include <joltc/Physics/Body/BodyID.h>
 #include <joltc/Physics/Body/BodyInterface.h>
 #include <joltc/Physics/Collision/Shape/Shape.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -37,12 +44,165 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Get the bounding box of one triangle of a map model
+ * @param model The model
+ * @param indices The three indices of the triangle
+ * @param center Where to write the center of the box
+ * @param extents Where to write the half size of the box
+ */
+static inline void MapTriangleBounds(const MapModel *model,
+									 const uint32_t *indices,
+									 Vector3 *center,
+									 Vector3 *extents)
+{
+	if (indices[0] >= model->vertexCount || indices[1] >= model->vertexCount || indices[2] >= model->vertexCount)
+	{
+		*center = Vector3_Zero;
+		*extents = Vector3_Zero;
+		return;
+	}
+	const Vector3 *a = &model->vertices[indices[0]].position;
+	const Vector3 *b = &model->vertices[indices[1]].position;
+	const Vector3 *c = &model->vertices[indices[2]].position;
+	const Vector3 minimum = {
+		fminf(a->x, fminf(b->x, c->x)),
+		fminf(a->y, fminf(b->y, c->y)),
+		fminf(a->z, fminf(b->z, c->z)),
+	};
+	const Vector3 maximum = {
+		fmaxf(a->x, fmaxf(b->x, c->x)),
+		fmaxf(a->y, fmaxf(b->y, c->y)),
+		fmaxf(a->z, fmaxf(b->z, c->z)),
+	};
+	*center = (Vector3){
+		(minimum.x + maximum.x) / 2.0f,
+		(minimum.y + maximum.y) / 2.0f,
+		(minimum.z + maximum.z) / 2.0f,
+	};
+	*extents = (Vector3){
+		(maximum.x - minimum.x) / 2.0f,
+		(maximum.y - minimum.y) / 2.0f,
+		(maximum.z - minimum.z) / 2.0f,
+	};
+}
+
+/**
+ * Split the triangles of one map model into clusters of nearby triangles, reordering the indices of the model so that
+ * the triangles of each cluster are next to each other
+ * @param map The map to add the clusters to
+ * @param modelIndex The index of the model in the map
+ * @param clusterCapacity The number of clusters that @c map->clusters has space for
+ */
+static void BuildMapModelClusters(Map *map, const size_t modelIndex, size_t *clusterCapacity)
+{
+	MapModel *model = map->models + modelIndex;
+	const uint32_t triangleCount = model->indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+	Vector3 *centers = malloc(triangleCount * sizeof(Vector3));
+	CheckAlloc(centers);
+	Vector3 *extents = malloc(triangleCount * sizeof(Vector3));
+	CheckAlloc(extents);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		MapTriangleBounds(model, model->indices + i * 3, centers + i, extents + i);
+	}
+
+	// The leaves of a hierarchy over the triangles are compact groups of at most MAP_CLUSTER_MAX_TRIANGLES triangles
+	Bvh triangleBvh;
+	BvhBuild(&triangleBvh, centers, extents, triangleCount, MAP_CLUSTER_MAX_TRIANGLES);
+	uint32_t *indices = malloc(model->indexCount * sizeof(uint32_t));
+	CheckAlloc(indices);
+	uint32_t indexOffset = 0;
+	for (size_t i = 0; i < triangleBvh.nodeCount; i++)
+	{
+		const BvhNode *node = &triangleBvh.nodes[i];
+		if (node->firstChild != 0)
+		{
+			continue;
+		}
+		if (map->clusterCount == *clusterCapacity)
+		{
+			*clusterCapacity = max(*clusterCapacity * 2, 64);
+			MapCluster *clusters = realloc(map->clusters, *clusterCapacity * sizeof(MapCluster));
+			CheckAlloc(clusters);
+			map->clusters = clusters;
+		}
+		map->clusters[map->clusterCount++] = (MapCluster){
+			.model = modelIndex,
+			.firstIndex = indexOffset,
+			.indexCount = node->itemCount * 3,
+			.center = node->center,
+			.extents = node->extents,
+		};
+		for (uint32_t j = 0; j < node->itemCount; j++)
+		{
+			memcpy(indices + indexOffset,
+				   model->indices + triangleBvh.items[node->firstItem + j] * 3,
+				   3 * sizeof(uint32_t));
+			indexOffset += 3;
+		}
+	}
+	// Any indices that don't make up a whole triangle are kept at the end
+	memcpy(indices + indexOffset,
+		   model->indices + triangleCount * 3,
+		   (model->indexCount - triangleCount * 3) * sizeof(uint32_t));
+	free(model->indices);
+	model->indices = indices;
+
+	BvhFree(&triangleBvh);
+	free(centers);
+	free(extents);
+}
+
+/**
+ * Split every map model into clusters and build the cluster BVH of the map
+ * @param map The map, which must have the vertices and indices of its models
+ */
+static void BuildMapClusters(Map *map)
+{
+	const uint64_t startTime = GetTimeNs();
+	size_t clusterCapacity = 0;
+	for (size_t i = 0; i < map->modelCount; i++)
+	{
+		BuildMapModelClusters(map, i, &clusterCapacity);
+	}
+
+	Vector3 *centers = malloc(max(map->clusterCount, 1) * sizeof(Vector3));
+	CheckAlloc(centers);
+	Vector3 *extents = malloc(max(map->clusterCount, 1) * sizeof(Vector3));
+	CheckAlloc(extents);
+	for (size_t i = 0; i < map->clusterCount; i++)
+	{
+		centers[i] = map->clusters[i].center;
+		extents[i] = map->clusters[i].extents;
+	}
+	BvhBuild(&map->clusterBvh, centers, extents, map->clusterCount, 1);
+	free(centers);
+	free(extents);
+
+	LogInfo("Split map models into %zu clusters and built the cluster BVH with %zu nodes in %.2f ms\n",
+			map->clusterCount,
+			map->clusterBvh.nodeCount,
+			(double)(GetTimeNs() - startTime) / 1000000.0);
+}
+
 bool LoadMap(Map *map, Asset *mapData)
 {
 	if (!map || !mapData)
 	{
 		return false;
 	}
+	if (mapData->typeVersion != MAP_ASSET_VERSION && mapData->typeVersion != MAP_ASSET_VERSION_FLOAT_UVS)
+	{
+		LogError("Failed to load map from asset due to version mismatch (got %d, expected %d)\n",
+				 mapData->typeVersion,
+				 MAP_ASSET_VERSION);
+		return false;
+	}
 
 	DataReader *reader = CreateDataReaderFromAsset(mapData);
 
@@ -172,30 +332,17 @@ bool LoadMap(Map *map, Asset *mapData)
 		assert(model->material);
 		free(materialName);
 
-		EXPECT_BYTES_BOOL(sizeof(uint32_t), bytesRemaining);
-		model->vertexCount = ReadUint32(reader);
-		model->vertices = malloc(sizeof(MapVertex) * model->vertexCount);
-		CheckAlloc(model->vertices);
-		for (uint32_t j = 0; j < model->vertexCount; j++)
+		const bool modelLoaded = mapData->typeVersion == MAP_ASSET_VERSION_FLOAT_UVS
+										 ? ReadFloatMapModel(reader, model, &bytesRemaining)
+										 : ReadQuantizedMapModel(reader, model, &bytesRemaining);
+		if (!modelLoaded)
 		{
-			MapVertex *vertex = model->vertices + j;
-			EXPECT_BYTES_BOOL(sizeof(float) * 7, bytesRemaining);
-			vertex->position.x = ReadFloat(reader);
-			vertex->position.y = ReadFloat(reader);
-			vertex->position.z = ReadFloat(reader);
-			vertex->uv.x = ReadFloat(reader);
-			vertex->uv.y = ReadFloat(reader);
-			vertex->lightmapUv.x = ReadFloat(reader);
-			vertex->lightmapUv.y = ReadFloat(reader);
+			LogError("Failed to read map model %zu!\n", i);
+			return false;
 		}
-		EXPECT_BYTES_BOOL(sizeof(uint32_t), bytesRemaining);
-		model->indexCount = ReadUint32(reader);
-		EXPECT_BYTES_BOOL(sizeof(uint32_t) * model->indexCount, bytesRemaining);
-		model->indices = malloc(sizeof(uint32_t) * model->indexCount);
-		CheckAlloc(model->indices);
-		ReadBuffer(reader, sizeof(uint32_t) * model->indexCount, model->indices);
 	}
-
+	BuildMapClusters(map);
+	ExtractOccluders(map);
 
 	Transform collisionXfm = {
 		.rotation = JPH_Quat_Identity,
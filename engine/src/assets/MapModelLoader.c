@@ -0,0 +1,125 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/assets/AssetReader.h>
+#include <engine/assets/DataReader.h>
+#include <engine/assets/MapModelLoader.h>
+#include <engine/structs/Map.h>
+#include <engine/structs/Vector2.h>
+#include <engine/subsystem/Error.h>
+#include <engine/subsystem/Logging.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Check whether every index of a map model can be stored in 16 bits
+ * @param model The model to check, which must already have its vertices loaded
+ */
+static inline bool MapModelFitsShortIndices(const MapModel *model)
+{
+	return model->vertexCount <= UINT16_MAX + 1;
+}
+
+uint16_t QuantizeUnorm16(const float value)
+{
+	if (value <= 0.0f)
+	{
+		return 0;
+	}
+	if (value >= 1.0f)
+	{
+		return UINT16_MAX;
+	}
+	return (uint16_t)lroundf(value * UINT16_MAX);
+}
+
+float DequantizeUnorm16(const uint16_t value, const float min, const float max)
+{
+	return min + ((float)value / UINT16_MAX) * (max - min);
+}
+
+bool ReadFloatMapModel(DataReader *reader, MapModel *model, size_t *bytesRemaining)
+{
+	EXPECT_BYTES_BOOL(sizeof(uint32_t), *bytesRemaining);
+	model->vertexCount = ReadUint32(reader);
+	model->vertices = malloc(sizeof(MapVertex) * model->vertexCount);
+	CheckAlloc(model->vertices);
+	EXPECT_BYTES_BOOL(sizeof(float) * 7 * model->vertexCount, *bytesRemaining);
+	for (uint32_t i = 0; i < model->vertexCount; i++)
+	{
+		MapVertex *vertex = model->vertices + i;
+		vertex->position.x = ReadFloat(reader);
+		vertex->position.y = ReadFloat(reader);
+		vertex->position.z = ReadFloat(reader);
+		vertex->uv.x = ReadFloat(reader);
+		vertex->uv.y = ReadFloat(reader);
+		vertex->lightmapUv[0] = QuantizeUnorm16(ReadFloat(reader));
+		vertex->lightmapUv[1] = QuantizeUnorm16(ReadFloat(reader));
+	}
+
+	EXPECT_BYTES_BOOL(sizeof(uint32_t), *bytesRemaining);
+	model->indexCount = ReadUint32(reader);
+	EXPECT_BYTES_BOOL(sizeof(uint32_t) * model->indexCount, *bytesRemaining);
+	model->indices = malloc(sizeof(uint32_t) * model->indexCount);
+	CheckAlloc(model->indices);
+	ReadBuffer(reader, sizeof(uint32_t) * model->indexCount, model->indices);
+	model->shortIndices = MapModelFitsShortIndices(model);
+
+	return true;
+}
+
+bool ReadQuantizedMapModel(DataReader *reader, MapModel *model, size_t *bytesRemaining)
+{
+	EXPECT_BYTES_BOOL(sizeof(uint32_t) + sizeof(float) * 4, *bytesRemaining);
+	model->vertexCount = ReadUint32(reader);
+	Vector2 uvMin;
+	Vector2 uvMax;
+	uvMin.x = ReadFloat(reader);
+	uvMin.y = ReadFloat(reader);
+	uvMax.x = ReadFloat(reader);
+	uvMax.y = ReadFloat(reader);
+	model->vertices = malloc(sizeof(MapVertex) * model->vertexCount);
+	CheckAlloc(model->vertices);
+	EXPECT_BYTES_BOOL((sizeof(float) * 3 + sizeof(uint16_t) * 4) * model->vertexCount, *bytesRemaining);
+	for (uint32_t i = 0; i < model->vertexCount; i++)
+	{
+		MapVertex *vertex = model->vertices + i;
+		vertex->position.x = ReadFloat(reader);
+		vertex->position.y = ReadFloat(reader);
+		vertex->position.z = ReadFloat(reader);
+		vertex->uv.x = DequantizeUnorm16(ReadUint16(reader), uvMin.x, uvMax.x);
+		vertex->uv.y = DequantizeUnorm16(ReadUint16(reader), uvMin.y, uvMax.y);
+		vertex->lightmapUv[0] = ReadUint16(reader);
+		vertex->lightmapUv[1] = ReadUint16(reader);
+	}
+
+	EXPECT_BYTES_BOOL(sizeof(uint8_t) + sizeof(uint32_t), *bytesRemaining);
+	const uint8_t indexSize = ReadUint8(reader);
+	model->indexCount = ReadUint32(reader);
+	model->indices = malloc(sizeof(uint32_t) * model->indexCount);
+	CheckAlloc(model->indices);
+	switch (indexSize)
+	{
+		case sizeof(uint16_t):
+			EXPECT_BYTES_BOOL(sizeof(uint16_t) * model->indexCount, *bytesRemaining);
+			for (uint32_t i = 0; i < model->indexCount; i++)
+			{
+				model->indices[i] = ReadUint16(reader);
+			}
+			break;
+		case sizeof(uint32_t):
+			EXPECT_BYTES_BOOL(sizeof(uint32_t) * model->indexCount, *bytesRemaining);
+			ReadBuffer(reader, sizeof(uint32_t) * model->indexCount, model->indices);
+			break;
+		default:
+			LogError("Invalid map model index size %d\n", indexSize);
+			return false;
+	}
+	model->shortIndices = MapModelFitsShortIndices(model);
+
+	return true;
+}
@@ -0,0 +1,1265 @@
+//
+// Created by droc101 on 10/18/26.
+//
+
+#include <assert.h>
+#include <engine/assets/TextureCompression.h>
+#include <engine/assets/TextureLoader.h>
+#include <engine/helpers/MathEx.h>
+#include <engine/subsystem/Error.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_PIXEL_COUNT (TEXTURE_BLOCK_SIZE * TEXTURE_BLOCK_SIZE)
+
+/// The half float bit pattern for 1.0
+#define HALF_ONE 0x3C00
+/// The largest finite half float bit pattern
+#define HALF_MAX 0x7BFF
+
+typedef struct BlockBits BlockBits;
+typedef struct Bc6hModeInfo Bc6hModeInfo;
+typedef struct Bc6hBitField Bc6hBitField;
+typedef struct Bc7ModeInfo Bc7ModeInfo;
+
+/// A cursor into the 128 (or 64) bits of a single block, reading or writing from the least significant bit up
+struct BlockBits
+{
+	uint8_t *data;
+	uint32_t position;
+};
+
+struct Bc7ModeInfo
+{
+	/// The number of subsets
+	uint8_t subsets;
+	/// The number of bits used to select the partition
+	uint8_t partitionBits;
+	/// The number of bits used to select the channel rotation
+	uint8_t rotationBits;
+	/// The number of bits used to select which index set is used for color
+	uint8_t indexSelectionBits;
+	/// The number of bits per color channel of each endpoint
+	uint8_t colorBits;
+	/// The number of bits for the alpha channel of each endpoint
+	uint8_t alphaBits;
+	/// Whether every endpoint has its own p-bit
+	bool endpointPBits;
+	/// Whether each subset has a p-bit shared by both of its endpoints
+	bool sharedPBits;
+	/// The number of bits per primary index
+	uint8_t indexBits;
+	/// The number of bits per secondary index, or 0 if there is only one index set
+	uint8_t secondaryIndexBits;
+};
+
+/// The fields that BC6H endpoints are scattered across, named as in the format specification
+enum Bc6hField
+{
+	BC6H_RW,
+	BC6H_GW,
+	BC6H_BW,
+	BC6H_RX,
+	BC6H_GX,
+	BC6H_BX,
+	BC6H_RY,
+	BC6H_GY,
+	BC6H_BY,
+	BC6H_RZ,
+	BC6H_GZ,
+	BC6H_BZ,
+	BC6H_D,
+	BC6H_END,
+};
+
+/// A run of bits of one endpoint field, stored least significant bit first starting at @c shift
+struct Bc6hBitField
+{
+	uint8_t field;
+	uint8_t shift;
+	uint8_t count;
+};
+
+struct Bc6hModeInfo
+{
+	/// The mode bits of this mode
+	uint8_t mode;
+	/// The number of subsets
+	uint8_t subsets;
+	/// Whether the non-base endpoints are stored as deltas from the base endpoint
+	bool transformed;
+	/// The number of bits of the base endpoint
+	uint8_t endpointBits;
+	/// The number of bits of each delta, per channel
+	uint8_t deltaBits[3];
+	/// The layout of the header bits following the mode bits
+	Bc6hBitField layout[32];
+};
+
+#pragma region Tables
+
+static const uint8_t WEIGHTS_2[4] = {0, 21, 43, 64};
+static const uint8_t WEIGHTS_3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static const uint8_t WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+/// One bit per pixel giving the subset of each pixel in the two subset partitions
+static const uint16_t PARTITIONS_2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8,
+	0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110,
+	0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696,
+	0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4, 0x4E40, 0x2720,
+	0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+/// Two bits per pixel giving the subset of each pixel in the three subset partitions
+static const uint32_t PARTITIONS_3[64] = {
+	0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+	0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+	0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+	0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+	0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+	0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+	0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+	0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+};
+
+/// The anchor pixel of the second subset in the two subset partitions
+static const uint8_t ANCHORS_2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8,
+	8, 15, 2, 8, 2, 2, 8, 8, 2, 2, 15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2,
+	2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+};
+
+/// The anchor pixel of the second subset in the three subset partitions
+static const uint8_t ANCHORS_3_SECOND[64] = {
+	3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8, 15, 3, 3,
+	6, 10, 5, 8, 8, 6, 8, 5, 15, 15, 8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5,
+	15, 15, 15, 15, 3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+};
+
+/// The anchor pixel of the third subset in the three subset partitions
+static const uint8_t ANCHORS_3_THIRD[64] = {
+	15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, 15, 8, 15, 3, 15, 8,
+	15, 8, 3, 15, 6, 10, 15, 15, 10, 8, 15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15,
+	3, 6, 6, 8, 15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+};
+
+static const Bc7ModeInfo BC7_MODES[8] = {
+	{3, 4, 0, 0, 4, 0, true, false, 3, 0},
+	{2, 6, 0, 0, 6, 0, false, true, 3, 0},
+	{3, 6, 0, 0, 5, 0, false, false, 2, 0},
+	{2, 6, 0, 0, 7, 0, true, false, 2, 0},
+	{1, 0, 2, 1, 5, 6, false, false, 2, 3},
+	{1, 0, 2, 0, 7, 8, false, false, 2, 2},
+	{1, 0, 0, 0, 7, 7, true, false, 4, 0},
+	{2, 6, 0, 0, 5, 5, true, false, 2, 0},
+};
+
+#define BITS(field, shift, count) {BC6H_##field, (shift), (count)}
+static const Bc6hModeInfo BC6H_MODES[14] = {
+	{
+		.mode = 0x00,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 10,
+		.deltaBits = {5, 5, 5},
+		.layout = {
+			BITS(GY, 4, 1), BITS(BY, 4, 1), BITS(BZ, 4, 1), BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10),
+			BITS(RX, 0, 5), BITS(GZ, 4, 1), BITS(GY, 0, 4), BITS(GX, 0, 5), BITS(BZ, 0, 1), BITS(GZ, 0, 4),
+			BITS(BX, 0, 5), BITS(BZ, 1, 1), BITS(BY, 0, 4), BITS(RY, 0, 5), BITS(BZ, 2, 1), BITS(RZ, 0, 5),
+			BITS(BZ, 3, 1), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x01,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 7,
+		.deltaBits = {6, 6, 6},
+		.layout = {
+			BITS(GY, 5, 1), BITS(GZ, 4, 1), BITS(GZ, 5, 1), BITS(RW, 0, 7), BITS(BZ, 0, 1), BITS(BZ, 1, 1),
+			BITS(BY, 4, 1), BITS(GW, 0, 7), BITS(BY, 5, 1), BITS(BZ, 2, 1), BITS(GY, 4, 1), BITS(BW, 0, 7),
+			BITS(BZ, 3, 1), BITS(BZ, 5, 1), BITS(BZ, 4, 1), BITS(RX, 0, 6), BITS(GY, 0, 4), BITS(GX, 0, 6),
+			BITS(GZ, 0, 4), BITS(BX, 0, 6), BITS(BY, 0, 4), BITS(RY, 0, 6), BITS(RZ, 0, 6), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x02,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 11,
+		.deltaBits = {5, 4, 4},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 5), BITS(RW, 10, 1), BITS(GY, 0, 4),
+			BITS(GX, 0, 4), BITS(GW, 10, 1), BITS(BZ, 0, 1), BITS(GZ, 0, 4), BITS(BX, 0, 4), BITS(BW, 10, 1),
+			BITS(BZ, 1, 1), BITS(BY, 0, 4), BITS(RY, 0, 5), BITS(BZ, 2, 1), BITS(RZ, 0, 5), BITS(BZ, 3, 1),
+			BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x06,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 11,
+		.deltaBits = {4, 5, 4},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 4), BITS(RW, 10, 1), BITS(GZ, 4, 1),
+			BITS(GY, 0, 4), BITS(GX, 0, 5), BITS(GW, 10, 1), BITS(GZ, 0, 4), BITS(BX, 0, 4), BITS(BW, 10, 1),
+			BITS(BZ, 1, 1), BITS(BY, 0, 4), BITS(RY, 0, 4), BITS(BZ, 0, 1), BITS(BZ, 2, 1), BITS(RZ, 0, 4),
+			BITS(GY, 4, 1), BITS(BZ, 3, 1), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x0A,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 11,
+		.deltaBits = {4, 4, 5},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 4), BITS(RW, 10, 1), BITS(BY, 4, 1),
+			BITS(GY, 0, 4), BITS(GX, 0, 4), BITS(GW, 10, 1), BITS(BZ, 0, 1), BITS(GZ, 0, 4), BITS(BX, 0, 5),
+			BITS(BW, 10, 1), BITS(BY, 0, 4), BITS(RY, 0, 4), BITS(BZ, 1, 1), BITS(BZ, 2, 1), BITS(RZ, 0, 4),
+			BITS(BZ, 4, 1), BITS(BZ, 3, 1), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x0E,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 9,
+		.deltaBits = {5, 5, 5},
+		.layout = {
+			BITS(RW, 0, 9), BITS(BY, 4, 1), BITS(GW, 0, 9), BITS(GY, 4, 1), BITS(BW, 0, 9), BITS(BZ, 4, 1),
+			BITS(RX, 0, 5), BITS(GZ, 4, 1), BITS(GY, 0, 4), BITS(GX, 0, 5), BITS(BZ, 0, 1), BITS(GZ, 0, 4),
+			BITS(BX, 0, 5), BITS(BZ, 1, 1), BITS(BY, 0, 4), BITS(RY, 0, 5), BITS(BZ, 2, 1), BITS(RZ, 0, 5),
+			BITS(BZ, 3, 1), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x12,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 8,
+		.deltaBits = {6, 5, 5},
+		.layout = {
+			BITS(RW, 0, 8), BITS(GZ, 4, 1), BITS(BY, 4, 1), BITS(GW, 0, 8), BITS(BZ, 2, 1), BITS(GY, 4, 1),
+			BITS(BW, 0, 8), BITS(BZ, 3, 1), BITS(BZ, 4, 1), BITS(RX, 0, 6), BITS(GY, 0, 4), BITS(GX, 0, 5),
+			BITS(BZ, 0, 1), BITS(GZ, 0, 4), BITS(BX, 0, 5), BITS(BZ, 1, 1), BITS(BY, 0, 4), BITS(RY, 0, 6),
+			BITS(RZ, 0, 6), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x16,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 8,
+		.deltaBits = {5, 6, 5},
+		.layout = {
+			BITS(RW, 0, 8), BITS(BZ, 0, 1), BITS(BY, 4, 1), BITS(GW, 0, 8), BITS(GY, 5, 1), BITS(GY, 4, 1),
+			BITS(BW, 0, 8), BITS(GZ, 5, 1), BITS(BZ, 4, 1), BITS(RX, 0, 5), BITS(GZ, 4, 1), BITS(GY, 0, 4),
+			BITS(GX, 0, 6), BITS(GZ, 0, 4), BITS(BX, 0, 5), BITS(BZ, 1, 1), BITS(BY, 0, 4), BITS(RY, 0, 5),
+			BITS(BZ, 2, 1), BITS(RZ, 0, 5), BITS(BZ, 3, 1), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x1A,
+		.subsets = 2,
+		.transformed = true,
+		.endpointBits = 8,
+		.deltaBits = {5, 5, 6},
+		.layout = {
+			BITS(RW, 0, 8), BITS(BZ, 1, 1), BITS(BY, 4, 1), BITS(GW, 0, 8), BITS(BY, 5, 1), BITS(GY, 4, 1),
+			BITS(BW, 0, 8), BITS(BZ, 5, 1), BITS(BZ, 4, 1), BITS(RX, 0, 5), BITS(GZ, 4, 1), BITS(GY, 0, 4),
+			BITS(GX, 0, 5), BITS(BZ, 0, 1), BITS(GZ, 0, 4), BITS(BX, 0, 6), BITS(BY, 0, 4), BITS(RY, 0, 5),
+			BITS(BZ, 2, 1), BITS(RZ, 0, 5), BITS(BZ, 3, 1), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x1E,
+		.subsets = 2,
+		.transformed = false,
+		.endpointBits = 6,
+		.deltaBits = {6, 6, 6},
+		.layout = {
+			BITS(RW, 0, 6), BITS(GZ, 4, 1), BITS(BZ, 0, 1), BITS(BZ, 1, 1), BITS(BY, 4, 1), BITS(GW, 0, 6),
+			BITS(GY, 5, 1), BITS(BY, 5, 1), BITS(BZ, 2, 1), BITS(GY, 4, 1), BITS(BW, 0, 6), BITS(GZ, 5, 1),
+			BITS(BZ, 3, 1), BITS(BZ, 5, 1), BITS(BZ, 4, 1), BITS(RX, 0, 6), BITS(GY, 0, 4), BITS(GX, 0, 6),
+			BITS(GZ, 0, 4), BITS(BX, 0, 6), BITS(BY, 0, 4), BITS(RY, 0, 6), BITS(RZ, 0, 6), BITS(D, 0, 5),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x03,
+		.subsets = 1,
+		.transformed = false,
+		.endpointBits = 10,
+		.deltaBits = {10, 10, 10},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 10), BITS(GX, 0, 10), BITS(BX, 0, 10),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x07,
+		.subsets = 1,
+		.transformed = true,
+		.endpointBits = 11,
+		.deltaBits = {9, 9, 9},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 9), BITS(RW, 10, 1), BITS(GX, 0, 9),
+			BITS(GW, 10, 1), BITS(BX, 0, 9), BITS(BW, 10, 1),
+			{BC6H_END, 0, 0},
+		},
+	},
+	// The high bits of the base endpoints in the last two modes are stored most significant bit first
+	{
+		.mode = 0x0B,
+		.subsets = 1,
+		.transformed = true,
+		.endpointBits = 12,
+		.deltaBits = {8, 8, 8},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 8), BITS(RW, 11, 1), BITS(RW, 10, 1),
+			BITS(GX, 0, 8), BITS(GW, 11, 1), BITS(GW, 10, 1), BITS(BX, 0, 8), BITS(BW, 11, 1), BITS(BW, 10, 1),
+			{BC6H_END, 0, 0},
+		},
+	},
+	{
+		.mode = 0x0F,
+		.subsets = 1,
+		.transformed = true,
+		.endpointBits = 16,
+		.deltaBits = {4, 4, 4},
+		.layout = {
+			BITS(RW, 0, 10), BITS(GW, 0, 10), BITS(BW, 0, 10), BITS(RX, 0, 4), BITS(RW, 15, 1), BITS(RW, 14, 1),
+			BITS(RW, 13, 1), BITS(RW, 12, 1), BITS(RW, 11, 1), BITS(RW, 10, 1), BITS(GX, 0, 4), BITS(GW, 15, 1),
+			BITS(GW, 14, 1), BITS(GW, 13, 1), BITS(GW, 12, 1), BITS(GW, 11, 1), BITS(GW, 10, 1), BITS(BX, 0, 4),
+			BITS(BW, 15, 1), BITS(BW, 14, 1), BITS(BW, 13, 1), BITS(BW, 12, 1), BITS(BW, 11, 1), BITS(BW, 10, 1),
+			{BC6H_END, 0, 0},
+		},
+	},
+};
+#undef BITS
+
+/// The BC6H mode used by the reference encoder, which has a single subset with 10 bit endpoints
+#define BC6H_ENCODER_MODE 10
+/// The BC7 mode used by the reference encoder, which has a single subset with RGBA endpoints and 4 bit indices
+#define BC7_ENCODER_MODE 6
+
+#pragma endregion
+
+#pragma region Helpers
+
+static inline uint32_t ReadBits(BlockBits *bits, const uint32_t count)
+{
+	uint32_t value = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t bit = (bits->data[bits->position >> 3] >> (bits->position & 7)) & 1;
+		value |= bit << i;
+		bits->position++;
+	}
+	return value;
+}
+
+static inline void WriteBits(BlockBits *bits, const uint32_t value, const uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if ((value >> i) & 1)
+		{
+			bits->data[bits->position >> 3] |= (uint8_t)(1 << (bits->position & 7));
+		}
+		bits->position++;
+	}
+}
+
+static inline uint8_t Interpolate(const uint32_t a, const uint32_t b, const uint8_t weight)
+{
+	return (uint8_t)((a * (64 - weight) + b * weight + 32) >> 6);
+}
+
+static inline const uint8_t *GetWeights(const uint8_t indexBits)
+{
+	switch (indexBits)
+	{
+		case 2:
+			return WEIGHTS_2;
+		case 3:
+			return WEIGHTS_3;
+		default:
+			return WEIGHTS_4;
+	}
+}
+
+static inline uint8_t GetSubset(const uint8_t subsets, const uint8_t partition, const uint8_t pixel)
+{
+	switch (subsets)
+	{
+		case 2:
+			return (PARTITIONS_2[partition] >> pixel) & 1;
+		case 3:
+			return (PARTITIONS_3[partition] >> (pixel * 2)) & 3;
+		default:
+			return 0;
+	}
+}
+
+static inline bool IsAnchor(const uint8_t subsets, const uint8_t partition, const uint8_t pixel)
+{
+	switch (subsets)
+	{
+		case 2:
+			return pixel == 0 || pixel == ANCHORS_2[partition];
+		case 3:
+			return pixel == 0 || pixel == ANCHORS_3_SECOND[partition] || pixel == ANCHORS_3_THIRD[partition];
+		default:
+			return pixel == 0;
+	}
+}
+
+static inline uint32_t ColorDistance(const uint8_t *a, const uint8_t *b, const uint8_t channels)
+{
+	uint32_t distance = 0;
+	for (uint8_t i = 0; i < channels; i++)
+	{
+		const int32_t difference = (int32_t)a[i] - (int32_t)b[i];
+		distance += (uint32_t)(difference * difference);
+	}
+	return distance;
+}
+
+static inline uint16_t PackRgb565(const uint8_t *color)
+{
+	return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static inline void UnpackRgb565(const uint16_t packed, uint8_t *color)
+{
+	const uint8_t r = (packed >> 11) & 0x1F;
+	const uint8_t g = (packed >> 5) & 0x3F;
+	const uint8_t b = packed & 0x1F;
+	color[0] = (uint8_t)((r << 3) | (r >> 2));
+	color[1] = (uint8_t)((g << 2) | (g >> 4));
+	color[2] = (uint8_t)((b << 3) | (b >> 2));
+	color[3] = 0xFF;
+}
+
+static inline size_t GetBlockSize(const ImagePixelFormat format)
+{
+	return format == PIXEL_FORMAT_BC1 ? 8 : 16;
+}
+
+#pragma endregion
+
+#pragma region BC1-BC5
+
+/**
+ * Build the palette of a BC1 color block
+ * @param color0 The first endpoint
+ * @param color1 The second endpoint
+ * @param forceFourColors Whether to ignore the endpoint order and always use four colors, as BC3 does
+ * @param palette The four RGBA colors of the palette
+ */
+static void GetBc1Palette(const uint16_t color0, const uint16_t color1, const bool forceFourColors, uint8_t palette[4][4])
+{
+	UnpackRgb565(color0, palette[0]);
+	UnpackRgb565(color1, palette[1]);
+	if (color0 > color1 || forceFourColors)
+	{
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			palette[2][i] = (uint8_t)((2 * palette[0][i] + palette[1][i]) / 3);
+			palette[3][i] = (uint8_t)((palette[0][i] + 2 * palette[1][i]) / 3);
+		}
+		palette[2][3] = 0xFF;
+		palette[3][3] = 0xFF;
+	} else
+	{
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			palette[2][i] = (uint8_t)((palette[0][i] + palette[1][i]) / 2);
+		}
+		palette[2][3] = 0xFF;
+		memset(palette[3], 0, sizeof(palette[3]));
+	}
+}
+
+static void DecodeBc1Block(const uint8_t *block, const bool forceFourColors, uint8_t *pixels, const size_t stride)
+{
+	const uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+	const uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+	uint8_t palette[4][4];
+	GetBc1Palette(color0, color1, forceFourColors, palette);
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const uint8_t index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+		memcpy(pixels + (i / 4) * stride + (i % 4) * 4, palette[index], 4);
+	}
+}
+
+/**
+ * Decode a BC4 block into one channel of an RGBA8 block
+ * @param block The BC4 block
+ * @param pixels The first channel of the first pixel to write to
+ * @param stride The number of bytes between rows
+ */
+static void DecodeBc4Block(const uint8_t *block, uint8_t *pixels, const size_t stride)
+{
+	uint8_t palette[8] = {block[0], block[1]};
+	if (palette[0] > palette[1])
+	{
+		for (uint8_t i = 1; i < 7; i++)
+		{
+			palette[i + 1] = (uint8_t)(((7 - i) * palette[0] + i * palette[1]) / 7);
+		}
+	} else
+	{
+		for (uint8_t i = 1; i < 5; i++)
+		{
+			palette[i + 1] = (uint8_t)(((5 - i) * palette[0] + i * palette[1]) / 5);
+		}
+		palette[6] = 0;
+		palette[7] = 0xFF;
+	}
+
+	uint64_t indices = 0;
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		indices |= (uint64_t)block[2 + i] << (i * 8);
+	}
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		pixels[(i / 4) * stride + (i % 4) * 4] = palette[(indices >> (i * 3)) & 7];
+	}
+}
+
+static void EncodeBc1Block(const uint8_t pixels[BLOCK_PIXEL_COUNT][4], const bool allowAlpha, uint8_t *block)
+{
+	uint8_t minColor[3] = {0xFF, 0xFF, 0xFF};
+	uint8_t maxColor[3] = {0, 0, 0};
+	bool hasTransparency = false;
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		if (allowAlpha && pixels[i][3] < 0x80)
+		{
+			hasTransparency = true;
+			continue;
+		}
+		for (uint8_t j = 0; j < 3; j++)
+		{
+			minColor[j] = min(minColor[j], pixels[i][j]);
+			maxColor[j] = max(maxColor[j], pixels[i][j]);
+		}
+	}
+	// Inset the bounding box slightly to reduce the error of the interpolated colors
+	for (uint8_t j = 0; j < 3; j++)
+	{
+		if (minColor[j] <= maxColor[j])
+		{
+			const uint8_t inset = (uint8_t)((maxColor[j] - minColor[j]) / 16);
+			minColor[j] += inset;
+			maxColor[j] -= inset;
+		}
+	}
+
+	uint16_t color0 = PackRgb565(maxColor);
+	uint16_t color1 = PackRgb565(minColor);
+	// Four color mode is selected by color0 > color1, three color mode with transparency otherwise
+	if ((color0 < color1) != hasTransparency)
+	{
+		const uint16_t temp = color0;
+		color0 = color1;
+		color1 = temp;
+	}
+	uint8_t palette[4][4];
+	GetBc1Palette(color0, color1, false, palette);
+	const uint8_t colorCount = color0 > color1 ? 4 : 3;
+
+	uint32_t indices = 0;
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		uint32_t bestIndex = 3;
+		if (!hasTransparency || pixels[i][3] >= 0x80)
+		{
+			uint32_t bestDistance = UINT32_MAX;
+			for (uint8_t j = 0; j < colorCount; j++)
+			{
+				const uint32_t distance = ColorDistance(pixels[i], palette[j], 3);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = j;
+				}
+			}
+		}
+		indices |= bestIndex << (i * 2);
+	}
+
+	block[0] = (uint8_t)color0;
+	block[1] = (uint8_t)(color0 >> 8);
+	block[2] = (uint8_t)color1;
+	block[3] = (uint8_t)(color1 >> 8);
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		block[4 + i] = (uint8_t)(indices >> (i * 8));
+	}
+}
+
+/**
+ * Encode one channel of an RGBA8 block as a BC4 block
+ * @param pixels The pixels of the block
+ * @param channel The channel to encode
+ * @param block The BC4 block to write to
+ */
+static void EncodeBc4Block(const uint8_t pixels[BLOCK_PIXEL_COUNT][4], const uint8_t channel, uint8_t *block)
+{
+	uint8_t minValue = 0xFF;
+	uint8_t maxValue = 0;
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		minValue = min(minValue, pixels[i][channel]);
+		maxValue = max(maxValue, pixels[i][channel]);
+	}
+
+	// The eight value mode is used, where palette entry 0 and 1 are the endpoints and 2-7 step from the first to the
+	// second endpoint
+	static const uint8_t PALETTE_POSITION_TO_INDEX[8] = {0, 2, 3, 4, 5, 6, 7, 1};
+	uint64_t indices = 0;
+	if (maxValue != minValue)
+	{
+		const uint32_t range = maxValue - minValue;
+		for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			const uint32_t position = ((maxValue - pixels[i][channel]) * 7 + range / 2) / range;
+			indices |= (uint64_t)PALETTE_POSITION_TO_INDEX[position] << (i * 3);
+		}
+	}
+
+	block[0] = maxValue;
+	block[1] = minValue;
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		block[2 + i] = (uint8_t)(indices >> (i * 8));
+	}
+}
+
+#pragma endregion
+
+#pragma region BC7
+
+static void DecodeBc7Block(const uint8_t *block, uint8_t *pixels, const size_t stride)
+{
+	uint8_t mode = 0;
+	while (mode < 8 && !(block[0] & (1 << mode)))
+	{
+		mode++;
+	}
+	if (mode == 8)
+	{
+		// Reserved mode, which decodes to transparent black
+		for (uint8_t i = 0; i < TEXTURE_BLOCK_SIZE; i++)
+		{
+			memset(pixels + i * stride, 0, TEXTURE_BLOCK_SIZE * 4);
+		}
+		return;
+	}
+
+	const Bc7ModeInfo *info = &BC7_MODES[mode];
+	BlockBits bits = {(uint8_t *)block, mode + 1};
+	const uint8_t partition = (uint8_t)ReadBits(&bits, info->partitionBits);
+	const uint8_t rotation = (uint8_t)ReadBits(&bits, info->rotationBits);
+	const uint8_t indexSelection = (uint8_t)ReadBits(&bits, info->indexSelectionBits);
+
+	uint8_t endpoints[6][4] = {0};
+	const uint8_t endpointCount = info->subsets * 2;
+	for (uint8_t channel = 0; channel < 3; channel++)
+	{
+		for (uint8_t i = 0; i < endpointCount; i++)
+		{
+			endpoints[i][channel] = (uint8_t)ReadBits(&bits, info->colorBits);
+		}
+	}
+	for (uint8_t i = 0; i < endpointCount; i++)
+	{
+		endpoints[i][3] = (uint8_t)ReadBits(&bits, info->alphaBits);
+	}
+
+	uint8_t colorBits = info->colorBits;
+	uint8_t alphaBits = info->alphaBits;
+	if (info->endpointPBits || info->sharedPBits)
+	{
+		uint8_t pBits[6];
+		if (info->endpointPBits)
+		{
+			for (uint8_t i = 0; i < endpointCount; i++)
+			{
+				pBits[i] = (uint8_t)ReadBits(&bits, 1);
+			}
+		} else
+		{
+			for (uint8_t i = 0; i < info->subsets; i++)
+			{
+				pBits[i * 2] = pBits[i * 2 + 1] = (uint8_t)ReadBits(&bits, 1);
+			}
+		}
+		for (uint8_t i = 0; i < endpointCount; i++)
+		{
+			for (uint8_t channel = 0; channel < 4; channel++)
+			{
+				endpoints[i][channel] = (uint8_t)((endpoints[i][channel] << 1) | pBits[i]);
+			}
+		}
+		colorBits++;
+		if (alphaBits)
+		{
+			alphaBits++;
+		}
+	}
+	for (uint8_t i = 0; i < endpointCount; i++)
+	{
+		for (uint8_t channel = 0; channel < 4; channel++)
+		{
+			const uint8_t channelBits = channel == 3 ? alphaBits : colorBits;
+			if (channelBits == 0)
+			{
+				endpoints[i][channel] = 0xFF;
+				continue;
+			}
+			endpoints[i][channel] <<= 8 - channelBits;
+			endpoints[i][channel] |= endpoints[i][channel] >> channelBits;
+		}
+	}
+
+	uint8_t indices[BLOCK_PIXEL_COUNT];
+	uint8_t secondaryIndices[BLOCK_PIXEL_COUNT];
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		indices[i] = (uint8_t)ReadBits(&bits, info->indexBits - IsAnchor(info->subsets, partition, i));
+	}
+	if (info->secondaryIndexBits)
+	{
+		for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			secondaryIndices[i] = (uint8_t)ReadBits(&bits, info->secondaryIndexBits - (i == 0));
+		}
+	}
+
+	const uint8_t *weights = GetWeights(info->indexBits);
+	const uint8_t *secondaryWeights = GetWeights(info->secondaryIndexBits);
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const uint8_t subset = GetSubset(info->subsets, partition, i);
+		const uint8_t *endpoint0 = endpoints[subset * 2];
+		const uint8_t *endpoint1 = endpoints[subset * 2 + 1];
+		uint8_t *pixel = pixels + (i / 4) * stride + (i % 4) * 4;
+		uint8_t colorWeight = weights[indices[i]];
+		uint8_t alphaWeight = colorWeight;
+		if (info->secondaryIndexBits)
+		{
+			alphaWeight = secondaryWeights[secondaryIndices[i]];
+			if (indexSelection)
+			{
+				const uint8_t temp = colorWeight;
+				colorWeight = alphaWeight;
+				alphaWeight = temp;
+			}
+		}
+		for (uint8_t channel = 0; channel < 3; channel++)
+		{
+			pixel[channel] = Interpolate(endpoint0[channel], endpoint1[channel], colorWeight);
+		}
+		pixel[3] = Interpolate(endpoint0[3], endpoint1[3], alphaWeight);
+		if (rotation)
+		{
+			const uint8_t temp = pixel[3];
+			pixel[3] = pixel[rotation - 1];
+			pixel[rotation - 1] = temp;
+		}
+	}
+}
+
+/**
+ * Pick the 7 bit value and p-bit that best represent an 8 bit endpoint, using the same p-bit for all channels
+ * @param endpoint The RGBA8 endpoint
+ * @param quantized The quantized 7 bit channels
+ * @return The p-bit
+ */
+static uint8_t QuantizeBc7Mode6Endpoint(const uint8_t *endpoint, uint8_t *quantized)
+{
+	uint32_t bestError = UINT32_MAX;
+	uint8_t bestPBit = 0;
+	for (uint8_t pBit = 0; pBit < 2; pBit++)
+	{
+		uint32_t error = 0;
+		uint8_t values[4];
+		for (uint8_t channel = 0; channel < 4; channel++)
+		{
+			const int32_t value = ((int32_t)endpoint[channel] - pBit + 1) / 2;
+			values[channel] = (uint8_t)clamp(value, 0, 0x7F);
+			const int32_t difference = (int32_t)endpoint[channel] - ((values[channel] << 1) | pBit);
+			error += (uint32_t)(difference * difference);
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			bestPBit = pBit;
+			memcpy(quantized, values, sizeof(values));
+		}
+	}
+	return bestPBit;
+}
+
+static void EncodeBc7Block(const uint8_t pixels[BLOCK_PIXEL_COUNT][4], uint8_t *block)
+{
+	uint8_t minColor[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+	uint8_t maxColor[4] = {0, 0, 0, 0};
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		for (uint8_t channel = 0; channel < 4; channel++)
+		{
+			minColor[channel] = min(minColor[channel], pixels[i][channel]);
+			maxColor[channel] = max(maxColor[channel], pixels[i][channel]);
+		}
+	}
+
+	uint8_t quantized[2][4];
+	uint8_t pBits[2];
+	pBits[0] = QuantizeBc7Mode6Endpoint(minColor, quantized[0]);
+	pBits[1] = QuantizeBc7Mode6Endpoint(maxColor, quantized[1]);
+	uint8_t palette[16][4];
+	for (uint8_t channel = 0; channel < 4; channel++)
+	{
+		const uint8_t endpoint0 = (uint8_t)((quantized[0][channel] << 1) | pBits[0]);
+		const uint8_t endpoint1 = (uint8_t)((quantized[1][channel] << 1) | pBits[1]);
+		for (uint8_t i = 0; i < 16; i++)
+		{
+			palette[i][channel] = Interpolate(endpoint0, endpoint1, WEIGHTS_4[i]);
+		}
+	}
+
+	uint8_t indices[BLOCK_PIXEL_COUNT];
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		uint32_t bestDistance = UINT32_MAX;
+		for (uint8_t j = 0; j < 16; j++)
+		{
+			const uint32_t distance = ColorDistance(pixels[i], palette[j], 4);
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				indices[i] = j;
+			}
+		}
+	}
+	// The most significant bit of the anchor index is implied to be zero, so swap the endpoints if it is not
+	if (indices[0] & 8)
+	{
+		uint8_t tempQuantized[4];
+		memcpy(tempQuantized, quantized[0], sizeof(tempQuantized));
+		memcpy(quantized[0], quantized[1], sizeof(tempQuantized));
+		memcpy(quantized[1], tempQuantized, sizeof(tempQuantized));
+		const uint8_t tempPBit = pBits[0];
+		pBits[0] = pBits[1];
+		pBits[1] = tempPBit;
+		for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	memset(block, 0, 16);
+	BlockBits bits = {block, 0};
+	WriteBits(&bits, 1 << BC7_ENCODER_MODE, BC7_ENCODER_MODE + 1);
+	for (uint8_t channel = 0; channel < 4; channel++)
+	{
+		WriteBits(&bits, quantized[0][channel], 7);
+		WriteBits(&bits, quantized[1][channel], 7);
+	}
+	WriteBits(&bits, pBits[0], 1);
+	WriteBits(&bits, pBits[1], 1);
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		WriteBits(&bits, indices[i], i == 0 ? 3 : 4);
+	}
+	assert(bits.position == 128);
+}
+
+#pragma endregion
+
+#pragma region BC6H
+
+static inline int32_t SignExtend(const uint32_t value, const uint8_t bits)
+{
+	const uint32_t signBit = 1u << (bits - 1);
+	return (int32_t)((value ^ signBit) - signBit);
+}
+
+static inline uint32_t UnquantizeBc6h(const uint32_t value, const uint8_t bits)
+{
+	if (bits >= 15 || value == 0)
+	{
+		return value;
+	}
+	if (value == (1u << bits) - 1)
+	{
+		return 0xFFFF;
+	}
+	return ((value << 16) + 0x8000) >> bits;
+}
+
+static inline uint16_t FinishUnquantizeBc6h(const uint32_t value)
+{
+	return (uint16_t)((value * 31) >> 6);
+}
+
+static void DecodeBc6hBlock(const uint8_t *block, uint16_t *pixels, const size_t stride)
+{
+	BlockBits bits = {(uint8_t *)block, 0};
+	uint8_t modeBits = (uint8_t)ReadBits(&bits, 2);
+	if (modeBits > 1)
+	{
+		modeBits |= (uint8_t)(ReadBits(&bits, 3) << 2);
+	}
+	const Bc6hModeInfo *info = NULL;
+	for (size_t i = 0; i < sizeof(BC6H_MODES) / sizeof(*BC6H_MODES); i++)
+	{
+		if (BC6H_MODES[i].mode == modeBits)
+		{
+			info = &BC6H_MODES[i];
+			break;
+		}
+	}
+	if (!info)
+	{
+		// Reserved mode, which decodes to black
+		for (uint8_t i = 0; i < TEXTURE_BLOCK_SIZE; i++)
+		{
+			memset(pixels + i * stride, 0, TEXTURE_BLOCK_SIZE * 4 * sizeof(uint16_t));
+		}
+		return;
+	}
+
+	uint32_t fields[BC6H_END] = {0};
+	for (const Bc6hBitField *field = info->layout; field->field != BC6H_END; field++)
+	{
+		fields[field->field] |= ReadBits(&bits, field->count) << field->shift;
+	}
+	const uint8_t subsets = info->subsets;
+	const uint8_t partition = (uint8_t)fields[BC6H_D];
+
+	uint32_t endpoints[4][3];
+	for (uint8_t channel = 0; channel < 3; channel++)
+	{
+		const uint32_t mask = (1u << info->endpointBits) - 1;
+		endpoints[0][channel] = fields[BC6H_RW + channel];
+		for (uint8_t i = 1; i < subsets * 2; i++)
+		{
+			// X, Y and Z are laid out in the same order as W, three fields apart
+			const uint32_t value = fields[BC6H_RW + channel + i * 3];
+			if (info->transformed)
+			{
+				const int32_t delta = SignExtend(value, info->deltaBits[channel]);
+				endpoints[i][channel] = (uint32_t)((int32_t)endpoints[0][channel] + delta) & mask;
+			} else
+			{
+				endpoints[i][channel] = value;
+			}
+		}
+		for (uint8_t i = 0; i < subsets * 2; i++)
+		{
+			endpoints[i][channel] = UnquantizeBc6h(endpoints[i][channel], info->endpointBits);
+		}
+	}
+
+	const uint8_t indexBits = subsets == 2 ? 3 : 4;
+	const uint8_t *weights = GetWeights(indexBits);
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const uint8_t index = (uint8_t)ReadBits(&bits, indexBits - IsAnchor(subsets, partition, i));
+		const uint8_t subset = GetSubset(subsets, partition, i);
+		uint16_t *pixel = pixels + (i / 4) * stride + (i % 4) * 4;
+		for (uint8_t channel = 0; channel < 3; channel++)
+		{
+			const uint32_t a = endpoints[subset * 2][channel];
+			const uint32_t b = endpoints[subset * 2 + 1][channel];
+			pixel[channel] = FinishUnquantizeBc6h((a * (64 - weights[index]) + b * weights[index] + 32) >> 6);
+		}
+		pixel[3] = HALF_ONE;
+	}
+}
+
+/**
+ * Convert a half float to the unquantized integer domain BC6H interpolates in
+ */
+static inline uint32_t HalfToBc6hUnquantized(const uint16_t half)
+{
+	if (half & 0x8000)
+	{
+		return 0;
+	}
+	return (min(half, HALF_MAX) * 64u + 30) / 31;
+}
+
+static void EncodeBc6hBlock(const uint16_t pixels[BLOCK_PIXEL_COUNT][4], uint8_t *block)
+{
+	const Bc6hModeInfo *info = &BC6H_MODES[BC6H_ENCODER_MODE];
+	const uint32_t maxQuantized = (1u << info->endpointBits) - 1;
+	uint32_t endpoints[2][3];
+	for (uint8_t channel = 0; channel < 3; channel++)
+	{
+		uint32_t minValue = UINT32_MAX;
+		uint32_t maxValue = 0;
+		for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			const uint32_t value = HalfToBc6hUnquantized(pixels[i][channel]);
+			minValue = min(minValue, value);
+			maxValue = max(maxValue, value);
+		}
+		endpoints[0][channel] = (minValue * maxQuantized + 0x7FFF) / 0xFFFF;
+		endpoints[1][channel] = (maxValue * maxQuantized + 0x7FFF) / 0xFFFF;
+	}
+
+	uint16_t palette[16][3];
+	for (uint8_t channel = 0; channel < 3; channel++)
+	{
+		const uint32_t a = UnquantizeBc6h(endpoints[0][channel], info->endpointBits);
+		const uint32_t b = UnquantizeBc6h(endpoints[1][channel], info->endpointBits);
+		for (uint8_t i = 0; i < 16; i++)
+		{
+			palette[i][channel] = FinishUnquantizeBc6h((a * (64 - WEIGHTS_4[i]) + b * WEIGHTS_4[i] + 32) >> 6);
+		}
+	}
+
+	uint8_t indices[BLOCK_PIXEL_COUNT];
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		uint64_t bestDistance = UINT64_MAX;
+		for (uint8_t j = 0; j < 16; j++)
+		{
+			uint64_t distance = 0;
+			for (uint8_t channel = 0; channel < 3; channel++)
+			{
+				const int64_t value = (pixels[i][channel] & 0x8000) ? 0 : min(pixels[i][channel], HALF_MAX);
+				const int64_t difference = value - palette[j][channel];
+				distance += (uint64_t)(difference * difference);
+			}
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				indices[i] = j;
+			}
+		}
+	}
+	if (indices[0] & 8)
+	{
+		for (uint8_t channel = 0; channel < 3; channel++)
+		{
+			const uint32_t temp = endpoints[0][channel];
+			endpoints[0][channel] = endpoints[1][channel];
+			endpoints[1][channel] = temp;
+		}
+		for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	memset(block, 0, 16);
+	BlockBits bits = {block, 0};
+	WriteBits(&bits, info->mode, 5);
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		for (uint8_t channel = 0; channel < 3; channel++)
+		{
+			WriteBits(&bits, endpoints[i][channel], info->endpointBits);
+		}
+	}
+	for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		WriteBits(&bits, indices[i], i == 0 ? 3 : 4);
+	}
+	assert(bits.position == 128);
+}
+
+#pragma endregion
+
+bool IsBlockCompressedPixelFormat(const ImagePixelFormat format)
+{
+	switch (format)
+	{
+		case PIXEL_FORMAT_BC1:
+		case PIXEL_FORMAT_BC3:
+		case PIXEL_FORMAT_BC5:
+		case PIXEL_FORMAT_BC7:
+		case PIXEL_FORMAT_BC6H:
+			return true;
+		default:
+			return false;
+	}
+}
+
+ImagePixelFormat GetDecompressedPixelFormat(const ImagePixelFormat format)
+{
+	switch (format)
+	{
+		case PIXEL_FORMAT_RGBA16F:
+		case PIXEL_FORMAT_BC6H:
+			return PIXEL_FORMAT_RGBA16F;
+		default:
+			return PIXEL_FORMAT_RGBA8;
+	}
+}
+
+size_t GetPixelDataSize(const ImagePixelFormat format, const size_t width, const size_t height)
+{
+	if (IsBlockCompressedPixelFormat(format))
+	{
+		const size_t blocksWide = (width + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+		const size_t blocksHigh = (height + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+		return blocksWide * blocksHigh * GetBlockSize(format);
+	}
+	if (format == PIXEL_FORMAT_RGBA16F)
+	{
+		return width * height * sizeof(_Float16) * 4;
+	}
+	return width * height * sizeof(uint32_t);
+}
+
+uint8_t *DecompressPixelData(const ImagePixelFormat format,
+							 const size_t width,
+							 const size_t height,
+							 const uint8_t *pixelData)
+{
+	assert(IsBlockCompressedPixelFormat(format));
+	const ImagePixelFormat outputFormat = GetDecompressedPixelFormat(format);
+	const size_t pixelSize = GetPixelDataSize(outputFormat, 1, 1);
+	uint8_t *output = malloc(GetPixelDataSize(outputFormat, width, height));
+	CheckAlloc(output);
+
+	const size_t blockSize = GetBlockSize(format);
+	const size_t blocksWide = (width + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+	const size_t blocksHigh = (height + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+	// Blocks are decoded into a full 4x4 scratch block so that images that are not a multiple of 4 can be cropped
+	uint16_t decodedPixels[BLOCK_PIXEL_COUNT * 4];
+	uint8_t *decodedBlock = (uint8_t *)decodedPixels;
+	const size_t decodedStride = TEXTURE_BLOCK_SIZE * pixelSize;
+	for (size_t blockY = 0; blockY < blocksHigh; blockY++)
+	{
+		for (size_t blockX = 0; blockX < blocksWide; blockX++)
+		{
+			const uint8_t *block = pixelData + (blockY * blocksWide + blockX) * blockSize;
+			switch (format)
+			{
+				case PIXEL_FORMAT_BC1:
+					DecodeBc1Block(block, false, decodedBlock, decodedStride);
+					break;
+				case PIXEL_FORMAT_BC3:
+					DecodeBc1Block(block + 8, true, decodedBlock, decodedStride);
+					DecodeBc4Block(block, decodedBlock + 3, decodedStride);
+					break;
+				case PIXEL_FORMAT_BC5:
+					memset(decodedPixels, 0, sizeof(decodedPixels));
+					DecodeBc4Block(block, decodedBlock, decodedStride);
+					DecodeBc4Block(block + 8, decodedBlock + 1, decodedStride);
+					for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+					{
+						decodedBlock[i * 4 + 3] = 0xFF;
+					}
+					break;
+				case PIXEL_FORMAT_BC7:
+					DecodeBc7Block(block, decodedBlock, decodedStride);
+					break;
+				case PIXEL_FORMAT_BC6H:
+					DecodeBc6hBlock(block, decodedPixels, TEXTURE_BLOCK_SIZE * 4);
+					break;
+				default:
+					// Impossible to hit
+					break;
+			}
+
+			const size_t copyWidth = min(TEXTURE_BLOCK_SIZE, width - blockX * TEXTURE_BLOCK_SIZE);
+			const size_t copyHeight = min(TEXTURE_BLOCK_SIZE, height - blockY * TEXTURE_BLOCK_SIZE);
+			for (size_t y = 0; y < copyHeight; y++)
+			{
+				const size_t outputOffset = ((blockY * TEXTURE_BLOCK_SIZE + y) * width + blockX * TEXTURE_BLOCK_SIZE) *
+											pixelSize;
+				memcpy(output + outputOffset, decodedBlock + y * decodedStride, copyWidth * pixelSize);
+			}
+		}
+	}
+
+	return output;
+}
+
+uint8_t *CompressPixelData(const ImagePixelFormat format,
+						   const size_t width,
+						   const size_t height,
+						   const uint8_t *pixelData)
+{
+	assert(IsBlockCompressedPixelFormat(format));
+	const size_t pixelSize = GetPixelDataSize(GetDecompressedPixelFormat(format), 1, 1);
+	uint8_t *output = malloc(GetPixelDataSize(format, width, height));
+	CheckAlloc(output);
+
+	const size_t blockSize = GetBlockSize(format);
+	const size_t blocksWide = (width + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+	const size_t blocksHigh = (height + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+	for (size_t blockY = 0; blockY < blocksHigh; blockY++)
+	{
+		for (size_t blockX = 0; blockX < blocksWide; blockX++)
+		{
+			// Pixels past the edge of the image are filled by clamping to the last row and column
+			union
+			{
+				uint8_t rgba8[BLOCK_PIXEL_COUNT][4];
+				uint16_t rgba16f[BLOCK_PIXEL_COUNT][4];
+			} source;
+			for (uint8_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+			{
+				const size_t x = min(blockX * TEXTURE_BLOCK_SIZE + i % 4, width - 1);
+				const size_t y = min(blockY * TEXTURE_BLOCK_SIZE + i / 4, height - 1);
+				memcpy((uint8_t *)&source + i * pixelSize, pixelData + (y * width + x) * pixelSize, pixelSize);
+			}
+
+			uint8_t *block = output + (blockY * blocksWide + blockX) * blockSize;
+			switch (format)
+			{
+				case PIXEL_FORMAT_BC1:
+					EncodeBc1Block(source.rgba8, true, block);
+					break;
+				case PIXEL_FORMAT_BC3:
+					EncodeBc4Block(source.rgba8, 3, block);
+					EncodeBc1Block(source.rgba8, false, block + 8);
+					break;
+				case PIXEL_FORMAT_BC5:
+					EncodeBc4Block(source.rgba8, 0, block);
+					EncodeBc4Block(source.rgba8, 1, block + 8);
+					break;
+				case PIXEL_FORMAT_BC7:
+					EncodeBc7Block(source.rgba8, block);
+					break;
+				case PIXEL_FORMAT_BC6H:
+					EncodeBc6hBlock(source.rgba16f, block);
+					break;
+				default:
+					// Impossible to hit
+					break;
+			}
+		}
+	}
+
+	return output;
+}
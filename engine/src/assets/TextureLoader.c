@@ -5,10 +5,13 @@
 #include <assert.h>
 #include <engine/assets/AssetReader.h>
 #include <engine/assets/DataReader.h>
+#include <engine/assets/TextureCompression.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/assets/TextureMipmaps.h>
 #include <engine/structs/Asset.h>
 #include <engine/subsystem/Error.h>
 #include <engine/subsystem/Logging.h>
+#include <SDL3/SDL_mutex.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -17,6 +20,9 @@
 
 uint32_t textureId;
 Image *images[MAX_TEXTURES];
+uint32_t textureLoaderGeneration;
+/// Guards @c images, since the render thread looks up images while the main thread loads new ones
+static SDL_Mutex *imagesMutex;
 
 #define MISSING_TEX_SIZE 2
 #define MISSING_TEX_COLOR_A 0xFF000000
@@ -51,6 +57,7 @@ void GenFallbackImage(Image *src)
 	src->filter = false;
 	src->repeat = true;
 	src->mipmaps = false;
+	src->mipLevels = 1;
 	src->pixelFormat = PIXEL_FORMAT_RGBA8;
 	const size_t pixelDataSize = MISSING_TEX_SIZE * MISSING_TEX_SIZE * sizeof(uint32_t);
 	uint32_t *pixelData = malloc(pixelDataSize);
@@ -72,7 +79,12 @@ void GenFallbackImage(Image *src)
 	}
 }
 
-Image *LoadImage(const char *asset)
+void InitTextureLoader()
+{
+	imagesMutex = SDL_CreateMutex();
+}
+
+static Image *LoadImageLocked(const char *asset)
 {
 	Image **foundImage = bsearch(asset, images, textureId, sizeof(Image *), ImageNameMatch);
 	if (foundImage != NULL && *foundImage != NULL)
@@ -96,7 +108,8 @@ Image *LoadImage(const char *asset)
 	} else
 	{
 		DataReader *reader = CreateDataReaderFromAsset(textureAsset);
-		if (textureAsset->typeVersion != TEXTURE_ASSET_VERSION)
+		if (textureAsset->typeVersion != TEXTURE_ASSET_VERSION &&
+			textureAsset->typeVersion != TEXTURE_ASSET_VERSION_NO_MIPS)
 		{
 			LogError("Failed to load texture from asset due to version mismatch (got %d, expected %d)\n",
 					 textureAsset->typeVersion,
@@ -104,7 +117,8 @@ Image *LoadImage(const char *asset)
 			GenFallbackImage(img);
 		} else
 		{
-			const size_t headerSize = (sizeof(size_t) * 2) + (sizeof(uint8_t) * 4);
+			const bool hasMipLevels = textureAsset->typeVersion != TEXTURE_ASSET_VERSION_NO_MIPS;
+			const size_t headerSize = (sizeof(size_t) * 2) + (sizeof(uint8_t) * (hasMipLevels ? 5 : 4));
 			if (textureAsset->size < headerSize)
 			{
 				LogError("Failed to load texture asset as it was the wrong size.\n");
@@ -117,15 +131,20 @@ Image *LoadImage(const char *asset)
 				img->repeat = ReadUint8(reader) != 0;
 				img->mipmaps = ReadUint8(reader) != 0;
 				img->pixelFormat = ReadUint8(reader);
-				size_t pixelDataSize = img->width * img->height;
-				if (img->pixelFormat == PIXEL_FORMAT_RGBA8)
+				img->mipLevels = hasMipLevels ? ReadUint8(reader) : 1;
+				const size_t pixelDataSize = GetMipChainDataSize(img->pixelFormat,
+																 img->width,
+																 img->height,
+																 img->mipLevels);
+				if (img->pixelFormat > PIXEL_FORMAT_BC6H)
 				{
-					pixelDataSize *= sizeof(uint32_t);
-				} else
+					LogError("Failed to load texture asset due to unknown pixel format %d.\n", img->pixelFormat);
+					GenFallbackImage(img);
+				} else if (img->mipLevels == 0 || img->mipLevels > GetFullMipLevelCount(img->width, img->height))
 				{
-					pixelDataSize *= sizeof(_Float16) * 4;
-				}
-				if (textureAsset->size < headerSize + pixelDataSize)
+					LogError("Failed to load texture asset due to invalid mip level count %d.\n", img->mipLevels);
+					GenFallbackImage(img);
+				} else if (textureAsset->size < headerSize + pixelDataSize)
 				{
 					LogError("Failed to load texture asset as it was the wrong size.\n");
 					GenFallbackImage(img);
@@ -166,7 +185,15 @@ Image *LoadImage(const char *asset)
 	return img;
 }
 
-Image *RegisterFallbackImage()
+Image *LoadImage(const char *asset)
+{
+	SDL_LockMutex(imagesMutex);
+	Image *image = LoadImageLocked(asset);
+	SDL_UnlockMutex(imagesMutex);
+	return image;
+}
+
+static Image *RegisterFallbackImageLocked()
 {
 	const char *asset = "_generic_fallback";
 	for (int i = 0; i < MAX_TEXTURES; i++)
@@ -210,6 +237,14 @@ Image *RegisterFallbackImage()
 	return img;
 }
 
+Image *RegisterFallbackImage()
+{
+	SDL_LockMutex(imagesMutex);
+	Image *image = RegisterFallbackImageLocked();
+	SDL_UnlockMutex(imagesMutex);
+	return image;
+}
+
 void DestroyTextureLoader()
 {
 	LogDebug("Cleaning up texture cache...\n");
@@ -224,4 +259,7 @@ void DestroyTextureLoader()
 		}
 	}
 	textureId = 0;
+	textureLoaderGeneration++;
+	SDL_DestroyMutex(imagesMutex);
+	imagesMutex = NULL;
 }
@@ -0,0 +1,199 @@
+//
+// Created by droc101 on 10/18/26.
+//
+
+#include <engine/assets/TextureCompression.h>
+#include <engine/assets/TextureLoader.h>
+#include <engine/assets/TextureMipmaps.h>
+#include <engine/helpers/MathEx.h>
+#include <engine/subsystem/Error.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static float srgbToLinear[256];
+static bool srgbToLinearInitialized = false;
+
+static inline void InitSrgbToLinear()
+{
+	if (srgbToLinearInitialized)
+	{
+		return;
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		const float value = (float)i / 255.0f;
+		srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+	}
+	srgbToLinearInitialized = true;
+}
+
+static inline uint8_t LinearToSrgb(const float value)
+{
+	const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+	return (uint8_t)lroundf(clamp(srgb, 0.0f, 1.0f) * 255.0f);
+}
+
+/**
+ * Downsample one RGBA8 level to the next with a 2x2 box filter, averaging color in linear space
+ */
+static void DownsampleRgba8(const uint8_t *source,
+							const size_t sourceWidth,
+							const size_t sourceHeight,
+							uint8_t *destination)
+{
+	const size_t width = max(sourceWidth / 2, 1);
+	const size_t height = max(sourceHeight / 2, 1);
+	for (size_t y = 0; y < height; y++)
+	{
+		const size_t y0 = min(y * 2, sourceHeight - 1);
+		const size_t y1 = min(y * 2 + 1, sourceHeight - 1);
+		for (size_t x = 0; x < width; x++)
+		{
+			const size_t x0 = min(x * 2, sourceWidth - 1);
+			const size_t x1 = min(x * 2 + 1, sourceWidth - 1);
+			const uint8_t *samples[4] = {
+				source + (y0 * sourceWidth + x0) * 4,
+				source + (y0 * sourceWidth + x1) * 4,
+				source + (y1 * sourceWidth + x0) * 4,
+				source + (y1 * sourceWidth + x1) * 4,
+			};
+			uint8_t *pixel = destination + (y * width + x) * 4;
+			for (int channel = 0; channel < 3; channel++)
+			{
+				float sum = 0;
+				for (int i = 0; i < 4; i++)
+				{
+					sum += srgbToLinear[samples[i][channel]];
+				}
+				pixel[channel] = LinearToSrgb(sum / 4.0f);
+			}
+			pixel[3] = (uint8_t)((samples[0][3] + samples[1][3] + samples[2][3] + samples[3][3] + 2) / 4);
+		}
+	}
+}
+
+/**
+ * Downsample one RGBA16F level to the next with a 2x2 box filter
+ */
+static void DownsampleRgba16F(const _Float16 *source,
+							  const size_t sourceWidth,
+							  const size_t sourceHeight,
+							  _Float16 *destination)
+{
+	const size_t width = max(sourceWidth / 2, 1);
+	const size_t height = max(sourceHeight / 2, 1);
+	for (size_t y = 0; y < height; y++)
+	{
+		const size_t y0 = min(y * 2, sourceHeight - 1);
+		const size_t y1 = min(y * 2 + 1, sourceHeight - 1);
+		for (size_t x = 0; x < width; x++)
+		{
+			const size_t x0 = min(x * 2, sourceWidth - 1);
+			const size_t x1 = min(x * 2 + 1, sourceWidth - 1);
+			for (int channel = 0; channel < 4; channel++)
+			{
+				const float sum = (float)source[(y0 * sourceWidth + x0) * 4 + channel] +
+								  (float)source[(y0 * sourceWidth + x1) * 4 + channel] +
+								  (float)source[(y1 * sourceWidth + x0) * 4 + channel] +
+								  (float)source[(y1 * sourceWidth + x1) * 4 + channel];
+				destination[(y * width + x) * 4 + channel] = (_Float16)(sum / 4.0f);
+			}
+		}
+	}
+}
+
+uint8_t GetFullMipLevelCount(size_t width, size_t height)
+{
+	uint8_t levelCount = 1;
+	while (width > 1 || height > 1)
+	{
+		width = max(width / 2, 1);
+		height = max(height / 2, 1);
+		levelCount++;
+	}
+	return levelCount;
+}
+
+size_t GetMipChainDataSize(const ImagePixelFormat format, size_t width, size_t height, const uint8_t levelCount)
+{
+	size_t size = 0;
+	for (uint8_t i = 0; i < levelCount; i++)
+	{
+		size += GetPixelDataSize(format, width, height);
+		width = max(width / 2, 1);
+		height = max(height / 2, 1);
+	}
+	return size;
+}
+
+uint8_t *GenerateMipChain(const ImagePixelFormat format,
+						  const size_t width,
+						  const size_t height,
+						  const uint8_t *pixelData,
+						  uint8_t *levelCount)
+{
+	InitSrgbToLinear();
+	*levelCount = GetFullMipLevelCount(width, height);
+
+	const bool compressed = IsBlockCompressedPixelFormat(format);
+	const ImagePixelFormat filterFormat = GetDecompressedPixelFormat(format);
+	uint8_t *chain = malloc(GetMipChainDataSize(filterFormat, width, height, *levelCount));
+	CheckAlloc(chain);
+	if (compressed)
+	{
+		uint8_t *baseLevel = DecompressPixelData(format, width, height, pixelData);
+		memcpy(chain, baseLevel, GetPixelDataSize(filterFormat, width, height));
+		free(baseLevel);
+	} else
+	{
+		memcpy(chain, pixelData, GetPixelDataSize(filterFormat, width, height));
+	}
+
+	uint8_t *level = chain;
+	size_t levelWidth = width;
+	size_t levelHeight = height;
+	for (uint8_t i = 1; i < *levelCount; i++)
+	{
+		uint8_t *nextLevel = level + GetPixelDataSize(filterFormat, levelWidth, levelHeight);
+		if (filterFormat == PIXEL_FORMAT_RGBA16F)
+		{
+			DownsampleRgba16F((const _Float16 *)level, levelWidth, levelHeight, (_Float16 *)nextLevel);
+		} else
+		{
+			DownsampleRgba8(level, levelWidth, levelHeight, nextLevel);
+		}
+		level = nextLevel;
+		levelWidth = max(levelWidth / 2, 1);
+		levelHeight = max(levelHeight / 2, 1);
+	}
+
+	if (!compressed)
+	{
+		return chain;
+	}
+
+	uint8_t *compressedChain = malloc(GetMipChainDataSize(format, width, height, *levelCount));
+	CheckAlloc(compressedChain);
+	const uint8_t *source = chain;
+	uint8_t *destination = compressedChain;
+	levelWidth = width;
+	levelHeight = height;
+	for (uint8_t i = 0; i < *levelCount; i++)
+	{
+		uint8_t *compressedLevel = CompressPixelData(format, levelWidth, levelHeight, source);
+		const size_t compressedLevelSize = GetPixelDataSize(format, levelWidth, levelHeight);
+		memcpy(destination, compressedLevel, compressedLevelSize);
+		free(compressedLevel);
+		source += GetPixelDataSize(filterFormat, levelWidth, levelHeight);
+		destination += compressedLevelSize;
+		levelWidth = max(levelWidth / 2, 1);
+		levelHeight = max(levelHeight / 2, 1);
+	}
+	free(chain);
+
+	return compressedChain;
+}
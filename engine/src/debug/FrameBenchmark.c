@@ -3,17 +3,36 @@
 //
 
 #include <engine/debug/FrameBenchmark.h>
+#include <engine/graphics/Bvh.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/structs/GlobalState.h>
+#include <engine/structs/List.h>
+#include <engine/structs/Map.h>
+#include <engine/subsystem/Error.h>
 #include <engine/subsystem/Logging.h>
 #include <engine/subsystem/Timing.h>
+#include <joltc/Math/Vector3.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The number of times the map cluster BVH is rebuilt when benchmarking it
+#define BENCHMARK_BVH_BUILDS 16
+/// The number of box queries made against the map cluster BVH when benchmarking it
+#define BENCHMARK_BVH_QUERIES 100000
+/// The half size of the boxes that the map cluster BVH is queried with
+#define BENCHMARK_BVH_QUERY_EXTENTS 4.0f
 
 bool benchRunning = false;
 uint64_t benchStartTime;
 uint64_t benchFrameCount;
 uint64_t highestFrameNs;
 uint64_t lowestFrameNs;
+uint64_t benchPassNs[RENDER_PASS_TIMING_COUNT];
+uint64_t benchGpuWaitNs;
 
 uint64_t benchFrameStartTime;
 
@@ -24,6 +43,8 @@ void BenchStart()
 	benchFrameCount = 0;
 	highestFrameNs = 0;
 	lowestFrameNs = ULONG_MAX;
+	memset(benchPassNs, 0, sizeof(benchPassNs));
+	benchGpuWaitNs = 0;
 	BenchFrameStart();
 	LogInfo("Benchmark started\n");
 }
@@ -53,10 +74,74 @@ void BenchFrameEnd()
 			highestFrameNs = frameTime;
 		}
 #endif
+		for (int i = 0; i < RENDER_PASS_TIMING_COUNT; i++)
+		{
+			benchPassNs[i] += lastRenderStats.passNs[i];
+		}
+		benchGpuWaitNs += lastRenderStats.gpuWaitNs;
 		benchFrameCount++;
 	}
 }
 
+#ifdef BENCHMARK_MAP_BVH
+/**
+ * Time rebuilding the cluster BVH of a map and querying it with boxes around its clusters
+ * @param map The map to benchmark
+ */
+static void BenchMapBvh(const Map *map)
+{
+	if (map->clusterCount == 0)
+	{
+		return;
+	}
+	Vector3 *centers = malloc(map->clusterCount * sizeof(Vector3));
+	CheckAlloc(centers);
+	Vector3 *extents = malloc(map->clusterCount * sizeof(Vector3));
+	CheckAlloc(extents);
+	for (size_t i = 0; i < map->clusterCount; i++)
+	{
+		centers[i] = map->clusters[i].center;
+		extents[i] = map->clusters[i].extents;
+	}
+	const uint64_t buildStartTime = GetTimeNs();
+	for (int i = 0; i < BENCHMARK_BVH_BUILDS; i++)
+	{
+		Bvh bvh;
+		BvhBuild(&bvh, centers, extents, map->clusterCount, 1);
+		BvhFree(&bvh);
+	}
+	const uint64_t buildTime = GetTimeNs() - buildStartTime;
+
+	List items;
+	ListInit(items, LIST_UINT32);
+	const Vector3 queryExtents = {
+		BENCHMARK_BVH_QUERY_EXTENTS,
+		BENCHMARK_BVH_QUERY_EXTENTS,
+		BENCHMARK_BVH_QUERY_EXTENTS,
+	};
+	size_t itemsFound = 0;
+	const uint64_t queryStartTime = GetTimeNs();
+	for (size_t i = 0; i < BENCHMARK_BVH_QUERIES; i++)
+	{
+		// Stepping by a large prime visits the clusters in an order that jumps around the map
+		const Vector3 *queryCenter = &centers[(i * 7919) % map->clusterCount];
+		ListClear(items);
+		BvhQueryBox(&map->clusterBvh, queryCenter, &queryExtents, &items);
+		itemsFound += items.length;
+	}
+	const uint64_t queryTime = GetTimeNs() - queryStartTime;
+	ListFree(items);
+	free(centers);
+	free(extents);
+
+	LogInfo("Map BVH: %zu clusters, %zu nodes\n", map->clusterCount, map->clusterBvh.nodeCount);
+	LogInfo("Map BVH build time: %f ms\n", (double)buildTime / BENCHMARK_BVH_BUILDS / 1000000.0);
+	LogInfo("Map BVH box queries: %f per second, %f clusters per query\n",
+			BENCHMARK_BVH_QUERIES / ((double)queryTime / 1000000000.0),
+			(double)itemsFound / BENCHMARK_BVH_QUERIES);
+}
+#endif
+
 void BenchFinish()
 {
 	benchRunning = false;
@@ -78,6 +163,21 @@ void BenchFinish()
 	LogInfo("Lowest frame time: %f ms\n", lowestFrameTime);
 	LogInfo("Highest frame time: %f ms\n", highestFrameTime);
 #endif
+
+	for (int i = 0; i < RENDER_PASS_TIMING_COUNT; i++)
+	{
+		LogInfo("Average %s pass CPU recording time: %f ms\n",
+				renderPassTimingNames[i],
+				(double)benchPassNs[i] / (double)benchFrameCount / 1000000.0);
+	}
+	LogInfo("Average GPU wait time: %f ms\n", (double)benchGpuWaitNs / (double)benchFrameCount / 1000000.0);
+
+#ifdef BENCHMARK_MAP_BVH
+	if (GetState()->map != NULL)
+	{
+		BenchMapBvh(GetState()->map);
+	}
+#endif
 }
 
 void BenchToggle()
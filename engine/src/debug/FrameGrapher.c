@@ -13,12 +13,26 @@
 #include <stdint.h>
 #include <stdio.h>
 
+/// The color of the time spent waiting for the GPU, on the graph and in the text above the frame rate
+#define GPU_WAIT_COLOR 0xffff6060
+
 static double framerates[FRAMEGRAPH_HISTORY_SIZE] = {0};
 static long framegraphLastUpdateTime = LONG_MIN;
 
 static double tickrates[FRAMEGRAPH_HISTORY_SIZE] = {0};
 static double tickGraphLastUpdateTime = LONG_MIN;
 
+static double passTimes[RENDER_PASS_TIMING_COUNT][FRAMEGRAPH_HISTORY_SIZE] = {0};
+static const uint32_t passColors[RENDER_PASS_TIMING_COUNT] = {
+	[RENDER_PASS_TIMING_SKY] = 0xff40c0ff,
+	[RENDER_PASS_TIMING_MAP] = 0xffffc040,
+	[RENDER_PASS_TIMING_ACTORS] = 0xffff40ff,
+	[RENDER_PASS_TIMING_WALLS] = 0xff40ff80,
+	[RENDER_PASS_TIMING_VIEWMODEL] = 0xffffff40,
+	[RENDER_PASS_TIMING_UI] = 0xffc0c0c0,
+};
+static double gpuWaitTimes[FRAMEGRAPH_HISTORY_SIZE] = {0};
+
 static inline void FrameGraphPushIntoArray(const double value)
 {
 	for (int i = 0; i < FRAMEGRAPH_HISTORY_SIZE - 1; i++)
@@ -28,6 +42,23 @@ static inline void FrameGraphPushIntoArray(const double value)
 	framerates[FRAMEGRAPH_HISTORY_SIZE - 1] = value;
 }
 
+static inline void PassTimesPushIntoArrays()
+{
+	for (int pass = 0; pass < RENDER_PASS_TIMING_COUNT; pass++)
+	{
+		for (int i = 0; i < FRAMEGRAPH_HISTORY_SIZE - 1; i++)
+		{
+			passTimes[pass][i] = passTimes[pass][i + 1];
+		}
+		passTimes[pass][FRAMEGRAPH_HISTORY_SIZE - 1] = (double)lastRenderStats.passNs[pass];
+	}
+	for (int i = 0; i < FRAMEGRAPH_HISTORY_SIZE - 1; i++)
+	{
+		gpuWaitTimes[i] = gpuWaitTimes[i + 1];
+	}
+	gpuWaitTimes[FRAMEGRAPH_HISTORY_SIZE - 1] = (double)lastRenderStats.gpuWaitNs;
+}
+
 static inline void TickGraphPushIntoArray(const double value)
 {
 	for (int i = 0; i < FRAMEGRAPH_HISTORY_SIZE - 1; i++)
@@ -46,6 +77,7 @@ void FrameGraphUpdate(const uint64_t ns)
 	}
 
 	FrameGraphPushIntoArray(ns == 0 ? 1 : (double)ns);
+	PassTimesPushIntoArrays();
 	framegraphLastUpdateTime = (long)GetTimeMs();
 }
 
@@ -157,10 +189,57 @@ void FrameGraphDraw()
 		y2 = (double)ScaledWindowHeight() - nextNsRemapped * FRAMEGRAPH_V_SCALE - 10;
 		lineColor.a = 0.5f;
 		DrawLine(v2((float)x1, (float)y1), v2((float)x2, (float)y2), 2, lineColor);
+#endif
+#ifdef FRAMEGRAPH_SHOW_PASS_TIMES
+		// A line for the time of each pass and for the GPU wait, on the same scale as the frame time
+		const double gpuWaitNs = fmin(remap(gpuWaitTimes[i], 0, FRAMEGRAPH_NSPF, 0, FRAMEGRAPH_THRESHOLD_GOOD),
+									  FRAMEGRAPH_THRESHOLD_GOOD * 2);
+		const double nextGpuWaitNs = fmin(remap(gpuWaitTimes[i + 1], 0, FRAMEGRAPH_NSPF, 0, FRAMEGRAPH_THRESHOLD_GOOD),
+										  FRAMEGRAPH_THRESHOLD_GOOD * 2);
+		DrawLine(v2((float)x1, (float)(ScaledWindowHeight() - gpuWaitNs * FRAMEGRAPH_V_SCALE - 10)),
+				 v2((float)x2, (float)(ScaledWindowHeight() - nextGpuWaitNs * FRAMEGRAPH_V_SCALE - 10)),
+				 1,
+				 COLOR(GPU_WAIT_COLOR));
+		for (int pass = 0; pass < RENDER_PASS_TIMING_COUNT; pass++)
+		{
+			const double *history = passTimes[pass];
+			const double passNs = fmin(remap(history[i], 0, FRAMEGRAPH_NSPF, 0, FRAMEGRAPH_THRESHOLD_GOOD),
+									   FRAMEGRAPH_THRESHOLD_GOOD * 2);
+			const double nextPassNs = fmin(remap(history[i + 1], 0, FRAMEGRAPH_NSPF, 0, FRAMEGRAPH_THRESHOLD_GOOD),
+										   FRAMEGRAPH_THRESHOLD_GOOD * 2);
+			DrawLine(v2((float)x1, (float)(ScaledWindowHeight() - passNs * FRAMEGRAPH_V_SCALE - 10)),
+					 v2((float)x2, (float)(ScaledWindowHeight() - nextPassNs * FRAMEGRAPH_V_SCALE - 10)),
+					 1,
+					 COLOR(passColors[pass]));
+		}
 #endif
 	}
 #else
 	Color lineColor;
+#endif
+#ifdef FRAMEGRAPH_SHOW_PASS_TIMES
+	// List the CPU recording time of each pass upward from just above the frame rate, in the colors of their lines,
+	// with the GPU wait above them
+	for (int pass = 0; pass < RENDER_PASS_TIMING_COUNT; pass++)
+	{
+		char passTime[40];
+		snprintf(passTime,
+				 sizeof(passTime),
+				 "%s CPU: %.3f ms",
+				 renderPassTimingNames[pass],
+				 passTimes[pass][FRAMEGRAPH_HISTORY_SIZE - 1] / 1000000.0);
+		const float y = ScaledWindowHeightFloat() - 10 - 38 - 14.0f * (float)(RENDER_PASS_TIMING_COUNT - pass);
+		FontDrawString(v2(11, y + 1), passTime, 12, COLOR_BLACK, smallFont);
+		FontDrawString(v2(10, y), passTime, 12, COLOR(passColors[pass]), smallFont);
+	}
+	char gpuWaitTime[40];
+	snprintf(gpuWaitTime,
+			 sizeof(gpuWaitTime),
+			 "GPU wait: %.3f ms",
+			 gpuWaitTimes[FRAMEGRAPH_HISTORY_SIZE - 1] / 1000000.0);
+	const float gpuWaitY = ScaledWindowHeightFloat() - 10 - 38 - 14.0f * (float)(RENDER_PASS_TIMING_COUNT + 1);
+	FontDrawString(v2(11, gpuWaitY + 1), gpuWaitTime, 12, COLOR_BLACK, smallFont);
+	FontDrawString(v2(10, gpuWaitY), gpuWaitTime, 12, COLOR(GPU_WAIT_COLOR), smallFont);
 #endif
 	const double currentNs = framerates[FRAMEGRAPH_HISTORY_SIZE - 1];
 	const double currentF = 1000000000.0 / currentNs;
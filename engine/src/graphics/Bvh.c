@@ -0,0 +1,304 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/Bvh.h>
+#include <engine/graphics/Culling.h>
+#include <engine/structs/List.h>
+#include <engine/subsystem/Error.h>
+#include <float.h>
+#include <joltc/Math/Vector3.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The deepest a hierarchy can get, which median splits can never reach
+#define BVH_MAX_DEPTH 64
+
+typedef enum FrustumIntersection FrustumIntersection;
+
+enum FrustumIntersection
+{
+	FRUSTUM_OUTSIDE,
+	FRUSTUM_INTERSECTING,
+	FRUSTUM_INSIDE,
+};
+
+static inline float VectorAxis(const Vector3 *vector, const int axis)
+{
+	switch (axis)
+	{
+		case 0:
+			return vector->x;
+		case 1:
+			return vector->y;
+		default:
+			return vector->z;
+	}
+}
+
+/**
+ * Reorder a range of items so that the item at @c middle is the one that would be there if the range was sorted along
+ * an axis, with every item before it not after it and every item after it not before it
+ */
+static void PartitionItems(uint32_t *items,
+						   const Vector3 *centers,
+						   const int axis,
+						   const size_t count,
+						   const size_t middle)
+{
+	ptrdiff_t left = 0;
+	ptrdiff_t right = (ptrdiff_t)count - 1;
+	while (left < right)
+	{
+		const float pivot = VectorAxis(&centers[items[left + (right - left) / 2]], axis);
+		ptrdiff_t i = left;
+		ptrdiff_t j = right;
+		while (i <= j)
+		{
+			while (VectorAxis(&centers[items[i]], axis) < pivot)
+			{
+				i++;
+			}
+			while (VectorAxis(&centers[items[j]], axis) > pivot)
+			{
+				j--;
+			}
+			if (i <= j)
+			{
+				const uint32_t item = items[i];
+				items[i] = items[j];
+				items[j] = item;
+				i++;
+				j--;
+			}
+		}
+		if ((ptrdiff_t)middle <= j)
+		{
+			right = j;
+		} else if ((ptrdiff_t)middle >= i)
+		{
+			left = i;
+		} else
+		{
+			break;
+		}
+	}
+}
+
+static void BuildNode(Bvh *bvh, const uint32_t nodeIndex, const uint32_t maxLeafItems, const int depth)
+{
+	BvhNode *node = &bvh->nodes[nodeIndex];
+	const uint32_t *items = bvh->items + node->firstItem;
+
+	Vector3 minimum = {FLT_MAX, FLT_MAX, FLT_MAX};
+	Vector3 maximum = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	Vector3 centerMinimum = minimum;
+	Vector3 centerMaximum = maximum;
+	for (uint32_t i = 0; i < node->itemCount; i++)
+	{
+		const Vector3 *center = &bvh->itemCenters[items[i]];
+		const Vector3 *extents = &bvh->itemExtents[items[i]];
+		minimum.x = fminf(minimum.x, center->x - extents->x);
+		minimum.y = fminf(minimum.y, center->y - extents->y);
+		minimum.z = fminf(minimum.z, center->z - extents->z);
+		maximum.x = fmaxf(maximum.x, center->x + extents->x);
+		maximum.y = fmaxf(maximum.y, center->y + extents->y);
+		maximum.z = fmaxf(maximum.z, center->z + extents->z);
+		centerMinimum.x = fminf(centerMinimum.x, center->x);
+		centerMinimum.y = fminf(centerMinimum.y, center->y);
+		centerMinimum.z = fminf(centerMinimum.z, center->z);
+		centerMaximum.x = fmaxf(centerMaximum.x, center->x);
+		centerMaximum.y = fmaxf(centerMaximum.y, center->y);
+		centerMaximum.z = fmaxf(centerMaximum.z, center->z);
+	}
+	node->center = (Vector3){
+		(minimum.x + maximum.x) / 2.0f,
+		(minimum.y + maximum.y) / 2.0f,
+		(minimum.z + maximum.z) / 2.0f,
+	};
+	node->extents = (Vector3){
+		(maximum.x - minimum.x) / 2.0f,
+		(maximum.y - minimum.y) / 2.0f,
+		(maximum.z - minimum.z) / 2.0f,
+	};
+	node->firstChild = 0;
+
+	if (node->itemCount <= maxLeafItems || depth + 1 >= BVH_MAX_DEPTH)
+	{
+		return;
+	}
+	const Vector3 centerSize = {
+		centerMaximum.x - centerMinimum.x,
+		centerMaximum.y - centerMinimum.y,
+		centerMaximum.z - centerMinimum.z,
+	};
+	int axis = centerSize.x >= centerSize.y ? 0 : 1;
+	if (centerSize.z > VectorAxis(&centerSize, axis))
+	{
+		axis = 2;
+	}
+
+	const uint32_t leftCount = node->itemCount / 2;
+	PartitionItems(bvh->items + node->firstItem, bvh->itemCenters, axis, node->itemCount, leftCount);
+
+	const uint32_t firstChild = bvh->nodeCount;
+	bvh->nodeCount += 2;
+	BvhNode *children = &bvh->nodes[firstChild];
+	children[0] = (BvhNode){.firstItem = node->firstItem, .itemCount = leftCount};
+	children[1] = (BvhNode){.firstItem = node->firstItem + leftCount, .itemCount = node->itemCount - leftCount};
+	node->firstChild = firstChild;
+
+	BuildNode(bvh, firstChild, maxLeafItems, depth + 1);
+	BuildNode(bvh, firstChild + 1, maxLeafItems, depth + 1);
+}
+
+void BvhBuild(Bvh *bvh,
+			  const Vector3 *centers,
+			  const Vector3 *extents,
+			  const size_t itemCount,
+			  const uint32_t maxLeafItems)
+{
+	memset(bvh, 0, sizeof(Bvh));
+	if (itemCount == 0)
+	{
+		return;
+	}
+	bvh->itemCount = itemCount;
+	bvh->items = malloc(itemCount * sizeof(uint32_t));
+	CheckAlloc(bvh->items);
+	bvh->itemCenters = malloc(itemCount * sizeof(Vector3));
+	CheckAlloc(bvh->itemCenters);
+	bvh->itemExtents = malloc(itemCount * sizeof(Vector3));
+	CheckAlloc(bvh->itemExtents);
+	for (size_t i = 0; i < itemCount; i++)
+	{
+		bvh->items[i] = i;
+	}
+	memcpy(bvh->itemCenters, centers, itemCount * sizeof(Vector3));
+	memcpy(bvh->itemExtents, extents, itemCount * sizeof(Vector3));
+
+	// A binary tree with one item per leaf has the most nodes
+	bvh->nodes = malloc((itemCount * 2 - 1) * sizeof(BvhNode));
+	CheckAlloc(bvh->nodes);
+	bvh->nodes[0] = (BvhNode){.firstItem = 0, .itemCount = itemCount};
+	bvh->nodeCount = 1;
+	BuildNode(bvh, 0, maxLeafItems == 0 ? 1 : maxLeafItems, 0);
+}
+
+void BvhFree(Bvh *bvh)
+{
+	free(bvh->nodes);
+	free(bvh->items);
+	free(bvh->itemCenters);
+	free(bvh->itemExtents);
+	memset(bvh, 0, sizeof(Bvh));
+}
+
+static inline FrustumIntersection IntersectFrustum(const Frustum *frustum,
+												   const Vector3 *center,
+												   const Vector3 *extents)
+{
+	FrustumIntersection intersection = FRUSTUM_INSIDE;
+	for (int i = 0; i < 6; i++)
+	{
+		const float *plane = frustum->planes[i];
+		const float distance = center->x * plane[0] + center->y * plane[1] + center->z * plane[2] + plane[3];
+		const float radius = extents->x * fabsf(plane[0]) + extents->y * fabsf(plane[1]) + extents->z * fabsf(plane[2]);
+		if (distance + radius < 0)
+		{
+			return FRUSTUM_OUTSIDE;
+		}
+		if (distance - radius < 0)
+		{
+			intersection = FRUSTUM_INTERSECTING;
+		}
+	}
+	return intersection;
+}
+
+size_t BvhQueryFrustum(const Bvh *bvh, const Frustum *frustum, uint8_t *visible)
+{
+	if (bvh->nodeCount == 0)
+	{
+		return 0;
+	}
+	memset(visible, 0, bvh->itemCount * sizeof(uint8_t));
+
+	size_t visibleCount = 0;
+	uint32_t stack[BVH_MAX_DEPTH + 1];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize != 0)
+	{
+		const BvhNode *node = &bvh->nodes[stack[--stackSize]];
+		const FrustumIntersection intersection = IntersectFrustum(frustum, &node->center, &node->extents);
+		if (intersection == FRUSTUM_OUTSIDE)
+		{
+			continue;
+		}
+		if (intersection == FRUSTUM_INSIDE || node->firstChild == 0)
+		{
+			for (uint32_t i = 0; i < node->itemCount; i++)
+			{
+				const uint32_t item = bvh->items[node->firstItem + i];
+				if (intersection == FRUSTUM_INSIDE ||
+					IntersectFrustum(frustum, &bvh->itemCenters[item], &bvh->itemExtents[item]) != FRUSTUM_OUTSIDE)
+				{
+					visible[item] = 1;
+					visibleCount++;
+				}
+			}
+			continue;
+		}
+		stack[stackSize++] = node->firstChild;
+		stack[stackSize++] = node->firstChild + 1;
+	}
+	return visibleCount;
+}
+
+static inline bool BoxesOverlap(const Vector3 *centerA,
+								const Vector3 *extentsA,
+								const Vector3 *centerB,
+								const Vector3 *extentsB)
+{
+	return fabsf(centerA->x - centerB->x) <= extentsA->x + extentsB->x &&
+		   fabsf(centerA->y - centerB->y) <= extentsA->y + extentsB->y &&
+		   fabsf(centerA->z - centerB->z) <= extentsA->z + extentsB->z;
+}
+
+void BvhQueryBox(const Bvh *bvh, const Vector3 *center, const Vector3 *extents, List *items)
+{
+	if (bvh->nodeCount == 0)
+	{
+		return;
+	}
+	uint32_t stack[BVH_MAX_DEPTH + 1];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize != 0)
+	{
+		const BvhNode *node = &bvh->nodes[stack[--stackSize]];
+		if (!BoxesOverlap(center, extents, &node->center, &node->extents))
+		{
+			continue;
+		}
+		if (node->firstChild != 0)
+		{
+			stack[stackSize++] = node->firstChild;
+			stack[stackSize++] = node->firstChild + 1;
+			continue;
+		}
+		for (uint32_t i = 0; i < node->itemCount; i++)
+		{
+			const uint32_t item = bvh->items[node->firstItem + i];
+			if (BoxesOverlap(center, extents, &bvh->itemCenters[item], &bvh->itemExtents[item]))
+			{
+				ListAdd(*items, item);
+			}
+		}
+	}
+}
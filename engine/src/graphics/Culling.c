@@ -0,0 +1,578 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <cglm/cglm.h>
+#include <cglm/clipspace/persp_lh_zo.h>
+#include <engine/graphics/Culling.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/helpers/MathEx.h>
+#include <engine/physics/Physics.h>
+#include <engine/structs/Camera.h>
+#include <engine/structs/Map.h>
+#include <engine/subsystem/Error.h>
+#include <float.h>
+#include <joltc/Math/Vector3.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// A batch of floats that is operated on at once, which compiles to SSE or NEON instructions where they are available
+typedef float CullingFloats __attribute__((vector_size(CULLING_BATCH_SIZE * sizeof(float))));
+/// The result of comparing two @c CullingFloats, with every bit set in lanes where the comparison is true
+typedef int32_t CullingMask __attribute__((vector_size(CULLING_BATCH_SIZE * sizeof(int32_t))));
+
+/// The extent that empty boxes use, which is negative so that the box is outside of every plane
+#define EMPTY_BOX_EXTENT (-FLT_MAX)
+/**
+ * How much closer than the occluders a box has to be to count as visible. This keeps geometry that is also drawn as an
+ * occluder from hiding itself due to rounding.
+ */
+#define OCCLUSION_DEPTH_BIAS 1e-6f
+
+void CameraMatrices(const Camera *camera, const float aspectRatio, mat4 *viewMatrix, mat4 *projectionMatrix)
+{
+	glm_perspective_lh_zo(glm_rad(camera->fov), aspectRatio, NEAR_Z, FAR_Z, *projectionMatrix);
+
+	versor rotationQuat;
+	QUAT_TO_VERSOR(camera->transform.rotation, rotationQuat);
+	versor rotationOffset;
+	glm_quatv(rotationOffset, GLM_PIf, GLM_XUP);
+	glm_quat_mul(rotationQuat, rotationOffset, rotationQuat);
+
+	glm_quat_look(VECTOR3_TO_VEC3(camera->transform.position), rotationQuat, *viewMatrix);
+}
+
+void CameraViewProjectionMatrix(const Camera *camera, const float aspectRatio, mat4 *viewProjectionMatrix)
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	CameraMatrices(camera, aspectRatio, &viewMatrix, &projectionMatrix);
+	glm_mat4_mul(projectionMatrix, viewMatrix, *viewProjectionMatrix);
+}
+
+void FrustumFromMatrix(mat4 viewProjectionMatrix, Frustum *frustum)
+{
+	// This uses the OpenGL clip space depth range, so the near plane ends up slightly behind the camera instead of at
+	// NEAR_Z. That only makes the test more conservative.
+	glm_frustum_planes(viewProjectionMatrix, frustum->planes);
+}
+
+void CameraFrustum(const Camera *camera, const float aspectRatio, Frustum *frustum)
+{
+	mat4 viewProjectionMatrix;
+	CameraViewProjectionMatrix(camera, aspectRatio, &viewProjectionMatrix);
+	FrustumFromMatrix(viewProjectionMatrix, frustum);
+}
+
+void TransformBoundingBox(mat4 transformMatrix,
+						  const Vector3 *origin,
+						  const Vector3 *extents,
+						  Vector3 *worldCenter,
+						  Vector3 *worldExtents)
+{
+	vec3 center;
+	glm_mat4_mulv3(transformMatrix, VECTOR3_TO_VEC3(*origin), 1.0f, center);
+	*worldCenter = VEC3_TO_VECTOR3(center);
+
+	// Each world axis of the box spans the projection of the rotated and scaled model axes onto it
+	float axisExtents[3];
+	for (int row = 0; row < 3; row++)
+	{
+		axisExtents[row] = fabsf(transformMatrix[0][row]) * extents->x +
+						   fabsf(transformMatrix[1][row]) * extents->y +
+						   fabsf(transformMatrix[2][row]) * extents->z;
+	}
+	worldExtents->x = axisExtents[0];
+	worldExtents->y = axisExtents[1];
+	worldExtents->z = axisExtents[2];
+}
+
+static inline void SetEmptyBoxes(const CullingBounds *bounds, const size_t firstIndex, const size_t endIndex)
+{
+	for (size_t i = firstIndex; i < endIndex; i++)
+	{
+		bounds->centerX[i] = 0;
+		bounds->centerY[i] = 0;
+		bounds->centerZ[i] = 0;
+		bounds->extentX[i] = EMPTY_BOX_EXTENT;
+		bounds->extentY[i] = EMPTY_BOX_EXTENT;
+		bounds->extentZ[i] = EMPTY_BOX_EXTENT;
+	}
+}
+
+void CullingBoundsResize(CullingBounds *bounds, const size_t count)
+{
+	if (count > bounds->capacity)
+	{
+		const size_t oldCapacity = bounds->capacity;
+		size_t capacity = max(bounds->capacity * 2, CULLING_BATCH_SIZE * 16);
+		while (capacity < count)
+		{
+			capacity *= 2;
+		}
+		float **arrays[] = {
+			&bounds->centerX,
+			&bounds->centerY,
+			&bounds->centerZ,
+			&bounds->extentX,
+			&bounds->extentY,
+			&bounds->extentZ,
+		};
+		for (size_t i = 0; i < sizeof(arrays) / sizeof(*arrays); i++)
+		{
+			float *array = realloc(*arrays[i], capacity * sizeof(float));
+			CheckAlloc(array);
+			*arrays[i] = array;
+		}
+		bounds->capacity = capacity;
+		// The boxes after count are tested along with the rest of their batch, so they are kept initialized as well
+		SetEmptyBoxes(bounds, oldCapacity, capacity);
+	}
+	if (count > bounds->count)
+	{
+		SetEmptyBoxes(bounds, bounds->count, count);
+	}
+	bounds->count = count;
+}
+
+void CullingBoundsSet(CullingBounds *bounds, const size_t index, const Vector3 *center, const Vector3 *extents)
+{
+	bounds->centerX[index] = center->x;
+	bounds->centerY[index] = center->y;
+	bounds->centerZ[index] = center->z;
+	bounds->extentX[index] = extents->x;
+	bounds->extentY[index] = extents->y;
+	bounds->extentZ[index] = extents->z;
+}
+
+void CullingBoundsFree(CullingBounds *bounds)
+{
+	free(bounds->centerX);
+	free(bounds->centerY);
+	free(bounds->centerZ);
+	free(bounds->extentX);
+	free(bounds->extentY);
+	free(bounds->extentZ);
+	memset(bounds, 0, sizeof(CullingBounds));
+}
+
+static inline CullingFloats LoadCullingFloats(const float *array, const size_t index)
+{
+	CullingFloats floats;
+	memcpy(&floats, array + index, sizeof(floats));
+	return floats;
+}
+
+size_t CullBoundingBoxes(const Frustum *frustum, const CullingBounds *bounds, uint8_t *visible)
+{
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < bounds->count; i += CULLING_BATCH_SIZE)
+	{
+		const CullingFloats centerX = LoadCullingFloats(bounds->centerX, i);
+		const CullingFloats centerY = LoadCullingFloats(bounds->centerY, i);
+		const CullingFloats centerZ = LoadCullingFloats(bounds->centerZ, i);
+		const CullingFloats extentX = LoadCullingFloats(bounds->extentX, i);
+		const CullingFloats extentY = LoadCullingFloats(bounds->extentY, i);
+		const CullingFloats extentZ = LoadCullingFloats(bounds->extentZ, i);
+
+		// A box is outside of a plane if even its corner furthest along the plane normal is behind the plane
+		CullingMask outside = {};
+		for (int j = 0; j < 6; j++)
+		{
+			const float *plane = frustum->planes[j];
+			const CullingFloats distance = centerX * plane[0] + centerY * plane[1] + centerZ * plane[2] + plane[3];
+			const CullingFloats radius = extentX * fabsf(plane[0]) +
+										 extentY * fabsf(plane[1]) +
+										 extentZ * fabsf(plane[2]);
+			outside |= distance + radius < 0;
+		}
+
+		const size_t batchCount = min(bounds->count - i, CULLING_BATCH_SIZE);
+		for (size_t j = 0; j < batchCount; j++)
+		{
+			visible[i + j] = outside[j] == 0;
+			visibleCount += visible[i + j];
+		}
+	}
+	return visibleCount;
+}
+
+typedef struct OccluderCandidate OccluderCandidate;
+
+struct OccluderCandidate
+{
+	float area;
+	const MapModel *model;
+	/// The index in the model's index array of the first index of the triangle
+	uint32_t firstIndex;
+};
+
+static int OccluderCandidateAreaCompare(const void *a, const void *b)
+{
+	const float areaA = ((const OccluderCandidate *)a)->area;
+	const float areaB = ((const OccluderCandidate *)b)->area;
+	return (areaA < areaB) - (areaA > areaB);
+}
+
+static inline float TriangleArea(const Vector3 *a, const Vector3 *b, const Vector3 *c)
+{
+	const Vector3 ab = {b->x - a->x, b->y - a->y, b->z - a->z};
+	const Vector3 ac = {c->x - a->x, c->y - a->y, c->z - a->z};
+	const Vector3 cross = {
+		ab.y * ac.z - ab.z * ac.y,
+		ab.z * ac.x - ab.x * ac.z,
+		ab.x * ac.y - ab.y * ac.x,
+	};
+	return sqrtf(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z) / 2.0f;
+}
+
+void ExtractOccluders(Map *map)
+{
+	free(map->occluderVertices);
+	map->occluderVertices = NULL;
+	map->occluderTriangleCount = 0;
+
+	size_t triangleCount = 0;
+	for (size_t i = 0; i < map->modelCount; i++)
+	{
+		triangleCount += map->models[i].indexCount / 3;
+	}
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	OccluderCandidate *candidates = malloc(triangleCount * sizeof(OccluderCandidate));
+	CheckAlloc(candidates);
+	size_t candidateCount = 0;
+	for (size_t i = 0; i < map->modelCount; i++)
+	{
+		const MapModel *model = map->models + i;
+		for (uint32_t j = 0; j + 2 < model->indexCount; j += 3)
+		{
+			const uint32_t *indices = model->indices + j;
+			if (indices[0] >= model->vertexCount ||
+				indices[1] >= model->vertexCount ||
+				indices[2] >= model->vertexCount)
+			{
+				continue;
+			}
+			const float area = TriangleArea(&model->vertices[indices[0]].position,
+											&model->vertices[indices[1]].position,
+											&model->vertices[indices[2]].position);
+			if (area >= OCCLUDER_MIN_AREA)
+			{
+				candidates[candidateCount++] = (OccluderCandidate){area, model, j};
+			}
+		}
+	}
+
+	qsort(candidates, candidateCount, sizeof(OccluderCandidate), OccluderCandidateAreaCompare);
+	const size_t occluderCount = min(candidateCount, OCCLUDER_MAX_TRIANGLES);
+	if (occluderCount != 0)
+	{
+		map->occluderVertices = malloc(occluderCount * 3 * sizeof(Vector3));
+		CheckAlloc(map->occluderVertices);
+		for (size_t i = 0; i < occluderCount; i++)
+		{
+			const OccluderCandidate *candidate = candidates + i;
+			for (int j = 0; j < 3; j++)
+			{
+				const uint32_t index = candidate->model->indices[candidate->firstIndex + j];
+				map->occluderVertices[i * 3 + j] = candidate->model->vertices[index].position;
+			}
+		}
+		map->occluderTriangleCount = occluderCount;
+	}
+	free(candidates);
+}
+
+/**
+ * Clip a triangle in clip space against the near plane
+ * @param triangle The vertices of the triangle
+ * @param polygon Where to write the vertices of the clipped polygon
+ * @return The number of vertices in @c polygon, which is 0, 3 or 4
+ */
+static inline int ClipToNearPlane(vec4 triangle[3], vec4 polygon[4])
+{
+	int vertexCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		float *current = triangle[i];
+		float *next = triangle[(i + 1) % 3];
+		if (current[2] >= 0)
+		{
+			glm_vec4_copy(current, polygon[vertexCount++]);
+		}
+		if ((current[2] >= 0) != (next[2] >= 0))
+		{
+			glm_vec4_lerp(current, next, current[2] / (current[2] - next[2]), polygon[vertexCount++]);
+		}
+	}
+	return vertexCount;
+}
+
+/**
+ * Check whether every vertex of a triangle is on the outside of the same clip space plane
+ */
+static inline bool TriangleOutsideClipSpace(vec4 triangle[3])
+{
+	int outsideFlags = ~0;
+	for (int i = 0; i < 3; i++)
+	{
+		const float *vertex = triangle[i];
+		outsideFlags &= (vertex[0] < -vertex[3]) |
+						(vertex[0] > vertex[3]) << 1 |
+						(vertex[1] < -vertex[3]) << 2 |
+						(vertex[1] > vertex[3]) << 3 |
+						(vertex[2] < 0) << 4 |
+						(vertex[2] > vertex[3]) << 5;
+	}
+	return outsideFlags != 0;
+}
+
+/**
+ * Transform a vertex from clip space into the pixel coordinates and depth of the first level of the depth buffer
+ */
+static inline void ClipToBuffer(const vec4 clip, vec3 buffer)
+{
+	const float inverseW = 1.0f / clip[3];
+	buffer[0] = (clip[0] * inverseW * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+	buffer[1] = (clip[1] * inverseW * 0.5f + 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+	buffer[2] = clip[2] * inverseW;
+}
+
+/**
+ * Draw one triangle into the first level of the depth buffer, four pixels at a time
+ * @return @c true if the triangle faces the camera and covers part of the buffer
+ */
+static bool DrawOccluderTriangle(float *depth, const float *a, const float *b, const float *c)
+{
+	// Map geometry is drawn with counter-clockwise front faces, which have a negative area here since Y points down
+	const float signedArea = (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+	if (signedArea >= 0)
+	{
+		return false;
+	}
+	// Swap two of the vertices so that the edge functions below are positive inside of the triangle
+	const float *vertices[3] = {a, c, b};
+
+	const int minX = max((int)floorf(fminf(a[0], fminf(b[0], c[0]))), 0) & ~(CULLING_BATCH_SIZE - 1);
+	const int maxX = min((int)ceilf(fmaxf(a[0], fmaxf(b[0], c[0]))), OCCLUSION_BUFFER_WIDTH);
+	const int minY = max((int)floorf(fminf(a[1], fminf(b[1], c[1]))), 0);
+	const int maxY = min((int)ceilf(fmaxf(a[1], fmaxf(b[1], c[1]))), OCCLUSION_BUFFER_HEIGHT);
+	if (minX >= maxX || minY >= maxY)
+	{
+		return false;
+	}
+
+	// Pixels are written when their center is inside of the triangle, so triangles that share an edge leave no gaps
+	float edgeStepX[3];
+	float edgeStepY[3];
+	float edgeOffset[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const float *start = vertices[i];
+		const float *end = vertices[(i + 1) % 3];
+		edgeStepX[i] = start[1] - end[1];
+		edgeStepY[i] = end[0] - start[0];
+		edgeOffset[i] = -edgeStepX[i] * start[0] - edgeStepY[i] * start[1];
+	}
+
+	// The depth is interpolated across the triangle, and moved to the furthest depth within each pixel
+	const float depthStepX = ((b[2] - a[2]) * (c[1] - a[1]) - (c[2] - a[2]) * (b[1] - a[1])) / signedArea;
+	const float depthStepY = ((c[2] - a[2]) * (b[0] - a[0]) - (b[2] - a[2]) * (c[0] - a[0])) / signedArea;
+	const float depthOffset = a[2] -
+							  depthStepX * a[0] -
+							  depthStepY * a[1] +
+							  (fabsf(depthStepX) + fabsf(depthStepY)) / 2.0f;
+
+	const CullingFloats laneOffsets = {0.5f, 1.5f, 2.5f, 3.5f};
+	for (int y = minY; y < maxY; y++)
+	{
+		const float centerY = (float)y + 0.5f;
+		float *row = depth + (size_t)y * OCCLUSION_BUFFER_WIDTH;
+		for (int x = minX; x < maxX; x += CULLING_BATCH_SIZE)
+		{
+			const CullingFloats centerX = laneOffsets + (float)x;
+			CullingMask covered = centerX * edgeStepX[0] + (centerY * edgeStepY[0] + edgeOffset[0]) >= 0;
+			covered &= centerX * edgeStepX[1] + (centerY * edgeStepY[1] + edgeOffset[1]) >= 0;
+			covered &= centerX * edgeStepX[2] + (centerY * edgeStepY[2] + edgeOffset[2]) >= 0;
+
+			const CullingFloats oldDepth = LoadCullingFloats(row, x);
+			const CullingFloats newDepth = centerX * depthStepX + (centerY * depthStepY + depthOffset);
+			const CullingMask write = covered & (newDepth < oldDepth);
+			const CullingMask result = ((CullingMask)newDepth & write) | ((CullingMask)oldDepth & ~write);
+			memcpy(row + x, &result, sizeof(result));
+		}
+	}
+	return true;
+}
+
+static inline size_t OcclusionLevelOffset(const int level)
+{
+	size_t offset = 0;
+	for (int i = 0; i < level; i++)
+	{
+		offset += (size_t)(OCCLUSION_BUFFER_WIDTH >> i) * (OCCLUSION_BUFFER_HEIGHT >> i);
+	}
+	return offset;
+}
+
+static inline void BuildDepthLevels(float *depth)
+{
+	size_t width = OCCLUSION_BUFFER_WIDTH;
+	size_t height = OCCLUSION_BUFFER_HEIGHT;
+	const float *source = depth;
+	for (int level = 1; level < OCCLUSION_BUFFER_LEVELS; level++)
+	{
+		float *target = depth + OcclusionLevelOffset(level);
+		for (size_t y = 0; y < height / 2; y++)
+		{
+			const float *sourceRow = source + y * 2 * width;
+			for (size_t x = 0; x < width / 2; x++)
+			{
+				target[y * (width / 2) + x] = fmaxf(fmaxf(sourceRow[x * 2], sourceRow[x * 2 + 1]),
+													fmaxf(sourceRow[width + x * 2], sourceRow[width + x * 2 + 1]));
+			}
+		}
+		source = target;
+		width /= 2;
+		height /= 2;
+	}
+}
+
+void DrawOccluders(OcclusionBuffer *buffer,
+				   mat4 viewProjectionMatrix,
+				   const Vector3 *vertices,
+				   const size_t triangleCount)
+{
+	glm_mat4_copy(viewProjectionMatrix, buffer->viewProjectionMatrix);
+	buffer->trianglesDrawn = 0;
+	for (size_t i = 0; i < OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT; i++)
+	{
+		buffer->depth[i] = 1.0f;
+	}
+
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		vec4 triangle[3];
+		for (int j = 0; j < 3; j++)
+		{
+			const Vector3 *vertex = vertices + i * 3 + j;
+			glm_mat4_mulv(viewProjectionMatrix, (vec4){vertex->x, vertex->y, vertex->z, 1.0f}, triangle[j]);
+		}
+		if (TriangleOutsideClipSpace(triangle))
+		{
+			continue;
+		}
+
+		vec4 polygon[4];
+		const int polygonVertexCount = ClipToNearPlane(triangle, polygon);
+		vec3 bufferPolygon[4];
+		for (int j = 0; j < polygonVertexCount; j++)
+		{
+			ClipToBuffer(polygon[j], bufferPolygon[j]);
+		}
+		bool drawn = false;
+		for (int j = 1; j + 1 < polygonVertexCount; j++)
+		{
+			drawn |= DrawOccluderTriangle(buffer->depth, bufferPolygon[0], bufferPolygon[j], bufferPolygon[j + 1]);
+		}
+		buffer->trianglesDrawn += drawn;
+	}
+
+	BuildDepthLevels(buffer->depth);
+}
+
+/**
+ * Check whether a box is entirely behind the occluders in an occlusion buffer
+ */
+static inline bool BoxOccluded(const OcclusionBuffer *buffer, const Vector3 *center, const Vector3 *extents)
+{
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	float minDepth = FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		vec4 corner = {
+			center->x + (i & 1 ? extents->x : -extents->x),
+			center->y + (i & 2 ? extents->y : -extents->y),
+			center->z + (i & 4 ? extents->z : -extents->z),
+			1.0f,
+		};
+		vec4 clip;
+		glm_mat4_mulv((vec4 *)buffer->viewProjectionMatrix, corner, clip);
+		if (clip[2] < 0)
+		{
+			// The box crosses the near plane, so it is too close to the camera to be hidden
+			return false;
+		}
+		vec3 bufferCorner;
+		ClipToBuffer(clip, bufferCorner);
+		minX = fminf(minX, bufferCorner[0]);
+		minY = fminf(minY, bufferCorner[1]);
+		maxX = fmaxf(maxX, bufferCorner[0]);
+		maxY = fmaxf(maxY, bufferCorner[1]);
+		minDepth = fminf(minDepth, bufferCorner[2]);
+	}
+
+	// Occluders cover every pixel whose center they cover, which can reach up to half a pixel past their edges, so the
+	// box is grown by a pixel to make sure that it is tested against the pixels just outside of an occluder's edge
+	const int firstX = max((int)floorf(minX) - 1, 0);
+	const int firstY = max((int)floorf(minY) - 1, 0);
+	const int lastX = min((int)ceilf(maxX) + 1, OCCLUSION_BUFFER_WIDTH) - 1;
+	const int lastY = min((int)ceilf(maxY) + 1, OCCLUSION_BUFFER_HEIGHT) - 1;
+	if (firstX > lastX || firstY > lastY)
+	{
+		// The box is outside of the buffer, which is left to frustum culling
+		return false;
+	}
+
+	// Use the smallest level at which the box covers no more than two texels in each direction
+	int level = 0;
+	while (level + 1 < OCCLUSION_BUFFER_LEVELS &&
+		   ((lastX >> level) - (firstX >> level) > 1 || (lastY >> level) - (firstY >> level) > 1))
+	{
+		level++;
+	}
+	const float *levelDepth = buffer->depth + OcclusionLevelOffset(level);
+	const int levelWidth = OCCLUSION_BUFFER_WIDTH >> level;
+	for (int y = firstY >> level; y <= lastY >> level; y++)
+	{
+		for (int x = firstX >> level; x <= lastX >> level; x++)
+		{
+			if (levelDepth[y * levelWidth + x] + OCCLUSION_DEPTH_BIAS > minDepth)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+size_t TestOcclusion(const OcclusionBuffer *buffer, const CullingBounds *bounds, uint8_t *visible)
+{
+	size_t occludedCount = 0;
+	for (size_t i = 0; i < bounds->count; i++)
+	{
+		if (!visible[i])
+		{
+			continue;
+		}
+		const Vector3 center = {bounds->centerX[i], bounds->centerY[i], bounds->centerZ[i]};
+		const Vector3 extents = {bounds->extentX[i], bounds->extentY[i], bounds->extentZ[i]};
+		if (BoxOccluded(buffer, &center, &extents))
+		{
+			visible[i] = 0;
+			occludedCount++;
+		}
+	}
+	return occludedCount;
+}
@@ -7,7 +7,7 @@
 #include <engine/graphics/Drawing.h>
 #include <engine/graphics/Font.h>
 #include <engine/graphics/RenderingHelpers.h>
-#include <engine/graphics/vulkan/Vulkan.h>
+#include <engine/graphics/RenderQueue.h>
 #include <engine/physics/PlayerPhysics.h>
 #include <engine/structs/Camera.h>
 #include <engine/structs/Color.h>
@@ -52,22 +52,40 @@ SDL_Surface *ToSDLSurface(const char *texture)
 
 inline void DrawLine(const Vector2 start, const Vector2 end, const float thickness, const Color color)
 {
-	VK_DrawLine((int)start.x, (int)start.y, (int)end.x, (int)end.y, (int)(thickness * GetState()->uiScale), color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_LINE);
+	command->line.startX = (int32_t)start.x;
+	command->line.startY = (int32_t)start.y;
+	command->line.endX = (int32_t)end.x;
+	command->line.endY = (int32_t)end.y;
+	command->line.thickness = (int32_t)(thickness * GetState()->uiScale);
+	command->line.color = color;
 }
 
 inline void DrawOutlineRect(const Vector2 pos, const Vector2 size, const float thickness, const Color color)
 {
-	VK_DrawRectOutline((int)pos.x, (int)pos.y, (int)size.x, (int)size.y, (int)(thickness * GetState()->uiScale), color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_RECT_OUTLINE);
+	command->line.startX = (int32_t)pos.x;
+	command->line.startY = (int32_t)pos.y;
+	command->line.endX = (int32_t)size.x;
+	command->line.endY = (int32_t)size.y;
+	command->line.thickness = (int32_t)(thickness * GetState()->uiScale);
+	command->line.color = color;
 }
 
 inline void DrawTexture(const Vector2 pos, const Vector2 size, const char *texture)
 {
-	VK_DrawTexturedQuad((int)pos.x, (int)pos.y, (int)size.x, (int)size.y, texture);
+	DrawTextureMod(pos, size, texture, &COLOR_WHITE);
 }
 
 inline void DrawTextureMod(const Vector2 pos, const Vector2 size, const char *texture, const Color *color)
 {
-	VK_DrawTexturedQuadMod((int)pos.x, (int)pos.y, (int)size.x, (int)size.y, texture, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_TEXTURED_QUAD);
+	command->quad.x = (int32_t)pos.x;
+	command->quad.y = (int32_t)pos.y;
+	command->quad.w = (int32_t)size.x;
+	command->quad.h = (int32_t)size.y;
+	command->quad.image = LoadImage(texture);
+	command->quad.color = *color;
 }
 
 inline void DrawTextureRegion(const Vector2 pos,
@@ -76,15 +94,7 @@ inline void DrawTextureRegion(const Vector2 pos,
 							  const Vector2 regionStart,
 							  const Vector2 regionEnd)
 {
-	VK_DrawTexturedQuadRegion((int)pos.x,
-							  (int)pos.y,
-							  (int)size.x,
-							  (int)size.y,
-							  (int)regionStart.x,
-							  (int)regionStart.y,
-							  (int)regionEnd.x,
-							  (int)regionEnd.y,
-							  texture);
+	DrawTextureRegionMod(pos, size, texture, regionStart, regionEnd, COLOR_WHITE);
 }
 
 inline void DrawTextureRegionMod(const Vector2 pos,
@@ -94,21 +104,27 @@ inline void DrawTextureRegionMod(const Vector2 pos,
 								 const Vector2 regionEnd,
 								 const Color color)
 {
-	VK_DrawTexturedQuadRegionMod((int)pos.x,
-								 (int)pos.y,
-								 (int)size.x,
-								 (int)size.y,
-								 (int)regionStart.x,
-								 (int)regionStart.y,
-								 (int)regionEnd.x,
-								 (int)regionEnd.y,
-								 texture,
-								 color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_TEXTURED_QUAD_REGION);
+	command->quad.x = (int32_t)pos.x;
+	command->quad.y = (int32_t)pos.y;
+	command->quad.w = (int32_t)size.x;
+	command->quad.h = (int32_t)size.y;
+	command->quad.regionX = (int32_t)regionStart.x;
+	command->quad.regionY = (int32_t)regionStart.y;
+	command->quad.regionW = (int32_t)regionEnd.x;
+	command->quad.regionH = (int32_t)regionEnd.y;
+	command->quad.image = LoadImage(texture);
+	command->quad.color = color;
 }
 
 inline void DrawRect(const int x, const int y, const int w, const int h, const Color color)
 {
-	VK_DrawColoredQuad(x, y, w, h, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_COLORED_QUAD);
+	command->quad.x = x;
+	command->quad.y = y;
+	command->quad.w = w;
+	command->quad.h = h;
+	command->quad.color = color;
 }
 
 void DrawNinePatchTexture(const Vector2 pos,
@@ -193,17 +209,33 @@ void DrawNinePatchTexture(const Vector2 pos,
 
 inline void DrawBatchedQuadsTextured(const BatchedQuadArray *batch, const char *texture, const Color color)
 {
-	VK_DrawTexturedQuadsBatched(batch->verts, batch->quadCount, texture, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_TEXTURED_QUADS_BATCHED);
+	command->batchedQuads.verticesOffset = RenderQueueAddData(batch->verts, sizeof(float) * 16 * batch->quadCount);
+	command->batchedQuads.quadCount = batch->quadCount;
+	command->batchedQuads.image = LoadImage(texture);
+	command->batchedQuads.color = color;
 }
 
 inline void DrawBatchedQuadsColored(const BatchedQuadArray *batch, const Color color)
 {
-	VK_DrawColoredQuadsBatched(batch->verts, batch->quadCount, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_COLORED_QUADS_BATCHED);
+	command->batchedQuads.verticesOffset = RenderQueueAddData(batch->verts, sizeof(float) * 8 * batch->quadCount);
+	command->batchedQuads.quadCount = batch->quadCount;
+	command->batchedQuads.color = color;
 }
 
 inline void DrawUiTriangles(const UiTriangleArray *triangleArray, const char *texture, const Color color)
 {
-	VK_DrawUiTriangles(triangleArray, texture, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_UI_TRIANGLES);
+	command->uiTriangles.verticesOffset = RenderQueueAddData(triangleArray->vertices,
+															 sizeof(*triangleArray->vertices) *
+																	 triangleArray->vertexCount);
+	command->uiTriangles.vertexCount = triangleArray->vertexCount;
+	command->uiTriangles.indicesOffset = RenderQueueAddData(triangleArray->indices,
+															sizeof(uint32_t) * triangleArray->indexCount);
+	command->uiTriangles.indexCount = triangleArray->indexCount;
+	command->uiTriangles.image = LoadImage(texture);
+	command->uiTriangles.color = color;
 }
 
 void DrawJoltDebugRendererDrawLine(void * /*userData*/,
@@ -211,7 +243,10 @@ void DrawJoltDebugRendererDrawLine(void * /*userData*/,
 								   const JPH_RVec3 *to,
 								   const JPH_Color color)
 {
-	VK_DrawJoltDebugRendererLine(from, to, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_JOLT_DEBUG_LINE);
+	command->joltDebug.vertices[0] = *from;
+	command->joltDebug.vertices[1] = *to;
+	command->joltDebug.color = color;
 }
 
 void DrawJoltDebugRendererDrawTriangle(void * /*userData*/,
@@ -221,7 +256,11 @@ void DrawJoltDebugRendererDrawTriangle(void * /*userData*/,
 									   const JPH_Color color,
 									   JPH_DebugRenderer_CastShadow /*castShadow*/)
 {
-	VK_DrawJoltDebugRendererTriangle((Vector3[]){*v1, *v2, *v3}, color);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_JOLT_DEBUG_TRIANGLE);
+	command->joltDebug.vertices[0] = *v1;
+	command->joltDebug.vertices[1] = *v2;
+	command->joltDebug.vertices[2] = *v3;
+	command->joltDebug.color = color;
 }
 
 void RenderInGameMenuBackground()
@@ -272,5 +311,9 @@ void RenderHUD()
 
 void RenderMap3D(Map *map, const Camera *cam)
 {
-	VK_RenderMap(map, cam);
+	RenderCommand *command = RenderQueueAddCommand(RENDER_COMMAND_MAP);
+	command->map.map = map;
+	command->map.camera = *cam;
+	command->map.isPlayerCamera = cam == &map->player.playerCamera;
+	GetMapRenderState(map, &command->map.state);
 }
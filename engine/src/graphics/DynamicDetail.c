@@ -0,0 +1,56 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/DynamicDetail.h>
+#include <engine/helpers/MathEx.h>
+#include <stdint.h>
+
+void DynamicDetailInit(DynamicDetailController *controller, const float scale)
+{
+	controller->scale = scale;
+	controller->smoothedFrameNs = 0;
+	controller->slowFrames = 0;
+	controller->fastFrames = 0;
+}
+
+float DynamicDetailUpdate(DynamicDetailController *controller,
+						  const DynamicDetailSettings *settings,
+						  const uint64_t frameNs)
+{
+	if (controller->smoothedFrameNs == 0)
+	{
+		controller->smoothedFrameNs = (double)frameNs;
+	} else
+	{
+		controller->smoothedFrameNs += ((double)frameNs - controller->smoothedFrameNs) * DYNAMIC_DETAIL_SMOOTHING;
+	}
+
+	const double targetFrameNs = (double)settings->targetFrameNs;
+	if (controller->smoothedFrameNs > targetFrameNs * (1.0 + settings->hysteresis))
+	{
+		controller->fastFrames = 0;
+		controller->slowFrames++;
+		if (controller->slowFrames >= DYNAMIC_DETAIL_DECREASE_FRAMES)
+		{
+			controller->scale *= (float)(targetFrameNs / controller->smoothedFrameNs);
+			controller->slowFrames = 0;
+		}
+	} else if (controller->smoothedFrameNs < targetFrameNs * (1.0 - settings->hysteresis))
+	{
+		controller->slowFrames = 0;
+		controller->fastFrames++;
+		if (controller->fastFrames >= DYNAMIC_DETAIL_INCREASE_FRAMES)
+		{
+			controller->scale += DYNAMIC_DETAIL_INCREASE_STEP;
+			controller->fastFrames = 0;
+		}
+	} else
+	{
+		controller->slowFrames = 0;
+		controller->fastFrames = 0;
+	}
+
+	controller->scale = clamp(controller->scale, settings->minScale, settings->maxScale);
+	return controller->scale;
+}
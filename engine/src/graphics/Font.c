@@ -22,9 +22,56 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325
+#define FNV_PRIME 0x100000001b3
+
+typedef struct TextLayoutKey TextLayoutKey;
+
+typedef struct TextLayout TextLayout;
+
+/// Everything other than the string itself that changes where the glyphs of a string are laid out
+struct TextLayoutKey
+{
+	const Font *font;
+	uint32_t size;
+	FontHorizontalAlign hAlign;
+	FontVerticalAlign vAlign;
+	Vector2 rectPos;
+	Vector2 rectSize;
+	/// The size of the window, since the quads are stored in normalized device coordinates
+	int windowWidth;
+	int windowHeight;
+	/// The length of the string
+	size_t length;
+};
+
+/// The glyph quads of a string that has been drawn recently
+struct TextLayout
+{
+	TextLayoutKey key;
+	/// The hash of the key and the string
+	uint64_t hash;
+	/// The vertices of the glyph quads, laid out like the vertices of a textured @c BatchedQuadArray, or NULL if the
+	/// slot is empty
+	float *vertices;
+	int quadCount;
+	/// A copy of the string, which is stored in the same allocation as @c vertices
+	char *string;
+	/// The value of @c textLayoutFrame when the layout was last drawn
+	uint64_t lastUsedFrame;
+};
+
 Font *smallFont;
 Font *largeFont;
 
+TextLayoutCacheStats textLayoutCacheStats;
+static TextLayoutCacheStats currentFrameTextLayoutStats;
+/// An open addressed hash table of the strings that have been drawn recently
+static TextLayout textLayouts[TEXT_LAYOUT_CACHE_SLOTS];
+static size_t textLayoutCount;
+/// The number of times that @c TrimTextLayoutCache has been called
+static uint64_t textLayoutFrame;
+
 inline void FontDrawString(const Vector2 pos, const char *str, const uint32_t size, const Color color, const Font *font)
 {
 	DrawTextAligned(str, size, color, pos, v2s(FLT_MAX), FONT_HALIGN_LEFT, FONT_VALIGN_TOP, font);
@@ -136,89 +183,182 @@ void TextGetLine(const char *str, const int line, char *out, const size_t outBuf
 	}
 }
 
-void DrawTextAligned(const char *str,
-					 const uint32_t size,
-					 const Color color,
-					 const Vector2 rectPos,
-					 const Vector2 rectSize,
-					 const FontHorizontalAlign hAlign,
-					 const FontVerticalAlign vAlign,
-					 const Font *font)
+/**
+ * Get the character that a font draws for a character of a string
+ * @param font The font
+ * @param character The character of the string
+ * @return The index of the character in the font
+ */
+static inline int FontCharacter(const Font *font, const char character)
 {
-	const size_t stringLength = strlen(str);
-	float *verts = malloc(stringLength * sizeof(float[4][4]));
-	CheckAlloc(verts);
-	uint32_t *indices = malloc(stringLength * sizeof(uint32_t[6]));
-	CheckAlloc(indices);
-	BatchedQuadArray quads;
-	quads.verts = verts;
-	quads.indices = indices;
-	quads.quadCount = (int)stringLength;
+	return font->uppercaseOnly ? (char)toupper(character) : character;
+}
 
-	const double sizeMultiplier = (double)size / font->defaultSize;
-	const float width = (float)(font->width * sizeMultiplier);
-	const float quadHeight = (float)(font->textureHeight * sizeMultiplier);
-	int c = 0;
+/**
+ * Measure the width of one line of text, in the same way as @c MeasureText
+ * @param line The start of the line
+ * @param length The number of characters in the line, which must not include a newline
+ * @param sizeMultiplier The size of the text divided by the default size of the font
+ * @param font The font to use
+ * @return The width of the line
+ */
+static int MeasureLineWidth(const char *line, const size_t length, const double sizeMultiplier, const Font *font)
+{
+	int width = 0;
+	for (size_t i = 0; i < length; i++)
+	{
+		const int character = FontCharacter(font, line[i]);
+		if (character == ' ')
+		{
+			width += (int)((font->spaceWidth + font->charSpacing) * sizeMultiplier);
+			continue;
+		}
+		width += (int)((font->charWidths[character] + font->charSpacing) * sizeMultiplier);
+		if (i == length - 1)
+		{
+			width -= (int)(font->charSpacing * sizeMultiplier); // fix extra spacing at the end of the line
+		}
+	}
+	return width;
+}
+
+static inline uint64_t HashBytes(uint64_t hash, const uint8_t *bytes, const size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
 
-	int lines = 1;
-	for (size_t i = 0; i < stringLength; i++)
+/**
+ * Find a string in the text layout cache
+ * @param key The key of the layout
+ * @param hash The hash of the key and the string
+ * @param str The string
+ * @return The slot of the layout, or the empty slot where it would be inserted if it is not cached
+ */
+static size_t FindTextLayout(const TextLayoutKey *key, const uint64_t hash, const char *str)
+{
+	size_t slot = hash & (TEXT_LAYOUT_CACHE_SLOTS - 1);
+	while (textLayouts[slot].vertices != NULL)
 	{
-		if (str[i] == '\n')
+		const TextLayout *layout = &textLayouts[slot];
+		if (layout->hash == hash &&
+			memcmp(&layout->key, key, sizeof(TextLayoutKey)) == 0 &&
+			memcmp(layout->string, str, key->length) == 0)
+		{
+			return slot;
+		}
+		slot = (slot + 1) & (TEXT_LAYOUT_CACHE_SLOTS - 1);
+	}
+	return slot;
+}
+
+/**
+ * Remove a layout from the text layout cache, moving the layouts after it back so that no lookup skips over the hole
+ * @param slot The slot of the layout
+ */
+static void RemoveTextLayout(const size_t slot)
+{
+	free(textLayouts[slot].vertices);
+	size_t hole = slot;
+	size_t next = (slot + 1) & (TEXT_LAYOUT_CACHE_SLOTS - 1);
+	while (textLayouts[next].vertices != NULL)
+	{
+		const size_t home = textLayouts[next].hash & (TEXT_LAYOUT_CACHE_SLOTS - 1);
+		// A layout can only fill the hole if the hole is between its home slot and the slot it is in
+		if (((next - home) & (TEXT_LAYOUT_CACHE_SLOTS - 1)) >= ((next - hole) & (TEXT_LAYOUT_CACHE_SLOTS - 1)))
+		{
+			textLayouts[hole] = textLayouts[next];
+			hole = next;
+		}
+		next = (next + 1) & (TEXT_LAYOUT_CACHE_SLOTS - 1);
+	}
+	textLayouts[hole].vertices = NULL;
+	textLayoutCount--;
+}
+
+/**
+ * Remove the layout that was drawn the longest time ago from the text layout cache
+ */
+static void RemoveLeastRecentTextLayout()
+{
+	size_t oldestSlot = 0;
+	uint64_t oldestFrame = UINT64_MAX;
+	for (size_t i = 0; i < TEXT_LAYOUT_CACHE_SLOTS; i++)
+	{
+		if (textLayouts[i].vertices != NULL && textLayouts[i].lastUsedFrame < oldestFrame)
 		{
-			lines++;
-			quads.quadCount--;
+			oldestSlot = i;
+			oldestFrame = textLayouts[i].lastUsedFrame;
 		}
 	}
-	int x = 0;
-	int y = (int)rectPos.y;
-	if (vAlign == FONT_VALIGN_MIDDLE)
+	RemoveTextLayout(oldestSlot);
+}
+
+/**
+ * Lay out the glyph quads of a string
+ * @param str The string
+ * @param key The size, font, alignment and bounds to lay the string out with
+ * @param vertices Where to write the quads, with space for one quad for each character that is not a space or newline
+ */
+static void LayoutText(const char *str, const TextLayoutKey *key, float *vertices)
+{
+	const Font *font = key->font;
+	const double sizeMultiplier = (double)key->size / font->defaultSize;
+	const float width = (float)(font->width * sizeMultiplier);
+	const float quadHeight = (float)(font->textureHeight * sizeMultiplier);
+
+	const int lines = StringLineCount(str);
+	int y = (int)key->rectPos.y;
+	if (key->vAlign == FONT_VALIGN_MIDDLE)
 	{
-		y += ((int)rectSize.y - lines * (int)size) / 2;
-	} else if (vAlign == FONT_VALIGN_BOTTOM)
+		y += ((int)key->rectSize.y - lines * (int)key->size) / 2;
+	} else if (key->vAlign == FONT_VALIGN_BOTTOM)
 	{
-		y += (int)rectSize.y - lines * (int)size;
+		y += (int)key->rectSize.y - lines * (int)key->size;
 	}
 
-	for (int i = 0; i < lines; i++)
+	// Each line is measured once from its own start, instead of copying it out and rescanning the string for it
+	float *vert = vertices;
+	const char *line = str;
+	const char *stringEnd = str + key->length;
+	while (true)
 	{
-		char line[256];
-		TextGetLine(str, i, line, 256, font->uppercaseOnly);
-		const Vector2 textSize = MeasureText(line, size, font);
-		if (hAlign == FONT_HALIGN_CENTER)
+		const char *lineEnd = memchr(line, '\n', stringEnd - line);
+		if (lineEnd == NULL)
 		{
-			x = (int)(rectPos.x + (rectSize.x - textSize.x) / 2);
-		} else if (hAlign == FONT_HALIGN_RIGHT)
+			lineEnd = stringEnd;
+		}
+		const size_t lineLength = lineEnd - line;
+		const int lineWidth = MeasureLineWidth(line, lineLength, sizeMultiplier, font);
+		int x = (int)key->rectPos.x;
+		if (key->hAlign == FONT_HALIGN_CENTER)
 		{
-			x = (int)(rectPos.x + rectSize.x - textSize.x);
-		} else
+			x = (int)(key->rectPos.x + (key->rectSize.x - (float)lineWidth) / 2);
+		} else if (key->hAlign == FONT_HALIGN_RIGHT)
 		{
-			x = (int)rectPos.x;
+			x = (int)(key->rectPos.x + key->rectSize.x - (float)lineWidth);
 		}
 		float lx = (float)x;
 		const float ly = (float)y;
-		for (size_t j = 0; line[j] != '\0'; j++)
+		for (size_t j = 0; j < lineLength; j++)
 		{
-			const int fSize = (int)((font->charWidths[(int)line[j]] + font->charSpacing) * sizeMultiplier);
-
-			if (line[j] == ' ')
+			const int character = FontCharacter(font, line[j]);
+			if (character == ' ')
 			{
 				lx += (float)((font->spaceWidth + font->charSpacing) * sizeMultiplier);
-				quads.quadCount--;
-				c--;
 				continue;
 			}
 
 			const Vector2 ndcPos = v2(X_TO_NDC(lx), Y_TO_NDC(ly));
 			const Vector2 ndcPosEnd = v2(X_TO_NDC(lx + width), Y_TO_NDC(ly + quadHeight));
-			const float charUVStart = font->charStartUVs[(int)line[j]];
-			const float charUVEnd = font->charEndUVs[(int)line[j]];
-
-			const size_t charIndex = c + j;
-			const size_t vertexOffset = charIndex * 4;
-			const size_t indexOffset = charIndex * 6;
+			const float charUVStart = font->charStartUVs[character];
+			const float charUVEnd = font->charEndUVs[character];
 
 			// *vert++ is used for optimization reasons (thanks compiler...)
-			float *vert = verts + vertexOffset * 4;
 			*vert++ = ndcPos.x;
 			*vert++ = ndcPos.y;
 			*vert++ = charUVStart;
@@ -234,29 +374,106 @@ void DrawTextAligned(const char *str,
 			*vert++ = ndcPosEnd.x;
 			*vert++ = ndcPos.y;
 			*vert++ = charUVEnd;
-			*vert = 0;
-
-			indices[indexOffset + 0] = 0;
-			indices[indexOffset + 1] = 1;
-			indices[indexOffset + 2] = 2;
-			indices[indexOffset + 3] = 0;
-			indices[indexOffset + 4] = 2;
-			indices[indexOffset + 5] = 3;
-			for (int k = 0; k < 6; k++)
+			*vert++ = 0;
+
+			lx += (float)(int)((font->charWidths[character] + font->charSpacing) * sizeMultiplier);
+		}
+		y += (int)(key->size + font->lineSpacing);
+		if (lineEnd == stringEnd)
+		{
+			break;
+		}
+		line = lineEnd + 1;
+	}
+}
+
+void DrawTextAligned(const char *str,
+					 const uint32_t size,
+					 const Color color,
+					 const Vector2 rectPos,
+					 const Vector2 rectSize,
+					 const FontHorizontalAlign hAlign,
+					 const FontVerticalAlign vAlign,
+					 const Font *font)
+{
+	TextLayoutKey key;
+	// The padding is cleared so that keys can be hashed and compared as bytes
+	memset(&key, 0, sizeof(TextLayoutKey));
+	key.font = font;
+	key.size = size;
+	key.hAlign = hAlign;
+	key.vAlign = vAlign;
+	key.rectPos = rectPos;
+	key.rectSize = rectSize;
+	key.windowWidth = ScaledWindowWidth();
+	key.windowHeight = ScaledWindowHeight();
+	key.length = strlen(str);
+	const uint64_t hash = HashBytes(HashBytes(FNV_OFFSET_BASIS, (const uint8_t *)&key, sizeof(TextLayoutKey)),
+									(const uint8_t *)str,
+									key.length);
+
+	size_t slot = FindTextLayout(&key, hash, str);
+	if (textLayouts[slot].vertices != NULL)
+	{
+		currentFrameTextLayoutStats.hits++;
+	} else
+	{
+		currentFrameTextLayoutStats.misses++;
+		int quadCount = 0;
+		for (size_t i = 0; i < key.length; i++)
+		{
+			if (str[i] != '\n' && str[i] != ' ')
 			{
-				indices[indexOffset + k] += vertexOffset;
+				quadCount++;
 			}
-
-			lx += fSize;
 		}
-		c += (int)strlen(line);
-		y += (int)(size + font->lineSpacing);
+		if (textLayoutCount == TEXT_LAYOUT_CACHE_MAX_ENTRIES)
+		{
+			RemoveLeastRecentTextLayout();
+			slot = FindTextLayout(&key, hash, str);
+		}
+		// The string is stored after the vertices so that the whole layout is one allocation
+		float *vertices = malloc(quadCount * sizeof(float[4][4]) + key.length + 1);
+		CheckAlloc(vertices);
+		LayoutText(str, &key, vertices);
+		TextLayout *layout = &textLayouts[slot];
+		layout->key = key;
+		layout->hash = hash;
+		layout->vertices = vertices;
+		layout->quadCount = quadCount;
+		layout->string = (char *)(vertices + quadCount * 16);
+		memcpy(layout->string, str, key.length + 1);
+		textLayoutCount++;
 	}
 
+	TextLayout *layout = &textLayouts[slot];
+	layout->lastUsedFrame = textLayoutFrame;
+	const BatchedQuadArray quads = {
+		.verts = layout->vertices,
+		.quadCount = layout->quadCount,
+	};
 	DrawBatchedQuadsTextured(&quads, font->texture, color);
+}
 
-	free(verts);
-	free(indices);
+void TrimTextLayoutCache()
+{
+	textLayoutCacheStats = currentFrameTextLayoutStats;
+	textLayoutCacheStats.layouts = textLayoutCount;
+	memset(&currentFrameTextLayoutStats, 0, sizeof(TextLayoutCacheStats));
+	textLayoutFrame++;
+	size_t slot = 0;
+	while (slot < TEXT_LAYOUT_CACHE_SLOTS)
+	{
+		// Removing a layout can move another one into its slot, so the slot is checked again
+		if (textLayouts[slot].vertices != NULL &&
+			textLayouts[slot].lastUsedFrame + TEXT_LAYOUT_CACHE_MAX_AGE < textLayoutFrame)
+		{
+			RemoveTextLayout(slot);
+		} else
+		{
+			slot++;
+		}
+	}
 }
 
 void InitCommonFonts()
@@ -269,6 +486,13 @@ void InitCommonFonts()
 void DestroyCommonFonts()
 {
 	LogDebug("Cleaning up fonts...\n");
+	// The layouts refer to the fonts, and new fonts could be allocated at the same addresses
+	for (size_t i = 0; i < TEXT_LAYOUT_CACHE_SLOTS; i++)
+	{
+		free(textLayouts[i].vertices);
+		textLayouts[i].vertices = NULL;
+	}
+	textLayoutCount = 0;
 	FreeFont(smallFont);
 	FreeFont(largeFont);
 }
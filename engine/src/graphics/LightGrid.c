@@ -0,0 +1,331 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <cglm/cglm.h>
+#include <engine/graphics/LightGrid.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/helpers/MathEx.h>
+#include <engine/structs/Light.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// A batch of floats that is operated on at once, which compiles to SSE or NEON instructions where they are available
+typedef float LightGridFloats __attribute__((vector_size(LIGHT_GRID_BATCH_SIZE * sizeof(float))));
+/// The result of comparing two @c LightGridFloats, with every bit set in lanes where the comparison is true
+typedef int32_t LightGridMask __attribute__((vector_size(LIGHT_GRID_BATCH_SIZE * sizeof(int32_t))));
+
+/// The number of cells in one depth slice of the light grid
+#define LIGHT_GRID_SLICE_CELLS (LIGHT_GRID_WIDTH * LIGHT_GRID_HEIGHT)
+
+/**
+ * Get the view space depth where a depth slice starts
+ * @param slice The index of the slice, which may be one past the last slice to get where the last slice ends
+ */
+static inline float LightGridSliceStart(const size_t slice)
+{
+	if (slice == 0)
+	{
+		return 0.0f;
+	}
+	return LIGHT_GRID_NEAR_Z * powf((float)FAR_Z / LIGHT_GRID_NEAR_Z, (float)(slice - 1) / (LIGHT_GRID_DEPTH - 1));
+}
+
+size_t LightGridSlice(const float viewZ)
+{
+	if (viewZ < LIGHT_GRID_NEAR_Z)
+	{
+		return 0;
+	}
+	const float sliceScale = (LIGHT_GRID_DEPTH - 1) / logf((float)FAR_Z / LIGHT_GRID_NEAR_Z);
+	const float slice = 1.0f + floorf(logf(viewZ / LIGHT_GRID_NEAR_Z) * sliceScale);
+	return (size_t)min(slice, LIGHT_GRID_DEPTH - 1);
+}
+
+/**
+ * Get the view space range that a range of normalized device coordinates covers between two depths
+ * @param ndcStart The start of the range in normalized device coordinates
+ * @param ndcEnd The end of the range in normalized device coordinates
+ * @param nearZ The nearer depth
+ * @param farZ The further depth
+ * @param projectionScale The scale that the projection applies to the axis
+ * @param minimum Where to write the start of the view space range
+ * @param maximum Where to write the end of the view space range
+ */
+static inline void CellAxisBounds(const float ndcStart,
+								  const float ndcEnd,
+								  const float nearZ,
+								  const float farZ,
+								  const float projectionScale,
+								  float *minimum,
+								  float *maximum)
+{
+	const float corners[4] = {
+		ndcStart * nearZ / projectionScale,
+		ndcStart * farZ / projectionScale,
+		ndcEnd * nearZ / projectionScale,
+		ndcEnd * farZ / projectionScale,
+	};
+	*minimum = fminf(fminf(corners[0], corners[1]), fminf(corners[2], corners[3]));
+	*maximum = fmaxf(fmaxf(corners[0], corners[1]), fmaxf(corners[2], corners[3]));
+}
+
+/**
+ * Compute the view space bounding box of every cell of a light grid
+ * @param grid The grid
+ * @param projectionScaleX The horizontal scale of the projection
+ * @param projectionScaleY The vertical scale of the projection
+ */
+static void ComputeCellBounds(LightGrid *grid, const float projectionScaleX, const float projectionScaleY)
+{
+	grid->projectionScaleX = projectionScaleX;
+	grid->projectionScaleY = projectionScaleY;
+	for (size_t slice = 0; slice < LIGHT_GRID_DEPTH; slice++)
+	{
+		const float nearZ = LightGridSliceStart(slice);
+		const float farZ = LightGridSliceStart(slice + 1);
+		for (size_t row = 0; row < LIGHT_GRID_HEIGHT; row++)
+		{
+			const float ndcTop = -1.0f + 2.0f * (float)row / LIGHT_GRID_HEIGHT;
+			const float ndcBottom = -1.0f + 2.0f * (float)(row + 1) / LIGHT_GRID_HEIGHT;
+			for (size_t column = 0; column < LIGHT_GRID_WIDTH; column++)
+			{
+				const float ndcLeft = -1.0f + 2.0f * (float)column / LIGHT_GRID_WIDTH;
+				const float ndcRight = -1.0f + 2.0f * (float)(column + 1) / LIGHT_GRID_WIDTH;
+				const size_t cell = (slice * LIGHT_GRID_HEIGHT + row) * LIGHT_GRID_WIDTH + column;
+				CellAxisBounds(ndcLeft,
+							   ndcRight,
+							   nearZ,
+							   farZ,
+							   projectionScaleX,
+							   &grid->cellMinimumX[cell],
+							   &grid->cellMaximumX[cell]);
+				CellAxisBounds(ndcTop,
+							   ndcBottom,
+							   nearZ,
+							   farZ,
+							   projectionScaleY,
+							   &grid->cellMinimumY[cell],
+							   &grid->cellMaximumY[cell]);
+				grid->cellMinimumZ[cell] = nearZ;
+				grid->cellMaximumZ[cell] = farZ;
+			}
+		}
+	}
+}
+
+static inline LightGridFloats LoadLightGridFloats(const float *array, const size_t index)
+{
+	LightGridFloats floats;
+	memcpy(&floats, array + index, sizeof(floats));
+	return floats;
+}
+
+/**
+ * Get the distance from a point to a range along one axis for a batch of ranges
+ * @param minimum The start of each range
+ * @param maximum The end of each range
+ * @param point The point, in every lane
+ * @return The distance from the point to each range, which is 0 for ranges that contain the point
+ */
+static inline LightGridFloats AxisDistance(const LightGridFloats minimum,
+										   const LightGridFloats maximum,
+										   const LightGridFloats point)
+{
+	// At most one of these is positive, and clearing the negative lanes leaves the distance to the range
+	const LightGridFloats below = minimum - point;
+	const LightGridFloats above = point - maximum;
+	const LightGridMask belowBits = (LightGridMask)below & (below > 0);
+	const LightGridMask aboveBits = (LightGridMask)above & (above > 0);
+	return (LightGridFloats)belowBits + (LightGridFloats)aboveBits;
+}
+
+/**
+ * Get the range of tiles along one axis of the screen that a view space box can cover
+ * @param minimum The start of the box along the axis
+ * @param maximum The end of the box along the axis
+ * @param nearZ The nearest depth of the box, which must be positive
+ * @param farZ The furthest depth of the box
+ * @param projectionScale The scale that the projection applies to the axis
+ * @param tileCount The number of tiles along the axis
+ * @param firstTile Where to write the first tile that the box covers
+ * @param endTile Where to write one past the last tile that the box covers
+ * @return Whether the box covers any tiles
+ */
+static inline bool TileRange(const float minimum,
+							 const float maximum,
+							 const float nearZ,
+							 const float farZ,
+							 const float projectionScale,
+							 const size_t tileCount,
+							 size_t *firstTile,
+							 size_t *endTile)
+{
+	float ndcMinimum;
+	float ndcMaximum;
+	CellAxisBounds(minimum * projectionScale,
+				   maximum * projectionScale,
+				   1.0f / nearZ,
+				   1.0f / farZ,
+				   1.0f,
+				   &ndcMinimum,
+				   &ndcMaximum);
+	if (ndcMaximum < -1.0f || ndcMinimum > 1.0f)
+	{
+		return false;
+	}
+	*firstTile = (size_t)max((ndcMinimum + 1.0f) / 2.0f * (float)tileCount, 0.0f);
+	*endTile = (size_t)min((ndcMaximum + 1.0f) / 2.0f * (float)tileCount + 1.0f, (float)tileCount);
+	return *firstTile < *endTile;
+}
+
+/**
+ * Find the cells of one depth slice that a light reaches, and add them to the cell and light pairs of a light grid
+ * @param grid The grid
+ * @param slice The index of the slice
+ * @param lightIndex The index of the light
+ * @param center The view space position of the light
+ * @param range The range of the light
+ * @param pairCount The number of pairs, which is updated
+ */
+static inline void AssignLightToSlice(LightGrid *grid,
+									  const size_t slice,
+									  const uint16_t lightIndex,
+									  const vec3 center,
+									  const float range,
+									  size_t *pairCount)
+{
+	const size_t sliceCell = slice * LIGHT_GRID_SLICE_CELLS;
+	const float nearZ = max(grid->cellMinimumZ[sliceCell], center[2] - range);
+	const float farZ = min(grid->cellMaximumZ[sliceCell], center[2] + range);
+	size_t firstColumn = 0;
+	size_t endColumn = LIGHT_GRID_WIDTH;
+	size_t firstRow = 0;
+	size_t endRow = LIGHT_GRID_HEIGHT;
+	// Narrowing down the tiles needs the light to be in front of the camera, otherwise every tile is tested
+	if (nearZ > 0 &&
+		(!TileRange(center[0] - range,
+					center[0] + range,
+					nearZ,
+					farZ,
+					grid->projectionScaleX,
+					LIGHT_GRID_WIDTH,
+					&firstColumn,
+					&endColumn) ||
+		 !TileRange(center[1] - range,
+					center[1] + range,
+					nearZ,
+					farZ,
+					grid->projectionScaleY,
+					LIGHT_GRID_HEIGHT,
+					&firstRow,
+					&endRow)))
+	{
+		return;
+	}
+	firstColumn -= firstColumn % LIGHT_GRID_BATCH_SIZE;
+
+	const LightGridFloats centerX = center[0] - (LightGridFloats){};
+	const LightGridFloats centerY = center[1] - (LightGridFloats){};
+	const LightGridFloats centerZ = center[2] - (LightGridFloats){};
+	const LightGridFloats rangeSquared = range * range - (LightGridFloats){};
+	for (size_t row = firstRow; row < endRow; row++)
+	{
+		const size_t rowCell = sliceCell + row * LIGHT_GRID_WIDTH;
+		for (size_t cell = rowCell + firstColumn; cell < rowCell + endColumn; cell += LIGHT_GRID_BATCH_SIZE)
+		{
+			const LightGridFloats distanceX = AxisDistance(LoadLightGridFloats(grid->cellMinimumX, cell),
+														   LoadLightGridFloats(grid->cellMaximumX, cell),
+														   centerX);
+			const LightGridFloats distanceY = AxisDistance(LoadLightGridFloats(grid->cellMinimumY, cell),
+														   LoadLightGridFloats(grid->cellMaximumY, cell),
+														   centerY);
+			const LightGridFloats distanceZ = AxisDistance(LoadLightGridFloats(grid->cellMinimumZ, cell),
+														   LoadLightGridFloats(grid->cellMaximumZ, cell),
+														   centerZ);
+			const LightGridMask inRange = distanceX * distanceX + distanceY * distanceY + distanceZ * distanceZ <=
+										  rangeSquared;
+			for (size_t i = 0; i < LIGHT_GRID_BATCH_SIZE; i++)
+			{
+				if (inRange[i] == 0)
+				{
+					continue;
+				}
+				if (*pairCount == LIGHT_GRID_MAX_INDICES)
+				{
+					grid->droppedIndexCount++;
+					continue;
+				}
+				grid->pairCells[*pairCount] = (uint16_t)(cell + i);
+				grid->pairLights[*pairCount] = lightIndex;
+				(*pairCount)++;
+			}
+		}
+	}
+}
+
+void LightGridBuild(LightGrid *grid,
+					mat4 viewMatrix,
+					mat4 projectionMatrix,
+					const PointLight *lights,
+					const size_t lightCount)
+{
+	if (grid->projectionScaleX != projectionMatrix[0][0] || grid->projectionScaleY != projectionMatrix[1][1])
+	{
+		ComputeCellBounds(grid, projectionMatrix[0][0], projectionMatrix[1][1]);
+	}
+
+	grid->lightCount = min(lightCount, LIGHT_GRID_MAX_LIGHTS);
+	grid->droppedIndexCount = 0;
+	size_t pairCount = 0;
+	for (size_t i = 0; i < grid->lightCount; i++)
+	{
+		const PointLight *light = &lights[i];
+		LightGridLight *gridLight = &grid->lights[i];
+		vec3 position;
+		memcpy(position, light->position, sizeof(vec3));
+		glm_vec4(position, light->range, gridLight->positionRange);
+		memcpy(gridLight->colorAttenuation, light->color, sizeof(vec3));
+		glm_vec3_scale(gridLight->colorAttenuation, light->brightnessScale, gridLight->colorAttenuation);
+		gridLight->colorAttenuation[3] = light->attenuation;
+
+		vec3 center;
+		glm_mat4_mulv3(viewMatrix, position, 1.0f, center);
+		const float range = light->range;
+		if (range <= 0 || center[2] + range < 0 || center[2] - range > (float)FAR_Z)
+		{
+			continue;
+		}
+
+		// Only the depth slices that the light reaches need to be tested
+		const size_t firstSlice = LightGridSlice(max(center[2] - range, 0.0f));
+		const size_t lastSlice = LightGridSlice(center[2] + range);
+		for (size_t slice = firstSlice; slice <= lastSlice; slice++)
+		{
+			AssignLightToSlice(grid, slice, (uint16_t)i, center, range, &pairCount);
+		}
+	}
+
+	// Sort the pairs by cell, which keeps the lights of each cell in the order they were given
+	memset(grid->cells, 0, sizeof(grid->cells));
+	for (size_t i = 0; i < pairCount; i++)
+	{
+		grid->cells[grid->pairCells[i]].lightCount++;
+	}
+	uint32_t firstIndex = 0;
+	for (size_t i = 0; i < LIGHT_GRID_CELLS; i++)
+	{
+		grid->cells[i].firstIndex = firstIndex;
+		firstIndex += grid->cells[i].lightCount;
+		grid->cells[i].lightCount = 0;
+	}
+	for (size_t i = 0; i < pairCount; i++)
+	{
+		LightGridCell *cell = &grid->cells[grid->pairCells[i]];
+		grid->indices[cell->firstIndex + cell->lightCount++] = grid->pairLights[i];
+	}
+	grid->indexCount = pairCount;
+}
@@ -0,0 +1,224 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/Drawing.h>
+#include <engine/graphics/RenderQueue.h>
+#include <engine/graphics/vulkan/Vulkan.h>
+#include <engine/subsystem/Error.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The alignment of every array copied into the data of a command buffer, which is enough for any vertex format
+#define RENDER_QUEUE_DATA_ALIGNMENT 16
+
+static RenderCommandBuffer commandBuffers[RENDER_QUEUE_BUFFER_COUNT];
+/// The index of the command buffer that is being recorded, where the ones before it are the ones that were submitted
+static size_t recordingIndex;
+/// The command buffer that commands are captured into instead of the frame, or NULL if nothing is being captured
+static RenderCommandBuffer *captureBuffer;
+
+static inline RenderCommandBuffer *RecordingBuffer()
+{
+	return captureBuffer != NULL ? captureBuffer : &commandBuffers[recordingIndex];
+}
+
+void RenderQueueBegin()
+{
+	commandBuffers[recordingIndex].commandCount = 0;
+	commandBuffers[recordingIndex].dataSize = 0;
+}
+
+RenderCommand *RenderQueueAddCommand(const RenderCommandType type)
+{
+	RenderCommandBuffer *buffer = RecordingBuffer();
+	if (buffer->commandCount == buffer->commandCapacity)
+	{
+		buffer->commandCapacity = buffer->commandCapacity == 0 ? 256 : buffer->commandCapacity * 2;
+		RenderCommand *newCommands = realloc(buffer->commands, buffer->commandCapacity * sizeof(RenderCommand));
+		CheckAlloc(newCommands);
+		buffer->commands = newCommands;
+	}
+	RenderCommand *command = &buffer->commands[buffer->commandCount++];
+	command->type = type;
+	return command;
+}
+
+size_t RenderQueueAddData(const void *data, const size_t size)
+{
+	RenderCommandBuffer *buffer = RecordingBuffer();
+	const size_t offset = buffer->dataSize;
+	const size_t alignedSize = (size + RENDER_QUEUE_DATA_ALIGNMENT - 1) & ~(size_t)(RENDER_QUEUE_DATA_ALIGNMENT - 1);
+	if (offset + alignedSize > buffer->dataCapacity)
+	{
+		size_t newCapacity = buffer->dataCapacity == 0 ? 65536 : buffer->dataCapacity;
+		while (offset + alignedSize > newCapacity)
+		{
+			newCapacity *= 2;
+		}
+		uint8_t *newData = realloc(buffer->data, newCapacity);
+		CheckAlloc(newData);
+		buffer->data = newData;
+		buffer->dataCapacity = newCapacity;
+	}
+	memcpy(buffer->data + offset, data, size);
+	buffer->dataSize = offset + alignedSize;
+	return offset;
+}
+
+void RenderQueueBeginCapture(RenderCommandBuffer *buffer)
+{
+	buffer->commandCount = 0;
+	buffer->dataSize = 0;
+	captureBuffer = buffer;
+}
+
+void RenderQueueEndCapture()
+{
+	captureBuffer = NULL;
+}
+
+void RenderQueueReplay(const RenderCommandBuffer *buffer)
+{
+	if (buffer->commandCount == 0)
+	{
+		return;
+	}
+	// The data of the buffer is copied as one block, so every offset into it moves by the offset of the copy
+	const size_t dataOffset = buffer->dataSize == 0 ? 0 : RenderQueueAddData(buffer->data, buffer->dataSize);
+	for (size_t i = 0; i < buffer->commandCount; i++)
+	{
+		const RenderCommand *source = &buffer->commands[i];
+		RenderCommand *command = RenderQueueAddCommand(source->type);
+		*command = *source;
+		switch (command->type)
+		{
+			case RENDER_COMMAND_COLORED_QUADS_BATCHED:
+			case RENDER_COMMAND_TEXTURED_QUADS_BATCHED:
+				command->batchedQuads.verticesOffset += dataOffset;
+				break;
+			case RENDER_COMMAND_UI_TRIANGLES:
+				command->uiTriangles.verticesOffset += dataOffset;
+				command->uiTriangles.indicesOffset += dataOffset;
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void RenderQueueFreeBuffer(RenderCommandBuffer *buffer)
+{
+	free(buffer->commands);
+	free(buffer->data);
+	memset(buffer, 0, sizeof(RenderCommandBuffer));
+}
+
+const RenderCommandBuffer *RenderQueueSwap()
+{
+	const RenderCommandBuffer *recorded = &commandBuffers[recordingIndex];
+	recordingIndex = (recordingIndex + 1) % RENDER_QUEUE_BUFFER_COUNT;
+	return recorded;
+}
+
+void RenderQueueExecute(const RenderCommandBuffer *buffer)
+{
+	for (size_t i = 0; i < buffer->commandCount; i++)
+	{
+		const RenderCommand *command = &buffer->commands[i];
+		switch (command->type)
+		{
+			case RENDER_COMMAND_COLORED_QUAD:
+				VK_DrawColoredQuad(command->quad.x,
+								   command->quad.y,
+								   command->quad.w,
+								   command->quad.h,
+								   command->quad.color);
+				break;
+			case RENDER_COMMAND_TEXTURED_QUAD:
+				VK_DrawTexturedQuadMod(command->quad.x,
+									   command->quad.y,
+									   command->quad.w,
+									   command->quad.h,
+									   command->quad.image,
+									   &command->quad.color);
+				break;
+			case RENDER_COMMAND_TEXTURED_QUAD_REGION:
+				VK_DrawTexturedQuadRegionMod(command->quad.x,
+											 command->quad.y,
+											 command->quad.w,
+											 command->quad.h,
+											 command->quad.regionX,
+											 command->quad.regionY,
+											 command->quad.regionW,
+											 command->quad.regionH,
+											 command->quad.image,
+											 command->quad.color);
+				break;
+			case RENDER_COMMAND_COLORED_QUADS_BATCHED:
+				VK_DrawColoredQuadsBatched((const float *)(buffer->data + command->batchedQuads.verticesOffset),
+										   command->batchedQuads.quadCount,
+										   command->batchedQuads.color);
+				break;
+			case RENDER_COMMAND_TEXTURED_QUADS_BATCHED:
+				VK_DrawTexturedQuadsBatched((const float *)(buffer->data + command->batchedQuads.verticesOffset),
+											command->batchedQuads.quadCount,
+											command->batchedQuads.image,
+											command->batchedQuads.color);
+				break;
+			case RENDER_COMMAND_LINE:
+				VK_DrawLine(command->line.startX,
+							command->line.startY,
+							command->line.endX,
+							command->line.endY,
+							command->line.thickness,
+							command->line.color);
+				break;
+			case RENDER_COMMAND_RECT_OUTLINE:
+				VK_DrawRectOutline(command->line.startX,
+								   command->line.startY,
+								   command->line.endX,
+								   command->line.endY,
+								   command->line.thickness,
+								   command->line.color);
+				break;
+			case RENDER_COMMAND_UI_TRIANGLES:
+			{
+				const UiTriangleArray triangleArray = {
+					.vertices = (float (*)[4])(buffer->data + command->uiTriangles.verticesOffset),
+					.indices = (uint32_t (*)[3])(buffer->data + command->uiTriangles.indicesOffset),
+					.vertexCount = command->uiTriangles.vertexCount,
+					.indexCount = command->uiTriangles.indexCount,
+				};
+				VK_DrawUiTriangles(&triangleArray, command->uiTriangles.image, command->uiTriangles.color);
+				break;
+			}
+			case RENDER_COMMAND_JOLT_DEBUG_LINE:
+				VK_DrawJoltDebugRendererLine(&command->joltDebug.vertices[0],
+											 &command->joltDebug.vertices[1],
+											 command->joltDebug.color);
+				break;
+			case RENDER_COMMAND_JOLT_DEBUG_TRIANGLE:
+				VK_DrawJoltDebugRendererTriangle(command->joltDebug.vertices, command->joltDebug.color);
+				break;
+			case RENDER_COMMAND_MAP:
+				VK_RenderMap(command->map.map,
+							 &command->map.camera,
+							 &command->map.state,
+							 command->map.isPlayerCamera);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void RenderQueueDestroy()
+{
+	for (size_t i = 0; i < RENDER_QUEUE_BUFFER_COUNT; i++)
+	{
+		RenderQueueFreeBuffer(&commandBuffers[i]);
+	}
+}
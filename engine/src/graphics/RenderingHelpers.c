@@ -8,8 +8,11 @@
 #include <cglm/types.h>
 #include <engine/assets/AssetReader.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/graphics/Font.h>
 #include <engine/graphics/RenderingHelpers.h>
+#include <engine/graphics/RenderQueue.h>
 #include <engine/graphics/vulkan/Vulkan.h>
+#include <engine/graphics/vulkan/VulkanActors.h>
 #include <engine/helpers/MathEx.h>
 #include <engine/structs/Actor.h>
 #include <engine/structs/Color.h>
@@ -19,6 +22,7 @@
 #include <engine/structs/Vector2.h>
 #include <engine/subsystem/Error.h>
 #include <engine/subsystem/Logging.h>
+#include <engine/subsystem/threads/RenderThread.h>
 #include <joltc/Math/RMat44.h>
 #include <joltc/Physics/Body/BodyID.h>
 #include <joltc/Physics/Body/BodyInterface.h>
@@ -36,6 +40,16 @@ int windowWidth;
 int windowHeight;
 
 RendererQueuedAction rendererQueuedActions = 0;
+RenderStats renderStats;
+RenderStats lastRenderStats;
+const char *const renderPassTimingNames[RENDER_PASS_TIMING_COUNT] = {
+	[RENDER_PASS_TIMING_SKY] = "Sky",
+	[RENDER_PASS_TIMING_MAP] = "Map",
+	[RENDER_PASS_TIMING_ACTORS] = "Actors",
+	[RENDER_PASS_TIMING_WALLS] = "Walls",
+	[RENDER_PASS_TIMING_VIEWMODEL] = "Viewmodel",
+	[RENDER_PASS_TIMING_UI] = "UI",
+};
 OptionsMsaa qaNewFrameufferMsaaValue = MSAA_NONE;
 
 void SetGameWindow(SDL_Window *w)
@@ -143,19 +157,27 @@ bool FrameStart()
 {
 	if ((rendererQueuedActions & QUEUED_ACTION_RELOAD_ALL_ASSETS) != 0)
 	{
+		RenderThreadWaitIdle();
 		HotReloadAssets();
 		rendererQueuedActions &= ~QUEUED_ACTION_RELOAD_ALL_ASSETS;
 	}
-	return VK_FrameStart();
+	if (VK_IsMinimized())
+	{
+		return false;
+	}
+	TrimTextLayoutCache();
+	RenderQueueBegin();
+	return true;
 }
 
 void FrameEnd()
 {
-	VK_FrameEnd();
+	RenderThreadSubmitFrame();
 }
 
 inline void UpdateViewportSize()
 {
+	RenderThreadWaitIdle();
 	const float newScaleX = ActualWindowSize().x / DEF_WIDTH;
 	const float newScaleY = ActualWindowSize().y / DEF_HEIGHT;
 	float newScale = newScaleX < newScaleY ? newScaleX : newScaleY;
@@ -168,11 +190,13 @@ inline void UpdateViewportSize()
 inline void WindowObscured()
 {
 	windowFocused = false;
+	RenderThreadWaitIdle();
 	VK_Minimize();
 }
 
 inline void WindowRestored()
 {
+	RenderThreadWaitIdle();
 	VK_Restore();
 }
 
@@ -204,10 +228,21 @@ inline float Y_TO_NDC(const float y)
 void LoadMapModels(Map *map)
 {
 	assert(map->lightmapPixels && map->models);
+	RenderThreadWaitIdle();
 	VK_LoadMap(map);
 	FreeLoadTimeMapData(map);
 }
 
+void NotifyActorAdded(Actor *actor)
+{
+	RegisterActorInstance(actor);
+}
+
+void NotifyActorRemoved(Actor *actor)
+{
+	UnregisterActorInstance(actor);
+}
+
 inline void GetColor(const uint32_t argb, Color *color)
 {
 	color->r = (float)(argb >> 16 & 0xFF) / 255.0f;
@@ -0,0 +1,76 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <assert.h>
+#include <engine/graphics/StagingRing.h>
+#include <engine/subsystem/Error.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+void StagingRingInit(StagingRing *ring, const size_t capacity)
+{
+	ring->memory = malloc(capacity);
+	CheckAlloc(ring->memory);
+	ring->capacity = capacity;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->firstRegion = 0;
+	ring->regionCount = 0;
+}
+
+void StagingRingDestroy(StagingRing *ring)
+{
+	free(ring->memory);
+	ring->memory = NULL;
+	ring->capacity = 0;
+}
+
+void *StagingRingAllocate(StagingRing *ring, const size_t bytes, const uint64_t serial)
+{
+	const size_t alignedBytes = (bytes + STAGING_RING_ALIGNMENT - 1) & ~(size_t)(STAGING_RING_ALIGNMENT - 1);
+	if (alignedBytes == 0 || alignedBytes > ring->capacity || ring->regionCount == STAGING_RING_MAX_REGIONS)
+	{
+		return NULL;
+	}
+	assert(ring->regionCount == 0 ||
+		   ring->regions[(ring->firstRegion + ring->regionCount - 1) % STAGING_RING_MAX_REGIONS].serial <= serial);
+
+	uint64_t start = ring->head;
+	const size_t offset = start % ring->capacity;
+	if (offset + alignedBytes > ring->capacity)
+	{
+		// The allocation has to be contiguous, so the space left before the end of the memory is skipped
+		start += ring->capacity - offset;
+	}
+	const uint64_t end = start + alignedBytes;
+	if (end - ring->tail > ring->capacity)
+	{
+		return NULL;
+	}
+
+	ring->regions[(ring->firstRegion + ring->regionCount) % STAGING_RING_MAX_REGIONS] = (StagingRingRegion){
+		.end = end,
+		.serial = serial,
+	};
+	ring->regionCount++;
+	ring->head = end;
+	return ring->memory + start % ring->capacity;
+}
+
+void StagingRingRelease(StagingRing *ring, const uint64_t pendingSerial)
+{
+	while (ring->regionCount > 0 && ring->regions[ring->firstRegion].serial < pendingSerial)
+	{
+		ring->tail = ring->regions[ring->firstRegion].end;
+		ring->firstRegion = (ring->firstRegion + 1) % STAGING_RING_MAX_REGIONS;
+		ring->regionCount--;
+	}
+	if (ring->regionCount == 0)
+	{
+		// Starting over at the beginning of the memory keeps large allocations from having to skip the end
+		ring->head = 0;
+		ring->tail = 0;
+	}
+}
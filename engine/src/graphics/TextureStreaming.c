@@ -0,0 +1,162 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/assets/TextureLoader.h>
+#include <engine/assets/TextureMipmaps.h>
+#include <engine/graphics/TextureStreaming.h>
+#include <engine/helpers/MathEx.h>
+#include <joltc/Math/Vector3.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+void StreamedTextureInit(StreamedTexture *texture,
+						 const ImagePixelFormat format,
+						 const size_t width,
+						 const size_t height,
+						 const uint8_t levelCount,
+						 const bool streamed)
+{
+	memset(texture, 0, sizeof(StreamedTexture));
+	texture->baseSize = max(width, height);
+	if (!streamed || levelCount <= 1)
+	{
+		texture->levelCount = 1;
+		texture->chainBytes[0] = GetMipChainDataSize(format, width, height, levelCount);
+		return;
+	}
+	texture->levelCount = min(levelCount, TEXTURE_STREAMING_MAX_LEVELS);
+	texture->lowestLevel = texture->levelCount - 1;
+	for (uint8_t i = 0; i < texture->levelCount; i++)
+	{
+		const size_t levelWidth = max(width >> i, 1);
+		const size_t levelHeight = max(height >> i, 1);
+		texture->chainBytes[i] = GetMipChainDataSize(format, levelWidth, levelHeight, texture->levelCount - i);
+		if (max(levelWidth, levelHeight) <= TEXTURE_STREAMING_RESIDENT_SIZE && i < texture->lowestLevel)
+		{
+			texture->lowestLevel = i;
+		}
+	}
+	texture->residentLevel = texture->lowestLevel;
+	texture->targetLevel = texture->lowestLevel;
+}
+
+void StreamedTextureSeen(StreamedTexture *texture, const float screenSize)
+{
+	texture->screenSize = fmaxf(texture->screenSize, screenSize);
+}
+
+uint8_t StreamedTextureWantedLevel(const StreamedTexture *texture)
+{
+	if (texture->screenSize < 1.0f)
+	{
+		return texture->lowestLevel;
+	}
+	const float level = floorf(log2f((float)texture->baseSize / texture->screenSize));
+	if (level <= 0.0f)
+	{
+		return 0;
+	}
+	return (uint8_t)min(level, (float)texture->lowestLevel);
+}
+
+float BoundsScreenSize(const Vector3 *cameraPosition,
+					   const float pixelScale,
+					   const Vector3 *center,
+					   const Vector3 *extents)
+{
+	const float radius = sqrtf(extents->x * extents->x + extents->y * extents->y + extents->z * extents->z);
+	const float dx = center->x - cameraPosition->x;
+	const float dy = center->y - cameraPosition->y;
+	const float dz = center->z - cameraPosition->z;
+	const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+	return 2.0f * radius / fmaxf(distance - radius, radius) * pixelScale;
+}
+
+static int CompareSortKeysDescending(const void *a, const void *b)
+{
+	const uint64_t keyA = *(const uint64_t *)a;
+	const uint64_t keyB = *(const uint64_t *)b;
+	return (keyA < keyB) - (keyA > keyB);
+}
+
+size_t TextureStreamingPlan(StreamedTexture *textures,
+							const size_t textureCount,
+							const size_t budgetBytes,
+							uint32_t *order)
+{
+	if (textureCount == 0)
+	{
+		return 0;
+	}
+	size_t residentBytes = 0;
+	uint8_t wantedLevels[textureCount];
+	// Screen sizes are never negative, so the bits of the float sort the same way as the float itself
+	uint64_t sortKeys[textureCount];
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		StreamedTexture *texture = &textures[i];
+		texture->targetLevel = texture->lowestLevel;
+		residentBytes += texture->chainBytes[texture->lowestLevel];
+		wantedLevels[i] = StreamedTextureWantedLevel(texture);
+		uint32_t screenSizeBits;
+		memcpy(&screenSizeBits, &texture->screenSize, sizeof(uint32_t));
+		sortKeys[i] = (uint64_t)screenSizeBits << 32 | i;
+	}
+	qsort(sortKeys, textureCount, sizeof(uint64_t), CompareSortKeysDescending);
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		order[i] = (uint32_t)sortKeys[i];
+	}
+
+	// Handing out one level per texture per pass keeps a few large textures from using the whole budget on their most
+	// detailed level while the rest of the screen stays blurry
+	bool gaveLevel = true;
+	while (gaveLevel)
+	{
+		gaveLevel = false;
+		for (size_t i = 0; i < textureCount; i++)
+		{
+			StreamedTexture *texture = &textures[order[i]];
+			if (texture->targetLevel <= wantedLevels[order[i]])
+			{
+				continue;
+			}
+			const size_t addedBytes = texture->chainBytes[texture->targetLevel - 1] -
+									  texture->chainBytes[texture->targetLevel];
+			if (budgetBytes != 0 && residentBytes + addedBytes > budgetBytes)
+			{
+				continue;
+			}
+			texture->targetLevel--;
+			residentBytes += addedBytes;
+			gaveLevel = true;
+		}
+	}
+
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		StreamedTexture *texture = &textures[order[i]];
+		while (texture->targetLevel > texture->residentLevel)
+		{
+			const size_t addedBytes = texture->chainBytes[texture->targetLevel - 1] -
+									  texture->chainBytes[texture->targetLevel];
+			if (budgetBytes != 0 && residentBytes + addedBytes > budgetBytes)
+			{
+				break;
+			}
+			texture->targetLevel--;
+			residentBytes += addedBytes;
+		}
+	}
+
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		textures[i].screenSize *= TEXTURE_STREAMING_SCREEN_SIZE_DECAY;
+	}
+	return residentBytes;
+}
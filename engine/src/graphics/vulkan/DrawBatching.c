@@ -0,0 +1,56 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/vulkan/DrawBatching.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+
+size_t CompactDrawInfo(const VkDrawIndexedIndirectCommand *drawInfo,
+					   const uint32_t *drawInfoClusters,
+					   const size_t drawCount,
+					   const uint8_t *clustersVisible,
+					   VkDrawIndexedIndirectCommand *visibleDrawInfo,
+					   size_t *visibleDrawCount)
+{
+	size_t firstChangedDrawInfo = SIZE_MAX;
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < drawCount; i++)
+	{
+		if (!clustersVisible[drawInfoClusters[i]])
+		{
+			continue;
+		}
+		const bool moved = visibleCount >= *visibleDrawCount ||
+						   visibleDrawInfo[visibleCount].firstIndex != drawInfo[i].firstIndex;
+		if (moved && firstChangedDrawInfo == SIZE_MAX)
+		{
+			firstChangedDrawInfo = visibleCount;
+		}
+		visibleDrawInfo[visibleCount] = drawInfo[i];
+		visibleCount++;
+	}
+	*visibleDrawCount = visibleCount;
+	return firstChangedDrawInfo;
+}
+
+bool JoinTrianglesIntoQuad(const uint32_t first[3], const uint32_t second[3], uint32_t quad[4])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			if (second[j] == first[i] && second[(j + 1) % 3] == first[(i + 2) % 3])
+			{
+				quad[0] = first[i];
+				quad[1] = first[(i + 1) % 3];
+				quad[2] = first[(i + 2) % 3];
+				quad[3] = second[(j + 2) % 3];
+				return true;
+			}
+		}
+	}
+	return false;
+}
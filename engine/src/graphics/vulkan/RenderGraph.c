@@ -0,0 +1,435 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <assert.h>
+#include <engine/graphics/vulkan/RenderGraph.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vulkan/vulkan_core.h>
+
+typedef struct AccessInfo AccessInfo;
+
+typedef struct ResourceState ResourceState;
+
+struct AccessInfo
+{
+	VkPipelineStageFlags stageMask;
+	VkAccessFlags accessMask;
+	VkImageLayout layout;
+	bool write;
+	/// Whether the access happens inside of a render pass, so that it can share a group with other attachment accesses
+	bool attachment;
+};
+
+/// What the passes compiled so far have done to a resource
+struct ResourceState
+{
+	bool used;
+	VkImageLayout layout;
+	/// The stages and access of the last write, which later accesses have to wait for
+	VkPipelineStageFlags writeStageMask;
+	VkAccessFlags writeAccessMask;
+	/// The stages that have read the resource since the last write, which a later write has to wait for
+	VkPipelineStageFlags readStageMask;
+	/// The group of the last pass that accessed the resource
+	size_t group;
+	/// The first and last passes that access the resource
+	size_t firstPass;
+	size_t lastPass;
+	/// The stages of the last access that is not presenting, and its access if it wrote, for the external dependency
+	VkPipelineStageFlags lastStageMask;
+	VkAccessFlags lastAccessMask;
+};
+
+static const AccessInfo ACCESS_INFO[] = {
+	[RENDER_GRAPH_ACCESS_COLOR_WRITE] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+										 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+										 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+										 true,
+										 true},
+	[RENDER_GRAPH_ACCESS_DEPTH_WRITE] = {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+												 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+										 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+										 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+										 true,
+										 true},
+	[RENDER_GRAPH_ACCESS_DEPTH_READ] = {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+												VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+										VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+										VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+										false,
+										true},
+	[RENDER_GRAPH_ACCESS_RESOLVE_WRITE] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+										   VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+										   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+										   true,
+										   true},
+	[RENDER_GRAPH_ACCESS_SAMPLED_READ] = {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+										  VK_ACCESS_SHADER_READ_BIT,
+										  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+										  false,
+										  false},
+	[RENDER_GRAPH_ACCESS_PRESENT] = {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+									 0,
+									 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+									 false,
+									 false},
+};
+
+void RenderGraphInit(RenderGraph *graph)
+{
+	memset(graph, 0, sizeof(RenderGraph));
+}
+
+uint8_t RenderGraphAddResource(RenderGraph *graph,
+							   const char *name,
+							   const VkFormat format,
+							   const VkSampleCountFlagBits samples,
+							   const bool transient)
+{
+	assert(graph->resourceCount < RENDER_GRAPH_MAX_RESOURCES);
+	RenderGraphResource *resource = &graph->resources[graph->resourceCount];
+	resource->name = name;
+	resource->format = format;
+	resource->samples = samples;
+	resource->transient = transient;
+	return graph->resourceCount++;
+}
+
+uint8_t RenderGraphAddPass(RenderGraph *graph, const char *name)
+{
+	assert(graph->passCount < RENDER_GRAPH_MAX_PASSES);
+	RenderGraphPass *pass = &graph->passes[graph->passCount];
+	memset(pass, 0, sizeof(RenderGraphPass));
+	pass->name = name;
+	return graph->passCount++;
+}
+
+void RenderGraphPassAccess(RenderGraph *graph,
+						   const uint8_t pass,
+						   const uint8_t resource,
+						   const RenderGraphAccessType accessType)
+{
+	assert(pass < graph->passCount && resource < graph->resourceCount);
+	RenderGraphPass *renderGraphPass = &graph->passes[pass];
+	assert(renderGraphPass->accessCount < RENDER_GRAPH_MAX_PASS_ACCESSES);
+	renderGraphPass->resources[renderGraphPass->accessCount] = resource;
+	renderGraphPass->accessTypes[renderGraphPass->accessCount] = accessType;
+	renderGraphPass->accessCount++;
+}
+
+/**
+ * Check if a pass can be recorded in the same render pass as the passes of the current group, which is the case when
+ * every access of the pass is an attachment access that does not change the layout of a resource used by the group
+ */
+static bool CanJoinGroup(const RenderGraphPass *pass,
+						 const ResourceState *states,
+						 const size_t group,
+						 const bool groupIsRenderPass)
+{
+	if (!groupIsRenderPass)
+	{
+		return false;
+	}
+	for (uint8_t i = 0; i < pass->accessCount; i++)
+	{
+		const AccessInfo *info = &ACCESS_INFO[pass->accessTypes[i]];
+		const ResourceState *state = &states[pass->resources[i]];
+		if (!info->attachment || (state->used && state->group == group && state->layout != info->layout))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Find the barrier that an access needs after what has already happened to the resource
+ * @return @c true if a barrier is needed, in which case it is written to @c barrier
+ */
+static bool AccessNeedsBarrier(const ResourceState *state,
+							   const AccessInfo *info,
+							   const size_t group,
+							   RenderGraphBarrier *barrier)
+{
+	if (state->group == group && state->layout == info->layout)
+	{
+		// Attachment accesses within one render pass are already ordered by rasterization order
+		return false;
+	}
+	const bool layoutChanged = state->layout != info->layout;
+	if (!info->write && !layoutChanged && (state->readStageMask & info->stageMask) == info->stageMask)
+	{
+		// An earlier barrier already made the last write visible to these stages
+		return false;
+	}
+	barrier->srcStageMask = state->writeStageMask;
+	barrier->srcAccessMask = state->writeAccessMask;
+	if (info->write || layoutChanged)
+	{
+		// Overwriting the image, including with a layout transition, must also wait for the reads since the last write
+		barrier->srcStageMask |= state->readStageMask;
+	}
+	if (barrier->srcStageMask == 0)
+	{
+		barrier->srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	}
+	barrier->dstStageMask = info->stageMask;
+	barrier->dstAccessMask = info->accessMask;
+	barrier->oldLayout = state->layout;
+	barrier->newLayout = info->layout;
+	return true;
+}
+
+/**
+ * Give each transient resource the first memory whose resources have the same format and sample count and are done
+ * before it is first used, and give every other resource its own memory. Resources are placed in the order that they
+ * are first used, so that a resource can take the memory of any resource that is done before it starts.
+ */
+static void AssignMemory(RenderGraph *graph, const ResourceState *states)
+{
+	uint8_t order[RENDER_GRAPH_MAX_RESOURCES];
+	for (size_t i = 0; i < graph->resourceCount; i++)
+	{
+		size_t j = i;
+		for (; j > 0 && states[order[j - 1]].firstPass > states[i].firstPass; j--)
+		{
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	size_t memoryLastPass[RENDER_GRAPH_MAX_RESOURCES];
+	uint8_t memoryFirstResource[RENDER_GRAPH_MAX_RESOURCES];
+	graph->memoryCount = 0;
+	for (size_t i = 0; i < graph->resourceCount; i++)
+	{
+		const RenderGraphResource *resource = &graph->resources[order[i]];
+		const ResourceState *state = &states[order[i]];
+		size_t memory = graph->memoryCount;
+		if (resource->transient && state->used)
+		{
+			for (size_t j = 0; j < graph->memoryCount; j++)
+			{
+				const RenderGraphResource *other = &graph->resources[memoryFirstResource[j]];
+				if (other->transient &&
+					other->format == resource->format &&
+					other->samples == resource->samples &&
+					memoryLastPass[j] < state->firstPass)
+				{
+					memory = j;
+					break;
+				}
+			}
+		}
+		if (memory == graph->memoryCount)
+		{
+			memoryFirstResource[memory] = order[i];
+			graph->memoryCount++;
+		}
+		memoryLastPass[memory] = state->lastPass;
+		graph->resourceMemory[order[i]] = memory;
+	}
+}
+
+void RenderGraphCompile(RenderGraph *graph)
+{
+	ResourceState states[RENDER_GRAPH_MAX_RESOURCES] = {0};
+	graph->barrierCount = 0;
+	graph->conservativeBarrierCount = 0;
+	graph->groupCount = 0;
+	memset(&graph->externalDependency, 0, sizeof(VkSubpassDependency));
+	graph->externalDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	graph->externalDependency.dstSubpass = 0;
+
+	bool groupIsRenderPass = false;
+	size_t groupFirstPass = 0;
+	for (size_t i = 0; i < graph->passCount; i++)
+	{
+		RenderGraphPass *pass = &graph->passes[i];
+		if (graph->groupCount == 0 || !CanJoinGroup(pass, states, graph->groupCount - 1, groupIsRenderPass))
+		{
+			graph->groupCount++;
+			groupFirstPass = i;
+			groupIsRenderPass = false;
+			for (uint8_t j = 0; j < pass->accessCount; j++)
+			{
+				groupIsRenderPass |= ACCESS_INFO[pass->accessTypes[j]].attachment;
+			}
+		}
+		pass->group = graph->groupCount - 1;
+
+		for (uint8_t j = 0; j < pass->accessCount; j++)
+		{
+			const AccessInfo *info = &ACCESS_INFO[pass->accessTypes[j]];
+			ResourceState *state = &states[pass->resources[j]];
+			if (!state->used)
+			{
+				// The first access is covered by the external dependency, and starts from an undefined layout
+				graph->externalDependency.dstStageMask |= info->stageMask;
+				graph->externalDependency.dstAccessMask |= info->accessMask;
+				state->used = true;
+				state->firstPass = i;
+			} else
+			{
+				graph->conservativeBarrierCount++;
+				RenderGraphBarrier *barrier = &graph->barriers[graph->barrierCount];
+				if (AccessNeedsBarrier(state, info, pass->group, barrier))
+				{
+					// Barriers can't be recorded inside of a render pass, so the barriers of a pass that joined a group
+					// are recorded before the group. A pass only joins a group if the accesses it waits for are in
+					// earlier groups, so this still comes after them.
+					barrier->pass = groupFirstPass;
+					barrier->resource = pass->resources[j];
+					graph->barrierCount++;
+				}
+			}
+
+			if (info->write)
+			{
+				state->writeStageMask = info->stageMask;
+				state->writeAccessMask = info->accessMask;
+				state->readStageMask = 0;
+			} else if (state->layout != info->layout)
+			{
+				// Reads from before the layout transition are ordered before it, and the transition is only visible to
+				// the stages of this access
+				state->readStageMask = info->stageMask;
+			} else
+			{
+				state->readStageMask |= info->stageMask;
+			}
+			state->layout = info->layout;
+			state->group = pass->group;
+			state->lastPass = i;
+			if (pass->accessTypes[j] != RENDER_GRAPH_ACCESS_PRESENT)
+			{
+				state->lastStageMask = info->stageMask;
+				// Only writes have to be made available to the next frame
+				state->lastAccessMask = info->write ? info->accessMask : 0;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < graph->resourceCount; i++)
+	{
+		graph->externalDependency.srcStageMask |= states[i].lastStageMask;
+		graph->externalDependency.srcAccessMask |= states[i].lastAccessMask;
+	}
+	AssignMemory(graph, states);
+}
+
+/**
+ * Get the short name of an image layout for the schedule dump
+ */
+static const char *LayoutName(const VkImageLayout layout)
+{
+	switch (layout)
+	{
+		case VK_IMAGE_LAYOUT_UNDEFINED:
+			return "undefined";
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+			return "color-attachment";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+			return "depth-attachment";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+			return "depth-read-only";
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			return "shader-read-only";
+		case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+			return "present";
+		default:
+			return "other";
+	}
+}
+
+/**
+ * Append formatted text to the schedule dump, keeping count of the full length when the buffer runs out
+ */
+static void AppendSchedule(char *buffer, const size_t bufferSize, size_t *length, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	const size_t offset = *length < bufferSize ? *length : bufferSize;
+	const int written = vsnprintf(buffer + offset, bufferSize - offset, format, args);
+	va_end(args);
+	if (written > 0)
+	{
+		*length += written;
+	}
+}
+
+size_t RenderGraphDumpSchedule(const RenderGraph *graph, char *buffer, const size_t bufferSize)
+{
+	if (bufferSize != 0)
+	{
+		buffer[0] = '\0';
+	}
+	size_t length = 0;
+	size_t barrier = 0;
+	for (size_t i = 0; i < graph->passCount; i++)
+	{
+		const RenderGraphPass *pass = &graph->passes[i];
+		if (i == 0 || pass->group != graph->passes[i - 1].group)
+		{
+			AppendSchedule(buffer, bufferSize, &length, "group %u\n", pass->group);
+		}
+		for (; barrier < graph->barrierCount && graph->barriers[barrier].pass == i; barrier++)
+		{
+			const RenderGraphBarrier *renderGraphBarrier = &graph->barriers[barrier];
+			AppendSchedule(buffer,
+						   bufferSize,
+						   &length,
+						   "  barrier %s: %s -> %s, stages 0x%x -> 0x%x, access 0x%x -> 0x%x\n",
+						   graph->resources[renderGraphBarrier->resource].name,
+						   LayoutName(renderGraphBarrier->oldLayout),
+						   LayoutName(renderGraphBarrier->newLayout),
+						   renderGraphBarrier->srcStageMask,
+						   renderGraphBarrier->dstStageMask,
+						   renderGraphBarrier->srcAccessMask,
+						   renderGraphBarrier->dstAccessMask);
+		}
+		AppendSchedule(buffer, bufferSize, &length, "  pass %s:", pass->name);
+		for (uint8_t j = 0; j < pass->accessCount; j++)
+		{
+			const AccessInfo *info = &ACCESS_INFO[pass->accessTypes[j]];
+			AppendSchedule(buffer,
+						   bufferSize,
+						   &length,
+						   " %s %s (%s)",
+						   info->write ? "write" : "read",
+						   graph->resources[pass->resources[j]].name,
+						   LayoutName(info->layout));
+		}
+		AppendSchedule(buffer, bufferSize, &length, "\n");
+	}
+	for (size_t i = 0; i < graph->resourceCount; i++)
+	{
+		AppendSchedule(buffer,
+					   bufferSize,
+					   &length,
+					   "resource %s: memory %u%s\n",
+					   graph->resources[i].name,
+					   graph->resourceMemory[i],
+					   graph->resources[i].transient ? " (transient)" : "");
+	}
+	AppendSchedule(buffer,
+				   bufferSize,
+				   &length,
+				   "%zu groups, %zu barriers (%zu without merging), %zu memory allocations\n"
+				   "external dependency: stages 0x%x -> 0x%x, access 0x%x -> 0x%x\n",
+				   graph->groupCount,
+				   graph->barrierCount,
+				   graph->conservativeBarrierCount,
+				   graph->memoryCount,
+				   graph->externalDependency.srcStageMask,
+				   graph->externalDependency.dstStageMask,
+				   graph->externalDependency.srcAccessMask,
+				   graph->externalDependency.dstAccessMask);
+	return length;
+}
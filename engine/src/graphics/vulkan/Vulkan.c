@@ -3,16 +3,23 @@
 //
 
 #include <assert.h>
+#include <cglm/mat4.h>
 #include <cglm/types.h>
 #include <engine/assets/AssetReader.h>
 #include <engine/assets/ModelLoader.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/graphics/Bvh.h>
+#include <engine/graphics/Culling.h>
 #include <engine/graphics/Drawing.h>
 #include <engine/graphics/RenderingHelpers.h>
+#include <engine/graphics/TextureStreaming.h>
+#include <engine/graphics/vulkan/DrawBatching.h>
 #include <engine/graphics/vulkan/Vulkan.h>
 #include <engine/graphics/vulkan/VulkanActors.h>
 #include <engine/graphics/vulkan/VulkanHelpers.h>
 #include <engine/graphics/vulkan/VulkanInternal.h>
+#include <engine/graphics/vulkan/VulkanResources.h>
+#include <engine/helpers/MathEx.h>
 #include <engine/structs/Camera.h>
 #include <engine/structs/Color.h>
 #include <engine/structs/GlobalState.h>
@@ -21,6 +28,8 @@
 #include <engine/structs/Viewmodel.h>
 #include <engine/subsystem/Logging.h>
 #include <engine/subsystem/threads/LodThread.h>
+#include <engine/subsystem/threads/RenderWorkers.h>
+#include <engine/subsystem/Timing.h>
 #include <joltc/Math/Vector3.h>
 #include <luna/lunaBuffer.h>
 #include <luna/lunaDevice.h>
@@ -28,6 +37,7 @@
 #include <luna/lunaInstance.h>
 #include <luna/lunaTypes.h>
 #include <math.h>
+#include <SDL3/SDL_atomic.h>
 #include <SDL3/SDL_video.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -42,8 +52,54 @@
 #include <engine/subsystem/Error.h>
 #endif
 
+/// The number of map clusters that each render worker job tests against the occlusion buffer
+#define OCCLUSION_TEST_JOB_SIZE 256
+
 static const Map *loadedMap;
 static LunaImage lightmap = LUNA_NULL_HANDLE;
+/// A bit per frame in flight whose descriptor set does not refer to @c lightmap yet
+static uint32_t lightmapDescriptorDirtyFrames;
+static VkIndexType mapIndexType = VK_INDEX_TYPE_UINT32;
+/// The draw command of every map cluster, with the shaded draw commands followed by the unshaded ones
+static VkDrawIndexedIndirectCommand *mapDrawInfo;
+/// The index of the map cluster that each draw command in @c mapDrawInfo draws
+static uint32_t *mapDrawInfoClusters;
+/// The number of shaded draw commands at the start of @c mapDrawInfo
+static size_t mapShadedDrawCount;
+/**
+ * The CPU-side copy of the map draw info buffers, laid out like @c mapDrawInfo. The draw commands of the clusters that
+ * are visible this frame are packed to the front of the shaded and unshaded halves.
+ */
+static VkDrawIndexedIndirectCommand *mapVisibleDrawInfo;
+/// The number of draw commands at the front of each half of @c mapVisibleDrawInfo
+static size_t mapVisibleShadedDrawCount;
+static size_t mapVisibleUnshadedDrawCount;
+/// For each frame in flight, the number of draw commands at the start of the shaded half of @c mapVisibleDrawInfo that
+/// are known to match that frame's shaded map draw info buffer
+static size_t mapFirstDirtyShadedDrawInfo[FRAMES_IN_FLIGHT];
+/// For each frame in flight, the number of draw commands at the start of the unshaded half of @c mapVisibleDrawInfo
+/// that are known to match that frame's unshaded map draw info buffer
+static size_t mapFirstDirtyUnshadedDrawInfo[FRAMES_IN_FLIGHT];
+/// The world space bounding box of each map cluster
+static CullingBounds mapClusterBounds;
+/// Whether the bounding box of each map cluster is inside the camera frustum and not hidden behind occluders this frame
+static uint8_t *mapClustersVisible;
+/// The texture index of each map model, which is the same as the instance data of the model
+static uint32_t *mapModelTextureIndices;
+/// A bit for each frame in flight whose map instance data buffer is older than @c mapModelTextureIndices
+static uint32_t mapInstanceDataDirtyFrames;
+/// A bit for each frame in flight whose viewmodel instance data and draw info buffers don't match the viewmodel
+static uint32_t viewmodelDirtyFrames;
+/// The model of the viewmodel that was last loaded
+static const ModelDefinition *loadedViewmodelModel;
+/// The skin of the viewmodel that was last loaded
+static uint32_t loadedViewmodelSkin;
+/// The contents of the global lighting uniform buffer
+static GlobalLightingUniform writtenLighting;
+/// The contents of the fog uniform buffer
+static FogUniform writtenFog;
+/// The occluders of the loaded map seen by the camera this frame
+static OcclusionBuffer occlusionBuffer;
 static size_t skyModelIndexCount;
 
 static inline VkResult LoadSky(const ModelDefinition *model)
@@ -94,6 +150,10 @@ static inline VkResult LoadSky(const ModelDefinition *model)
 	return VK_SUCCESS;
 }
 
+/**
+ * Write the material data of the viewmodel to the current frame's instance data buffer, and its draw commands to the
+ * current frame's draw info buffers
+ */
 static inline VkResult UpdateViewmodel(const Viewmodel *viewmodel)
 {
 	const ModelDefinition *model = viewmodel->model;
@@ -115,7 +175,7 @@ static inline VkResult UpdateViewmodel(const Viewmodel *viewmodel)
 		};
 		VulkanTestReturnResult(lunaWriteDataToBuffer(device,
 													 commandBuffer,
-													 buffers.viewmodel.instanceData,
+													 buffers.viewmodel.instanceData[currentFrame],
 													 &instanceDataBufferWriteInfo),
 							   "Failed to write viewmodel instance data to buffer!");
 
@@ -135,8 +195,8 @@ static inline VkResult UpdateViewmodel(const Viewmodel *viewmodel)
 		VulkanTestReturnResult(lunaWriteDataToBuffer(device,
 													 commandBuffer,
 													 material->shader == SHADER_SHADED
-															 ? buffers.viewmodel.shadedDrawInfo
-															 : buffers.viewmodel.unshadedDrawInfo,
+															 ? buffers.viewmodel.shadedDrawInfo[currentFrame]
+															 : buffers.viewmodel.unshadedDrawInfo[currentFrame],
 													 &drawInfoBufferWriteInfo),
 							   "Failed to write viewmodel draw info to buffer!");
 
@@ -147,65 +207,92 @@ static inline VkResult UpdateViewmodel(const Viewmodel *viewmodel)
 	return VK_SUCCESS;
 }
 
-static inline VkResult LoadViewmodel(const Viewmodel *viewmodel)
+/**
+ * Bring the current frame's viewmodel instance data and draw info buffers up to date if the viewmodel has been loaded
+ * since they were last written. The buffers of each frame in flight are resized to fit the viewmodel exactly, since
+ * their sizes are used as the draw counts.
+ */
+static inline VkResult UpdateViewmodelFrameBuffers(const Viewmodel *viewmodel)
 {
-	if (viewmodel->model == NULL)
+	if ((viewmodelDirtyFrames & 1u << currentFrame) == 0)
 	{
-		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.vertices, 0),
-							   "Failed to resize viewmodel vertex buffer!");
-		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.indices, 0),
-							   "Failed to resize viewmodel index buffer!");
-		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.instanceData, 0),
-							   "Failed to resize viewmodel instance data buffer!");
-		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.shadedDrawInfo, 0),
-							   "Failed to resize viewmodel shaded material draw info buffer!");
-		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.unshadedDrawInfo, 0),
-							   "Failed to resize viewmodel unshaded material draw info buffer!");
 		return VK_SUCCESS;
 	}
-	const ModelDefinition *model = viewmodel->model;
-	const uint32_t *materialIndices = model->skinMaterialIndices[viewmodel->modelSkin];
-	const ModelLod *lod = model->lods;
+	viewmodelDirtyFrames &= ~(1u << currentFrame);
 
-	uint32_t indices[lod->totalIndexCount];
-	size_t indexCount = 0;
 	size_t shadedMaterialCount = 0;
 	size_t unshadedMaterialCount = 0;
-	for (size_t i = 0; i < model->materialSlotCount; i++)
+	const ModelDefinition *model = viewmodel->model;
+	for (size_t i = 0; model != NULL && i < model->materialSlotCount; i++)
 	{
-		memcpy(indices + indexCount, lod->indexData[i], lod->indexCount[i] * sizeof(uint32_t));
-		indexCount += lod->indexCount[i];
-		if (model->materials[materialIndices[i]].shader == SHADER_SHADED)
+		const Material *material = &model->materials[model->skinMaterialIndices[viewmodel->modelSkin][i]];
+		if (material->shader == SHADER_SHADED)
 		{
 			shadedMaterialCount++;
 		} else
 		{
-			assert(model->materials[materialIndices[i]].shader == SHADER_UNSHADED);
+			assert(material->shader == SHADER_UNSHADED);
 			unshadedMaterialCount++;
 		}
 	}
 
-	const size_t vertexBufferSize = lod->vertexCount * sizeof(ModelVertex);
-	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.vertices, vertexBufferSize),
-						   "Failed to resize viewmodel vertex buffer!");
-	const size_t indexBufferSize = lod->totalIndexCount * sizeof(uint32_t);
-	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.indices, indexBufferSize),
-						   "Failed to resize viewmodel index buffer!");
 	VulkanTestReturnResult(lunaResizeBuffer(device,
 											commandBuffer,
-											&buffers.viewmodel.instanceData,
+											&buffers.viewmodel.instanceData[currentFrame],
 											(shadedMaterialCount + unshadedMaterialCount) * sizeof(ModelInstanceData)),
 						   "Failed to resize viewmodel instance data buffer!");
 	VulkanTestReturnResult(lunaResizeBuffer(device,
 											commandBuffer,
-											&buffers.viewmodel.shadedDrawInfo,
+											&buffers.viewmodel.shadedDrawInfo[currentFrame],
 											shadedMaterialCount * sizeof(VkDrawIndexedIndirectCommand)),
 						   "Failed to resize viewmodel shaded material draw info buffer!");
 	VulkanTestReturnResult(lunaResizeBuffer(device,
 											commandBuffer,
-											&buffers.viewmodel.unshadedDrawInfo,
+											&buffers.viewmodel.unshadedDrawInfo[currentFrame],
 											unshadedMaterialCount * sizeof(VkDrawIndexedIndirectCommand)),
 						   "Failed to resize viewmodel unshaded material draw info buffer!");
+	if (model == NULL)
+	{
+		return VK_SUCCESS;
+	}
+
+	return UpdateViewmodel(viewmodel);
+}
+
+/**
+ * Load the vertices and indices of the viewmodel, and mark the instance data and draw info buffers of every frame in
+ * flight to be brought up to date when that frame is recorded
+ */
+static inline VkResult LoadViewmodel(const Viewmodel *viewmodel)
+{
+	viewmodelDirtyFrames = ALL_FRAMES_IN_FLIGHT_BITS;
+	loadedViewmodelModel = viewmodel->model;
+	loadedViewmodelSkin = viewmodel->modelSkin;
+	if (viewmodel->model == NULL)
+	{
+		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.vertices, 0),
+							   "Failed to resize viewmodel vertex buffer!");
+		VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.indices, 0),
+							   "Failed to resize viewmodel index buffer!");
+		return VK_SUCCESS;
+	}
+	const ModelDefinition *model = viewmodel->model;
+	const ModelLod *lod = model->lods;
+
+	uint32_t indices[lod->totalIndexCount];
+	size_t indexCount = 0;
+	for (size_t i = 0; i < model->materialSlotCount; i++)
+	{
+		memcpy(indices + indexCount, lod->indexData[i], lod->indexCount[i] * sizeof(uint32_t));
+		indexCount += lod->indexCount[i];
+	}
+
+	const size_t vertexBufferSize = lod->vertexCount * sizeof(ModelVertex);
+	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.vertices, vertexBufferSize),
+						   "Failed to resize viewmodel vertex buffer!");
+	const size_t indexBufferSize = lod->totalIndexCount * sizeof(uint32_t);
+	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.viewmodel.indices, indexBufferSize),
+						   "Failed to resize viewmodel index buffer!");
 
 	const LunaBufferWriteInfo vertexBufferWriteInfo = {
 		.bytes = vertexBufferSize,
@@ -228,102 +315,119 @@ static inline VkResult LoadViewmodel(const Viewmodel *viewmodel)
 												 &indexBufferWriteInfo),
 						   "Failed to write data to viewmodel index buffer!");
 
-
-	VulkanTestReturnResult(UpdateViewmodel(viewmodel), "Failed to update viewmodel!");
-
 	return VK_SUCCESS;
 }
 
-static inline VkResult LoadMapModelsToBuffer(const size_t modelCount, const MapModel *models)
+static inline VkResult LoadMapModelsToBuffer(const Map *map)
 {
+	const size_t modelCount = map->modelCount;
+	const MapModel *models = map->models;
 	size_t totalVertexCount = 0;
 	size_t totalIndexCount = 0;
-	size_t totalMaterialCount = 0;
-	size_t shadedMaterialCount = 0;
-	size_t unshadedMaterialCount = 0;
+	bool shortIndices = true;
 	for (size_t i = 0; i < modelCount; i++)
 	{
 		const MapModel *model = models + i;
 		totalVertexCount += model->vertexCount;
 		totalIndexCount += model->indexCount;
-		totalMaterialCount++;
+		shortIndices &= model->shortIndices;
 		const ModelShader shader = model->material->shader;
-		switch (shader)
+		if (shader != SHADER_SHADED && shader != SHADER_UNSHADED)
 		{
-			case SHADER_SHADED:
-				shadedMaterialCount++;
-				break;
-			case SHADER_UNSHADED:
-				unshadedMaterialCount++;
-				break;
-			default:
-				return VK_ERROR_UNKNOWN;
+			return VK_ERROR_UNKNOWN;
+		}
+	}
+	size_t shadedClusterCount = 0;
+	size_t unshadedClusterCount = 0;
+	for (size_t i = 0; i < map->clusterCount; i++)
+	{
+		if (models[map->clusters[i].model].material->shader == SHADER_SHADED)
+		{
+			shadedClusterCount++;
+		} else
+		{
+			unshadedClusterCount++;
 		}
 	}
 	const size_t vertexBufferSize = totalVertexCount * sizeof(MapVertex);
 	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.map.vertices, vertexBufferSize),
 						   "Failed to resize map vertex buffer!");
-	const size_t indexBufferSize = totalIndexCount * sizeof(uint32_t);
+	// Indices are relative to the vertexOffset of each draw, so the whole map can use 16-bit indices as long as every
+	// model can.
+	mapIndexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	const size_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t indexBufferSize = totalIndexCount * indexSize;
 	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.map.indices, indexBufferSize),
 						   "Failed to resize map index buffer!");
-	const size_t instanceDataBufferSize = totalMaterialCount * sizeof(uint32_t);
-	VulkanTestReturnResult(lunaResizeBuffer(device, commandBuffer, &buffers.map.instanceData, instanceDataBufferSize),
-						   "Failed to resize map instance data buffer!");
-	const size_t shadedDrawInfoBufferSize = shadedMaterialCount * sizeof(VkDrawIndexedIndirectCommand);
-	VulkanTestReturnResult(lunaResizeBuffer(device,
-											commandBuffer,
-											&buffers.map.shadedDrawInfo,
-											shadedDrawInfoBufferSize),
-						   "Failed to resize map shaded draw info buffer!");
-	const size_t unshadedDrawInfoBufferSize = unshadedMaterialCount * sizeof(VkDrawIndexedIndirectCommand);
-	VulkanTestReturnResult(lunaResizeBuffer(device,
-											commandBuffer,
-											&buffers.map.unshadedDrawInfo,
-											unshadedDrawInfoBufferSize),
-						   "Failed to resize map unshaded draw info buffer!");
+
+	const size_t drawInfoSize = max(map->clusterCount, 1) * sizeof(VkDrawIndexedIndirectCommand);
+	VkDrawIndexedIndirectCommand *drawInfo = realloc(mapDrawInfo, drawInfoSize);
+	CheckAlloc(drawInfo);
+	mapDrawInfo = drawInfo;
+	VkDrawIndexedIndirectCommand *visibleDrawInfo = realloc(mapVisibleDrawInfo, drawInfoSize);
+	CheckAlloc(visibleDrawInfo);
+	mapVisibleDrawInfo = visibleDrawInfo;
+	uint32_t *drawInfoClusters = realloc(mapDrawInfoClusters, max(map->clusterCount, 1) * sizeof(uint32_t));
+	CheckAlloc(drawInfoClusters);
+	mapDrawInfoClusters = drawInfoClusters;
+	mapShadedDrawCount = shadedClusterCount;
+	uint8_t *clustersVisible = realloc(mapClustersVisible, max(map->clusterCount, 1) * sizeof(uint8_t));
+	CheckAlloc(clustersVisible);
+	mapClustersVisible = clustersVisible;
+	uint32_t *modelTextureIndices = realloc(mapModelTextureIndices, max(modelCount, 1) * sizeof(uint32_t));
+	CheckAlloc(modelTextureIndices);
+	mapModelTextureIndices = modelTextureIndices;
+	CullingBoundsResize(&mapClusterBounds, map->clusterCount);
 
 	VkDeviceSize vertexOffset = 0;
 	VkDeviceSize indexOffset = 0;
-	size_t shadedMaterialIndex = 0;
-	size_t unshadedMaterialIndex = 0;
 	MapVertex vertices[totalVertexCount];
 	uint32_t indices[totalIndexCount];
-	uint32_t textureIndices[totalMaterialCount];
-	VkDrawIndexedIndirectCommand shadedDrawInfo[shadedMaterialCount];
-	VkDrawIndexedIndirectCommand unshadedDrawInfo[unshadedMaterialCount];
+	uint32_t modelFirstIndices[modelCount];
+	int32_t modelVertexOffsets[modelCount];
 	for (size_t i = 0; i < modelCount; i++)
 	{
 		const MapModel *model = models + i;
 		memcpy(vertices + vertexOffset, model->vertices, model->vertexCount * sizeof(MapVertex));
-		memcpy(indices + indexOffset, model->indices, model->indexCount * sizeof(uint32_t));
-		textureIndices[i] = TextureIndex(model->material->texture);
-		switch (models[i].material->shader)
+		if (shortIndices)
 		{
-			case SHADER_SHADED:
-				shadedDrawInfo[shadedMaterialIndex].indexCount = model->indexCount;
-				shadedDrawInfo[shadedMaterialIndex].instanceCount = 1;
-				shadedDrawInfo[shadedMaterialIndex].firstIndex = indexOffset;
-				shadedDrawInfo[shadedMaterialIndex].vertexOffset = (int32_t)vertexOffset;
-				shadedDrawInfo[shadedMaterialIndex].firstInstance = i;
-				shadedMaterialIndex++;
-				break;
-			case SHADER_UNSHADED:
-				unshadedDrawInfo[unshadedMaterialIndex].indexCount = model->indexCount;
-				unshadedDrawInfo[unshadedMaterialIndex].instanceCount = 1;
-				unshadedDrawInfo[unshadedMaterialIndex].firstIndex = indexOffset;
-				unshadedDrawInfo[unshadedMaterialIndex].vertexOffset = (int32_t)vertexOffset;
-				unshadedDrawInfo[unshadedMaterialIndex].firstInstance = i;
-				unshadedMaterialIndex++;
-				break;
-			default:
-				// Impossible to hit
-				return VK_ERROR_UNKNOWN;
+			uint16_t *shortIndexData = (uint16_t *)indices + indexOffset;
+			for (uint32_t j = 0; j < model->indexCount; j++)
+			{
+				shortIndexData[j] = (uint16_t)model->indices[j];
+			}
+		} else
+		{
+			memcpy(indices + indexOffset, model->indices, model->indexCount * sizeof(uint32_t));
 		}
+		mapModelTextureIndices[i] = TextureIndex(model->material->texture);
+		modelFirstIndices[i] = indexOffset;
+		modelVertexOffsets[i] = (int32_t)vertexOffset;
 
 		vertexOffset += model->vertexCount;
 		indexOffset += model->indexCount;
 	}
 
+	size_t shadedDrawIndex = 0;
+	size_t unshadedDrawIndex = shadedClusterCount;
+	for (size_t i = 0; i < map->clusterCount; i++)
+	{
+		const MapCluster *cluster = map->clusters + i;
+		const size_t drawIndex = models[cluster->model].material->shader == SHADER_SHADED ? shadedDrawIndex++
+																						   : unshadedDrawIndex++;
+		// The instance data is per model, so every cluster of a model uses the index of the model as its instance
+		mapDrawInfo[drawIndex] = (VkDrawIndexedIndirectCommand){
+			.indexCount = cluster->indexCount,
+			.instanceCount = 1,
+			.firstIndex = modelFirstIndices[cluster->model] + cluster->firstIndex,
+			.vertexOffset = modelVertexOffsets[cluster->model],
+			.firstInstance = cluster->model,
+		};
+		mapDrawInfoClusters[drawIndex] = i;
+		CullingBoundsSet(&mapClusterBounds, i, &cluster->center, &cluster->extents);
+		// Every cluster starts out drawn until the first time the map is culled
+		mapClustersVisible[i] = 1;
+	}
 	const LunaBufferWriteInfo vertexBufferWriteInfo = {
 		.bytes = vertexBufferSize,
 		.data = vertices,
@@ -338,68 +442,246 @@ static inline VkResult LoadMapModelsToBuffer(const size_t modelCount, const MapM
 	};
 	VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, buffers.map.indices, &indexBufferWriteInfo),
 						   "Failed to write data to map index buffer!");
-	const LunaBufferWriteInfo instanceDataBufferWriteInfo = {
-		.bytes = instanceDataBufferSize,
-		.data = textureIndices,
-		.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-	};
-	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-												 commandBuffer,
-												 buffers.map.instanceData,
-												 &instanceDataBufferWriteInfo),
-						   "Failed to write data to map per-material data buffer!");
-	const LunaBufferWriteInfo shadedDrawInfoBufferWriteInfo = {
-		.bytes = shadedDrawInfoBufferSize,
-		.data = shadedDrawInfo,
+
+	// The instance data and draw info buffers of each frame in flight are written in full when that frame is next
+	// recorded, starting out with every draw command, which is the same as every cluster being visible
+	memcpy(mapVisibleDrawInfo, mapDrawInfo, map->clusterCount * sizeof(VkDrawIndexedIndirectCommand));
+	mapVisibleShadedDrawCount = shadedClusterCount;
+	mapVisibleUnshadedDrawCount = unshadedClusterCount;
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		mapFirstDirtyShadedDrawInfo[i] = 0;
+		mapFirstDirtyUnshadedDrawInfo[i] = 0;
+	}
+	mapInstanceDataDirtyFrames = ALL_FRAMES_IN_FLIGHT_BITS;
+
+	return VK_SUCCESS;
+}
+
+/**
+ * Write a range of the CPU-side map draw info to the current frame's copy of one of the map draw info buffers
+ * @param frameBuffers The buffers to write to, one for each frame in flight
+ * @param firstDrawInfo The index in the buffer of the first draw command to write
+ * @param endDrawInfo One past the index in the buffer of the last draw command to write
+ * @param bufferDrawInfo The CPU-side copy of the buffer
+ * @param drawCount The number of draw commands that the buffer has to have space for
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static inline VkResult WriteMapDrawInfo(LunaBuffer *frameBuffers,
+										const size_t firstDrawInfo,
+										const size_t endDrawInfo,
+										const VkDrawIndexedIndirectCommand *bufferDrawInfo,
+										const size_t drawCount)
+{
+	// The buffer only has to grow after a map is loaded, which marks every draw command as changed
+	VulkanTestReturnResult(EnsureFrameBufferSize(&frameBuffers[currentFrame],
+												 drawCount * sizeof(VkDrawIndexedIndirectCommand)),
+						   "Failed to resize map draw info buffer!");
+	if (firstDrawInfo >= endDrawInfo)
+	{
+		return VK_SUCCESS;
+	}
+	const LunaBufferWriteInfo writeInfo = {
+		.bytes = (endDrawInfo - firstDrawInfo) * sizeof(VkDrawIndexedIndirectCommand),
+		.data = bufferDrawInfo + firstDrawInfo,
+		.offset = firstDrawInfo * sizeof(VkDrawIndexedIndirectCommand),
 		.stageFlags = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
 	};
-	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-												 commandBuffer,
-												 buffers.map.shadedDrawInfo,
-												 &shadedDrawInfoBufferWriteInfo),
-						   "Failed to write data to map shaded draw info buffer!");
-	const LunaBufferWriteInfo unshadedDrawInfoBufferWriteInfo = {
-		.bytes = unshadedDrawInfoBufferSize,
-		.data = unshadedDrawInfo,
-		.stageFlags = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+	return lunaWriteDataToBuffer(device, commandBuffer, frameBuffers[currentFrame], &writeInfo);
+}
+
+/**
+ * Pack the draw commands of the visible map clusters to the front of one of the map draw info buffers. Commands past
+ * the visible count are never read, so only the commands that moved since the current frame's copy of the buffer was
+ * last written are written.
+ * @param frameBuffers The buffers to write to, one for each frame in flight
+ * @param drawInfo The draw commands of every cluster that is drawn from the buffer
+ * @param drawInfoClusters The index of the cluster that each command in @c drawInfo draws
+ * @param drawCount The number of commands in @c drawInfo
+ * @param visibleDrawInfo The CPU-side copy of the buffer
+ * @param visibleDrawCount The number of commands at the front of @c visibleDrawInfo, which is updated
+ * @param firstDirtyDrawInfo For each frame in flight, the number of commands at the start of @c visibleDrawInfo that
+ *  are known to match that frame's buffer, which is updated
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static inline VkResult CompactMapDrawInfo(LunaBuffer *frameBuffers,
+										  const VkDrawIndexedIndirectCommand *drawInfo,
+										  const uint32_t *drawInfoClusters,
+										  const size_t drawCount,
+										  VkDrawIndexedIndirectCommand *visibleDrawInfo,
+										  size_t *visibleDrawCount,
+										  size_t *firstDirtyDrawInfo)
+{
+	const size_t firstChangedDrawInfo = CompactDrawInfo(drawInfo,
+														drawInfoClusters,
+														drawCount,
+														mapClustersVisible,
+														visibleDrawInfo,
+														visibleDrawCount);
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		firstDirtyDrawInfo[i] = min(firstDirtyDrawInfo[i], firstChangedDrawInfo);
+	}
+	// The commands past the visible count were not written, so they might not match once the visible count grows
+	const size_t firstDrawInfo = firstDirtyDrawInfo[currentFrame];
+	firstDirtyDrawInfo[currentFrame] = *visibleDrawCount;
+	return WriteMapDrawInfo(frameBuffers, firstDrawInfo, *visibleDrawCount, visibleDrawInfo, drawCount);
+}
+
+/**
+ * Test one range of @c OCCLUSION_TEST_JOB_SIZE map clusters against the occlusion buffer, on a render worker
+ * @param data An @c SDL_AtomicInt that the number of hidden clusters is added to
+ * @param index The index of the range
+ */
+static void TestOcclusionJob(void *data, const size_t index)
+{
+	const size_t start = index * OCCLUSION_TEST_JOB_SIZE;
+	const CullingBounds bounds = {
+		.centerX = mapClusterBounds.centerX + start,
+		.centerY = mapClusterBounds.centerY + start,
+		.centerZ = mapClusterBounds.centerZ + start,
+		.extentX = mapClusterBounds.extentX + start,
+		.extentY = mapClusterBounds.extentY + start,
+		.extentZ = mapClusterBounds.extentZ + start,
+		.count = min(mapClusterBounds.count - start, OCCLUSION_TEST_JOB_SIZE),
+		.capacity = mapClusterBounds.capacity - start,
 	};
-	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-												 commandBuffer,
-												 buffers.map.unshadedDrawInfo,
-												 &unshadedDrawInfoBufferWriteInfo),
-						   "Failed to write data to map unshaded draw info buffer!");
+	const size_t occludedCount = TestOcclusion(&occlusionBuffer, &bounds, mapClustersVisible + start);
+	SDL_AddAtomicInt(data, (int)occludedCount);
+}
+
+/**
+ * Test the map clusters against the camera frustum using the cluster BVH and then against the occlusion buffer, and
+ * pack the draw commands of the visible clusters to the front of the map draw info buffers so that culled clusters
+ * cost nothing on the GPU
+ */
+static inline VkResult CullMapClusters(const Map *map, const Frustum *frustum)
+{
+	const size_t inFrustumCount = BvhQueryFrustum(&map->clusterBvh, frustum, mapClustersVisible);
+	const uint64_t occlusionTestStartTime = GetTimeNs();
+	SDL_AtomicInt occludedCounter;
+	SDL_SetAtomicInt(&occludedCounter, 0);
+	RenderWorkersRun(TestOcclusionJob,
+					 &occludedCounter,
+					 (mapClusterBounds.count + OCCLUSION_TEST_JOB_SIZE - 1) / OCCLUSION_TEST_JOB_SIZE);
+	const size_t occludedCount = SDL_GetAtomicInt(&occludedCounter);
+	renderStats.occlusionTestNs += GetTimeNs() - occlusionTestStartTime;
+	renderStats.visibleMapClusters += inFrustumCount - occludedCount;
+	renderStats.culledMapClusters += mapClusterBounds.count - inFrustumCount;
+	renderStats.occludedMapClusters += occludedCount;
+
+	VulkanTestReturnResult(CompactMapDrawInfo(buffers.map.shadedDrawInfo,
+											  mapDrawInfo,
+											  mapDrawInfoClusters,
+											  mapShadedDrawCount,
+											  mapVisibleDrawInfo,
+											  &mapVisibleShadedDrawCount,
+											  mapFirstDirtyShadedDrawInfo),
+						   "Failed to write map shaded draw info!");
+	VulkanTestReturnResult(CompactMapDrawInfo(buffers.map.unshadedDrawInfo,
+											  mapDrawInfo + mapShadedDrawCount,
+											  mapDrawInfoClusters + mapShadedDrawCount,
+											  mapClusterBounds.count - mapShadedDrawCount,
+											  mapVisibleDrawInfo + mapShadedDrawCount,
+											  &mapVisibleUnshadedDrawCount,
+											  mapFirstDirtyUnshadedDrawInfo),
+						   "Failed to write map unshaded draw info!");
 
 	return VK_SUCCESS;
 }
 
-static inline VkResult UpdateMapInstanceData(const Map *map)
+/**
+ * Record the screen size of every map cluster that is drawn this frame on the texture of its model, so that texture
+ * streaming can give it the mip levels it needs
+ * @param map The map
+ * @param cameraPosition The position of the camera
+ * @param pixelScale The height of the viewport in pixels divided by the height of the view at a distance of one
+ */
+static inline void ReportMapTextureScreenSizes(const Map *map, const Vector3 *cameraPosition, const float pixelScale)
+{
+	for (size_t i = 0; i < map->clusterCount; i++)
+	{
+		if (!mapClustersVisible[i])
+		{
+			continue;
+		}
+		const MapCluster *cluster = &map->clusters[i];
+		const float screenSize = BoundsScreenSize(cameraPosition, pixelScale, &cluster->center, &cluster->extents);
+		StreamedTextureSeen(&streamedTextures[mapModelTextureIndices[cluster->model]], screenSize);
+	}
+}
+
+/**
+ * Look up the texture index of every map model again, and mark the instance data buffer of every frame in flight to be
+ * written when that frame is next recorded
+ */
+static inline void UpdateMapInstanceData(const Map *map)
 {
-	const size_t materialCount = lunaGetBufferSize(buffers.map.instanceData) / sizeof(uint32_t);
-	uint32_t textureIndices[materialCount];
 	for (size_t i = 0; i < map->modelCount; i++)
 	{
-		const MapModel *model = &map->models[i];
-		textureIndices[i] = TextureIndex(model->material->texture);
+		mapModelTextureIndices[i] = TextureIndex(map->models[i].material->texture);
+	}
+	mapInstanceDataDirtyFrames = ALL_FRAMES_IN_FLIGHT_BITS;
+}
+
+/**
+ * Write @c mapModelTextureIndices to the current frame's map instance data buffer if it has changed since the buffer
+ * was last written
+ */
+static inline VkResult WriteMapInstanceData(const Map *map)
+{
+	if ((mapInstanceDataDirtyFrames & 1u << currentFrame) == 0)
+	{
+		return VK_SUCCESS;
+	}
+	mapInstanceDataDirtyFrames &= ~(1u << currentFrame);
+	if (map->modelCount == 0)
+	{
+		return VK_SUCCESS;
 	}
+
+	const size_t instanceDataBufferSize = map->modelCount * sizeof(uint32_t);
+	VulkanTestReturnResult(EnsureFrameBufferSize(&buffers.map.instanceData[currentFrame], instanceDataBufferSize),
+						   "Failed to resize map instance data buffer!");
 	const LunaBufferWriteInfo instanceDataBufferWriteInfo = {
-		.bytes = lunaGetBufferSize(buffers.map.instanceData),
-		.data = textureIndices,
+		.bytes = instanceDataBufferSize,
+		.data = mapModelTextureIndices,
 		.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
 	};
 	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
 												 commandBuffer,
-												 buffers.map.instanceData,
+												 buffers.map.instanceData[currentFrame],
 												 &instanceDataBufferWriteInfo),
 						   "Failed to update map instance data buffer!");
 
 	return VK_SUCCESS;
 }
 
+/**
+ * Point the lightmap descriptor of the current frame at @c lightmap. This has to be called while the current frame is
+ * being recorded, since the descriptor set is not pending then.
+ */
+static inline void WriteLightmapDescriptor()
+{
+	const LunaDescriptorImageInfo imageInfo = {
+		.image = lightmap,
+		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	};
+	const LunaWriteDescriptorSet writeDescriptor = {
+		.descriptorSet = descriptorSets[currentFrame],
+		.bindingName = "Lightmap",
+		.descriptorCount = 1,
+		.imageInfo = &imageInfo,
+	};
+	lunaWriteDescriptorSets(device, 1, &writeDescriptor);
+	lightmapDescriptorDirtyFrames &= ~(1u << currentFrame);
+}
+
 static inline VkResult LoadLightmap(const Map *map)
 {
 	if (lightmap != LUNA_NULL_HANDLE)
 	{
-		lunaDestroyImage(device, lightmap);
+		DestroyImageWhenRetired(lightmap);
 		lightmap = LUNA_NULL_HANDLE;
 	}
 	const VkPipelineStageFlags2 waitStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
@@ -427,20 +709,14 @@ static inline VkResult LoadLightmap(const Map *map)
 		.writeInfo.submitInfo = &submitInfo,
 		.sampler = textureSamplers.nearestNoRepeatNoAnisotropy,
 	};
-	VulkanTestReturnResult(lunaCreateImage(device, secondaryCommandBuffer, &imageCreationInfo, &lightmap),
+	VulkanTestReturnResult(lunaCreateImage(device, NextUploadCommandBuffer(), &imageCreationInfo, &lightmap),
 						   "Failed to create texture!");
-
-	const LunaDescriptorImageInfo imageInfo = {
-		.image = lightmap,
-		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-	};
-	const LunaWriteDescriptorSet writeDescriptor = {
-		.descriptorSet = descriptorSet,
-		.bindingName = "Lightmap",
-		.descriptorCount = 1,
-		.imageInfo = &imageInfo,
-	};
-	lunaWriteDescriptorSets(device, 1, &writeDescriptor);
+	// Pending frames still sample the old lightmap, so each descriptor set is rewritten once its frame is recorded
+	lightmapDescriptorDirtyFrames = ALL_FRAMES_IN_FLIGHT_BITS;
+	if (recordingFrame)
+	{
+		WriteLightmapDescriptor();
+	}
 
 	return VK_SUCCESS;
 }
@@ -473,19 +749,18 @@ static inline VkResult DrawSky(const LunaGraphicsPipelineBindInfo *pipelineBindI
 
 static inline VkResult DrawMap(const LunaGraphicsPipelineBindInfo *pipelineBindInfo)
 {
-	const size_t shadedDrawCount = lunaGetBufferSize(buffers.map.shadedDrawInfo) / sizeof(VkDrawIndexedIndirectCommand);
-	const size_t unshadedDrawCount = lunaGetBufferSize(buffers.map.unshadedDrawInfo) /
-									 sizeof(VkDrawIndexedIndirectCommand);
+	const size_t shadedDrawCount = mapVisibleShadedDrawCount;
+	const size_t unshadedDrawCount = mapVisibleUnshadedDrawCount;
 
 	if (shadedDrawCount != 0 || unshadedDrawCount != 0)
 	{
 		VulkanTest(lunaBindVertexBuffers(device,
 										 commandBuffer,
-										 (LunaBuffer[]){buffers.map.vertices, buffers.map.instanceData},
+										 (LunaBuffer[]){buffers.map.vertices, buffers.map.instanceData[currentFrame]},
 										 0,
 										 2),
 				   "Failed to bind map vertex buffers!");
-		VulkanTest(lunaBindIndexBuffer(device, commandBuffer, buffers.map.indices, VK_INDEX_TYPE_UINT32),
+		VulkanTest(lunaBindIndexBuffer(device, commandBuffer, buffers.map.indices, mapIndexType),
 				   "Failed to bind map index buffer!");
 	}
 
@@ -494,7 +769,7 @@ static inline VkResult DrawMap(const LunaGraphicsPipelineBindInfo *pipelineBindI
 		const LunaDrawIndexedIndirectInfo drawInfo = {
 			.pipeline = pipelines.shadedMap,
 			.pipelineBindInfo = pipelineBindInfo,
-			.buffer = buffers.map.shadedDrawInfo,
+			.buffer = buffers.map.shadedDrawInfo[currentFrame],
 			.drawCount = shadedDrawCount,
 		};
 		VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &drawInfo), "Failed to draw shaded map!");
@@ -505,7 +780,7 @@ static inline VkResult DrawMap(const LunaGraphicsPipelineBindInfo *pipelineBindI
 		const LunaDrawIndexedIndirectInfo drawInfo = {
 			.pipeline = pipelines.unshadedMap,
 			.pipelineBindInfo = pipelineBindInfo,
-			.buffer = buffers.map.unshadedDrawInfo,
+			.buffer = buffers.map.unshadedDrawInfo[currentFrame],
 			.drawCount = unshadedDrawCount,
 		};
 		VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &drawInfo),
@@ -515,51 +790,67 @@ static inline VkResult DrawMap(const LunaGraphicsPipelineBindInfo *pipelineBindI
 	return VK_SUCCESS;
 }
 
-static inline VkResult DrawActors(const LunaGraphicsPipelineBindInfo *pipelineBindInfo)
+static inline VkResult DrawActors(const LunaGraphicsPipelineBindInfo *pipelineBindInfo,
+								  const Frustum *frustum,
+								  const Vector3 *cameraPosition,
+								  const float pixelScale)
 {
-	VulkanTestReturnResult(UpdateActors(), "Failed to update actors!");
+	const uint64_t actorsStartTime = GetTimeNs();
+	VulkanTestReturnResult(UpdateActors(frustum, &occlusionBuffer, cameraPosition, pixelScale),
+						   "Failed to update actors!");
 
-	const size_t shadedDrawCount = lunaGetBufferSize(buffers.actorModels.shadedDrawInfo) /
-								   sizeof(VkDrawIndexedIndirectCommand);
-	const size_t unshadedDrawCount = lunaGetBufferSize(buffers.actorModels.unshadedDrawInfo) /
-									 sizeof(VkDrawIndexedIndirectCommand);
-
-	if (shadedDrawCount != 0 || unshadedDrawCount != 0)
+	const ActorModelBuffer *actorModels = &buffers.actorModels;
+	if (actorModels->materialSlotCount != 0)
 	{
 		VulkanTest(lunaBindVertexBuffers(device,
 										 commandBuffer,
-										 (LunaBuffer[]){buffers.actorModels.vertices, buffers.actorModels.instanceData},
+										 (LunaBuffer[]){actorModels->vertices, actorModels->instanceData[currentFrame]},
 										 0,
 										 2),
 				   "Failed to bind actor models vertex buffers!");
-		VulkanTest(lunaBindIndexBuffer(device, commandBuffer, buffers.actorModels.indices, VK_INDEX_TYPE_UINT32),
+		VulkanTest(lunaBindIndexBuffer(device, commandBuffer, actorModels->indices, VK_INDEX_TYPE_UINT32),
 				   "Failed to bind actor models index buffer!");
 
-		if (shadedDrawCount != 0)
+		// Each material slot index has its own material data and draw info buffers, so the per-actor instance data
+		// bound above is shared by every draw, and only the material data binding changes between them.
+		for (uint32_t i = 0; i < actorModels->materialSlotCount; i++)
 		{
-			const LunaDrawIndexedIndirectInfo drawInfo = {
+			if (actorModels->drawCounts[i] == 0)
+			{
+				continue;
+			}
+			VulkanTest(lunaBindVertexBuffers(device, commandBuffer, &actorModels->materialData[currentFrame][i], 2, 1),
+					   "Failed to bind actor models material data buffer!");
+			const LunaDrawIndexedIndirectInfo shadedDrawInfo = {
 				.pipeline = pipelines.shadedActorModel,
 				.pipelineBindInfo = pipelineBindInfo,
-				.buffer = buffers.actorModels.shadedDrawInfo,
-				.drawCount = shadedDrawCount,
+				.buffer = actorModels->shadedDrawInfo[currentFrame][i],
+				.drawCount = actorModels->drawCounts[i],
 			};
-			VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &drawInfo),
+			VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &shadedDrawInfo),
 								   "Failed to draw shaded actor models!");
 		}
-
-		if (unshadedDrawCount != 0)
+		for (uint32_t i = 0; i < actorModels->materialSlotCount; i++)
 		{
-			const LunaDrawIndexedIndirectInfo drawInfo = {
+			if (actorModels->drawCounts[i] == 0)
+			{
+				continue;
+			}
+			VulkanTest(lunaBindVertexBuffers(device, commandBuffer, &actorModels->materialData[currentFrame][i], 2, 1),
+					   "Failed to bind actor models material data buffer!");
+			const LunaDrawIndexedIndirectInfo unshadedDrawInfo = {
 				.pipeline = pipelines.unshadedActorModel,
 				.pipelineBindInfo = pipelineBindInfo,
-				.buffer = buffers.actorModels.unshadedDrawInfo,
-				.drawCount = unshadedDrawCount,
+				.buffer = actorModels->unshadedDrawInfo[currentFrame][i],
+				.drawCount = actorModels->drawCounts[i],
 			};
-			VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &drawInfo),
+			VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &unshadedDrawInfo),
 								   "Failed to draw unshaded actor models!");
 		}
 	}
 
+	const uint64_t wallsStartTime = GetTimeNs();
+	renderStats.passNs[RENDER_PASS_TIMING_ACTORS] += wallsStartTime - actorsStartTime;
 	if (buffers.actorWalls.shadedInstanceCount != 0 || buffers.actorWalls.unshadedInstanceCount != 0)
 	{
 		VulkanTest(lunaBindVertexBuffers(device, commandBuffer, &buffers.actorWalls.vertices, 0, 1),
@@ -567,7 +858,11 @@ static inline VkResult DrawActors(const LunaGraphicsPipelineBindInfo *pipelineBi
 
 		if (buffers.actorWalls.shadedInstanceCount != 0)
 		{
-			VulkanTest(lunaBindVertexBuffers(device, commandBuffer, &buffers.actorWalls.shadedInstanceData, 1, 1),
+			VulkanTest(lunaBindVertexBuffers(device,
+											 commandBuffer,
+											 &buffers.actorWalls.shadedInstanceData[currentFrame],
+											 1,
+											 1),
 					   "Failed to bind shaded actor wall instance data buffer!");
 			const LunaDrawInfo drawInfo = {
 				.pipeline = pipelines.shadedActorWall,
@@ -580,7 +875,11 @@ static inline VkResult DrawActors(const LunaGraphicsPipelineBindInfo *pipelineBi
 
 		if (buffers.actorWalls.unshadedInstanceCount != 0)
 		{
-			VulkanTest(lunaBindVertexBuffers(device, commandBuffer, &buffers.actorWalls.unshadedInstanceData, 1, 1),
+			VulkanTest(lunaBindVertexBuffers(device,
+											 commandBuffer,
+											 &buffers.actorWalls.unshadedInstanceData[currentFrame],
+											 1,
+											 1),
 					   "Failed to bind unshaded actor wall instance data buffer!");
 			const LunaDrawInfo drawInfo = {
 				.pipeline = pipelines.unshadedActorWall,
@@ -591,22 +890,32 @@ static inline VkResult DrawActors(const LunaGraphicsPipelineBindInfo *pipelineBi
 			VulkanTestReturnResult(lunaDraw(device, commandBuffer, &drawInfo), "Failed to draw unshaded actor walls!");
 		}
 	}
+	renderStats.passNs[RENDER_PASS_TIMING_WALLS] += GetTimeNs() - wallsStartTime;
 
 	return VK_SUCCESS;
 }
 
-static inline VkResult DrawViewmodel(const LunaGraphicsPipelineBindInfo *pipelineBindInfo)
+static inline VkResult DrawViewmodel(const Viewmodel *viewmodel, const LunaGraphicsPipelineBindInfo *pipelineBindInfo)
 {
-	const size_t shadedDrawCount = lunaGetBufferSize(buffers.viewmodel.shadedDrawInfo) /
+	const ModelDefinition *model = viewmodel->model;
+	for (uint32_t i = 0; i < model->materialSlotCount; i++)
+	{
+		const Material *material = model->materials + model->skinMaterialIndices[viewmodel->modelSkin][i];
+		RequestFullTextureDetail(TextureIndex(material->texture));
+	}
+
+
+	const size_t shadedDrawCount = lunaGetBufferSize(buffers.viewmodel.shadedDrawInfo[currentFrame]) /
 								   sizeof(VkDrawIndexedIndirectCommand);
-	const size_t unshadedDrawCount = lunaGetBufferSize(buffers.viewmodel.unshadedDrawInfo) /
+	const size_t unshadedDrawCount = lunaGetBufferSize(buffers.viewmodel.unshadedDrawInfo[currentFrame]) /
 									 sizeof(VkDrawIndexedIndirectCommand);
 
 	if (shadedDrawCount != 0 || unshadedDrawCount != 0)
 	{
 		VulkanTest(lunaBindVertexBuffers(device,
 										 commandBuffer,
-										 (LunaBuffer[]){buffers.viewmodel.vertices, buffers.viewmodel.instanceData},
+										 (LunaBuffer[]){buffers.viewmodel.vertices,
+														buffers.viewmodel.instanceData[currentFrame]},
 										 0,
 										 2),
 				   "Failed to bind viewmodel vertex buffers!");
@@ -619,7 +928,7 @@ static inline VkResult DrawViewmodel(const LunaGraphicsPipelineBindInfo *pipelin
 		const LunaDrawIndexedIndirectInfo drawInfo = {
 			.pipeline = pipelines.shadedViewmodel,
 			.pipelineBindInfo = pipelineBindInfo,
-			.buffer = buffers.viewmodel.shadedDrawInfo,
+			.buffer = buffers.viewmodel.shadedDrawInfo[currentFrame],
 			.drawCount = shadedDrawCount,
 		};
 		VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &drawInfo),
@@ -631,7 +940,7 @@ static inline VkResult DrawViewmodel(const LunaGraphicsPipelineBindInfo *pipelin
 		const LunaDrawIndexedIndirectInfo drawInfo = {
 			.pipeline = pipelines.unshadedViewmodel,
 			.pipelineBindInfo = pipelineBindInfo,
-			.buffer = buffers.viewmodel.unshadedDrawInfo,
+			.buffer = buffers.viewmodel.unshadedDrawInfo[currentFrame],
 			.drawCount = unshadedDrawCount,
 		};
 		VulkanTestReturnResult(lunaDrawIndexedIndirect(device, commandBuffer, &drawInfo),
@@ -641,11 +950,11 @@ static inline VkResult DrawViewmodel(const LunaGraphicsPipelineBindInfo *pipelin
 	return VK_SUCCESS;
 }
 
-static inline VkResult UpdateGlobalLightingUniform(const Map *map)
+static inline VkResult UpdateGlobalLightingUniform(const MapRenderState *state)
 {
 	const GlobalLightingUniform globalLightingUniform = {
-		.color = map->lightColor,
-		.exposure = map->exposure,
+		.color = state->lightColor,
+		.exposure = state->exposure,
 	};
 	const LunaBufferWriteInfo lightingBufferWriteInfo = {
 		.bytes = sizeof(GlobalLightingUniform),
@@ -657,16 +966,17 @@ static inline VkResult UpdateGlobalLightingUniform(const Map *map)
 												 buffers.uniforms.lighting,
 												 &lightingBufferWriteInfo),
 						   "Failed to update lighting data!");
+	writtenLighting = globalLightingUniform;
 
 	return VK_SUCCESS;
 }
 
-static inline VkResult UpdateFogUniform(const Map *map)
+static inline VkResult UpdateFogUniform(const MapRenderState *state)
 {
-	FogUniform fog = {
-		.color = map->fogColor,
-		.start = map->fogStart,
-		.end = map->fogEnd,
+	const FogUniform fog = {
+		.color = state->fogColor,
+		.start = state->fogStart,
+		.end = state->fogEnd,
 	};
 	const LunaBufferWriteInfo fogBufferWriteInfo = {
 		.bytes = sizeof(fog),
@@ -675,38 +985,41 @@ static inline VkResult UpdateFogUniform(const Map *map)
 	};
 	VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, buffers.uniforms.fog, &fogBufferWriteInfo),
 						   "Failed to update fog data!");
+	writtenFog = fog;
 
 	return VK_SUCCESS;
 }
 
-static inline VkResult HandleMapChangeFlags(Map *map)
+/**
+ * Write the lighting and fog uniforms and load the viewmodel if they differ from the state that the frame was queued
+ * with. The state is compared instead of relying on the main thread to flag changes, since a flag would be lost with
+ * any frame that is skipped, such as while the window is minimized.
+ * @param state The state of the map as of when the frame was queued
+ */
+static inline VkResult HandleMapRenderStateChanges(const MapRenderState *state)
 {
-	if (map->changeFlags != 0)
-	{
-		asm("nop");
-	}
-	static_assert(MAP_LIGHT_CHANGED == MAP_EXPOSURE_CHANGED);
-	if ((map->changeFlags & MAP_LIGHT_CHANGED) == MAP_LIGHT_CHANGED)
+	if (memcmp(&state->lightColor, &writtenLighting.color, sizeof(Color)) != 0 ||
+		state->exposure != writtenLighting.exposure)
 	{
-		VulkanTestReturnResult(UpdateGlobalLightingUniform(map), "Failed to update global lighting uniform!");
+		VulkanTestReturnResult(UpdateGlobalLightingUniform(state), "Failed to update global lighting uniform!");
 	}
 
-	if ((map->changeFlags & MAP_FOG_CHANGED) == MAP_FOG_CHANGED)
+	if (memcmp(&state->fogColor, &writtenFog.color, sizeof(Color)) != 0 ||
+		state->fogStart != writtenFog.start ||
+		state->fogEnd != writtenFog.end)
 	{
-		VulkanTestReturnResult(UpdateFogUniform(map), "Failed to update fog uniform!");
+		VulkanTestReturnResult(UpdateFogUniform(state), "Failed to update fog uniform!");
 	}
 
-	if ((map->changeFlags & MAP_VIEWMODEL_CHANGED) == MAP_VIEWMODEL_CHANGED)
+	if (state->viewmodel.model != loadedViewmodelModel || state->viewmodel.modelSkin != loadedViewmodelSkin)
 	{
-		VulkanTestReturnResult(LoadViewmodel(&map->viewmodel), "Failed to updated load viewmodel!");
+		VulkanTestReturnResult(LoadViewmodel(&state->viewmodel), "Failed to load viewmodel!");
 	}
 
-	map->changeFlags = 0;
-
 	return VK_SUCCESS;
 }
 
-static inline bool HandleRendererQueuedActions()
+bool VK_HandleQueuedActions()
 {
 	if (rendererQueuedActions & QUEUED_ACTION_CLEAR_ALL_TEXTURES)
 	{
@@ -714,6 +1027,7 @@ static inline bool HandleRendererQueuedActions()
 		{
 			return false;
 		}
+		InvalidateActorInstanceData();
 		const Map *map = GetState()->map;
 		if (map != loadedMap)
 		{
@@ -725,7 +1039,7 @@ static inline bool HandleRendererQueuedActions()
 		}
 		if (loadedMap != NULL)
 		{
-			VulkanTest(UpdateMapInstanceData(loadedMap), "Failed to update map instance data when reloading textures!");
+			UpdateMapInstanceData(loadedMap);
 			if (loadedMap->renderSky)
 			{
 				skyTextureIndex = TextureIndex(loadedMap->skyTexture);
@@ -761,7 +1075,7 @@ bool VK_Init(SDL_Window *window)
 	// clang-format off
 	if (CreateSurface(window) && CreateLogicalDevice() && CreateCommandBuffers() && CreateSwapchain() &&
 		CreateRenderPass() && CreateDescriptorSetLayouts() && CreateGraphicsPipelines() && CreateTextureSamplers() &&
-		CreateBuffers() && CreateDescriptorSet())
+		CreateBuffers() && CreateDescriptorSets())
 	{
 		// clang-format on
 		char vendor[32] = {};
@@ -823,12 +1137,18 @@ bool VK_FrameStart()
 		return false;
 	}
 
-	if (!HandleRendererQueuedActions())
+	const uint64_t gpuWaitStartTime = GetTimeNs();
+	const VkResult beginFrameResult = lunaBeginFrame(device, commandBuffer, false);
+	renderStats.gpuWaitNs = GetTimeNs() - gpuWaitStartTime;
+	VulkanTestResizeSwapchain(beginFrameResult, "Failed to begin frame!");
+	recordingFrame = true;
+	DestroyRetiredResources();
+	// The descriptor set of this frame was in use until lunaBeginFrame waited for it, so changes made since are written
+	if (lightmapDescriptorDirtyFrames & 1u << currentFrame)
 	{
-		return false;
+		WriteLightmapDescriptor();
 	}
-
-	VulkanTestResizeSwapchain(lunaBeginFrame(device, commandBuffer, false), "Failed to begin frame!");
+	WriteDirtyTextureDescriptors();
 	const LunaRenderPassBeginInfo beginInfo = {
 		.renderArea.extent = swapChainExtent,
 		.depthAttachmentClearValue.depthStencil.depth = 1,
@@ -847,7 +1167,7 @@ bool VK_FrameStart()
 	return true;
 }
 
-bool VK_RenderMap(Map *map, const Camera *camera)
+bool VK_RenderMap(Map *map, const Camera *camera, const MapRenderState *state, const bool isPlayerCamera)
 {
 	if (map != loadedMap)
 	{
@@ -857,12 +1177,30 @@ bool VK_RenderMap(Map *map, const Camera *camera)
 		}
 	}
 
-	VulkanTest(HandleMapChangeFlags(map), "Failed to handle map change flags!");
+	VulkanTest(HandleMapRenderStateChanges(state), "Failed to handle map state changes!");
 
 	VulkanTest(UpdateCameraUniform(camera), "Failed to update transform matrix!");
 
-	VulkanTest(UpdateViewModelMatrix(&map->viewmodel), "Failed to update viewmodel transform matrix!");
+	VulkanTest(UpdateViewmodelFrameBuffers(&state->viewmodel), "Failed to update viewmodel buffers!");
+
+	VulkanTest(UpdateViewModelMatrix(&state->viewmodel), "Failed to update viewmodel transform matrix!");
+
+	VulkanTest(WriteMapInstanceData(map), "Failed to write map instance data!");
 
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	mat4 viewProjectionMatrix;
+	const float aspectRatio = (float)swapChainExtent.width / (float)swapChainExtent.height;
+	CameraMatrices(camera, aspectRatio, &viewMatrix, &projectionMatrix);
+	glm_mat4_mul(projectionMatrix, viewMatrix, viewProjectionMatrix);
+	const uint64_t occluderStartTime = GetTimeNs();
+	DrawOccluders(&occlusionBuffer, viewProjectionMatrix, map->occluderVertices, map->occluderTriangleCount);
+	renderStats.occluderDrawNs += GetTimeNs() - occluderStartTime;
+	renderStats.occluderTriangles += occlusionBuffer.trianglesDrawn;
+	Frustum frustum;
+	FrustumFromMatrix(viewProjectionMatrix, &frustum);
+	const float pixelScale = projectionMatrix[1][1] * (float)swapChainExtent.height / 2.0f;
+	VulkanTest(CullMapClusters(map, &frustum), "Failed to cull map clusters!");
 
 	const VkViewport viewport = {
 		.width = (float)swapChainExtent.width,
@@ -892,20 +1230,34 @@ bool VK_RenderMap(Map *map, const Camera *camera)
 	};
 	const LunaGraphicsPipelineBindInfo pipelineBindInfo = {
 		.descriptorSetBindInfo.descriptorSetCount = 1,
-		.descriptorSetBindInfo.descriptorSets = &descriptorSet,
+		.descriptorSetBindInfo.descriptorSets = &descriptorSets[currentFrame],
 		.dynamicStateCount = sizeof(dynamicStateBindInfos) / sizeof(*dynamicStateBindInfos),
 		.dynamicStates = dynamicStateBindInfos,
 	};
 
+	uint64_t passStartTime = GetTimeNs();
 	if (map->renderSky)
 	{
 		VulkanTest(DrawSky(&pipelineBindInfo), "Failed to draw sky!");
 	}
+	renderStats.passNs[RENDER_PASS_TIMING_SKY] += GetTimeNs() - passStartTime;
+	passStartTime = GetTimeNs();
 	VulkanTest(DrawMap(&pipelineBindInfo), "Failed to draw map!");
-	VulkanTest(DrawActors(&pipelineBindInfo), "Failed to draw actors!");
-	if (map->viewmodel.enabled && camera == &map->player.playerCamera)
+	renderStats.passNs[RENDER_PASS_TIMING_MAP] += GetTimeNs() - passStartTime;
+	// The actor and wall passes are timed inside of DrawActors, since they are recorded by the same function
+	VulkanTest(DrawActors(&pipelineBindInfo, &frustum, &camera->transform.position, pixelScale),
+			   "Failed to draw actors!");
+	passStartTime = GetTimeNs();
+	if (state->viewmodel.enabled && isPlayerCamera)
 	{
-		VulkanTest(DrawViewmodel(&pipelineBindInfo), "Failed to draw viewmodel!");
+		VulkanTest(DrawViewmodel(&state->viewmodel, &pipelineBindInfo), "Failed to draw viewmodel!");
+	}
+	renderStats.passNs[RENDER_PASS_TIMING_VIEWMODEL] += GetTimeNs() - passStartTime;
+
+	ReportMapTextureScreenSizes(map, &camera->transform.position, pixelScale);
+	if (map->renderSky)
+	{
+		RequestFullTextureDetail(skyTextureIndex);
 	}
 
 	return true;
@@ -913,38 +1265,59 @@ bool VK_RenderMap(Map *map, const Camera *camera)
 
 bool VK_FrameEnd()
 {
-	if ((pendingTasks & PENDING_TASK_UI_BUFFERS_RESIZE_BIT) == PENDING_TASK_UI_BUFFERS_RESIZE_BIT)
+	// This runs after both the map and the UI have recorded which textures they drew this frame
+	VulkanTest(StreamTextures(), "Failed to stream textures!");
+
+	const uint64_t uiStartTime = GetTimeNs();
+	LunaBuffer *uiVertexBuffer = &buffers.ui.vertexBuffers[currentFrame];
+	if (buffers.ui.bufferQuads[currentFrame] < buffers.ui.allocatedQuads)
 	{
+		// The previous use of this buffer was by the frame that lunaBeginFrame waited for, so it can be replaced
 		VulkanTest(lunaGrowBuffer(device,
 								  commandBuffer,
-								  &buffers.ui.vertexBuffer,
+								  uiVertexBuffer,
 								  buffers.ui.allocatedQuads * 4 * sizeof(UiVertex)),
 				   "Failed to recreate UI vertex buffer!");
-		VulkanTest(lunaGrowBuffer(device,
-								  commandBuffer,
-								  &buffers.ui.indexBuffer,
-								  buffers.ui.allocatedQuads * 6 * sizeof(uint32_t)),
-				   "Failed to recreate UI index buffer!");
 
-		pendingTasks &= ~PENDING_TASK_UI_BUFFERS_RESIZE_BIT;
+		buffers.ui.bufferQuads[currentFrame] = buffers.ui.allocatedQuads;
+	}
+	if (!buffers.ui.indexBufferWritten)
+	{
+		// The indices are the same for every frame, so they are only written once
+		uint16_t *indices = malloc(UI_INDEXED_QUADS * 6 * sizeof(uint16_t));
+		CheckAlloc(indices);
+		for (uint32_t i = 0; i < UI_INDEXED_QUADS; i++)
+		{
+			const uint16_t firstVertex = (uint16_t)(i * 4);
+			indices[i * 6 + 0] = firstVertex;
+			indices[i * 6 + 1] = (uint16_t)(firstVertex + 1);
+			indices[i * 6 + 2] = (uint16_t)(firstVertex + 2);
+			indices[i * 6 + 3] = firstVertex;
+			indices[i * 6 + 4] = (uint16_t)(firstVertex + 2);
+			indices[i * 6 + 5] = (uint16_t)(firstVertex + 3);
+		}
+		const LunaBufferWriteInfo indexBufferWriteInfo = {
+			.bytes = UI_INDEXED_QUADS * 6 * sizeof(uint16_t),
+			.data = indices,
+			.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		};
+		const VkResult result = lunaWriteDataToBuffer(device,
+													  commandBuffer,
+													  buffers.ui.indexBuffer,
+													  &indexBufferWriteInfo);
+		free(indices);
+		VulkanTest(result, "Failed to write UI index buffer!");
+		buffers.ui.indexBufferWritten = true;
 	}
 	if (buffers.ui.freeQuads != buffers.ui.allocatedQuads)
 	{
-		// TODO: This write is the cause of the glitching (and crash) when pausing the game
 		const LunaBufferWriteInfo vertexBufferWriteInfo = {
 			.bytes = (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 4 * sizeof(UiVertex),
 			.data = buffers.ui.vertexData,
 			.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
 		};
-		const LunaBufferWriteInfo indexBufferWriteInfo = {
-			.bytes = (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 6 * sizeof(uint32_t),
-			.data = buffers.ui.indexData,
-			.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-		};
-		VulkanTest(lunaWriteDataToBuffer(device, commandBuffer, buffers.ui.vertexBuffer, &vertexBufferWriteInfo),
+		VulkanTest(lunaWriteDataToBuffer(device, commandBuffer, *uiVertexBuffer, &vertexBufferWriteInfo),
 				   "Failed to write UI vertex buffer!");
-		VulkanTest(lunaWriteDataToBuffer(device, commandBuffer, buffers.ui.indexBuffer, &indexBufferWriteInfo),
-				   "Failed to write UI index buffer!");
 	}
 
 	if (buffers.ui.freeQuads != buffers.ui.allocatedQuads)
@@ -977,24 +1350,31 @@ bool VK_FrameEnd()
 		};
 		const LunaGraphicsPipelineBindInfo pipelineBindInfo = {
 			.descriptorSetBindInfo.descriptorSetCount = 1,
-			.descriptorSetBindInfo.descriptorSets = &descriptorSet,
+			.descriptorSetBindInfo.descriptorSets = &descriptorSets[currentFrame],
 			.dynamicStateCount = sizeof(dynamicStateBindInfos) / sizeof(*dynamicStateBindInfos),
 			.dynamicStates = dynamicStateBindInfos,
 		};
-		const LunaDrawIndexedInfo drawInfo = {
-			.pipeline = pipelines.ui,
-			.pipelineBindInfo = &pipelineBindInfo,
-			.indexCount = (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 6,
-			.instanceCount = 1,
-		};
-		VulkanTest(lunaDrawBufferIndexed(device,
-										 commandBuffer,
-										 buffers.ui.vertexBuffer,
-										 buffers.ui.indexBuffer,
-										 VK_INDEX_TYPE_UINT32,
-										 &drawInfo),
-				   "Failed to draw UI!");
+		// 16-bit indices only reach UI_INDEXED_QUADS quads, so each draw after the first starts that many quads later
+		const uint32_t quadCount = buffers.ui.allocatedQuads - buffers.ui.freeQuads;
+		for (uint32_t firstQuad = 0; firstQuad < quadCount; firstQuad += UI_INDEXED_QUADS)
+		{
+			const LunaDrawIndexedInfo drawInfo = {
+				.pipeline = pipelines.ui,
+				.pipelineBindInfo = &pipelineBindInfo,
+				.indexCount = min(quadCount - firstQuad, UI_INDEXED_QUADS) * 6,
+				.instanceCount = 1,
+				.vertexOffset = (int32_t)(firstQuad * 4),
+			};
+			VulkanTest(lunaDrawBufferIndexed(device,
+											 commandBuffer,
+											 *uiVertexBuffer,
+											 buffers.ui.indexBuffer,
+											 VK_INDEX_TYPE_UINT16,
+											 &drawInfo),
+					   "Failed to draw UI!");
+		}
 	}
+	renderStats.passNs[RENDER_PASS_TIMING_UI] += GetTimeNs() - uiStartTime;
 
 	lunaEndRenderPass(commandBuffer);
 
@@ -1016,8 +1396,10 @@ bool VK_FrameEnd()
 		.signalSemaphores = &semaphore,
 	};
 
-	VulkanTestResizeSwapchain(lunaEndFrame(device, commandBuffer, &presentInfo, &submitInfo),
-							  "Failed to present swapchain!");
+	// The frame is submitted even when presenting fails because the swapchain is out of date
+	const VkResult endFrameResult = lunaEndFrame(device, commandBuffer, &presentInfo, &submitInfo);
+	AdvanceFrame();
+	VulkanTestResizeSwapchain(endFrameResult, "Failed to present swapchain!");
 
 	return true;
 }
@@ -1026,7 +1408,13 @@ void VK_Cleanup()
 {
 	LogDebug("Cleaning up Vulkan renderer...\n");
 	free(buffers.ui.vertexData);
-	free(buffers.ui.indexData);
+	free(mapDrawInfo);
+	free(mapVisibleDrawInfo);
+	free(mapDrawInfoClusters);
+	free(mapClustersVisible);
+	free(mapModelTextureIndices);
+	CullingBoundsFree(&mapClusterBounds);
+	DestroyTextureStagingRing();
 	VulkanTestInternal(lunaDestroyInstance(), (void)0, "Cleanup failed!");
 }
 
@@ -1046,7 +1434,7 @@ bool VK_LoadMap(const Map *map)
 {
 	if (map == NULL)
 	{
-		lunaDestroyImage(device, lightmap);
+		DestroyImageWhenRetired(lightmap);
 		lightmap = LUNA_NULL_HANDLE;
 
 		loadedMap = NULL;
@@ -1054,11 +1442,13 @@ bool VK_LoadMap(const Map *map)
 		return true;
 	}
 
-	VulkanTest(LoadMapModelsToBuffer(map->modelCount, map->models), "Failed to load map models!");
+	VulkanTest(LoadMapModelsToBuffer(map), "Failed to load map models!");
 
 	VulkanTest(LoadLightmap(map), "Failed to load lightmap!");
 
-	VulkanTest(LoadViewmodel(&map->viewmodel), "Failed to load viewmodel!");
+	MapRenderState state;
+	GetMapRenderState(map, &state);
+	VulkanTest(LoadViewmodel(&state.viewmodel), "Failed to load viewmodel!");
 
 	VulkanTest(LoadActors(&map->actors), "Failed to load actors!");
 
@@ -1068,9 +1458,9 @@ bool VK_LoadMap(const Map *map)
 		skyTextureIndex = TextureIndex(map->skyTexture);
 	}
 
-	VulkanTest(UpdateGlobalLightingUniform(map), "Failed to update global lighting uniform!");
+	VulkanTest(UpdateGlobalLightingUniform(&state), "Failed to update global lighting uniform!");
 
-	VulkanTest(UpdateFogUniform(map), "Failed to update fog uniform!");
+	VulkanTest(UpdateFogUniform(&state), "Failed to update fog uniform!");
 
 	loadedMap = map;
 
@@ -1104,6 +1494,11 @@ inline void VK_Restore()
 	minimized = false;
 }
 
+inline bool VK_IsMinimized()
+{
+	return minimized;
+}
+
 void VK_DrawColoredQuad(const int32_t x, const int32_t y, const int32_t w, const int32_t h, const Color color)
 {
 	DrawRectInternal(VK_X_TO_NDC(x), VK_Y_TO_NDC(y), VK_X_TO_NDC(x + w), VK_Y_TO_NDC(y + h), 0, 0, 0, 0, &color, -1);
@@ -1124,7 +1519,7 @@ void VK_DrawColoredQuadsBatched(const float *vertices, const int32_t quadCount,
 	}
 }
 
-void VK_DrawTexturedQuad(const int32_t x, const int32_t y, const int32_t w, const int32_t h, const char *texture)
+void VK_DrawTexturedQuad(const int32_t x, const int32_t y, const int32_t w, const int32_t h, const Image *image)
 {
 	DrawRectInternal(VK_X_TO_NDC(x),
 					 VK_Y_TO_NDC(y),
@@ -1135,14 +1530,14 @@ void VK_DrawTexturedQuad(const int32_t x, const int32_t y, const int32_t w, cons
 					 1,
 					 1,
 					 &COLOR_WHITE,
-					 TextureIndex(texture));
+					 ImageIndex(image));
 }
 
 void VK_DrawTexturedQuadMod(const int32_t x,
 							const int32_t y,
 							const int32_t w,
 							const int32_t h,
-							const char *texture,
+							const Image *image,
 							const Color *color)
 {
 	DrawRectInternal(VK_X_TO_NDC(x),
@@ -1154,7 +1549,7 @@ void VK_DrawTexturedQuadMod(const int32_t x,
 					 1,
 					 1,
 					 color,
-					 TextureIndex(texture));
+					 ImageIndex(image));
 }
 
 void VK_DrawTexturedQuadRegion(const int32_t x,
@@ -1165,10 +1560,8 @@ void VK_DrawTexturedQuadRegion(const int32_t x,
 							   const int32_t regionY,
 							   const int32_t regionW,
 							   const int32_t regionH,
-							   const char *texture)
+							   const Image *image)
 {
-	const Image *image = LoadImage(texture);
-
 	const float startU = (float)regionX / (float)image->width;
 	const float startV = (float)regionY / (float)image->height;
 
@@ -1192,11 +1585,9 @@ void VK_DrawTexturedQuadRegionMod(const int32_t x,
 								  const int32_t regionY,
 								  const int32_t regionW,
 								  const int32_t regionH,
-								  const char *texture,
+								  const Image *image,
 								  const Color color)
 {
-	const Image *image = LoadImage(texture);
-
 	const float startU = (float)regionX / (float)image->width;
 	const float startV = (float)regionY / (float)image->height;
 
@@ -1212,9 +1603,9 @@ void VK_DrawTexturedQuadRegionMod(const int32_t x,
 					 ImageIndex(image));
 }
 
-void VK_DrawTexturedQuadsBatched(const float *vertices, const int32_t quadCount, const char *texture, const Color color)
+void VK_DrawTexturedQuadsBatched(const float *vertices, const int32_t quadCount, const Image *image, const Color color)
 {
-	const uint32_t textureIndex = TextureIndex(texture);
+	const uint32_t textureIndex = ImageIndex(image);
 	for (int32_t i = 0; i < quadCount; i++)
 	{
 		DrawQuadInternal((vec4 *)(vertices + i * 16), &color, textureIndex);
@@ -1274,31 +1665,36 @@ void VK_DrawRectOutline(const int32_t x,
 	VK_DrawLine(x, y + h, x, y, thickness, color);
 }
 
-void VK_DrawUiTriangles(const UiTriangleArray *triangleArray, const char *texture, const Color color)
+void VK_DrawUiTriangles(const UiTriangleArray *triangleArray, const Image *image, const Color color)
 {
-	// Good enough for now
-	const size_t quadCount = triangleArray->indexCount / 6;
-	EnsureSpaceForUiElements(quadCount);
-
-	const size_t vertexOffset = (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 4;
-	UiVertex *vertices = buffers.ui.vertexData + vertexOffset;
-	uint32_t *indices = buffers.ui.indexData + (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 6;
-
-	for (size_t i = 0; i < triangleArray->vertexCount; i++)
+	// Pairs of triangles that share an edge become one quad, and any other triangle becomes a quad with its last vertex
+	// repeated, so that the triangles can use the same indices as every other UI element
+	const size_t triangleCount = triangleArray->indexCount / 3;
+	EnsureSpaceForUiElements(triangleCount);
+	const uint32_t textureIndex = ImageIndex(image);
+	RequestFullTextureDetail(textureIndex);
+
+	UiVertex *vertices = buffers.ui.vertexData + (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 4;
+	for (size_t i = 0; i < triangleCount; i++)
 	{
-		memcpy(vertices + i, triangleArray->vertices[i], sizeof(*triangleArray->vertices));
-		vertices[i].r = color.r;
-		vertices[i].g = color.g;
-		vertices[i].b = color.b;
-		vertices[i].a = color.a;
-		vertices[i].textureIndex = TextureIndex(texture);
-	}
-	for (size_t i = 0; i < triangleArray->indexCount; i++)
-	{
-		indices[i] = (*triangleArray->indices)[i] + vertexOffset;
+		const uint32_t *triangle = triangleArray->indices[i];
+		uint32_t quad[4] = {triangle[0], triangle[1], triangle[2], triangle[2]};
+		if (i + 1 < triangleCount && JoinTrianglesIntoQuad(triangle, triangleArray->indices[i + 1], quad))
+		{
+			i++;
+		}
+		for (int j = 0; j < 4; j++)
+		{
+			memcpy(vertices, triangleArray->vertices[quad[j]], sizeof(*triangleArray->vertices));
+			vertices->r = color.r;
+			vertices->g = color.g;
+			vertices->b = color.b;
+			vertices->a = color.a;
+			vertices->textureIndex = textureIndex;
+			vertices++;
+		}
+		buffers.ui.freeQuads--;
 	}
-
-	buffers.ui.freeQuads -= quadCount;
 }
 
 void VK_DrawJoltDebugRendererLine(const Vector3 *from, const Vector3 *to, const uint32_t color)
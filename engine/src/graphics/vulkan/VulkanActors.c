@@ -2,14 +2,30 @@
 //
 
 #include <assert.h>
+#include <cglm/mat4.h>
+#include <cglm/types.h>
 #include <engine/assets/ModelLoader.h>
+#include <engine/graphics/Culling.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/graphics/TextureStreaming.h>
 #include <engine/graphics/vulkan/VulkanActors.h>
 #include <engine/graphics/vulkan/VulkanHelpers.h>
+#include <engine/helpers/MathEx.h>
 #include <engine/structs/Actor.h>
+#include <engine/structs/Color.h>
 #include <engine/structs/GlobalState.h>
 #include <engine/structs/List.h>
+#include <engine/subsystem/Logging.h>
+#include <engine/subsystem/Timing.h>
+#include <joltc/Math/Quat.h>
+#include <joltc/Math/Vector3.h>
+#include <joltc/Physics/Body/BodyID.h>
+#include <joltc/Physics/Body/BodyInterface.h>
 #include <luna/lunaBuffer.h>
 #include <luna/lunaTypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,56 +38,195 @@ typedef struct
 	int32_t vertexOffset;
 } MaterialSlotVertexData;
 
+/**
+ * The instances of one model LOD
+ *
+ * The LOD owns a run of @c instanceCapacity entries in @c modelsInstanceData, and the same entries of the material data
+ * array of each of its material slots. Every material slot of the LOD has a draw command in the draw info array of that
+ * material slot index, and all of them use the same instances, so the per-actor data is only stored once.
+ */
 typedef struct
 {
-	/// A pointer to the VkDrawIndexedIndirectCommand structure used for drawing this material as shaded
-	VkDrawIndexedIndirectCommand *shadedDrawInfo;
-	/// A pointer to the VkDrawIndexedIndirectCommand structure used for drawing this material as unshaded
-	VkDrawIndexedIndirectCommand *unshadedDrawInfo;
-	/// A pointer to the instance data for the first instance
-	ActorModelInstanceData *instanceData;
-} MaterialSlotData;
+	/// The number of material slots of the LOD's model
+	uint32_t materialSlotCount;
+	/// The index of the LOD's draw command in the draw info array of each material slot index
+	uint32_t *drawInfoIndices;
+	/// The index in @c modelsInstanceData of the first entry of the run
+	uint32_t firstInstance;
+	/// The number of instances
+	uint32_t instanceCount;
+	/// The number of instances at the start of the run that are drawn, which is the instance count of the draw commands
+	uint32_t drawnCount;
+	/// The number of instances that the run has space for
+	uint32_t instanceCapacity;
+	/// The instance slot that owns each instance, used to find the actor whose instance is moved by a removal
+	uint32_t *instanceOwners;
+} LodInstanceRange;
+
+/**
+ * The material data and draw commands for one material slot index, shared by every LOD with more slots than the index
+ */
+typedef struct
+{
+	/// The CPU-side copy of the material data buffer, using the same indices as @c modelsInstanceData
+	ActorModelMaterialData *materialData;
+	/// For each frame in flight, a bitset of the entries in @c materialData that have changed since they were last
+	/// written to that frame's material data buffer
+	uint64_t *materialDirtyBits[FRAMES_IN_FLIGHT];
+	/// The CPU-side copy of the draw info buffers, which hold the same commands for the shaded and unshaded pipelines
+	VkDrawIndexedIndirectCommand *drawInfo;
+	/// The number of draw commands that @c drawInfo has space for
+	uint32_t drawInfoCapacity;
+	/// For each frame in flight, the first draw command that has changed since that frame's draw info buffers were last
+	/// written
+	uint32_t firstDirtyDrawInfo[FRAMES_IN_FLIGHT];
+	/// For each frame in flight, one past the last draw command that has changed since that frame's draw info buffers
+	/// were last written
+	uint32_t endDirtyDrawInfo[FRAMES_IN_FLIGHT];
+} MaterialSlotStream;
 
+/**
+ * The instances of either the shaded or the unshaded actor walls
+ */
 typedef struct
 {
+	/// The buffers that the instance data is written to, one for each frame in flight
+	LunaBuffer *frameBuffers;
+	/// The number of instances at the start of the array that are drawn, which is the instance count of the draw call
+	uint32_t drawnCount;
 	/// The number of instances
 	uint32_t instanceCount;
-	/// A list of @c MaterialSlotData structures, indexed using a material slot index
-	List materialSlots;
-} LodMaterialSlotsData;
+	/// The number of instances that the arrays have space for
+	uint32_t instanceCapacity;
+	/// The CPU-side copy of the instance data
+	ActorWallInstanceData *instanceData;
+	/// For each frame in flight, a bitset of the entries in @c instanceData that have changed since they were last
+	/// written to that frame's buffer
+	uint64_t *dirtyBits[FRAMES_IN_FLIGHT];
+	/// The instance slot that owns each instance
+	uint32_t *instanceOwners;
+} WallInstanceArray;
+
+typedef enum ActorInstanceDirtyFlags
+{
+	/// The actor's body has moved or rotated
+	ACTOR_INSTANCE_DIRTY_TRANSFORM = 1 << 0,
+	/// The actor's modColor has changed
+	ACTOR_INSTANCE_DIRTY_COLOR = 1 << 1,
+	/// The actor's skin has changed, or the texture indices of its materials might have changed
+	ACTOR_INSTANCE_DIRTY_SKIN = 1 << 2,
+	/// The actor's model has switched to a different LOD
+	ACTOR_INSTANCE_DIRTY_LOD = 1 << 3,
+	ACTOR_INSTANCE_DIRTY_ALL = ACTOR_INSTANCE_DIRTY_TRANSFORM |
+							   ACTOR_INSTANCE_DIRTY_COLOR |
+							   ACTOR_INSTANCE_DIRTY_SKIN |
+							   ACTOR_INSTANCE_DIRTY_LOD,
+} ActorInstanceDirtyFlags;
 
+/**
+ * The renderer's record of an actor's instance, indexed using @c Actor::instanceSlot
+ *
+ * The record stores the state that was last written to the instance data, which is compared against the actor every
+ * frame to find out which parts of the instance data have to be written again.
+ *
+ * The instances of each LOD and wall array are kept partitioned, with the drawn instances at the start, so that culled
+ * and hidden instances are left out of the draws without writing anything for them. The CPU-side instance data of an
+ * instance is always kept up to date, but it is only written to the GPU while the instance is drawn.
+ */
 typedef struct
 {
-	List *lodInstanceCounts;
-	uint32_t modelInstanceCount;
-	uint32_t modelDrawCount;
-	uint32_t shadedWallsInstanceCount;
-	uint32_t unshadedWallsInstanceCount;
-	bool shouldReallocModels;
-	bool shouldReallocShadedWalls;
-	bool shouldReallocUnshadedWalls;
-} InstanceDataReallocInfo;
+	/// The actor that owns the slot, or @c NULL if the slot is free
+	const Actor *actor;
+	/// The model that the instance was added for, or @c NULL for walls
+	const ModelDefinition *model;
+	/// The index of the instance, within its LOD for models or within its instance buffer for walls
+	uint32_t instanceIndex;
+	/// The id of the LOD the instance belongs to, or @c UINT32_MAX for walls
+	uint32_t lodId;
+	/// Whether the instance is in the unshaded walls instance buffer, only used for walls
+	bool unshadedWall;
+	/// Whether the instance is in the drawn part of its LOD or wall array
+	bool drawn;
+	/// Flags for the parts of the instance data that have to be written this frame
+	uint8_t dirtyFlags;
+	/// The position of the actor's body when its transform was last written
+	JPH_RVec3 position;
+	/// The rotation of the actor's body when its transform was last written
+	JPH_Quat rotation;
+	/// The modColor that was last written
+	Color modColor;
+	/// The skin that was last written
+	uint32_t skinIndex;
+	/// The LOD that was last written
+	uint32_t lod;
+} ActorInstanceSlot;
+
+/// Clean instances that are surrounded by dirty instances are written anyway if there are fewer than this many of them
+#define INSTANCE_WRITE_MERGE_GAP 8
+/// The number of instances that a LOD has space for once its first instance is added
+#define MIN_LOD_INSTANCE_CAPACITY 4
+/// The number of walls that a wall instance array has space for once its first wall is added
+#define MIN_WALL_INSTANCE_CAPACITY 16
+/// The number of draw commands that the draw info array of a material slot index has space for once it is first used
+#define MIN_DRAW_INFO_CAPACITY 16
+/// The number of instance slot records that are allocated when the first actor is added
+#define MIN_INSTANCE_SLOT_CAPACITY 64
 
 static size_t bufferVertexCount;
 static size_t bufferIndexCount;
+
 static ActorModelInstanceData *modelsInstanceData;
-static VkDrawIndexedIndirectCommand *shadedModelsDrawInfo;
-static VkDrawIndexedIndirectCommand *unshadedModelsDrawInfo;
-static ActorWallInstanceData *shadedWallsInstanceData;
-static ActorWallInstanceData *unshadedWallsInstanceData;
+/// For each frame in flight, a bitset of the entries in @c modelsInstanceData that have changed since they were last
+/// written to that frame's instance data buffer
+static uint64_t *modelsInstanceDirtyBits[FRAMES_IN_FLIGHT];
+/// The number of entries at the start of @c modelsInstanceData that belong to a LOD or are a hole between LODs
+static uint32_t modelsInstanceCount;
+/// The number of entries that @c modelsInstanceData has space for
+static uint32_t modelsInstanceCapacity;
+/// The number of entries before @c modelsInstanceCount that were left behind by LODs that had to move to grow
+static uint32_t modelsInstanceHoleCount;
+
+/// The material data and draw commands of each material slot index, one for each of @c buffers.actorModels.materialData
+static MaterialSlotStream *materialSlotStreams;
+
+static WallInstanceArray shadedWalls = {
+	.frameBuffers = buffers.actorWalls.shadedInstanceData,
+};
+static WallInstanceArray unshadedWalls = {
+	.frameBuffers = buffers.actorWalls.unshadedInstanceData,
+};
+
+/// The instance slot records, indexed using @c Actor::instanceSlot
+static ActorInstanceSlot *instanceSlots;
+/// The number of records in @c instanceSlots, including free ones
+static uint32_t instanceSlotCount;
+/// The number of records that @c instanceSlots has space for
+static uint32_t allocatedInstanceSlots;
+/// A list of uint32_t indices of the records in @c instanceSlots that are free
+static List freeInstanceSlots;
+/// A list of actors that were added to the map and will be given an instance slot at the start of the next frame
+static List pendingActors;
+/// The world space bounding box of each instance, indexed using @c Actor::instanceSlot
+static CullingBounds instanceBounds;
+/// Whether the bounding box of each instance intersected the camera frustum this frame, indexed like @c instanceBounds
+static uint8_t *instancesInFrustum;
+/// Whether the bounding box of each instance is inside the camera frustum and not hidden behind occluders this frame
+static uint8_t *instancesVisible;
 
 /// A list of uint32_t model ids that are currently loaded
 static List loadedModelIds;
 /// A list, indexed with a lod id, that contains lists of @c MaterialSlotVertexData structures for each material slot
 static List lodMaterialSlotsVertexData;
-/// A list of @c LodMaterialSlotsData structures, indexed using a lod id
-static List lodMaterialSlotsData;
+/// A list of @c LodInstanceRange structures, indexed using a lod id, which is @c NULL for LODs that have no range yet
+static List lodInstanceRanges;
 
 void InitActorLoadingVariables()
 {
 	ListInit(loadedModelIds, LIST_UINT32);
 	ListInit(lodMaterialSlotsVertexData, LIST_NESTED);
-	ListInit(lodMaterialSlotsData, LIST_POINTER);
+	ListInit(lodInstanceRanges, LIST_POINTER);
+	ListInit(freeInstanceSlots, LIST_UINT32);
+	ListInit(pendingActors, LIST_POINTER);
 }
 
 static inline VkResult LoadModelLods(const ModelDefinition *model)
@@ -179,238 +334,823 @@ static inline VkResult LoadModelLods(const ModelDefinition *model)
 	return VK_SUCCESS;
 }
 
-static inline VkResult LoadActor(const Actor *actor)
+/**
+ * Replace the dirty bitsets of every frame in flight with empty ones that have space for a number of entries
+ */
+static inline void ReallocateDirtyBits(uint64_t **dirtyBits, const size_t capacity)
 {
-	if (actor->hasModel)
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		free(dirtyBits[i]);
+		dirtyBits[i] = calloc((capacity + 63) / 64 + 1, sizeof(uint64_t));
+		CheckAlloc(dirtyBits[i]);
+	}
+}
+
+/**
+ * Mark an entry as dirty in the bitset of every frame in flight, since each frame's buffer has to be brought up to date
+ */
+static inline void MarkInstanceDirty(uint64_t *const *dirtyBits, const size_t index)
+{
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		dirtyBits[i][index / 64] |= 1ull << (index % 64);
+	}
+}
+
+static inline void MarkInstancesDirty(uint64_t *const *dirtyBits, const size_t firstIndex, const size_t count)
+{
+	for (size_t i = firstIndex; i < firstIndex + count; i++)
+	{
+		MarkInstanceDirty(dirtyBits, i);
+	}
+}
+
+static inline bool IsInstanceDirty(const uint64_t *dirtyBits, const size_t index)
+{
+	return (dirtyBits[index / 64] & 1ull << (index % 64)) != 0;
+}
+
+static inline void MarkDrawInfoDirty(MaterialSlotStream *stream, const uint32_t firstDrawInfo, const uint32_t count)
+{
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		stream->firstDirtyDrawInfo[i] = min(stream->firstDirtyDrawInfo[i], firstDrawInfo);
+		stream->endDirtyDrawInfo[i] = max(stream->endDirtyDrawInfo[i], firstDrawInfo + count);
+	}
+}
+
+/**
+ * Copy the instance count and location of a LOD into its draw commands
+ */
+static inline void UpdateLodDrawInfo(const LodInstanceRange *range)
+{
+	for (uint32_t i = 0; i < range->materialSlotCount; i++)
+	{
+		MaterialSlotStream *stream = &materialSlotStreams[i];
+		VkDrawIndexedIndirectCommand *drawInfo = &stream->drawInfo[range->drawInfoIndices[i]];
+		drawInfo->instanceCount = range->drawnCount;
+		drawInfo->firstInstance = range->firstInstance;
+		MarkDrawInfoDirty(stream, range->drawInfoIndices[i], 1);
+	}
+}
+
+/**
+ * Resize the dirty bitsets of a material slot index to the capacity of @c modelsInstanceData. Its material data buffers
+ * are resized the next time that they are written, since the buffers of the other frames in flight can still be in use.
+ */
+static void ResizeMaterialData(const uint32_t materialSlotIndex)
+{
+	MaterialSlotStream *stream = &materialSlotStreams[materialSlotIndex];
+	ReallocateDirtyBits(stream->materialDirtyBits, modelsInstanceCapacity);
+	// The resized buffers are written in full instead of relying on their old contents being kept
+	MarkInstancesDirty(stream->materialDirtyBits, 0, modelsInstanceCount);
+}
+
+static void ResizeDrawInfo(const uint32_t materialSlotIndex, const uint32_t capacity)
+{
+	MaterialSlotStream *stream = &materialSlotStreams[materialSlotIndex];
+	VkDrawIndexedIndirectCommand *drawInfo = realloc(stream->drawInfo, capacity * sizeof(VkDrawIndexedIndirectCommand));
+	CheckAlloc(drawInfo);
+	stream->drawInfo = drawInfo;
+	stream->drawInfoCapacity = capacity;
+	// The draw info buffers are resized when they are next written, and are then written in full instead of relying on
+	// their old contents being kept
+	MarkDrawInfoDirty(stream, 0, buffers.actorModels.drawCounts[materialSlotIndex]);
+}
+
+static inline VkResult CreateActorModelBuffer(const VkBufferUsageFlags usage, LunaBuffer *buffer)
+{
+	const LunaBufferCreationInfo bufferCreationInfo = {
+		.usage = usage,
+		.queueFamilyIndexCount = 1,
+		.queueFamilyIndices = &queueFamilyIndex,
+	};
+	return lunaCreateBuffer(device, &bufferCreationInfo, buffer);
+}
+
+/**
+ * Make sure that there is a material slot stream and its buffers for every material slot index below a count
+ * @param materialSlotCount The number of material slot indices that are needed
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static VkResult EnsureMaterialSlotStreams(const uint32_t materialSlotCount)
+{
+	const uint32_t oldCount = buffers.actorModels.materialSlotCount;
+	if (materialSlotCount <= oldCount)
+	{
+		return VK_SUCCESS;
+	}
+
+	MaterialSlotStream *streams = realloc(materialSlotStreams, materialSlotCount * sizeof(MaterialSlotStream));
+	CheckAlloc(streams);
+	materialSlotStreams = streams;
+	for (uint32_t frame = 0; frame < FRAMES_IN_FLIGHT; frame++)
 	{
-		return LoadModelLods(actor->model);
+		LunaBuffer *materialData = realloc(buffers.actorModels.materialData[frame],
+										   materialSlotCount * sizeof(LunaBuffer));
+		CheckAlloc(materialData);
+		buffers.actorModels.materialData[frame] = materialData;
+		LunaBuffer *shadedDrawInfo = realloc(buffers.actorModels.shadedDrawInfo[frame],
+											 materialSlotCount * sizeof(LunaBuffer));
+		CheckAlloc(shadedDrawInfo);
+		buffers.actorModels.shadedDrawInfo[frame] = shadedDrawInfo;
+		LunaBuffer *unshadedDrawInfo = realloc(buffers.actorModels.unshadedDrawInfo[frame],
+											   materialSlotCount * sizeof(LunaBuffer));
+		CheckAlloc(unshadedDrawInfo);
+		buffers.actorModels.unshadedDrawInfo[frame] = unshadedDrawInfo;
 	}
+	uint32_t *drawCounts = realloc(buffers.actorModels.drawCounts, materialSlotCount * sizeof(uint32_t));
+	CheckAlloc(drawCounts);
+	buffers.actorModels.drawCounts = drawCounts;
+
+	for (uint32_t i = oldCount; i < materialSlotCount; i++)
+	{
+		MaterialSlotStream *stream = &materialSlotStreams[i];
+		memset(stream, 0, sizeof(MaterialSlotStream));
+		stream->materialData = malloc(max(modelsInstanceCapacity, 1) * sizeof(ActorModelMaterialData));
+		CheckAlloc(stream->materialData);
+		buffers.actorModels.drawCounts[i] = 0;
+
+		for (uint32_t frame = 0; frame < FRAMES_IN_FLIGHT; frame++)
+		{
+			stream->firstDirtyDrawInfo[frame] = UINT32_MAX;
+			VulkanTestReturnResult(CreateActorModelBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+														  &buffers.actorModels.materialData[frame][i]),
+								   "Failed to create actor models material data buffer!");
+			VulkanTestReturnResult(CreateActorModelBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+														  &buffers.actorModels.shadedDrawInfo[frame][i]),
+								   "Failed to create actor models shaded draw info buffer!");
+			VulkanTestReturnResult(CreateActorModelBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+														  &buffers.actorModels.unshadedDrawInfo[frame][i]),
+								   "Failed to create actor models unshaded draw info buffer!");
+		}
+		buffers.actorModels.materialSlotCount = i + 1;
+		ResizeMaterialData(i);
+	}
+
 	return VK_SUCCESS;
 }
 
-VkResult LoadActors(const LockingList *actors)
+/**
+ * Get the instance range of a model LOD, creating it and its draw commands if the LOD has not been used before
+ * @param model The model
+ * @param lod The index of the LOD in @c model
+ * @param range Where to write a pointer to the range
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static VkResult GetLodInstanceRange(const ModelDefinition *model, const uint32_t lod, LodInstanceRange **range)
 {
-	buffers.actorWalls.shadedInstanceCount = 0;
-	buffers.actorWalls.unshadedInstanceCount = 0;
+	const uint32_t lodId = model->lods[lod].id;
+	while (lodId >= lodInstanceRanges.length)
+	{
+		ListAdd(lodInstanceRanges, NULL);
+	}
+	*range = ListGetPointer(lodInstanceRanges, lodId);
+	if (*range != NULL)
+	{
+		return VK_SUCCESS;
+	}
 
-	ListLock(*actors);
-	for (size_t i = 0; i < actors->length; i++)
+	VulkanTestReturnResult(EnsureMaterialSlotStreams(model->materialSlotCount),
+						   "Failed to create actor models material slot buffers!");
+
+	LodInstanceRange *newRange = calloc(1, sizeof(LodInstanceRange));
+	CheckAlloc(newRange);
+	newRange->materialSlotCount = model->materialSlotCount;
+	newRange->drawInfoIndices = malloc(max(model->materialSlotCount, 1) * sizeof(uint32_t));
+	CheckAlloc(newRange->drawInfoIndices);
+	newRange->firstInstance = modelsInstanceCount;
+	const List *materialSlotsVertexData = &ListGetNestedList(lodMaterialSlotsVertexData, lodId);
+	for (uint32_t i = 0; i < model->materialSlotCount; i++)
 	{
-		VulkanTestReturnResult(LoadActor(ListGetPointer(*actors, i)), "Failed to load actor!");
+		MaterialSlotStream *stream = &materialSlotStreams[i];
+		uint32_t *drawCount = &buffers.actorModels.drawCounts[i];
+		if (*drawCount == stream->drawInfoCapacity)
+		{
+			ResizeDrawInfo(i, max(stream->drawInfoCapacity * 2, MIN_DRAW_INFO_CAPACITY));
+		}
+		const MaterialSlotVertexData *materialSlotVertexData = ListGetPointer(*materialSlotsVertexData, i);
+		VkDrawIndexedIndirectCommand *drawInfo = &stream->drawInfo[*drawCount];
+		drawInfo->indexCount = materialSlotVertexData->indexCount;
+		drawInfo->firstIndex = materialSlotVertexData->firstIndex;
+		drawInfo->vertexOffset = materialSlotVertexData->vertexOffset;
+		newRange->drawInfoIndices[i] = (*drawCount)++;
 	}
-	ListUnlock(*actors);
+	ListSet(lodInstanceRanges, lodId, newRange);
+	UpdateLodDrawInfo(newRange);
 
+	*range = newRange;
 	return VK_SUCCESS;
 }
 
-static inline bool ShouldReallocInstanceData(const LockingList *actors, InstanceDataReallocInfo *reallocInfo)
+/**
+ * Copy the instances of a LOD to a new location, in the instance data and in the material data of each material slot
+ */
+static inline void CopyLodInstances(const LodInstanceRange *range,
+									ActorModelInstanceData *instanceData,
+									ActorModelMaterialData *const *materialData,
+									const uint32_t firstInstance)
 {
-	ListInit(*reallocInfo->lodInstanceCounts, LIST_UINT32);
-	for (size_t i = 0; i < actors->length; i++)
+	if (range->instanceCount == 0)
 	{
-		const Actor *actor = ListGetPointer(*actors, i);
-		if (actor->hasModel)
+		return;
+	}
+	memcpy(instanceData + firstInstance,
+		   modelsInstanceData + range->firstInstance,
+		   range->instanceCount * sizeof(ActorModelInstanceData));
+	for (uint32_t i = 0; i < range->materialSlotCount; i++)
+	{
+		memcpy(materialData[i] + firstInstance,
+			   materialSlotStreams[i].materialData + range->firstInstance,
+			   range->instanceCount * sizeof(ActorModelMaterialData));
+	}
+}
+
+/**
+ * Pack every LOD back to back into new instance and material data arrays with room to spare, dropping the holes left
+ * by LODs that moved. This is only needed when a LOD can't grow within the existing arrays, so its cost is amortized by
+ * the growth.
+ * @param grownRange A range whose capacity is changed during the relayout
+ * @param grownCapacity The new capacity of @c grownRange
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static VkResult RelayoutModelsInstanceData(LodInstanceRange *grownRange, const uint32_t grownCapacity)
+{
+	uint32_t requiredCount = 0;
+	for (size_t i = 0; i < lodInstanceRanges.length; i++)
+	{
+		const LodInstanceRange *range = ListGetPointer(lodInstanceRanges, i);
+		if (range != NULL)
 		{
-			reallocInfo->modelInstanceCount += actor->model->materialSlotCount;
-			const uint32_t lodId = actor->model->lods[actor->currentLod].id;
-			while (lodId >= reallocInfo->lodInstanceCounts->length)
-			{
-				ListAdd(*reallocInfo->lodInstanceCounts, 0);
-				reallocInfo->modelDrawCount += actor->model->materialSlotCount;
-			}
-			ListSet(*reallocInfo->lodInstanceCounts, lodId, ListGetUint32(*reallocInfo->lodInstanceCounts, lodId) + 1);
-		} else if (actor->wall)
+			requiredCount += range == grownRange ? grownCapacity : range->instanceCapacity;
+		}
+	}
+	const uint32_t capacity = max(requiredCount * 2, MIN_LOD_INSTANCE_CAPACITY);
+	const uint32_t materialSlotCount = buffers.actorModels.materialSlotCount;
+	ActorModelInstanceData *instanceData = malloc(capacity * sizeof(ActorModelInstanceData));
+	CheckAlloc(instanceData);
+	ActorModelMaterialData **materialData = malloc(max(materialSlotCount, 1) * sizeof(ActorModelMaterialData *));
+	CheckAlloc(materialData);
+	for (uint32_t i = 0; i < materialSlotCount; i++)
+	{
+		materialData[i] = malloc(capacity * sizeof(ActorModelMaterialData));
+		CheckAlloc(materialData[i]);
+	}
+
+	uint32_t firstInstance = 0;
+	for (size_t i = 0; i < lodInstanceRanges.length; i++)
+	{
+		LodInstanceRange *range = ListGetPointer(lodInstanceRanges, i);
+		if (range == NULL)
 		{
-			if (actor->wall->unshaded)
-			{
-				reallocInfo->unshadedWallsInstanceCount++;
-			} else
-			{
-				reallocInfo->shadedWallsInstanceCount++;
-			}
+			continue;
 		}
+		CopyLodInstances(range, instanceData, materialData, firstInstance);
+		range->firstInstance = firstInstance;
+		range->instanceCapacity = range == grownRange ? grownCapacity : range->instanceCapacity;
+		UpdateLodDrawInfo(range);
+		firstInstance += range->instanceCapacity;
+	}
+
+	free(modelsInstanceData);
+	modelsInstanceData = instanceData;
+	modelsInstanceCount = firstInstance;
+	modelsInstanceCapacity = capacity;
+	modelsInstanceHoleCount = 0;
+	// The instance data buffers are resized when they are next written, and are then written in full
+	ReallocateDirtyBits(modelsInstanceDirtyBits, capacity);
+	MarkInstancesDirty(modelsInstanceDirtyBits, 0, modelsInstanceCount);
+	for (uint32_t i = 0; i < materialSlotCount; i++)
+	{
+		free(materialSlotStreams[i].materialData);
+		materialSlotStreams[i].materialData = materialData[i];
+		ResizeMaterialData(i);
 	}
+	free(materialData);
+	LogDebug("Relaid out actor model instance data, %u entries in use with space for %u\n",
+			 modelsInstanceCount,
+			 modelsInstanceCapacity);
 
-	reallocInfo->shouldReallocShadedWalls = reallocInfo->shadedWallsInstanceCount !=
-											buffers.actorWalls.shadedInstanceCount;
-	reallocInfo->shouldReallocUnshadedWalls = reallocInfo->unshadedWallsInstanceCount !=
-											  buffers.actorWalls.unshadedInstanceCount;
+	return VK_SUCCESS;
+}
 
-	if (reallocInfo->lodInstanceCounts->length != lodMaterialSlotsData.length)
+/**
+ * Double the number of instances that a LOD has space for.
+ * The LOD grows in place if it is the last one in the arrays, moves to the end of the arrays if there is space for it
+ * there, and otherwise the arrays are laid out again.
+ */
+static VkResult GrowLodInstanceRange(LodInstanceRange *range)
+{
+	const uint32_t capacity = max(range->instanceCapacity * 2, MIN_LOD_INSTANCE_CAPACITY);
+	uint32_t *instanceOwners = realloc(range->instanceOwners, capacity * sizeof(uint32_t));
+	CheckAlloc(instanceOwners);
+	range->instanceOwners = instanceOwners;
+
+	if (range->firstInstance + range->instanceCapacity == modelsInstanceCount &&
+		range->firstInstance + capacity <= modelsInstanceCapacity)
+	{
+		// The LOD is the last one, so the space after it is free
+		range->instanceCapacity = capacity;
+		modelsInstanceCount = range->firstInstance + capacity;
+		return VK_SUCCESS;
+	}
+	if (modelsInstanceCount + capacity > modelsInstanceCapacity ||
+		modelsInstanceHoleCount + range->instanceCapacity > modelsInstanceCount / 2)
 	{
-		reallocInfo->shouldReallocModels = true;
-		return true;
+		return RelayoutModelsInstanceData(range, capacity);
 	}
 
-	for (uint32_t i = 0; i < reallocInfo->lodInstanceCounts->length; i++)
+	const uint32_t firstInstance = modelsInstanceCount;
+	ActorModelMaterialData **materialData = malloc(max(range->materialSlotCount, 1) * sizeof(ActorModelMaterialData *));
+	CheckAlloc(materialData);
+	for (uint32_t i = 0; i < range->materialSlotCount; i++)
+	{
+		materialData[i] = materialSlotStreams[i].materialData;
+		MarkInstancesDirty(materialSlotStreams[i].materialDirtyBits, firstInstance, range->instanceCount);
+	}
+	CopyLodInstances(range, modelsInstanceData, materialData, firstInstance);
+	free(materialData);
+	MarkInstancesDirty(modelsInstanceDirtyBits, firstInstance, range->instanceCount);
+
+	modelsInstanceHoleCount += range->instanceCapacity;
+	range->firstInstance = firstInstance;
+	range->instanceCapacity = capacity;
+	modelsInstanceCount = firstInstance + capacity;
+	UpdateLodDrawInfo(range);
+
+	return VK_SUCCESS;
+}
+
+static void GrowWallInstanceArray(WallInstanceArray *walls)
+{
+	walls->instanceCapacity = max(walls->instanceCapacity * 2, MIN_WALL_INSTANCE_CAPACITY);
+	ActorWallInstanceData *instanceData = realloc(walls->instanceData,
+												  walls->instanceCapacity * sizeof(ActorWallInstanceData));
+	CheckAlloc(instanceData);
+	walls->instanceData = instanceData;
+	uint32_t *instanceOwners = realloc(walls->instanceOwners, walls->instanceCapacity * sizeof(uint32_t));
+	CheckAlloc(instanceOwners);
+	walls->instanceOwners = instanceOwners;
+	ReallocateDirtyBits(walls->dirtyBits, walls->instanceCapacity);
+	// The buffers are resized when they are next written, and are then written in full instead of relying on their old
+	// contents being kept
+	MarkInstancesDirty(walls->dirtyBits, 0, walls->drawnCount);
+}
+
+static inline uint32_t AllocateInstanceSlot(Actor *actor)
+{
+	uint32_t slotIndex = 0;
+	if (freeInstanceSlots.length != 0)
+	{
+		slotIndex = ListGetUint32(freeInstanceSlots, freeInstanceSlots.length - 1);
+		ListRemoveAt(freeInstanceSlots, freeInstanceSlots.length - 1);
+	} else
 	{
-		const uint32_t instanceCount = ListGetUint32(*reallocInfo->lodInstanceCounts, i);
-		const LodMaterialSlotsData *materialSlotDatas = ListGetPointer(lodMaterialSlotsData, i);
-		if (instanceCount != materialSlotDatas->instanceCount)
+		if (instanceSlotCount == allocatedInstanceSlots)
 		{
-			reallocInfo->shouldReallocModels = true;
-			return true;
+			allocatedInstanceSlots = max(allocatedInstanceSlots * 2, MIN_INSTANCE_SLOT_CAPACITY);
+			ActorInstanceSlot *slots = realloc(instanceSlots, allocatedInstanceSlots * sizeof(ActorInstanceSlot));
+			CheckAlloc(slots);
+			instanceSlots = slots;
+			uint8_t *inFrustum = realloc(instancesInFrustum, allocatedInstanceSlots * sizeof(uint8_t));
+			CheckAlloc(inFrustum);
+			instancesInFrustum = inFrustum;
+			uint8_t *visible = realloc(instancesVisible, allocatedInstanceSlots * sizeof(uint8_t));
+			CheckAlloc(visible);
+			instancesVisible = visible;
 		}
+		slotIndex = instanceSlotCount++;
+		CullingBoundsResize(&instanceBounds, instanceSlotCount);
+	}
+	ActorInstanceSlot *slot = &instanceSlots[slotIndex];
+	memset(slot, 0, sizeof(ActorInstanceSlot));
+	slot->actor = actor;
+	actor->instanceSlot = slotIndex;
+	return slotIndex;
+}
+
+static VkResult AddModelInstance(const uint32_t slotIndex, const Actor *actor)
+{
+	LodInstanceRange *range = NULL;
+	VulkanTestReturnResult(GetLodInstanceRange(actor->model, actor->currentLod, &range),
+						   "Failed to get actor model LOD instance range!");
+	if (range->instanceCount == range->instanceCapacity)
+	{
+		VulkanTestReturnResult(GrowLodInstanceRange(range), "Failed to grow actor model LOD instance range!");
+	}
+
+	// The instance starts out in the culled part of the LOD, and is moved into the drawn part once it has been tested
+	ActorInstanceSlot *slot = &instanceSlots[slotIndex];
+	slot->model = actor->model;
+	slot->lodId = actor->model->lods[actor->currentLod].id;
+	slot->instanceIndex = range->instanceCount;
+	slot->drawn = false;
+	slot->dirtyFlags = ACTOR_INSTANCE_DIRTY_ALL;
+	range->instanceOwners[range->instanceCount++] = slotIndex;
+
+	return VK_SUCCESS;
+}
+
+/**
+ * Swap two instances of a LOD, in the instance data and in the material data of each material slot
+ */
+static inline void SwapModelInstances(LodInstanceRange *range, const uint32_t index, const uint32_t otherIndex)
+{
+	const uint32_t instanceIndex = range->firstInstance + index;
+	const uint32_t otherInstanceIndex = range->firstInstance + otherIndex;
+	const ActorModelInstanceData instanceData = modelsInstanceData[instanceIndex];
+	modelsInstanceData[instanceIndex] = modelsInstanceData[otherInstanceIndex];
+	modelsInstanceData[otherInstanceIndex] = instanceData;
+	for (uint32_t i = 0; i < range->materialSlotCount; i++)
+	{
+		ActorModelMaterialData *materialData = materialSlotStreams[i].materialData;
+		const ActorModelMaterialData slotMaterialData = materialData[instanceIndex];
+		materialData[instanceIndex] = materialData[otherInstanceIndex];
+		materialData[otherInstanceIndex] = slotMaterialData;
+	}
+	const uint32_t slotIndex = range->instanceOwners[index];
+	range->instanceOwners[index] = range->instanceOwners[otherIndex];
+	range->instanceOwners[otherIndex] = slotIndex;
+	instanceSlots[range->instanceOwners[index]].instanceIndex = index;
+	instanceSlots[range->instanceOwners[otherIndex]].instanceIndex = otherIndex;
+}
+
+static inline void MarkModelInstanceDirty(const LodInstanceRange *range, const uint32_t index)
+{
+	const uint32_t instanceIndex = range->firstInstance + index;
+	MarkInstanceDirty(modelsInstanceDirtyBits, instanceIndex);
+	for (uint32_t i = 0; i < range->materialSlotCount; i++)
+	{
+		MarkInstanceDirty(materialSlotStreams[i].materialDirtyBits, instanceIndex);
+	}
+}
+
+/**
+ * Move an instance into the drawn part of its LOD
+ */
+static inline void ShowModelInstance(ActorInstanceSlot *slot)
+{
+	LodInstanceRange *range = ListGetPointer(lodInstanceRanges, slot->lodId);
+	if (slot->instanceIndex != range->drawnCount)
+	{
+		SwapModelInstances(range, slot->instanceIndex, range->drawnCount);
+	}
+	range->drawnCount++;
+	// The GPU-side data of the instance was not kept up to date while it wasn't drawn
+	MarkModelInstanceDirty(range, slot->instanceIndex);
+	slot->drawn = true;
+	UpdateLodDrawInfo(range);
+}
+
+/**
+ * Move an instance out of the drawn part of its LOD
+ */
+static inline void HideModelInstance(ActorInstanceSlot *slot)
+{
+	LodInstanceRange *range = ListGetPointer(lodInstanceRanges, slot->lodId);
+	const uint32_t lastDrawnIndex = --range->drawnCount;
+	if (slot->instanceIndex != lastDrawnIndex)
+	{
+		// The last drawn instance fills the gap, so that the drawn instances of the LOD stay contiguous
+		const uint32_t index = slot->instanceIndex;
+		SwapModelInstances(range, index, lastDrawnIndex);
+		MarkModelInstanceDirty(range, index);
+	}
+	slot->drawn = false;
+	UpdateLodDrawInfo(range);
+}
+
+static inline void RemoveModelInstance(ActorInstanceSlot *slot)
+{
+	if (slot->drawn)
+	{
+		HideModelInstance(slot);
+	}
+	// The last instance fills the gap, so that the instances of the LOD stay contiguous. Neither instance is drawn, so
+	// nothing has to be written.
+	LodInstanceRange *range = ListGetPointer(lodInstanceRanges, slot->lodId);
+	const uint32_t lastIndex = --range->instanceCount;
+	if (slot->instanceIndex != lastIndex)
+	{
+		SwapModelInstances(range, slot->instanceIndex, lastIndex);
+	}
+}
+
+static VkResult AddWallInstance(const uint32_t slotIndex, const Actor *actor)
+{
+	WallInstanceArray *walls = actor->wall->unshaded ? &unshadedWalls : &shadedWalls;
+	if (walls->instanceCount == walls->instanceCapacity)
+	{
+		GrowWallInstanceArray(walls);
 	}
 
-	return reallocInfo->shouldReallocShadedWalls || reallocInfo->shouldReallocUnshadedWalls;
+	ActorInstanceSlot *slot = &instanceSlots[slotIndex];
+	slot->lodId = UINT32_MAX;
+	slot->unshadedWall = actor->wall->unshaded;
+	slot->instanceIndex = walls->instanceCount;
+	slot->drawn = false;
+	slot->dirtyFlags = ACTOR_INSTANCE_DIRTY_ALL;
+	walls->instanceOwners[walls->instanceCount++] = slotIndex;
+
+	return VK_SUCCESS;
+}
+
+static inline void SwapWallInstances(WallInstanceArray *walls, const uint32_t index, const uint32_t otherIndex)
+{
+	const ActorWallInstanceData instanceData = walls->instanceData[index];
+	walls->instanceData[index] = walls->instanceData[otherIndex];
+	walls->instanceData[otherIndex] = instanceData;
+	const uint32_t slotIndex = walls->instanceOwners[index];
+	walls->instanceOwners[index] = walls->instanceOwners[otherIndex];
+	walls->instanceOwners[otherIndex] = slotIndex;
+	instanceSlots[walls->instanceOwners[index]].instanceIndex = index;
+	instanceSlots[walls->instanceOwners[otherIndex]].instanceIndex = otherIndex;
 }
 
-static inline VkResult ReallocateInstanceData(const LockingList *actors, const InstanceDataReallocInfo *reallocInfo)
+/**
+ * Move a wall into the drawn part of its wall array
+ */
+static inline void ShowWallInstance(ActorInstanceSlot *slot)
 {
-	const uint32_t drawInfoBytes = reallocInfo->modelDrawCount * sizeof(VkDrawIndexedIndirectCommand);
+	WallInstanceArray *walls = slot->unshadedWall ? &unshadedWalls : &shadedWalls;
+	if (slot->instanceIndex != walls->drawnCount)
+	{
+		SwapWallInstances(walls, slot->instanceIndex, walls->drawnCount);
+	}
+	walls->drawnCount++;
+	MarkInstanceDirty(walls->dirtyBits, slot->instanceIndex);
+	slot->drawn = true;
+}
 
-	if (reallocInfo->shouldReallocModels)
+/**
+ * Move a wall out of the drawn part of its wall array
+ */
+static inline void HideWallInstance(ActorInstanceSlot *slot)
+{
+	WallInstanceArray *walls = slot->unshadedWall ? &unshadedWalls : &shadedWalls;
+	const uint32_t lastDrawnIndex = --walls->drawnCount;
+	if (slot->instanceIndex != lastDrawnIndex)
 	{
-		free(shadedModelsDrawInfo);
-		free(unshadedModelsDrawInfo);
-		free(modelsInstanceData); // Intentionally not using realloc in order to skip the memmove associated with it
-		shadedModelsDrawInfo = calloc(1, drawInfoBytes);
-		CheckAlloc(shadedModelsDrawInfo);
-		unshadedModelsDrawInfo = calloc(1, drawInfoBytes);
-		CheckAlloc(unshadedModelsDrawInfo);
-		modelsInstanceData = malloc(reallocInfo->modelInstanceCount * sizeof(ActorModelInstanceData));
-		CheckAlloc(modelsInstanceData);
+		const uint32_t index = slot->instanceIndex;
+		SwapWallInstances(walls, index, lastDrawnIndex);
+		MarkInstanceDirty(walls->dirtyBits, index);
+	}
+	slot->drawn = false;
+}
 
-		ListFree(lodMaterialSlotsData);
-		ListInit(lodMaterialSlotsData, LIST_POINTER);
-		for (size_t i = 0; i < reallocInfo->lodInstanceCounts->length; i++)
+static inline void RemoveWallInstance(ActorInstanceSlot *slot)
+{
+	if (slot->drawn)
+	{
+		HideWallInstance(slot);
+	}
+	WallInstanceArray *walls = slot->unshadedWall ? &unshadedWalls : &shadedWalls;
+	const uint32_t lastIndex = --walls->instanceCount;
+	if (slot->instanceIndex != lastIndex)
+	{
+		SwapWallInstances(walls, slot->instanceIndex, lastIndex);
+	}
+}
+
+/**
+ * Give an actor an instance slot and an instance, loading its model first if needed
+ */
+static VkResult AddActorInstance(Actor *actor)
+{
+	if (actor->instanceSlot != UINT32_MAX)
+	{
+		return VK_SUCCESS;
+	}
+	if (actor->hasModel)
+	{
+		VulkanTestReturnResult(LoadModelLods(actor->model), "Failed to load actor model!");
+		return AddModelInstance(AllocateInstanceSlot(actor), actor);
+	}
+	if (actor->wall)
+	{
+		return AddWallInstance(AllocateInstanceSlot(actor), actor);
+	}
+	return VK_SUCCESS;
+}
+
+/**
+ * Forget every instance and instance slot, while keeping the arrays and buffers around for the next map
+ */
+static inline void ResetInstanceRegistry()
+{
+	for (size_t i = 0; i < lodInstanceRanges.length; i++)
+	{
+		LodInstanceRange *range = ListGetPointer(lodInstanceRanges, i);
+		if (range != NULL)
 		{
-			LodMaterialSlotsData *materialSlotsData = malloc(sizeof(LodMaterialSlotsData));
-			materialSlotsData->instanceCount = ListGetUint32(*reallocInfo->lodInstanceCounts, i);
-			ListInit(materialSlotsData->materialSlots, LIST_POINTER);
-			ListAdd(lodMaterialSlotsData, materialSlotsData);
+			free(range->drawInfoIndices);
+			free(range->instanceOwners);
+			free(range);
 		}
 	}
-
-	size_t instanceDataOffset = 0;
-	size_t drawInfoOffset = 0;
-	for (size_t i = 0; i < actors->length; i++)
+	ListClear(lodInstanceRanges);
+	modelsInstanceCount = 0;
+	modelsInstanceHoleCount = 0;
+	for (uint32_t i = 0; i < buffers.actorModels.materialSlotCount; i++)
 	{
-		const Actor *actor = ListGetPointer(*actors, i);
-		if (actor->hasModel && reallocInfo->shouldReallocModels)
+		buffers.actorModels.drawCounts[i] = 0;
+		for (uint32_t frame = 0; frame < FRAMES_IN_FLIGHT; frame++)
 		{
-			const uint32_t lodId = actor->model->lods[actor->currentLod].id;
-			LodMaterialSlotsData *materialSlotsData = ListGetPointer(lodMaterialSlotsData, lodId);
-			if (materialSlotsData->materialSlots.length == 0)
-			{
-				List *materialSlotsVertexData = &ListGetNestedList(lodMaterialSlotsVertexData, lodId);
-				for (uint32_t j = 0; j < actor->model->materialSlotCount; j++)
-				{
-					const MaterialSlotVertexData *materialSlotVertexData = ListGetPointer(*materialSlotsVertexData, j);
-					MaterialSlotData *materialSlotData = malloc(sizeof(MaterialSlotData));
-					materialSlotData->shadedDrawInfo = shadedModelsDrawInfo + drawInfoOffset;
-					materialSlotData->shadedDrawInfo->indexCount = materialSlotVertexData->indexCount;
-					materialSlotData->shadedDrawInfo->instanceCount = materialSlotsData->instanceCount;
-					materialSlotData->shadedDrawInfo->firstIndex = materialSlotVertexData->firstIndex;
-					materialSlotData->shadedDrawInfo->vertexOffset = materialSlotVertexData->vertexOffset;
-					materialSlotData->shadedDrawInfo->firstInstance = instanceDataOffset;
-					materialSlotData->unshadedDrawInfo = unshadedModelsDrawInfo + drawInfoOffset;
-					*materialSlotData->unshadedDrawInfo = *materialSlotData->shadedDrawInfo;
-					materialSlotData->instanceData = modelsInstanceData + instanceDataOffset;
-					ListAdd(materialSlotsData->materialSlots, materialSlotData);
-					drawInfoOffset++;
-					instanceDataOffset += materialSlotsData->instanceCount;
-				}
-			}
+			materialSlotStreams[i].firstDirtyDrawInfo[frame] = UINT32_MAX;
+			materialSlotStreams[i].endDirtyDrawInfo[frame] = 0;
 		}
 	}
 
-	if (reallocInfo->shouldReallocModels)
-	{
-		VulkanTestReturnResult(lunaResizeBuffer(device,
-												commandBuffer,
-												&buffers.actorModels.instanceData,
-												instanceDataOffset * sizeof(ActorModelInstanceData)),
-							   "Failed to resize actor models instance data buffer!");
-		VulkanTestReturnResult(lunaResizeBuffer(device,
-												commandBuffer,
-												&buffers.actorModels.shadedDrawInfo,
-												drawInfoBytes),
-							   "Failed to resize actor models shaded draw info buffer!");
-		VulkanTestReturnResult(lunaResizeBuffer(device,
-												commandBuffer,
-												&buffers.actorModels.unshadedDrawInfo,
-												drawInfoBytes),
-							   "Failed to resize actor models unshaded draw info buffer!");
-
-		const LunaBufferWriteInfo shadedWriteInfo = {
-			.bytes = drawInfoBytes,
-			.data = shadedModelsDrawInfo,
-			.stageFlags = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
-		};
-		VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-													 commandBuffer,
-													 buffers.actorModels.shadedDrawInfo,
-													 &shadedWriteInfo),
-							   "Failed to write actor models shaded draw info to buffer!");
-		const LunaBufferWriteInfo unshadedWriteInfo = {
-			.bytes = drawInfoBytes,
-			.data = unshadedModelsDrawInfo,
-			.stageFlags = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
-		};
-		VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-													 commandBuffer,
-													 buffers.actorModels.unshadedDrawInfo,
-													 &unshadedWriteInfo),
-							   "Failed to write actor models unshaded draw info to buffer!");
+	shadedWalls.instanceCount = 0;
+	shadedWalls.drawnCount = 0;
+	unshadedWalls.instanceCount = 0;
+	unshadedWalls.drawnCount = 0;
+	buffers.actorWalls.shadedInstanceCount = 0;
+	buffers.actorWalls.unshadedInstanceCount = 0;
+
+	instanceSlotCount = 0;
+	CullingBoundsResize(&instanceBounds, 0);
+	ListClear(freeInstanceSlots);
+	ListClear(pendingActors);
+}
+
+/**
+ * Give every actor of a map an instance, with the list of actors already locked
+ */
+static VkResult LoadActorInstances(const LockingList *actors)
+{
+	ResetInstanceRegistry();
+	for (size_t i = 0; i < actors->length; i++)
+	{
+		Actor *actor = ListGetPointer(*actors, i);
+		actor->instanceSlot = UINT32_MAX;
+		VulkanTestReturnResult(AddActorInstance(actor), "Failed to load actor!");
 	}
 
-	if (reallocInfo->shouldReallocShadedWalls)
+	return VK_SUCCESS;
+}
+
+VkResult LoadActors(const LockingList *actors)
+{
+	ListLock(*actors);
+	// The list has to be unlocked on failure too, so the result is only returned once it is
+	const VkResult result = LoadActorInstances(actors);
+	ListUnlock(*actors);
+
+	return result;
+}
+
+void RegisterActorInstance(Actor *actor)
+{
+	ListAdd(pendingActors, actor);
+}
+
+void UnregisterActorInstance(Actor *actor)
+{
+	if (actor->instanceSlot == UINT32_MAX)
+	{
+		const size_t pendingIndex = ListFind(pendingActors, actor);
+		if (pendingIndex != SIZE_MAX)
+		{
+			ListRemoveAt(pendingActors, pendingIndex);
+		}
+		return;
+	}
+	if (actor->instanceSlot >= instanceSlotCount || instanceSlots[actor->instanceSlot].actor != actor)
 	{
-		buffers.actorWalls.shadedInstanceCount = reallocInfo->shadedWallsInstanceCount;
-		free(shadedWallsInstanceData);
-		shadedWallsInstanceData = malloc(sizeof(ActorWallInstanceData) * buffers.actorWalls.shadedInstanceCount);
-		CheckAlloc(shadedWallsInstanceData);
-		VulkanTestReturnResult(lunaResizeBuffer(device,
-												commandBuffer,
-												&buffers.actorWalls.shadedInstanceData,
-												sizeof(ActorWallInstanceData) * buffers.actorWalls.shadedInstanceCount),
-							   "Failed to resize shaded actor walls instance data buffer!");
+		// The slot is from a map that has since been unloaded
+		actor->instanceSlot = UINT32_MAX;
+		return;
 	}
-	if (reallocInfo->shouldReallocUnshadedWalls)
+	ActorInstanceSlot *slot = &instanceSlots[actor->instanceSlot];
+	if (slot->lodId == UINT32_MAX)
 	{
-		buffers.actorWalls.unshadedInstanceCount = reallocInfo->unshadedWallsInstanceCount;
-		free(unshadedWallsInstanceData);
-		unshadedWallsInstanceData = malloc(sizeof(ActorWallInstanceData) * buffers.actorWalls.unshadedInstanceCount);
-		CheckAlloc(unshadedWallsInstanceData);
-		VulkanTestReturnResult(lunaResizeBuffer(device,
-												commandBuffer,
-												&buffers.actorWalls.unshadedInstanceData,
-												sizeof(ActorWallInstanceData) *
-														buffers.actorWalls.unshadedInstanceCount),
-							   "Failed to resize unshaded actor walls instance data buffer!");
+		RemoveWallInstance(slot);
+	} else
+	{
+		RemoveModelInstance(slot);
+	}
+	slot->actor = NULL;
+	ListAdd(freeInstanceSlots, actor->instanceSlot);
+	actor->instanceSlot = UINT32_MAX;
+}
+
+static inline VkResult AddPendingActorInstances()
+{
+	for (size_t i = 0; i < pendingActors.length; i++)
+	{
+		VulkanTestReturnResult(AddActorInstance(ListGetPointer(pendingActors, i)), "Failed to add actor instance!");
 	}
+	ListClear(pendingActors);
 
 	return VK_SUCCESS;
 }
 
-static inline void UpdateActorModelInstanceData(const Actor *actor, List *lodInstanceCounts)
-{
-	const uint32_t lodId = actor->model->lods[actor->currentLod].id;
-	const LodMaterialSlotsData *materialSlotsData = ListGetPointer(lodMaterialSlotsData, lodId);
-	assert(lodInstanceCounts->length == lodMaterialSlotsData.length &&
-		   ListGetUint32(*lodInstanceCounts, lodId) <= materialSlotsData->instanceCount);
-	assert(actor->model->materialSlotCount == materialSlotsData->materialSlots.length);
-	const uint32_t instanceIndex = ListGetUint32(*lodInstanceCounts, lodId) - 1;
-	ListSet(*lodInstanceCounts, lodId, instanceIndex);
-	mat4 transformMatrix;
-	ActorTransformMatrix(actor, &transformMatrix);
-	for (uint32_t j = 0; j < materialSlotsData->materialSlots.length; j++)
-	{
-		const uint32_t materialIndex = actor->model->skinMaterialIndices[actor->currentSkinIndex][j];
-		const Material *material = &actor->model->materials[materialIndex];
-		const MaterialSlotData *materialSlotData = ListGetPointer(materialSlotsData->materialSlots, j);
-		ActorModelInstanceData *instanceData = &materialSlotData->instanceData[instanceIndex];
-		memcpy(instanceData->transformMatrix, transformMatrix, sizeof(transformMatrix));
+/**
+ * Compare an actor against the state that was last written for it and add the matching dirty flags to its slot
+ */
+static inline void UpdateActorInstanceDirtyFlags(const Actor *actor, ActorInstanceSlot *slot)
+{
+	if (actor->bodyId != JPH_BodyId_InvalidBodyID && actor->bodyInterface != NULL)
+	{
+		JPH_RVec3 position;
+		JPH_Quat rotation;
+		JPH_BodyInterface_GetPositionAndRotation(actor->bodyInterface, actor->bodyId, &position, &rotation);
+		if (memcmp(&position, &slot->position, sizeof(position)) != 0 ||
+			memcmp(&rotation, &slot->rotation, sizeof(rotation)) != 0)
+		{
+			slot->position = position;
+			slot->rotation = rotation;
+			slot->dirtyFlags |= ACTOR_INSTANCE_DIRTY_TRANSFORM;
+		}
+	}
+	if (memcmp(&actor->modColor, &slot->modColor, sizeof(Color)) != 0)
+	{
+		slot->modColor = actor->modColor;
+		slot->dirtyFlags |= ACTOR_INSTANCE_DIRTY_COLOR;
+	}
+	if (actor->hasModel)
+	{
+		if (actor->currentSkinIndex != slot->skinIndex)
+		{
+			slot->skinIndex = actor->currentSkinIndex;
+			slot->dirtyFlags |= ACTOR_INSTANCE_DIRTY_SKIN;
+		}
+		if (actor->currentLod != slot->lod)
+		{
+			slot->lod = actor->currentLod;
+			slot->dirtyFlags |= ACTOR_INSTANCE_DIRTY_LOD;
+		}
+	}
+}
+
+static inline VkResult UpdateActorModelInstanceData(const Actor *actor)
+{
+	ActorInstanceSlot *slot = &instanceSlots[actor->instanceSlot];
+	if (actor->model != slot->model || actor->model->lods[actor->currentLod].id != slot->lodId)
+	{
+		// The actor has switched to a different LOD, so its instance moves to the range of that LOD
+		RemoveModelInstance(slot);
+		VulkanTestReturnResult(LoadModelLods(actor->model), "Failed to load actor model!");
+		VulkanTestReturnResult(AddModelInstance(actor->instanceSlot, actor), "Failed to move actor model instance!");
+	}
+	UpdateActorInstanceDirtyFlags(actor, slot);
+	if (slot->dirtyFlags == 0)
+	{
+		return VK_SUCCESS;
+	}
+
+	const LodInstanceRange *range = ListGetPointer(lodInstanceRanges, slot->lodId);
+	assert(slot->instanceIndex < range->instanceCount);
+	assert(actor->model->materialSlotCount == range->materialSlotCount);
+	const uint32_t instanceIndex = range->firstInstance + slot->instanceIndex;
+
+	if ((slot->dirtyFlags &
+		 (ACTOR_INSTANCE_DIRTY_TRANSFORM | ACTOR_INSTANCE_DIRTY_COLOR | ACTOR_INSTANCE_DIRTY_LOD)) != 0)
+	{
+		ActorModelInstanceData *instanceData = &modelsInstanceData[instanceIndex];
+		if ((slot->dirtyFlags & (ACTOR_INSTANCE_DIRTY_TRANSFORM | ACTOR_INSTANCE_DIRTY_LOD)) != 0)
+		{
+			ActorTransformMatrix(actor, &instanceData->transformMatrix);
+			Vector3 center;
+			Vector3 extents;
+			TransformBoundingBox(instanceData->transformMatrix,
+								 &actor->model->boundingBoxOrigin,
+								 &actor->model->boundingBoxExtents,
+								 &center,
+								 &extents);
+			CullingBoundsSet(&instanceBounds, actor->instanceSlot, &center, &extents);
+		}
 		memcpy(instanceData->modColor, &actor->modColor, sizeof(Color));
-		memcpy(instanceData->materialColor, &material->color, sizeof(Color));
-		instanceData->textureIndex = TextureIndex(material->texture);
+		if (slot->drawn)
+		{
+			MarkInstanceDirty(modelsInstanceDirtyBits, instanceIndex);
+		}
 	}
+	if ((slot->dirtyFlags & (ACTOR_INSTANCE_DIRTY_SKIN | ACTOR_INSTANCE_DIRTY_LOD)) != 0)
+	{
+		for (uint32_t i = 0; i < range->materialSlotCount; i++)
+		{
+			const uint32_t materialIndex = actor->model->skinMaterialIndices[actor->currentSkinIndex][i];
+			const Material *material = &actor->model->materials[materialIndex];
+			MaterialSlotStream *stream = &materialSlotStreams[i];
+			stream->materialData[instanceIndex].materialColor = material->color;
+			stream->materialData[instanceIndex].textureIndex = TextureIndex(material->texture);
+			if (slot->drawn)
+			{
+				MarkInstanceDirty(stream->materialDirtyBits, instanceIndex);
+			}
+		}
+	}
+	slot->dirtyFlags = 0;
+
+	return VK_SUCCESS;
 }
 
-static inline void UpdateActorWallInstanceData(const Actor *actor, ActorWallInstanceData *actorInstanceData)
+static inline void UpdateActorWallInstanceData(const Actor *actor)
 {
+	ActorInstanceSlot *slot = &instanceSlots[actor->instanceSlot];
 	JPH_RVec3 position;
 	JPH_Quat rotation;
 	JPH_BodyInterface_GetPositionAndRotation(actor->bodyInterface, actor->bodyId, &position, &rotation);
@@ -418,109 +1158,316 @@ static inline void UpdateActorWallInstanceData(const Actor *actor, ActorWallInst
 		.x = actor->wall->orientation == ACTOR_WALL_ORIENTATION_X_AXIS ? 1 : 0,
 		.y = actor->wall->orientation == ACTOR_WALL_ORIENTATION_Z_AXIS ? 1 : 0,
 	};
-	const ActorWallInstanceData instanceData = {
-		.position.x = position.x,
-		.position.y = position.y,
-		.position.z = position.z,
-		.scale.x = actor->wall->length,
-		.scale.y = actor->wall->height,
-		.axis = axis,
-		.centerOffset = actor->wall->centerOffset,
-		.rotationQuat = rotation,
-		.textureIndex = TextureIndex(actor->wall->texture),
-		.uvScale = actor->wall->uvScale,
-		.uvOffset = actor->wall->uvOffset,
-		.modColor = actor->modColor,
-	};
-	memcpy(actorInstanceData, &instanceData, sizeof(instanceData));
+	// The padding is cleared so that comparing against the last written instance can use memcmp
+	ActorWallInstanceData instanceData;
+	memset(&instanceData, 0, sizeof(instanceData));
+	instanceData.position.x = position.x;
+	instanceData.position.y = position.y;
+	instanceData.position.z = position.z;
+	instanceData.scale.x = actor->wall->length;
+	instanceData.scale.y = actor->wall->height;
+	instanceData.axis = axis;
+	instanceData.centerOffset = actor->wall->centerOffset;
+	instanceData.rotationQuat = rotation;
+	instanceData.textureIndex = TextureIndex(actor->wall->texture);
+	instanceData.uvScale = actor->wall->uvScale;
+	instanceData.uvOffset = actor->wall->uvOffset;
+	instanceData.modColor = actor->modColor;
+
+	// Walls have few enough fields that comparing the whole instance is cheaper than tracking every field separately
+	const WallInstanceArray *walls = slot->unshadedWall ? &unshadedWalls : &shadedWalls;
+	ActorWallInstanceData *actorInstanceData = &walls->instanceData[slot->instanceIndex];
+	if (slot->dirtyFlags != 0 || memcmp(actorInstanceData, &instanceData, sizeof(instanceData)) != 0)
+	{
+		memcpy(actorInstanceData, &instanceData, sizeof(instanceData));
+		if (slot->drawn)
+		{
+			MarkInstanceDirty(walls->dirtyBits, slot->instanceIndex);
+		}
+		slot->dirtyFlags = 0;
+	}
+
+	// A sphere around the body that contains the wall in every orientation, so that billboarding can't invalidate it
+	const float halfLength = actor->wall->length / 2.0f + fabsf(actor->wall->centerOffset.x);
+	const float halfHeight = actor->wall->height / 2.0f + fabsf(actor->wall->centerOffset.y);
+	const float radius = sqrtf(halfLength * halfLength + halfHeight * halfHeight);
+	const Vector3 extents = {radius, radius, radius};
+	CullingBoundsSet(&instanceBounds, actor->instanceSlot, &instanceData.position, &extents);
 }
 
-static inline VkResult WriteWallsInstanceData()
+/**
+ * Write every dirty entry of a CPU-side instance data array to the current frame's buffer, then clear the current
+ * frame's dirty bits. Runs of dirty entries separated by only a few clean entries are merged into a single write.
+ * @param buffer The current frame's buffer, which is grown to hold @c capacity entries if it is smaller
+ * @param data The CPU-side instance data array
+ * @param stride The size of one entry in bytes
+ * @param frameDirtyBits The dirty bitsets of the array, one for each frame in flight
+ * @param count The number of entries in the array
+ * @param capacity The number of entries that the array has space for
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static VkResult WriteDirtyInstances(LunaBuffer *buffer,
+									const void *data,
+									const size_t stride,
+									uint64_t *const *frameDirtyBits,
+									const size_t count,
+									const size_t capacity)
 {
-	const LunaBufferWriteInfo shadedWallsInstanceDataWriteInfo = {
-		.bytes = sizeof(ActorWallInstanceData) * buffers.actorWalls.shadedInstanceCount,
-		.data = shadedWallsInstanceData,
-		.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-	};
-	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-												 commandBuffer,
-												 buffers.actorWalls.shadedInstanceData,
-												 &shadedWallsInstanceDataWriteInfo),
-						   "Failed to write shaded actor walls instance data to buffer!");
+	// A buffer only has to grow after the array has grown, which marks every entry as dirty
+	VulkanTestReturnResult(EnsureFrameBufferSize(buffer, capacity * stride), "Failed to resize instance data buffer!");
+	uint64_t *dirtyBits = frameDirtyBits[currentFrame];
+	size_t index = 0;
+	while (index < count)
+	{
+		if (dirtyBits[index / 64] == 0)
+		{
+			index = (index / 64 + 1) * 64;
+			continue;
+		}
+		if (!IsInstanceDirty(dirtyBits, index))
+		{
+			index++;
+			continue;
+		}
 
-	const LunaBufferWriteInfo unshadedWallsInstanceDataWriteInfo = {
-		.bytes = sizeof(ActorWallInstanceData) * buffers.actorWalls.unshadedInstanceCount,
-		.data = unshadedWallsInstanceData,
-		.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-	};
-	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-												 commandBuffer,
-												 buffers.actorWalls.unshadedInstanceData,
-												 &unshadedWallsInstanceDataWriteInfo),
-						   "Failed to write unshaded actor walls instance data to buffer!");
+		const size_t firstIndex = index;
+		size_t lastIndex = index;
+		while (index < count && index - lastIndex <= INSTANCE_WRITE_MERGE_GAP)
+		{
+			if (IsInstanceDirty(dirtyBits, index))
+			{
+				lastIndex = index;
+			}
+			index++;
+		}
+
+		const size_t runLength = lastIndex - firstIndex + 1;
+		const LunaBufferWriteInfo writeInfo = {
+			.bytes = runLength * stride,
+			.data = (const uint8_t *)data + firstIndex * stride,
+			.offset = firstIndex * stride,
+			.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		};
+		VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, *buffer, &writeInfo),
+							   "Failed to write instance data to buffer!");
+		renderStats.instancesWritten += runLength;
+		renderStats.instanceBytesWritten += runLength * stride;
+		index = lastIndex + 1;
+	}
+	memset(dirtyBits, 0, (count + 63) / 64 * sizeof(uint64_t));
 
 	return VK_SUCCESS;
 }
 
+static inline VkResult WriteDirtyDrawInfo(const uint32_t materialSlotIndex)
+{
+	MaterialSlotStream *stream = &materialSlotStreams[materialSlotIndex];
+	LunaBuffer *shadedDrawInfo = &buffers.actorModels.shadedDrawInfo[currentFrame][materialSlotIndex];
+	LunaBuffer *unshadedDrawInfo = &buffers.actorModels.unshadedDrawInfo[currentFrame][materialSlotIndex];
+	const size_t drawInfoSize = stream->drawInfoCapacity * sizeof(VkDrawIndexedIndirectCommand);
+	VulkanTestReturnResult(EnsureFrameBufferSize(shadedDrawInfo, drawInfoSize),
+						   "Failed to resize actor models shaded draw info buffer!");
+	VulkanTestReturnResult(EnsureFrameBufferSize(unshadedDrawInfo, drawInfoSize),
+						   "Failed to resize actor models unshaded draw info buffer!");
+
+	const uint32_t firstDirtyDrawInfo = stream->firstDirtyDrawInfo[currentFrame];
+	const uint32_t endDirtyDrawInfo = min(stream->endDirtyDrawInfo[currentFrame],
+										  buffers.actorModels.drawCounts[materialSlotIndex]);
+	if (firstDirtyDrawInfo < endDirtyDrawInfo)
+	{
+		const LunaBufferWriteInfo writeInfo = {
+			.bytes = (endDirtyDrawInfo - firstDirtyDrawInfo) * sizeof(VkDrawIndexedIndirectCommand),
+			.data = stream->drawInfo + firstDirtyDrawInfo,
+			.offset = firstDirtyDrawInfo * sizeof(VkDrawIndexedIndirectCommand),
+			.stageFlags = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		};
+		VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, *shadedDrawInfo, &writeInfo),
+							   "Failed to write actor models shaded draw info to buffer!");
+		VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, *unshadedDrawInfo, &writeInfo),
+							   "Failed to write actor models unshaded draw info to buffer!");
+	}
+	stream->firstDirtyDrawInfo[currentFrame] = UINT32_MAX;
+	stream->endDirtyDrawInfo[currentFrame] = 0;
+
+	return VK_SUCCESS;
+}
+
+/**
+ * Move every instance whose actor is visible, inside the camera frustum and not hidden behind occluders into the drawn
+ * part of its LOD or wall array, and every other instance out of it
+ */
+static inline void UpdateDrawnInstances()
+{
+	for (uint32_t i = 0; i < instanceSlotCount; i++)
+	{
+		ActorInstanceSlot *slot = &instanceSlots[i];
+		if (slot->actor == NULL)
+		{
+			continue;
+		}
+		const bool drawn = slot->actor->visible && instancesVisible[i];
+		if (drawn)
+		{
+			renderStats.visibleActors++;
+		} else if (slot->actor->visible && !instancesInFrustum[i])
+		{
+			renderStats.culledActors++;
+		} else if (slot->actor->visible)
+		{
+			renderStats.occludedActors++;
+		}
+		if (drawn == slot->drawn)
+		{
+			continue;
+		}
+		if (slot->lodId == UINT32_MAX && drawn)
+		{
+			ShowWallInstance(slot);
+		} else if (slot->lodId == UINT32_MAX)
+		{
+			HideWallInstance(slot);
+		} else if (drawn)
+		{
+			ShowModelInstance(slot);
+		} else
+		{
+			HideModelInstance(slot);
+		}
+	}
+}
+
 static inline VkResult UpdateInstanceData(const LockingList *actors,
-										  List *lodInstanceCounts,
-										  const uint32_t modelInstanceCount)
+										  const Frustum *frustum,
+										  const OcclusionBuffer *occlusionBuffer)
 {
-	size_t shadedWallsInstanceIndex = 0;
-	size_t unshadedWallsInstanceIndex = 0;
 	for (size_t i = 0; i < actors->length; i++)
 	{
 		const Actor *actor = ListGetPointer(*actors, i);
+		if (actor->instanceSlot == UINT32_MAX)
+		{
+			continue;
+		}
 		if (actor->hasModel)
 		{
-			UpdateActorModelInstanceData(actor, lodInstanceCounts);
-		} else if (actor->wall)
+			VulkanTestReturnResult(UpdateActorModelInstanceData(actor), "Failed to update actor model instance data!");
+		} else
 		{
-			if (actor->wall->unshaded)
-			{
-				UpdateActorWallInstanceData(actor, &unshadedWallsInstanceData[unshadedWallsInstanceIndex]);
-				unshadedWallsInstanceIndex++;
-			} else
-			{
-				UpdateActorWallInstanceData(actor, &shadedWallsInstanceData[shadedWallsInstanceIndex]);
-				shadedWallsInstanceIndex++;
-			}
+			UpdateActorWallInstanceData(actor);
 		}
 	}
-	const LunaBufferWriteInfo modelsInstanceDataWriteInfo = {
-		.bytes = modelInstanceCount * sizeof(ActorModelInstanceData),
-		.data = modelsInstanceData,
-		.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-	};
-	VulkanTestReturnResult(lunaWriteDataToBuffer(device,
-												 commandBuffer,
-												 buffers.actorModels.instanceData,
-												 &modelsInstanceDataWriteInfo),
-						   "Failed to write actor models instance data to buffer!");
 
-	VulkanTestReturnResult(WriteWallsInstanceData(), "Failed to write actor walls instance data!");
+	CullBoundingBoxes(frustum, &instanceBounds, instancesInFrustum);
+	if (instanceSlotCount != 0)
+	{
+		memcpy(instancesVisible, instancesInFrustum, instanceSlotCount * sizeof(uint8_t));
+	}
+	const uint64_t occlusionTestStartTime = GetTimeNs();
+	TestOcclusion(occlusionBuffer, &instanceBounds, instancesVisible);
+	renderStats.occlusionTestNs += GetTimeNs() - occlusionTestStartTime;
+	UpdateDrawnInstances();
+
+	VulkanTestReturnResult(WriteDirtyInstances(&buffers.actorModels.instanceData[currentFrame],
+											   modelsInstanceData,
+											   sizeof(ActorModelInstanceData),
+											   modelsInstanceDirtyBits,
+											   modelsInstanceCount,
+											   modelsInstanceCapacity),
+						   "Failed to write actor models instance data!");
+	for (uint32_t i = 0; i < buffers.actorModels.materialSlotCount; i++)
+	{
+		VulkanTestReturnResult(WriteDirtyInstances(&buffers.actorModels.materialData[currentFrame][i],
+												   materialSlotStreams[i].materialData,
+												   sizeof(ActorModelMaterialData),
+												   materialSlotStreams[i].materialDirtyBits,
+												   modelsInstanceCount,
+												   modelsInstanceCapacity),
+							   "Failed to write actor models material data!");
+		VulkanTestReturnResult(WriteDirtyDrawInfo(i), "Failed to write actor models draw info!");
+	}
+	VulkanTestReturnResult(WriteDirtyInstances(&shadedWalls.frameBuffers[currentFrame],
+											   shadedWalls.instanceData,
+											   sizeof(ActorWallInstanceData),
+											   shadedWalls.dirtyBits,
+											   shadedWalls.drawnCount,
+											   shadedWalls.instanceCapacity),
+						   "Failed to write shaded actor walls instance data!");
+	VulkanTestReturnResult(WriteDirtyInstances(&unshadedWalls.frameBuffers[currentFrame],
+											   unshadedWalls.instanceData,
+											   sizeof(ActorWallInstanceData),
+											   unshadedWalls.dirtyBits,
+											   unshadedWalls.drawnCount,
+											   unshadedWalls.instanceCapacity),
+						   "Failed to write unshaded actor walls instance data!");
+	// The main thread can remove walls while the frame is recorded, so the draw calls use the counts that were written
+	buffers.actorWalls.shadedInstanceCount = shadedWalls.drawnCount;
+	buffers.actorWalls.unshadedInstanceCount = unshadedWalls.drawnCount;
 
 	return VK_SUCCESS;
 }
 
-VkResult UpdateActors()
+void InvalidateActorInstanceData()
+{
+	for (uint32_t i = 0; i < instanceSlotCount; i++)
+	{
+		if (instanceSlots[i].actor != NULL)
+		{
+			instanceSlots[i].dirtyFlags = ACTOR_INSTANCE_DIRTY_ALL;
+		}
+	}
+}
+
+/**
+ * Record the screen size of every actor instance that is drawn this frame on the textures of its materials, so that
+ * texture streaming can give them the mip levels they need. This must be called with the actor list locked.
+ * @param cameraPosition The position of the camera
+ * @param pixelScale The height of the viewport in pixels divided by the height of the view at a distance of one
+ */
+static void ReportActorTextureScreenSizes(const Vector3 *cameraPosition, const float pixelScale)
+{
+	for (uint32_t i = 0; i < instanceSlotCount; i++)
+	{
+		const ActorInstanceSlot *slot = &instanceSlots[i];
+		if (slot->actor == NULL || !slot->drawn)
+		{
+			continue;
+		}
+		const Vector3 center = {instanceBounds.centerX[i], instanceBounds.centerY[i], instanceBounds.centerZ[i]};
+		const Vector3 extents = {instanceBounds.extentX[i], instanceBounds.extentY[i], instanceBounds.extentZ[i]};
+		const float screenSize = BoundsScreenSize(cameraPosition, pixelScale, &center, &extents);
+		if (slot->lodId == UINT32_MAX)
+		{
+			const WallInstanceArray *walls = slot->unshadedWall ? &unshadedWalls : &shadedWalls;
+			const uint32_t textureIndex = walls->instanceData[slot->instanceIndex].textureIndex;
+			StreamedTextureSeen(&streamedTextures[textureIndex], screenSize);
+			continue;
+		}
+		const LodInstanceRange *range = ListGetPointer(lodInstanceRanges, slot->lodId);
+		const uint32_t instanceIndex = range->firstInstance + slot->instanceIndex;
+		for (uint32_t j = 0; j < range->materialSlotCount; j++)
+		{
+			const uint32_t textureIndex = materialSlotStreams[j].materialData[instanceIndex].textureIndex;
+			StreamedTextureSeen(&streamedTextures[textureIndex], screenSize);
+		}
+	}
+}
+
+VkResult UpdateActors(const Frustum *frustum,
+					  const OcclusionBuffer *occlusionBuffer,
+					  const Vector3 *cameraPosition,
+					  const float pixelScale)
 {
 	const LockingList *actors = &GetState()->map->actors;
 	ListLock(*actors);
-	List lodInstanceCounts;
-	InstanceDataReallocInfo reallocInfo = {
-		.lodInstanceCounts = &lodInstanceCounts,
-	};
-	if (ShouldReallocInstanceData(actors, &reallocInfo))
+	VkResult result = AddPendingActorInstances();
+	if (result == VK_SUCCESS)
+	{
+		result = UpdateInstanceData(actors, frustum, occlusionBuffer);
+	}
+	if (result == VK_SUCCESS)
 	{
-		VulkanTestReturnResult(ReallocateInstanceData(actors, &reallocInfo),
-							   "Failed to reallocate actor instance data!");
+		ReportActorTextureScreenSizes(cameraPosition, pixelScale);
 	}
-	VulkanTestReturnResult(UpdateInstanceData(actors, &lodInstanceCounts, reallocInfo.modelInstanceCount),
-						   "Failed to update actor models instance data!");
 	ListUnlock(*actors);
 
-	ListFree(lodInstanceCounts);
-
-	return VK_SUCCESS;
+	return result;
 }
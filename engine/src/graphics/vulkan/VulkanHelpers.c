@@ -7,11 +7,11 @@
 #include <cglm/clipspace/persp_lh_zo.h>
 #include <engine/assets/ShaderLoader.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/graphics/Culling.h>
 #include <engine/graphics/RenderingHelpers.h>
 #include <engine/graphics/vulkan/VulkanHelpers.h>
 #include <engine/graphics/vulkan/VulkanInternal.h>
 #include <engine/graphics/vulkan/VulkanResources.h>
-#include <engine/physics/Physics.h>
 #include <engine/structs/Camera.h>
 #include <engine/structs/Color.h>
 #include <engine/structs/List.h>
@@ -33,11 +33,17 @@
 bool minimized = false;
 LunaDevice device = LUNA_NULL_HANDLE;
 VkPhysicalDeviceProperties physicalDeviceProperties = {0};
+bool textureCompressionBCSupported = false;
 uint32_t queueFamilyIndex = -1u;
 VkQueue queue = VK_NULL_HANDLE;
 LunaCommandPool commandPool = LUNA_NULL_HANDLE;
+LunaCommandBuffer commandBuffers[FRAMES_IN_FLIGHT] = {LUNA_NULL_HANDLE};
+uint32_t currentFrame = 0;
 LunaCommandBuffer commandBuffer = LUNA_NULL_HANDLE;
-LunaCommandBuffer secondaryCommandBuffer = LUNA_NULL_HANDLE;
+uint64_t submittedFrames = 0;
+bool recordingFrame = false;
+LunaCommandBuffer uploadCommandBuffers[UPLOAD_COMMAND_BUFFER_COUNT] = {LUNA_NULL_HANDLE};
+uint64_t issuedUploads = 0;
 LunaSemaphore semaphore = LUNA_NULL_HANDLE;
 VkSurfaceKHR surface = VK_NULL_HANDLE;
 VkExtent2D swapChainExtent = {0};
@@ -53,8 +59,10 @@ TextureSamplers textureSamplers = {
 	.nearestNoRepeatNoAnisotropy = LUNA_NULL_HANDLE,
 };
 LockingList textures = {0};
+StreamedTexture streamedTextures[MAX_TEXTURES];
+const Image *streamedTextureImages[MAX_TEXTURES];
 LunaDescriptorSetLayout descriptorSetLayout = LUNA_NULL_HANDLE;
-LunaDescriptorSet descriptorSet;
+LunaDescriptorSet descriptorSets[FRAMES_IN_FLIGHT];
 Buffers buffers = {
 #ifdef JPH_DEBUG_RENDERER
 	.debugDrawLines.vertices.allocatedSize = sizeof(DebugDrawVertex) * MAX_DEBUG_DRAW_VERTICES_INIT,
@@ -68,24 +76,116 @@ Pipelines pipelines = {
 	.debugDrawTriangles = LUNA_NULL_HANDLE,
 #endif
 };
-uint32_t pendingTasks = 0;
 uint32_t skyTextureIndex = 0;
 #pragma endregion variables
 
+/// An image or sampler that is waiting for the frames that may use it to finish
+typedef struct RetiredResource
+{
+	/// The value of @c submittedFrames when the resource was released, which is the last frame that may use it
+	uint64_t releasedFrame;
+	LunaImage image;
+	LunaSampler sampler;
+} RetiredResource;
+
+static RetiredResource *retiredResources = NULL;
+static size_t retiredResourceCount = 0;
+static size_t retiredResourceCapacity = 0;
+
+LunaCommandBuffer NextUploadCommandBuffer()
+{
+	return uploadCommandBuffers[issuedUploads++ % UPLOAD_COMMAND_BUFFER_COUNT];
+}
+
+static void RetireResource(const LunaImage image, const LunaSampler sampler)
+{
+	if (retiredResourceCount == retiredResourceCapacity)
+	{
+		retiredResourceCapacity = retiredResourceCapacity == 0 ? 16 : retiredResourceCapacity * 2;
+		RetiredResource *newResources = realloc(retiredResources, retiredResourceCapacity * sizeof(RetiredResource));
+		CheckAlloc(newResources);
+		retiredResources = newResources;
+	}
+	retiredResources[retiredResourceCount++] = (RetiredResource){
+		.releasedFrame = submittedFrames,
+		.image = image,
+		.sampler = sampler,
+	};
+}
+
+void DestroyImageWhenRetired(const LunaImage image)
+{
+	if (image != LUNA_NULL_HANDLE)
+	{
+		RetireResource(image, LUNA_NULL_HANDLE);
+	}
+}
+
+void DestroySamplerWhenRetired(const LunaSampler sampler)
+{
+	if (sampler != LUNA_NULL_HANDLE)
+	{
+		RetireResource(LUNA_NULL_HANDLE, sampler);
+	}
+}
+
+void DestroyRetiredResources()
+{
+	size_t remaining = 0;
+	for (size_t i = 0; i < retiredResourceCount; i++)
+	{
+		const RetiredResource *resource = &retiredResources[i];
+		// Frame releasedFrame may still use the resource, and lunaBeginFrame has only waited for the frame that last
+		// used the current command buffer, which is FRAMES_IN_FLIGHT frames before the one being recorded
+		if (resource->releasedFrame + FRAMES_IN_FLIGHT > submittedFrames)
+		{
+			retiredResources[remaining++] = *resource;
+			continue;
+		}
+		if (resource->image != LUNA_NULL_HANDLE)
+		{
+			lunaDestroyImage(device, resource->image);
+		}
+		if (resource->sampler != LUNA_NULL_HANDLE)
+		{
+			lunaDestroySampler(device, resource->sampler);
+		}
+	}
+	retiredResourceCount = remaining;
+}
+
+void AdvanceFrame()
+{
+	recordingFrame = false;
+	submittedFrames++;
+	currentFrame = submittedFrames % FRAMES_IN_FLIGHT;
+	commandBuffer = commandBuffers[currentFrame];
+}
+
+VkResult EnsureFrameBufferSize(LunaBuffer *buffer, const size_t bytes)
+{
+	if (lunaGetBufferSize(*buffer) >= bytes)
+	{
+		return VK_SUCCESS;
+	}
+	return lunaResizeBuffer(device, commandBuffer, buffer, bytes);
+}
+
 bool ClearTextureCache()
 {
 	memset(imageAssetIdToIndexMap, -1, sizeof(*imageAssetIdToIndexMap) * MAX_TEXTURES);
 	for (size_t i = 0; i < textures.length; i++)
 	{
-		lunaDestroyImage(device, (LunaImage)ListGetUint64(textures, i));
+		DestroyImageWhenRetired((LunaImage)ListGetUint64(textures, i));
 	}
 	ListFree(textures);
-	lunaDestroySampler(device, textureSamplers.linearRepeatAnisotropy);
-	lunaDestroySampler(device, textureSamplers.linearNoRepeatAnisotropy);
-	lunaDestroySampler(device, textureSamplers.linearRepeatNoAnisotropy);
-	lunaDestroySampler(device, textureSamplers.nearestRepeatNoAnisotropy);
-	lunaDestroySampler(device, textureSamplers.linearNoRepeatNoAnisotropy);
-	lunaDestroySampler(device, textureSamplers.nearestNoRepeatNoAnisotropy);
+	ReleaseTextureSlots();
+	DestroySamplerWhenRetired(textureSamplers.linearRepeatAnisotropy);
+	DestroySamplerWhenRetired(textureSamplers.linearNoRepeatAnisotropy);
+	DestroySamplerWhenRetired(textureSamplers.linearRepeatNoAnisotropy);
+	DestroySamplerWhenRetired(textureSamplers.nearestRepeatNoAnisotropy);
+	DestroySamplerWhenRetired(textureSamplers.linearNoRepeatNoAnisotropy);
+	DestroySamplerWhenRetired(textureSamplers.nearestNoRepeatNoAnisotropy);
 	return CreateTextureSamplers();
 }
 
@@ -139,25 +239,10 @@ inline uint32_t ImageIndex(const Image *image)
 // TODO: Make sure this doesn't need changes
 VkResult UpdateCameraUniform(const Camera *camera)
 {
-	mat4 perspectiveMatrix;
-	glm_perspective_lh_zo(glm_rad(camera->fov),
-						  (float)swapChainExtent.width / (float)swapChainExtent.height,
-						  NEAR_Z,
-						  FAR_Z,
-						  perspectiveMatrix);
-
-	versor rotationQuat;
-	QUAT_TO_VERSOR(camera->transform.rotation, rotationQuat);
-	versor rotationOffset;
-	glm_quatv(rotationOffset, GLM_PIf, GLM_XUP);
-	glm_quat_mul(rotationQuat, rotationOffset, rotationQuat);
-
-	vec3 cameraPosition = {camera->transform.position.x, camera->transform.position.y, camera->transform.position.z};
-	mat4 viewMatrix;
-	glm_quat_look(cameraPosition, rotationQuat, viewMatrix);
-
 	CameraUniform uniform;
-	glm_mat4_mul(perspectiveMatrix, viewMatrix, uniform.transform);
+	CameraViewProjectionMatrix(camera,
+							   (float)swapChainExtent.width / (float)swapChainExtent.height,
+							   &uniform.transform);
 	uniform.position = camera->transform.position;
 	const LunaBufferWriteInfo bufferWriteInfo = {
 		.bytes = sizeof(CameraUniform),
@@ -195,7 +280,8 @@ VkResult UpdateViewModelMatrix(const Viewmodel *viewmodel)
 	glm_mat4_mul(translationMatrix, rotationMatrix, translationMatrix);
 	glm_mat4_mul(perspectiveMatrix, translationMatrix, viewModelMatrix);
 
-	const size_t instanceCount = lunaGetBufferSize(buffers.viewmodel.instanceData) / sizeof(ModelInstanceData);
+	const LunaBuffer instanceData = buffers.viewmodel.instanceData[currentFrame];
+	const size_t instanceCount = lunaGetBufferSize(instanceData) / sizeof(ModelInstanceData);
 	for (size_t i = 0; i < instanceCount; i++)
 	{
 		const LunaBufferWriteInfo writeInfo = {
@@ -204,13 +290,18 @@ VkResult UpdateViewModelMatrix(const Viewmodel *viewmodel)
 			.offset = i * sizeof(ModelInstanceData) + offsetof(ModelInstanceData, transformMatrix),
 			.stageFlags = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
 		};
-		VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, buffers.viewmodel.instanceData, &writeInfo),
+		VulkanTestReturnResult(lunaWriteDataToBuffer(device, commandBuffer, instanceData, &writeInfo),
 							   "Failed to write viewmodel transform matrix to instance data buffer!");
 	}
 
 	return VK_SUCCESS;
 }
 
+inline void RequestFullTextureDetail(const uint32_t textureIndex)
+{
+	StreamedTextureSeen(&streamedTextures[textureIndex], (float)max(swapChainExtent.width, swapChainExtent.height));
+}
+
 void EnsureSpaceForUiElements(const size_t quadCount)
 {
 	if (buffers.ui.freeQuads < quadCount)
@@ -218,15 +309,9 @@ void EnsureSpaceForUiElements(const size_t quadCount)
 		buffers.ui.freeQuads += quadCount + 16;
 		buffers.ui.allocatedQuads += quadCount + 16;
 
-		pendingTasks |= PENDING_TASK_UI_BUFFERS_RESIZE_BIT;
-
 		UiVertex *newVertices = realloc(buffers.ui.vertexData, buffers.ui.allocatedQuads * 4 * sizeof(UiVertex));
 		CheckAlloc(newVertices);
 		buffers.ui.vertexData = newVertices;
-
-		uint32_t *newIndices = realloc(buffers.ui.indexData, buffers.ui.allocatedQuads * 6 * sizeof(uint32_t));
-		CheckAlloc(newIndices);
-		buffers.ui.indexData = newIndices;
 	}
 }
 
@@ -253,10 +338,9 @@ void DrawRectInternal(const float ndcStartX,
 void DrawQuadInternal(const mat4 vertices_posXY_uvZW, const Color *color, const uint32_t textureIndex)
 {
 	EnsureSpaceForUiElements(1);
+	RequestFullTextureDetail(textureIndex);
 
-	const size_t vertexOffset = (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 4;
-	UiVertex *vertices = buffers.ui.vertexData + vertexOffset;
-	uint32_t *indices = buffers.ui.indexData + (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 6;
+	UiVertex *vertices = buffers.ui.vertexData + (buffers.ui.allocatedQuads - buffers.ui.freeQuads) * 4;
 
 	for (uint8_t i = 0; i < 4; i++)
 	{
@@ -265,12 +349,5 @@ void DrawQuadInternal(const mat4 vertices_posXY_uvZW, const Color *color, const
 		((uint32_t *)(vertices++))[8] = textureIndex;
 	}
 
-	indices[0] = vertexOffset;
-	indices[1] = vertexOffset + 1;
-	indices[2] = vertexOffset + 2;
-	indices[3] = vertexOffset;
-	indices[4] = vertexOffset + 2;
-	indices[5] = vertexOffset + 3;
-
 	buffers.ui.freeQuads--;
 }
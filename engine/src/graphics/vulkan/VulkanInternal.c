@@ -3,6 +3,7 @@
 
 #include <assert.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/graphics/vulkan/RenderGraph.h>
 #include <engine/graphics/vulkan/Vulkan.h>
 #include <engine/graphics/vulkan/VulkanHelpers.h>
 #include <engine/graphics/vulkan/VulkanInternal.h>
@@ -12,6 +13,7 @@
 #include <engine/structs/List.h>
 #include <engine/structs/Options.h>
 #include <engine/subsystem/Error.h>
+#include <engine/subsystem/Logging.h>
 #include <luna/luna.h>
 #include <luna/lunaDevice.h>
 #include <luna/lunaDrawing.h>
@@ -30,6 +32,7 @@
 #include <vulkan/vulkan_core.h>
 
 static SDL_Window *vulkanWindow;
+static RenderGraph frameGraph;
 
 bool CreateInstance()
 {
@@ -69,23 +72,156 @@ bool CreateSurface(SDL_Window *window)
 	return true;
 }
 
+/**
+ * Check whether a physical device supports every feature that is set in a set of required features
+ */
+static inline bool PhysicalDeviceSupportsFeatures(const VkPhysicalDeviceFeatures *features,
+												  const VkPhysicalDeviceFeatures *requiredFeatures)
+{
+	const VkBool32 *supported = (const VkBool32 *)features;
+	const VkBool32 *required = (const VkBool32 *)requiredFeatures;
+	for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); i++)
+	{
+		if (required[i] && !supported[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Check whether a physical device supports every Vulkan 1.2 feature that is set in a set of required features
+ */
+static inline bool PhysicalDeviceSupportsVulkan12Features(const VkPhysicalDeviceVulkan12Features *features,
+														  const VkPhysicalDeviceVulkan12Features *requiredFeatures)
+{
+	// Every member after sType and pNext is a VkBool32
+	const size_t firstFeatureOffset = offsetof(VkPhysicalDeviceVulkan12Features, samplerMirrorClampToEdge);
+	const VkBool32 *supported = (const VkBool32 *)((const uint8_t *)features + firstFeatureOffset);
+	const VkBool32 *required = (const VkBool32 *)((const uint8_t *)requiredFeatures + firstFeatureOffset);
+	for (size_t i = 0; i < (sizeof(VkPhysicalDeviceVulkan12Features) - firstFeatureOffset) / sizeof(VkBool32); i++)
+	{
+		if (required[i] && !supported[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Find the physical device that the logical device will be created on, in order to check the optional features that it
+ * supports before the logical device is created. The device is picked the same way as Luna picks it, which is the first
+ * device of the preferred type that has every required feature, or the first device with every required feature if
+ * there is no device of the preferred type. Optional features are only required when the device that would be picked
+ * without them supports them, so requiring them never changes which device gets picked.
+ * @param requiredFeatures The Vulkan 1.0 features that are required
+ * @param requiredVulkan12Features The Vulkan 1.2 features that are required
+ * @param preferredDeviceType The type of device that is preferred
+ * @param selectedFeatures Set to the Vulkan 1.0 features supported by the device that will be picked
+ * @return @c VK_SUCCESS, @c VK_ERROR_FEATURE_NOT_PRESENT if no device supports every required feature, or a meaningful
+ *  result code if the devices could not be queried
+ */
+static inline VkResult SelectPhysicalDevice(const VkPhysicalDeviceFeatures *requiredFeatures,
+											const VkPhysicalDeviceVulkan12Features *requiredVulkan12Features,
+											const VkPhysicalDeviceType preferredDeviceType,
+											VkPhysicalDeviceFeatures *selectedFeatures)
+{
+	const PFN_vkGetInstanceProcAddr getInstanceProcAddr = (PFN_vkGetInstanceProcAddr)
+			SDL_Vulkan_GetVkGetInstanceProcAddr();
+	if (!getInstanceProcAddr)
+	{
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+	const VkInstance instance = lunaGetInstance();
+	const PFN_vkEnumeratePhysicalDevices enumeratePhysicalDevices = (PFN_vkEnumeratePhysicalDevices)
+			getInstanceProcAddr(instance, "vkEnumeratePhysicalDevices");
+	const PFN_vkGetPhysicalDeviceFeatures2 getPhysicalDeviceFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)
+			getInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2");
+	const PFN_vkGetPhysicalDeviceProperties getPhysicalDeviceProperties = (PFN_vkGetPhysicalDeviceProperties)
+			getInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties");
+	if (!enumeratePhysicalDevices || !getPhysicalDeviceFeatures2 || !getPhysicalDeviceProperties)
+	{
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	uint32_t physicalDeviceCount = 0;
+	VulkanTestReturnResult(enumeratePhysicalDevices(instance, &physicalDeviceCount, NULL),
+						   "Failed to enumerate physical devices!");
+	if (physicalDeviceCount == 0)
+	{
+		return VK_ERROR_FEATURE_NOT_PRESENT;
+	}
+	VkPhysicalDevice physicalDevices[physicalDeviceCount];
+	VulkanTestReturnResult(enumeratePhysicalDevices(instance, &physicalDeviceCount, physicalDevices),
+						   "Failed to enumerate physical devices!");
+	bool foundDevice = false;
+	for (uint32_t i = 0; i < physicalDeviceCount; i++)
+	{
+		VkPhysicalDeviceVulkan12Features vulkan12Features = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+		};
+		VkPhysicalDeviceFeatures2 features = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+			.pNext = &vulkan12Features,
+		};
+		getPhysicalDeviceFeatures2(physicalDevices[i], &features);
+		if (!PhysicalDeviceSupportsFeatures(&features.features, requiredFeatures) ||
+			!PhysicalDeviceSupportsVulkan12Features(&vulkan12Features, requiredVulkan12Features))
+		{
+			continue;
+		}
+		VkPhysicalDeviceProperties properties;
+		getPhysicalDeviceProperties(physicalDevices[i], &properties);
+		if (properties.deviceType == preferredDeviceType)
+		{
+			*selectedFeatures = features.features;
+			return VK_SUCCESS;
+		}
+		if (!foundDevice)
+		{
+			foundDevice = true;
+			*selectedFeatures = features.features;
+		}
+	}
+	return foundDevice ? VK_SUCCESS : VK_ERROR_FEATURE_NOT_PRESENT;
+}
+
 bool CreateLogicalDevice()
 {
 	const LunaPhysicalDevicePreferenceDefinition devicePreferenceDefinition = {
 		.preferredDeviceType = VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU,
 	};
-	const VkPhysicalDeviceFeatures vulkan10Features = {
+	VkPhysicalDeviceFeatures vulkan10Features = {
 		.samplerAnisotropy = VK_TRUE,
 		.multiDrawIndirect = VK_TRUE,
 		.drawIndirectFirstInstance = VK_TRUE,
 	};
+	// Texture slots that have never been written are left unbound, and slots that are first used while other frames are
+	// in flight are written while those frames are pending, which is only valid for slots those frames do not use
 	VkPhysicalDeviceVulkan12Features vulkan12Features = {
 		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
 		.scalarBlockLayout = VK_TRUE,
 		.runtimeDescriptorArray = VK_TRUE,
 		.shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
 		.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+		.descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+		.descriptorBindingPartiallyBound = VK_TRUE,
 	};
+	VkPhysicalDeviceFeatures selectedDeviceFeatures = {0};
+	const VkResult selectResult = SelectPhysicalDevice(&vulkan10Features,
+													   &vulkan12Features,
+													   devicePreferenceDefinition.preferredDeviceType,
+													   &selectedDeviceFeatures);
+	if (selectResult == VK_ERROR_FEATURE_NOT_PRESENT)
+	{
+		VulkanLogError("No GPU supports every required feature, including partially bound descriptors!\n");
+		return false;
+	}
+	// If the devices could not be queried here, Luna still checks the required features when creating the device
+	textureCompressionBCSupported = selectResult == VK_SUCCESS && selectedDeviceFeatures.textureCompressionBC;
+	vulkan10Features.textureCompressionBC = textureCompressionBCSupported;
 	const VkPhysicalDeviceFeatures2 requiredFeatures = {
 		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
 		.pNext = &vulkan12Features,
@@ -100,6 +236,10 @@ bool CreateLogicalDevice()
 	};
 	VulkanTest(lunaCreateDevice2(&deviceCreationInfo, &device), "Failed to create logical device!");
 	lunaGetPhysicalDeviceProperties(device, &physicalDeviceProperties);
+	if (!textureCompressionBCSupported)
+	{
+		LogInfo("BC texture compression is not supported, compressed textures will be decompressed on the CPU\n");
+	}
 	// TODO: Check that no limits are being exceeded
 	return true;
 }
@@ -117,10 +257,20 @@ bool CreateCommandBuffers()
 		.queueFamilyIndex = queueFamilyIndex,
 	};
 	VulkanTest(lunaCreateCommandPool(device, &commandPoolCreationInfo, &commandPool), "Failed to create command pool!");
-	VulkanTest(lunaAllocateCommandBuffer(device, commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, &commandBuffer),
-			   "Failed to allocate command buffer!");
-	VulkanTest(lunaAllocateCommandBuffer(device, commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, &secondaryCommandBuffer),
-			   "Failed to allocate secondary command buffer!");
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		VulkanTest(lunaAllocateCommandBuffer(device, commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, &commandBuffers[i]),
+				   "Failed to allocate command buffer!");
+	}
+	commandBuffer = commandBuffers[currentFrame];
+	for (uint32_t i = 0; i < UPLOAD_COMMAND_BUFFER_COUNT; i++)
+	{
+		VulkanTest(lunaAllocateCommandBuffer(device,
+											 commandPool,
+											 VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+											 &uploadCommandBuffers[i]),
+				   "Failed to allocate upload command buffer!");
+	}
 
 	const LunaSemaphoreCreationInfo semaphoreCreationInfo = {};
 	VulkanTest(lunaCreateSemaphore(device, &semaphoreCreationInfo, &semaphore), "Failed to create semaphore!");
@@ -197,6 +347,51 @@ bool CreateSwapchain()
 	return true;
 }
 
+/**
+ * Declare the passes of a frame in the order that they are recorded, with the attachments that each one uses, and
+ * compile the graph. The formats are the preferred ones, since they are only used to decide which transient attachments
+ * can share memory.
+ * @param graph The graph to build
+ */
+static void BuildFrameGraph(RenderGraph *graph)
+{
+	RenderGraphInit(graph);
+	const uint8_t swapchain = RenderGraphAddResource(graph,
+													 "swapchain",
+													 VK_FORMAT_B8G8R8A8_UNORM,
+													 VK_SAMPLE_COUNT_1_BIT,
+													 false);
+	const uint8_t color = msaaSamples == VK_SAMPLE_COUNT_1_BIT
+								  ? swapchain
+								  : RenderGraphAddResource(graph, "color", VK_FORMAT_B8G8R8A8_UNORM, msaaSamples, true);
+	const uint8_t depth = RenderGraphAddResource(graph, "depth", VK_FORMAT_D24_UNORM_S8_UINT, msaaSamples, true);
+
+	const uint8_t sky = RenderGraphAddPass(graph, "sky");
+	RenderGraphPassAccess(graph, sky, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t map = RenderGraphAddPass(graph, "map");
+	RenderGraphPassAccess(graph, map, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(graph, map, depth, RENDER_GRAPH_ACCESS_DEPTH_WRITE);
+	const uint8_t actors = RenderGraphAddPass(graph, "actors");
+	RenderGraphPassAccess(graph, actors, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(graph, actors, depth, RENDER_GRAPH_ACCESS_DEPTH_WRITE);
+	const uint8_t viewmodel = RenderGraphAddPass(graph, "viewmodel");
+	RenderGraphPassAccess(graph, viewmodel, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t ui = RenderGraphAddPass(graph, "ui");
+	RenderGraphPassAccess(graph, ui, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	if (color != swapchain)
+	{
+		const uint8_t resolve = RenderGraphAddPass(graph, "resolve");
+		RenderGraphPassAccess(graph, resolve, swapchain, RENDER_GRAPH_ACCESS_RESOLVE_WRITE);
+	}
+	const uint8_t present = RenderGraphAddPass(graph, "present");
+	RenderGraphPassAccess(graph, present, swapchain, RENDER_GRAPH_ACCESS_PRESENT);
+
+	RenderGraphCompile(graph);
+	char schedule[2048];
+	RenderGraphDumpSchedule(graph, schedule, sizeof(schedule));
+	LogDebug("Frame graph schedule:\n%s", schedule);
+}
+
 bool CreateRenderPass()
 {
 	// TODO: Once Luna supports it, prefer using VK_FORMAT_D32_SFLOAT
@@ -244,18 +439,20 @@ bool CreateRenderPass()
 					"A fallback has been set to avoid issues.");
 	}
 
+	BuildFrameGraph(&frameGraph);
+	if (frameGraph.groupCount != 2)
+	{
+		// Luna records the whole frame in one subpass followed by presenting
+		VulkanLogError("The frame graph needs %zu render pass groups, but only one render pass is supported",
+					   frameGraph.groupCount);
+		return false;
+	}
 	const LunaSubpassCreationInfo subpassCreationInfo = {
 		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
 		.useColorAttachment = true,
 		.useDepthAttachment = true,
 	};
-	VkSubpassDependency dependency = {
-		.srcSubpass = VK_SUBPASS_EXTERNAL,
-		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-		.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-		.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-	};
+	VkSubpassDependency dependency = frameGraph.externalDependency;
 	SDL_Rect bounds;
 	if (!SDL_GetDisplayBounds(SDL_GetDisplayForWindow(vulkanWindow), &bounds))
 	{
@@ -291,13 +488,16 @@ bool CreateDescriptorSetLayouts()
 			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 			.descriptorCount = 1,
 			.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+			.bindingFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
 		},
 		{
 			.bindingName = "Textures",
 			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 			.descriptorCount = MAX_TEXTURES,
 			.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-			.bindingFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+			.bindingFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+							VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+							VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
 		},
 		{
 			.bindingName = "Camera",
@@ -319,7 +519,7 @@ bool CreateDescriptorSetLayouts()
 		},
 	};
 	const LunaDescriptorSetLayoutCreationInfo descriptorSetLayoutCreationInfo = {
-		.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+		.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
 		.bindingCount = sizeof(bindings) / sizeof(*bindings),
 		.bindings = bindings,
 	};
@@ -447,65 +647,74 @@ bool CreateTextureSamplers()
 	return true;
 }
 
-// TODO: Revisit this to ensure it's as it should be (update after bind flag or usage of MAX_FRAMES_IN_FLIGHT, for example)
-bool CreateDescriptorSet()
+bool CreateDescriptorSets()
 {
 	LunaDescriptorPool descriptorPool = LUNA_NULL_HANDLE;
 	const VkDescriptorPoolSize poolSizes[] = {
 		{
 			.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			.descriptorCount = MAX_TEXTURES + 1,
+			.descriptorCount = (MAX_TEXTURES + 1) * FRAMES_IN_FLIGHT,
 		},
 		{
 			.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-			.descriptorCount = 3,
+			.descriptorCount = 3 * FRAMES_IN_FLIGHT,
 		},
 	};
 	const LunaDescriptorPoolCreationInfo descriptorPoolCreationInfo = {
-		.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
-		.maxSets = 1,
+		.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+		.maxSets = FRAMES_IN_FLIGHT,
 		.poolSizeCount = sizeof(poolSizes) / sizeof(*poolSizes),
 		.poolSizes = poolSizes,
 	};
 	VulkanTest(lunaCreateDescriptorPool(device, &descriptorPoolCreationInfo, &descriptorPool),
 			   "Failed to create descriptor pool!");
 
+	LunaDescriptorSetLayout setLayouts[FRAMES_IN_FLIGHT];
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		setLayouts[i] = descriptorSetLayout;
+	}
 	const LunaDescriptorSetAllocationInfo allocationInfo = {
 		.descriptorPool = descriptorPool,
-		.setLayoutCount = 1,
-		.setLayouts = &descriptorSetLayout,
+		.setLayoutCount = FRAMES_IN_FLIGHT,
+		.setLayouts = setLayouts,
 	};
-	VulkanTest(lunaAllocateDescriptorSets(device, &allocationInfo, &descriptorSet),
+	VulkanTest(lunaAllocateDescriptorSets(device, &allocationInfo, descriptorSets),
 			   "Failed to allocate descriptor sets!");
 
 	const LunaDescriptorBufferInfo transformMatrixBufferInfo = {
 		.buffer = buffers.uniforms.camera,
 	};
-	const LunaWriteDescriptorSet transformMatrixWrite = {
-		.descriptorSet = descriptorSet,
-		.bindingName = "Camera",
-		.descriptorCount = 1,
-		.bufferInfo = &transformMatrixBufferInfo,
-	};
 	const LunaDescriptorBufferInfo lightingBufferInfo = {
 		.buffer = buffers.uniforms.lighting,
 	};
-	const LunaWriteDescriptorSet lightingWrite = {
-		.descriptorSet = descriptorSet,
-		.bindingName = "Global Lighting",
-		.descriptorCount = 1,
-		.bufferInfo = &lightingBufferInfo,
-	};
 	const LunaDescriptorBufferInfo fogBufferInfo = {
 		.buffer = buffers.uniforms.fog,
 	};
-	const LunaWriteDescriptorSet fogWrite = {
-		.descriptorSet = descriptorSet,
-		.bindingName = "Fog",
-		.descriptorCount = 1,
-		.bufferInfo = &fogBufferInfo,
-	};
-	lunaWriteDescriptorSets(device, 3, (LunaWriteDescriptorSet[]){transformMatrixWrite, lightingWrite, fogWrite});
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		const LunaWriteDescriptorSet transformMatrixWrite = {
+			.descriptorSet = descriptorSets[i],
+			.bindingName = "Camera",
+			.descriptorCount = 1,
+			.bufferInfo = &transformMatrixBufferInfo,
+		};
+		const LunaWriteDescriptorSet lightingWrite = {
+			.descriptorSet = descriptorSets[i],
+			.bindingName = "Global Lighting",
+			.descriptorCount = 1,
+			.bufferInfo = &lightingBufferInfo,
+		};
+		const LunaWriteDescriptorSet fogWrite = {
+			.descriptorSet = descriptorSets[i],
+			.bindingName = "Fog",
+			.descriptorCount = 1,
+			.bufferInfo = &fogBufferInfo,
+		};
+		lunaWriteDescriptorSets(device,
+								3,
+								(LunaWriteDescriptorSet[]){transformMatrixWrite, lightingWrite, fogWrite});
+	}
 
 	return true;
 }
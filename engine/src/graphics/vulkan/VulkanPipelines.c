@@ -7,11 +7,14 @@
 #include <engine/assets/ShaderLoader.h>
 #include <engine/graphics/vulkan/VulkanHelpers.h>
 #include <engine/graphics/vulkan/VulkanInternal.h>
+#include <engine/subsystem/Logging.h>
+#include <engine/subsystem/Timing.h>
 #include <luna/luna.h>
 #include <luna/lunaDrawing.h>
 #include <luna/lunaTypes.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <vulkan/vulkan_core.h>
 
 // TODO: This probably won't change much since pipelines are really just a lot of boilerplate,
@@ -215,7 +218,7 @@ static inline bool CreateShadedMapPipeline()
 		{
 			.location = 2,
 			.binding = 0,
-			.format = VK_FORMAT_R32G32_SFLOAT,
+			.format = VK_FORMAT_R16G16_UNORM,
 			.offset = offsetof(MapVertex, lightmapUv),
 		},
 		{
@@ -675,6 +678,11 @@ static inline bool CreateShadedActorModelPipeline()
 			.stride = sizeof(ActorModelInstanceData),
 			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
 		},
+		{
+			.binding = 2,
+			.stride = sizeof(ActorModelMaterialData),
+			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+		},
 	};
 	const VkVertexInputAttributeDescription attributeDescriptions[] = {
 		{
@@ -733,15 +741,15 @@ static inline bool CreateShadedActorModelPipeline()
 		},
 		{
 			.location = 9,
-			.binding = 1,
+			.binding = 2,
 			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
-			.offset = offsetof(ActorModelInstanceData, materialColor),
+			.offset = offsetof(ActorModelMaterialData, materialColor),
 		},
 		{
 			.location = 10,
-			.binding = 1,
+			.binding = 2,
 			.format = VK_FORMAT_R32_UINT,
-			.offset = offsetof(ActorModelInstanceData, textureIndex),
+			.offset = offsetof(ActorModelMaterialData, textureIndex),
 		},
 	};
 	const VkPipelineVertexInputStateCreateInfo vertexInputInfo = {
@@ -800,6 +808,11 @@ static inline bool CreateUnshadedActorModelPipeline()
 			.stride = sizeof(ActorModelInstanceData),
 			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
 		},
+		{
+			.binding = 2,
+			.stride = sizeof(ActorModelMaterialData),
+			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+		},
 	};
 	const VkVertexInputAttributeDescription attributeDescriptions[] = {
 		{
@@ -852,15 +865,15 @@ static inline bool CreateUnshadedActorModelPipeline()
 		},
 		{
 			.location = 8,
-			.binding = 1,
+			.binding = 2,
 			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
-			.offset = offsetof(ActorModelInstanceData, materialColor),
+			.offset = offsetof(ActorModelMaterialData, materialColor),
 		},
 		{
 			.location = 9,
-			.binding = 1,
+			.binding = 2,
 			.format = VK_FORMAT_R32_UINT,
-			.offset = offsetof(ActorModelInstanceData, textureIndex),
+			.offset = offsetof(ActorModelMaterialData, textureIndex),
 		},
 	};
 	const VkPipelineVertexInputStateCreateInfo vertexInputInfo = {
@@ -1112,7 +1125,7 @@ static inline bool CreateDebugDrawPipeline()
 		.layoutCreationInfo = pipelineLayoutCreationInfo,
 		.subpass = lunaGetRenderPassSubpassByName(renderPass, NULL),
 	};
-	VulkanTest(lunaCreateGraphicsPipeline(&linesPipelineInfo, &pipelines.debugDrawLines),
+	VulkanTest(lunaCreateGraphicsPipeline(device, &linesPipelineInfo, &pipelines.debugDrawLines),
 			   "Failed to create graphics pipeline for Jolt debug renderer lines!");
 
 	const LunaGraphicsPipelineCreationInfo trianglesPipelineInfo = {
@@ -1129,7 +1142,7 @@ static inline bool CreateDebugDrawPipeline()
 		.layoutCreationInfo = pipelineLayoutCreationInfo,
 		.subpass = lunaGetRenderPassSubpassByName(renderPass, NULL),
 	};
-	VulkanTest(lunaCreateGraphicsPipeline(&trianglesPipelineInfo, &pipelines.debugDrawTriangles),
+	VulkanTest(lunaCreateGraphicsPipeline(device, &trianglesPipelineInfo, &pipelines.debugDrawTriangles),
 			   "Failed to create graphics pipeline for Jolt debug renderer triangles!");
 #endif
 
@@ -1141,19 +1154,27 @@ bool CreateGraphicsPipelines()
 	multisampling.rasterizationSamples = msaaSamples;
 	pipelineLayoutCreationInfo.descriptorSetLayouts = &descriptorSetLayout;
 
+	const uint64_t startTime = GetTimeNs();
+
 	VulkanTest(CreateShaderModule(SHADER("model_shaded_f"), SHADER_TYPE_FRAG, &modelShadedFragShaderModule),
 			   "Failed to load shaded model fragment shader!");
 	VulkanTest(CreateShaderModule(SHADER("model_unshaded_f"), SHADER_TYPE_FRAG, &modelUnshadedFragShaderModule),
 			   "Failed to load unshaded model fragment shader!");
 
-	return CreateUIPipeline() &&
-		   CreateShadedMapPipeline() &&
-		   CreateUnshadedMapPipeline() &&
-		   CreateSkyPipeline() &&
-		   CreateShadedViewmodelPipeline() &&
-		   CreateUnshadedViewmodelPipeline() &&
-		   CreateShadedActorModelPipeline() &&
-		   CreateUnshadedActorModelPipeline() &&
-		   CreateActorWallPipelines() &&
-		   CreateDebugDrawPipeline();
+	if (!(CreateUIPipeline() &&
+		  CreateShadedMapPipeline() &&
+		  CreateUnshadedMapPipeline() &&
+		  CreateSkyPipeline() &&
+		  CreateShadedViewmodelPipeline() &&
+		  CreateUnshadedViewmodelPipeline() &&
+		  CreateShadedActorModelPipeline() &&
+		  CreateUnshadedActorModelPipeline() &&
+		  CreateActorWallPipelines() &&
+		  CreateDebugDrawPipeline()))
+	{
+		return false;
+	}
+
+	LogInfo("Created graphics pipelines in %.2f ms\n", (double)(GetTimeNs() - startTime) / 1000000.0);
+	return true;
 }
@@ -2,9 +2,15 @@
 // Created by Noah on 12/18/2024.
 //
 
+#include <assert.h>
 #include <cglm/cglm.h>
 #include <engine/assets/AssetReader.h>
+#include <engine/assets/TextureCompression.h>
 #include <engine/assets/TextureLoader.h>
+#include <engine/assets/TextureMipmaps.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/graphics/StagingRing.h>
+#include <engine/graphics/TextureStreaming.h>
 #include <engine/graphics/vulkan/VulkanHelpers.h>
 #include <engine/graphics/vulkan/VulkanResources.h>
 #include <engine/helpers/MathEx.h>
@@ -12,6 +18,7 @@
 #include <engine/structs/List.h>
 #include <engine/subsystem/Error.h>
 #include <engine/subsystem/threads/LodThread.h>
+#include <engine/subsystem/Timing.h>
 #include <luna/luna.h>
 #include <luna/lunaBuffer.h>
 #include <luna/lunaImage.h>
@@ -24,6 +31,16 @@
 #include <string.h>
 #include <vulkan/vulkan_core.h>
 
+#define TEXTURE_DESCRIPTOR_DIRTY_WORDS ((MAX_TEXTURES + 63) / 64)
+
+/// For each frame in flight, a bit per texture slot whose image changed since that frame's descriptor set was written
+static uint64_t textureDescriptorDirtyBits[FRAMES_IN_FLIGHT][TEXTURE_DESCRIPTOR_DIRTY_WORDS];
+/// The first value of @c submittedFrames at which no pending frame can use a texture slot from before the last time
+/// the slots were released
+static uint64_t textureSlotsUnusedFrame;
+/// The ring that decompressed texture pixel data is staged in, which is only allocated once a texture needs it
+static StagingRing textureStagingRing;
+
 static inline VkResult CreateUiBuffers()
 {
 	static const uint32_t MAX_UI_QUADS_INIT = 8192;
@@ -38,22 +55,23 @@ static inline VkResult CreateUiBuffers()
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device, &vertexBufferCreationInfo, &buffers.ui.vertexBuffer),
-						   "Failed to create UI vertex buffer!");
-	buffers.ui.vertexData = malloc(vertexBufferAllocationSize);
-	CheckAlloc(buffers.ui.vertexData);
-
-	const size_t indexBufferAllocationSize = MAX_UI_QUADS_INIT * 6 * sizeof(uint32_t);
 	const LunaBufferCreationInfo indexBufferCreationInfo = {
-		.size = indexBufferAllocationSize,
+		.size = UI_INDEXED_QUADS * 6 * sizeof(uint16_t),
 		.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		VulkanTestReturnResult(lunaCreateBuffer(device, &vertexBufferCreationInfo, &buffers.ui.vertexBuffers[i]),
+							   "Failed to create UI vertex buffer!");
+		buffers.ui.bufferQuads[i] = MAX_UI_QUADS_INIT;
+	}
 	VulkanTestReturnResult(lunaCreateBuffer(device, &indexBufferCreationInfo, &buffers.ui.indexBuffer),
 						   "Failed to create UI index buffer!");
-	buffers.ui.indexData = malloc(indexBufferAllocationSize);
-	CheckAlloc(buffers.ui.indexData);
+	buffers.ui.indexBufferWritten = false;
+	buffers.ui.vertexData = malloc(vertexBufferAllocationSize);
+	CheckAlloc(buffers.ui.vertexData);
 
 	return VK_SUCCESS;
 }
@@ -113,22 +131,20 @@ static inline VkResult CreateMapBuffers()
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device, &instanceDataBufferCreationInfo, &buffers.map.instanceData),
-						   "Failed to create shaded map instance data buffer!");
-	const LunaBufferCreationInfo shadedDrawInfoBufferCreationInfo = {
-		.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-		.queueFamilyIndexCount = 1,
-		.queueFamilyIndices = &queueFamilyIndex,
-	};
-	VulkanTestReturnResult(lunaCreateBuffer(device, &shadedDrawInfoBufferCreationInfo, &buffers.map.shadedDrawInfo),
-						   "Failed to create shaded map draw info buffer!");
-	const LunaBufferCreationInfo unshadedDrawInfoBufferCreationInfo = {
+	const LunaBufferCreationInfo drawInfoBufferCreationInfo = {
 		.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device, &unshadedDrawInfoBufferCreationInfo, &buffers.map.unshadedDrawInfo),
-						   "Failed to create unshaded map draw info buffer!");
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		VulkanTestReturnResult(lunaCreateBuffer(device, &instanceDataBufferCreationInfo, &buffers.map.instanceData[i]),
+							   "Failed to create shaded map instance data buffer!");
+		VulkanTestReturnResult(lunaCreateBuffer(device, &drawInfoBufferCreationInfo, &buffers.map.shadedDrawInfo[i]),
+							   "Failed to create shaded map draw info buffer!");
+		VulkanTestReturnResult(lunaCreateBuffer(device, &drawInfoBufferCreationInfo, &buffers.map.unshadedDrawInfo[i]),
+							   "Failed to create unshaded map draw info buffer!");
+	}
 
 	return VK_SUCCESS;
 }
@@ -179,26 +195,26 @@ static inline VkResult CreateViewmodelBuffers()
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device, &instanceDataBufferCreationInfo, &buffers.viewmodel.instanceData),
-						   "Failed to create shaded viewmodel instance data buffer!");
-	const LunaBufferCreationInfo shadedDrawInfoBufferCreationInfo = {
-		.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-		.queueFamilyIndexCount = 1,
-		.queueFamilyIndices = &queueFamilyIndex,
-	};
-	VulkanTestReturnResult(lunaCreateBuffer(device,
-											&shadedDrawInfoBufferCreationInfo,
-											&buffers.viewmodel.shadedDrawInfo),
-						   "Failed to create shaded viewmodel draw info buffer!");
-	const LunaBufferCreationInfo unshadedDrawInfoBufferCreationInfo = {
+	const LunaBufferCreationInfo drawInfoBufferCreationInfo = {
 		.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device,
-											&unshadedDrawInfoBufferCreationInfo,
-											&buffers.viewmodel.unshadedDrawInfo),
-						   "Failed to create unshaded viewmodel draw info buffer!");
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		VulkanTestReturnResult(lunaCreateBuffer(device,
+												&instanceDataBufferCreationInfo,
+												&buffers.viewmodel.instanceData[i]),
+							   "Failed to create shaded viewmodel instance data buffer!");
+		VulkanTestReturnResult(lunaCreateBuffer(device,
+												&drawInfoBufferCreationInfo,
+												&buffers.viewmodel.shadedDrawInfo[i]),
+							   "Failed to create shaded viewmodel draw info buffer!");
+		VulkanTestReturnResult(lunaCreateBuffer(device,
+												&drawInfoBufferCreationInfo,
+												&buffers.viewmodel.unshadedDrawInfo[i]),
+							   "Failed to create unshaded viewmodel draw info buffer!");
+	}
 
 	return VK_SUCCESS;
 }
@@ -224,26 +240,13 @@ static inline VkResult CreateActorModelBuffers()
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device, &instanceDataBufferCreationInfo, &buffers.actorModels.instanceData),
-						   "Failed to create shaded actor models instance data buffer!");
-	const LunaBufferCreationInfo shadedDrawInfoBufferCreationInfo = {
-		.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-		.queueFamilyIndexCount = 1,
-		.queueFamilyIndices = &queueFamilyIndex,
-	};
-	VulkanTestReturnResult(lunaCreateBuffer(device,
-											&shadedDrawInfoBufferCreationInfo,
-											&buffers.actorModels.shadedDrawInfo),
-						   "Failed to create shaded actor models draw info buffer!");
-	const LunaBufferCreationInfo unshadedDrawInfoBufferCreationInfo = {
-		.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-		.queueFamilyIndexCount = 1,
-		.queueFamilyIndices = &queueFamilyIndex,
-	};
-	VulkanTestReturnResult(lunaCreateBuffer(device,
-											&unshadedDrawInfoBufferCreationInfo,
-											&buffers.actorModels.unshadedDrawInfo),
-						   "Failed to create unshaded actor models draw info buffer!");
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		VulkanTestReturnResult(lunaCreateBuffer(device,
+												&instanceDataBufferCreationInfo,
+												&buffers.actorModels.instanceData[i]),
+							   "Failed to create shaded actor models instance data buffer!");
+	}
 
 	return VK_SUCCESS;
 }
@@ -333,25 +336,22 @@ static inline VkResult CreateActorWallBuffers()
 												 &vertexDataWriteInfo),
 						   "Failed to write actor vertex data to buffer!");
 
-	const LunaBufferCreationInfo shadedInstanceDataBufferCreationInfo = {
-		.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		.queueFamilyIndexCount = 1,
-		.queueFamilyIndices = &queueFamilyIndex,
-	};
-	VulkanTestReturnResult(lunaCreateBuffer(device,
-											&shadedInstanceDataBufferCreationInfo,
-											&buffers.actorWalls.shadedInstanceData),
-						   "Failed to create shaded actor walls instance data buffer!");
-
-	const LunaBufferCreationInfo unshadedInstanceDataBufferCreationInfo = {
+	const LunaBufferCreationInfo instanceDataBufferCreationInfo = {
 		.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 	};
-	VulkanTestReturnResult(lunaCreateBuffer(device,
-											&unshadedInstanceDataBufferCreationInfo,
-											&buffers.actorWalls.unshadedInstanceData),
-						   "Failed to create unshaded actor walls instance data buffer!");
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		VulkanTestReturnResult(lunaCreateBuffer(device,
+												&instanceDataBufferCreationInfo,
+												&buffers.actorWalls.shadedInstanceData[i]),
+							   "Failed to create shaded actor walls instance data buffer!");
+		VulkanTestReturnResult(lunaCreateBuffer(device,
+												&instanceDataBufferCreationInfo,
+												&buffers.actorWalls.unshadedInstanceData[i]),
+							   "Failed to create unshaded actor walls instance data buffer!");
+	}
 
 	return VK_SUCCESS;
 }
@@ -431,8 +431,120 @@ VkResult ResizeDebugDrawBuffers()
 	return VK_SUCCESS;
 }
 
-bool LoadTexture(const Image *image)
+static inline VkFormat GetVkFormat(const ImagePixelFormat pixelFormat)
+{
+	switch (pixelFormat)
+	{
+		case PIXEL_FORMAT_RGBA16F:
+			return VK_FORMAT_R16G16B16A16_SFLOAT;
+		case PIXEL_FORMAT_BC1:
+			return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case PIXEL_FORMAT_BC3:
+			return VK_FORMAT_BC3_UNORM_BLOCK;
+		case PIXEL_FORMAT_BC5:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case PIXEL_FORMAT_BC7:
+			return VK_FORMAT_BC7_UNORM_BLOCK;
+		case PIXEL_FORMAT_BC6H:
+			return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case PIXEL_FORMAT_RGBA8:
+		default:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+/**
+ * Decompress a range of levels of the mip chain of a block compressed image
+ * @param image The image to decompress
+ * @param firstLevel The first level to decompress
+ * @param levelCount The number of levels to decompress
+ * @param chain Where to write the decompressed levels, tightly packed from largest to smallest
+ */
+static inline void DecompressMipChain(const Image *image,
+									  const uint8_t firstLevel,
+									  const uint8_t levelCount,
+									  uint8_t *chain)
+{
+	const ImagePixelFormat decompressedFormat = GetDecompressedPixelFormat(image->pixelFormat);
+	size_t width = max(image->width >> firstLevel, 1);
+	size_t height = max(image->height >> firstLevel, 1);
+	const uint8_t *source = image->pixelData +
+							GetMipChainDataSize(image->pixelFormat, image->width, image->height, firstLevel);
+	uint8_t *destination = chain;
+	for (uint8_t i = 0; i < levelCount; i++)
+	{
+		uint8_t *level = DecompressPixelData(image->pixelFormat, width, height, source);
+		const size_t levelSize = GetPixelDataSize(decompressedFormat, width, height);
+		memcpy(destination, level, levelSize);
+		free(level);
+		source += GetPixelDataSize(image->pixelFormat, width, height);
+		destination += levelSize;
+		width = max(width / 2, 1);
+		height = max(height / 2, 1);
+	}
+}
+
+/**
+ * Get memory to stage the converted pixel data of the next upload in. The memory comes from the staging ring when it
+ * has room, and the ring gets it back once the upload command buffer that read it has been waited for.
+ * @param bytes The size of the pixel data
+ * @param heapPixelData Set to the memory if it had to be allocated on the heap instead, which must then be freed
+ * @return The memory
+ */
+static inline uint8_t *StageTexturePixelData(const size_t bytes, uint8_t **heapPixelData)
+{
+	if (textureStagingRing.memory == NULL)
+	{
+		StagingRingInit(&textureStagingRing, TEXTURE_STAGING_RING_BYTES);
+	}
+	// Recording upload issuedUploads - 1 waited for the command buffer that it shares with the upload
+	// UPLOAD_COMMAND_BUFFER_COUNT before it, so every upload up to that one has completed
+	const uint64_t pendingSerial = issuedUploads > UPLOAD_COMMAND_BUFFER_COUNT
+										   ? issuedUploads - UPLOAD_COMMAND_BUFFER_COUNT
+										   : 0;
+	StagingRingRelease(&textureStagingRing, pendingSerial);
+	uint8_t *pixelData = StagingRingAllocate(&textureStagingRing, bytes, issuedUploads);
+	*heapPixelData = NULL;
+	if (pixelData == NULL)
+	{
+		*heapPixelData = malloc(bytes);
+		CheckAlloc(*heapPixelData);
+		pixelData = *heapPixelData;
+	}
+	return pixelData;
+}
+
+/**
+ * Check whether a texture is uploaded with the mip levels stored in its image, which is what allows it to be streamed
+ * @param image The image of the texture
+ */
+static inline bool UsesPrecomputedMipmaps(const Image *image)
+{
+	return GetState()->options.mipmaps && image->mipmaps && image->mipLevels > 1;
+}
+
+/**
+ * Check whether the pixel data of a texture has to be decompressed before it is uploaded
+ * @param image The image of the texture
+ */
+static inline bool NeedsDecompression(const Image *image)
+{
+	const bool useMipmaps = GetState()->options.mipmaps && image->mipmaps;
+	// Block compressed formats can't be blitted to generate mipmaps, so they are decompressed as well
+	return IsBlockCompressedPixelFormat(image->pixelFormat) &&
+		   (!textureCompressionBCSupported || (useMipmaps && !UsesPrecomputedMipmaps(image)));
+}
+
+/**
+ * Create the GPU image of a texture with its mip levels from @c firstLevel to its smallest level
+ * @param image The image of the texture
+ * @param firstLevel The most detailed level to upload, which must be 0 unless the texture uses precomputed mipmaps
+ * @param lunaImage Where to write the created image
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static VkResult CreateTextureImage(const Image *image, const uint8_t firstLevel, LunaImage *lunaImage)
 {
+	const uint64_t uploadStartTime = GetTimeNs();
 	const bool useMipmaps = GetState()->options.mipmaps && image->mipmaps;
 	LunaSampler sampler = LUNA_NULL_HANDLE;
 	if (image->filter && image->repeat)
@@ -453,10 +565,10 @@ bool LoadTexture(const Image *image)
 	}
 
 	const VkPipelineStageFlags2 waitStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-	// TODO: Using the same semaphore for wait and signal slows down loading multiple textures per frame.
-	//  The wait semaphore is important because this needs to wait for the previous render to be finished before it can
-	//  actually start, otherwise it could cause the previous frame to have garbage data.
-	//  For now I'm just using one semaphore for both image->render and for render->image.
+	// The wait semaphore is important because this needs to wait for the previous render to be finished before it can
+	//  actually start, otherwise it could cause the previous frame to have garbage data. Signaling the same semaphore
+	//  makes the next frame wait for the upload, so the texture is ready by the time it is first sampled. Only the GPU
+	//  is serialized by this, since each upload is recorded into its own command buffer from the upload ring.
 	const LunaCommandBufferSubmitInfo submitInfo = {
 		.queue = queue,
 		.waitSemaphoreCount = 1,
@@ -465,21 +577,43 @@ bool LoadTexture(const Image *image)
 		.signalSemaphoreCount = 1,
 		.signalSemaphores = &semaphore,
 	};
-	const VkFormat format = image->pixelFormat == PIXEL_FORMAT_RGBA16F ? VK_FORMAT_R16G16B16A16_SFLOAT
-																	   : VK_FORMAT_R8G8B8A8_UNORM;
-	const size_t bytesPerTexelChannel = image->pixelFormat == PIXEL_FORMAT_RGBA16F ? sizeof(_Float16) : sizeof(uint8_t);
+	// Precomputed mip levels are uploaded in the same staging copy as the base level, and blitting on the GPU is only
+	// used for images that were cooked without them
+	const bool usePrecomputedMipmaps = UsesPrecomputedMipmaps(image);
+	assert(firstLevel == 0 || (usePrecomputedMipmaps && firstLevel < image->mipLevels));
+	const uint8_t uploadedLevels = usePrecomputedMipmaps ? image->mipLevels - firstLevel : 1;
+	uint8_t mipmapLevels = 1;
+	if (usePrecomputedMipmaps)
+	{
+		mipmapLevels = uploadedLevels;
+	} else if (useMipmaps)
+	{
+		mipmapLevels = GetFullMipLevelCount(image->width, image->height);
+	}
+	const size_t width = max(image->width >> firstLevel, 1);
+	const size_t height = max(image->height >> firstLevel, 1);
+	ImagePixelFormat pixelFormat = image->pixelFormat;
+	uint8_t *pixelData = image->pixelData + GetMipChainDataSize(pixelFormat, image->width, image->height, firstLevel);
+	uint8_t *heapPixelData = NULL;
+	if (NeedsDecompression(image))
+	{
+		pixelFormat = GetDecompressedPixelFormat(pixelFormat);
+		pixelData = StageTexturePixelData(GetMipChainDataSize(pixelFormat, width, height, uploadedLevels),
+										  &heapPixelData);
+		DecompressMipChain(image, firstLevel, uploadedLevels, pixelData);
+	}
 	const LunaImageCreationInfo imageCreationInfo = {
-		.format = format,
-		.width = image->width,
-		.height = image->height,
+		.format = GetVkFormat(pixelFormat),
+		.width = width,
+		.height = height,
 		.usage = VK_IMAGE_USAGE_SAMPLED_BIT,
 		.queueFamilyIndexCount = 1,
 		.queueFamilyIndices = &queueFamilyIndex,
 		.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		.writeInfo.bytes = image->width * image->height * 4 * bytesPerTexelChannel,
-		.writeInfo.pixels = image->pixelData,
-		.writeInfo.mipmapLevels = useMipmaps ? (uint8_t)log2(max(image->width, image->height)) + 1 : 1,
-		.writeInfo.generateMipmaps = useMipmaps,
+		.writeInfo.bytes = GetMipChainDataSize(pixelFormat, width, height, uploadedLevels),
+		.writeInfo.pixels = pixelData,
+		.writeInfo.mipmapLevels = mipmapLevels,
+		.writeInfo.generateMipmaps = useMipmaps && !usePrecomputedMipmaps,
 		.writeInfo.mipmapFilter = VK_FILTER_LINEAR,
 		.writeInfo.sourceStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
 		.writeInfo.destinationStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
@@ -487,25 +621,167 @@ bool LoadTexture(const Image *image)
 		.writeInfo.submitInfo = &submitInfo,
 		.sampler = sampler,
 	};
-	LunaImage lunaImage = LUNA_NULL_HANDLE;
-	const size_t index = textures.length;
-	VulkanTest(lunaCreateImage(device, secondaryCommandBuffer, &imageCreationInfo, &lunaImage),
-			   "Failed to create texture!");
-	imageAssetIdToIndexMap[image->id] = index;
-	ListAdd(textures, lunaImage);
+	const VkResult createResult = lunaCreateImage(device, NextUploadCommandBuffer(), &imageCreationInfo, lunaImage);
+	free(heapPixelData);
+	VulkanTestReturnResult(createResult, "Failed to create texture!");
+
+	renderStats.textureUploads++;
+	renderStats.textureUploadBytes += imageCreationInfo.writeInfo.bytes;
+	renderStats.textureUploadNs += GetTimeNs() - uploadStartTime;
+
+	return VK_SUCCESS;
+}
 
+static inline void WriteTextureDescriptor(const uint32_t frame, const uint32_t index, const LunaImage lunaImage)
+{
 	const LunaDescriptorImageInfo imageInfo = {
 		.image = lunaImage,
 		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 	};
 	const LunaWriteDescriptorSet writeDescriptor = {
-		.descriptorSet = descriptorSet,
+		.descriptorSet = descriptorSets[frame],
 		.bindingName = "Textures",
 		.descriptorArrayElement = index,
 		.descriptorCount = 1,
 		.imageInfo = &imageInfo,
 	};
 	lunaWriteDescriptorSets(device, 1, &writeDescriptor);
+}
+
+/**
+ * Point a texture slot at a new image in the descriptor set of every frame in flight. Update unused while pending lets
+ * a slot that no pending frame uses be written in every set right away. Otherwise, the sets of pending frames are left
+ * alone and are written by @c WriteDirtyTextureDescriptors once their frames are being recorded again.
+ * @param index The index of the texture slot
+ * @param lunaImage The image that the slot should refer to
+ * @param unusedByPendingFrames Whether it is known that no pending frame samples the slot
+ */
+static inline void SetTextureDescriptor(const uint32_t index,
+										const LunaImage lunaImage,
+										const bool unusedByPendingFrames)
+{
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		if (unusedByPendingFrames || (recordingFrame && i == currentFrame))
+		{
+			WriteTextureDescriptor(i, index, lunaImage);
+			textureDescriptorDirtyBits[i][index / 64] &= ~(1ull << (index % 64));
+		} else
+		{
+			textureDescriptorDirtyBits[i][index / 64] |= 1ull << (index % 64);
+		}
+	}
+}
+
+bool LoadTexture(const Image *image)
+{
+	const uint32_t index = textures.length;
+	StreamedTexture *streamedTexture = &streamedTextures[index];
+	const bool usePrecomputedMipmaps = UsesPrecomputedMipmaps(image);
+	uint8_t levelCount = 1;
+	if (usePrecomputedMipmaps)
+	{
+		levelCount = image->mipLevels;
+	} else if (GetState()->options.mipmaps && image->mipmaps)
+	{
+		levelCount = GetFullMipLevelCount(image->width, image->height);
+	}
+	const ImagePixelFormat uploadedFormat = NeedsDecompression(image) ? GetDecompressedPixelFormat(image->pixelFormat)
+																	  : image->pixelFormat;
+	StreamedTextureInit(streamedTexture,
+						uploadedFormat,
+						image->width,
+						image->height,
+						levelCount,
+						usePrecomputedMipmaps);
+	streamedTextureImages[index] = image;
+
+	// Streamed textures start out with only their smallest levels, and the rest are uploaded once they are seen
+	LunaImage lunaImage = LUNA_NULL_HANDLE;
+	VulkanTest(CreateTextureImage(image, streamedTexture->residentLevel, &lunaImage), "Failed to create texture!");
+	imageAssetIdToIndexMap[image->id] = index;
+	ListAdd(textures, lunaImage);
+	SetTextureDescriptor(index, lunaImage, submittedFrames >= textureSlotsUnusedFrame);
 
 	return true;
 }
+
+/**
+ * Replace the GPU image of a streamed texture with one that has its target level as its most detailed level. The
+ * descriptor is updated in place, so nothing that refers to the texture index has to change. Pending frames may still
+ * be sampling the slot, so their descriptor sets are only rewritten once their frames are being recorded again.
+ * @param index The index of the texture
+ * @return @c VK_SUCCESS, or a meaningful result code on failure
+ */
+static VkResult StreamTexture(const uint32_t index)
+{
+	StreamedTexture *streamedTexture = &streamedTextures[index];
+	LunaImage lunaImage = LUNA_NULL_HANDLE;
+	VulkanTestReturnResult(CreateTextureImage(streamedTextureImages[index], streamedTexture->targetLevel, &lunaImage),
+						   "Failed to stream texture!");
+	SetTextureDescriptor(index, lunaImage, false);
+	// Frames in flight may still be sampling the old image through the descriptor they were recorded with
+	DestroyImageWhenRetired((LunaImage)ListGetUint64(textures, index));
+	ListSet(textures, index, lunaImage);
+	streamedTexture->residentLevel = streamedTexture->targetLevel;
+
+	return VK_SUCCESS;
+}
+
+VkResult StreamTextures()
+{
+	const size_t textureCount = textures.length;
+	const size_t budgetBytes = (size_t)GetState()->options.textureBudgetMiB * 1024 * 1024;
+	uint32_t order[MAX_TEXTURES];
+	TextureStreamingPlan(streamedTextures, textureCount, budgetBytes, order);
+
+	// Evictions go first so that the uploads after them stay inside the budget
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		if (streamedTextures[order[i]].targetLevel > streamedTextures[order[i]].residentLevel)
+		{
+			VulkanTestReturnResult(StreamTexture(order[i]), "Failed to evict texture levels!");
+		}
+	}
+	uint32_t uploadCount = 0;
+	for (size_t i = 0; i < textureCount && uploadCount < TEXTURE_STREAMING_UPLOADS_PER_FRAME; i++)
+	{
+		if (streamedTextures[order[i]].targetLevel < streamedTextures[order[i]].residentLevel)
+		{
+			VulkanTestReturnResult(StreamTexture(order[i]), "Failed to stream in texture levels!");
+			uploadCount++;
+		}
+	}
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		renderStats.textureResidentBytes += streamedTextures[i].chainBytes[streamedTextures[i].residentLevel];
+	}
+
+	return VK_SUCCESS;
+}
+
+void DestroyTextureStagingRing()
+{
+	StagingRingDestroy(&textureStagingRing);
+}
+
+void ReleaseTextureSlots()
+{
+	// Frames up to and including the one being recorded may use the old slots, and the last of them is pending until
+	// lunaBeginFrame has waited for it FRAMES_IN_FLIGHT frames later
+	textureSlotsUnusedFrame = submittedFrames + FRAMES_IN_FLIGHT + 1;
+}
+
+void WriteDirtyTextureDescriptors()
+{
+	uint64_t *dirtyBits = textureDescriptorDirtyBits[currentFrame];
+	for (uint32_t i = 0; i < textures.length; i++)
+	{
+		if (dirtyBits[i / 64] & 1ull << (i % 64))
+		{
+			WriteTextureDescriptor(currentFrame, i, (LunaImage)ListGetUint64(textures, i));
+		}
+	}
+	// Slots past the end of the list were marked before the texture cache was cleared, and are written when reloaded
+	memset(dirtyBits, 0, sizeof(textureDescriptorDirtyBits[currentFrame]));
+}
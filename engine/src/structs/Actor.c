@@ -38,6 +38,7 @@ Actor *CreateActor(Transform *transform, const char *actorType, KvList params, J
 	actor->definition = GetActorDefinition(actorType);
 	actor->visible = true;
 	actor->modColor = COLOR_WHITE;
+	actor->instanceSlot = UINT32_MAX;
 	actor->bodyInterface = bodyInterface;
 	actor->bodyId = JPH_BodyId_InvalidBodyID;
 	ListInit(actor->ioConnections, LIST_POINTER);
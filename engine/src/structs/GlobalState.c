@@ -4,6 +4,7 @@
 
 #include <engine/assets/AssetReader.h>
 #include <engine/assets/MapLoader.h>
+#include <engine/Engine.h>
 #include <engine/graphics/RenderingHelpers.h>
 #include <engine/helpers/Arguments.h>
 #include <engine/physics/Physics.h>
@@ -18,6 +19,7 @@
 #include <engine/subsystem/Logging.h>
 #include <engine/subsystem/threads/LodThread.h>
 #include <engine/subsystem/threads/PhysicsThread.h>
+#include <engine/subsystem/threads/RenderThread.h>
 #include <SDL3/SDL_mouse.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -45,6 +47,7 @@ void InitState()
 	CheckAlloc(state.saveData);
 	state.saveData->hp = 100;
 	state.camera = NULL;
+	state.detailScale = 1.0f;
 	state.rpcState = IN_MENUS;
 	ListInit(state.saveData->items, LIST_POINTER);
 }
@@ -110,7 +113,6 @@ void SwitchToItem(const ItemDefinition *definition)
 					previousItem->definition->SwitchFrom(previousItem, &state.map->viewmodel);
 				}
 				definition->SwitchTo(item, &state.map->viewmodel);
-				state.map->changeFlags |= MAP_VIEWMODEL_CHANGED;
 			}
 			return;
 		}
@@ -168,7 +170,7 @@ void ProcessStateChangeQueue()
 		state.gameState = queuedStateChange;
 		PhysicsThreadSetFunction(queuedStateChange->FixedUpdateGame);
 		DiscordUpdateRPC();
-		if (!HasCliArg("--no-mouse-capture"))
+		if (!HasCliArg("--no-mouse-capture") && !IsHeadless())
 		{
 			SDL_SetWindowRelativeMouseMode(GetGameWindow(), queuedStateChange->enableRelativeMouseMode);
 		}
@@ -178,6 +180,8 @@ void ProcessStateChangeQueue()
 
 void ChangeMap(Map *map)
 {
+	// The render thread may still be drawing the old map
+	RenderThreadWaitIdle();
 	PhysicsThreadLockTickMutex();
 	LockLodThreadMutex();
 	state.camera = NULL;
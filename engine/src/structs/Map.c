@@ -3,7 +3,9 @@
 //
 
 #include <engine/debug/JoltDebugRenderer.h>
+#include <engine/graphics/Bvh.h>
 #include <engine/graphics/Drawing.h>
+#include <engine/graphics/RenderingHelpers.h>
 #include <engine/physics/Physics.h>
 #include <engine/structs/Actor.h>
 #include <engine/structs/ActorWall.h>
@@ -43,7 +45,6 @@ Map *CreateMap(void)
 	map->skyTexture = NULL;
 	map->lightColor = COLOR_WHITE;
 	map->physicsTick = 0;
-	map->changeFlags = 0;
 	map->exposure = 1.0f;
 	map->numPointLights = 0;
 	map->pointLights = NULL;
@@ -95,6 +96,9 @@ void DestroyMap(Map *map)
 		free(map->models);
 		map->models = NULL;
 	}
+	free(map->clusters);
+	BvhFree(&map->clusterBvh);
+	free(map->occluderVertices);
 
 	free(map->mapName);
 
@@ -124,7 +128,11 @@ void DestroyMap(Map *map)
 
 void AddActor(Actor *actor)
 {
-	ListAdd(GetState()->map->actors, actor);
+	LockingList *actors = &GetState()->map->actors;
+	ListLock(*actors);
+	ListAdd(*actors, actor);
+	NotifyActorAdded(actor);
+	ListUnlock(*actors);
 }
 
 void RemoveActor(Actor *actor)
@@ -141,12 +149,16 @@ void RemoveActor(Actor *actor)
 		ListRemoveAt(map->namedActorPointers, nameIdx);
 	}
 
+	ListLock(map->actors);
 	const size_t idx = ListFind(map->actors, actor);
 	if (idx == SIZE_MAX)
 	{
+		ListUnlock(map->actors);
 		return;
 	}
 	ListRemoveAt(map->actors, idx);
+	NotifyActorRemoved(actor);
+	ListUnlock(map->actors);
 	FreeActor(actor);
 
 	Player *plr = &GetState()->map->player;
@@ -194,6 +206,16 @@ void GetActorsByName(const char *name, const Map *map, List *actors)
 	ListUnlock(map->namedActorNames);
 }
 
+void GetMapRenderState(const Map *map, MapRenderState *state)
+{
+	state->fogColor = map->fogColor;
+	state->fogStart = map->fogStart;
+	state->fogEnd = map->fogEnd;
+	state->lightColor = map->lightColor;
+	state->exposure = map->exposure;
+	state->viewmodel = map->viewmodel;
+}
+
 void RenderMap(Map *map, const Camera *camera)
 {
 	JoltDebugRendererDrawBodies(map->physicsSystem);
@@ -32,6 +32,11 @@ void DefaultOptions(Options *options)
 	options->fov = 90.0f;
 	options->anisotropy = ANISOTROPY_16X;
 	options->maxFps = 0;
+	options->textureBudgetMiB = 512;
+	options->dynamicDetail = false;
+	options->dynamicDetailMinScale = 0.5f;
+	options->dynamicDetailMaxScale = 1.0f;
+	options->dynamicDetailHysteresis = 0.1f;
 #ifdef BUILDSTYLE_DEBUG
 	options->vsync = false;
 	options->limitFpsWhenUnfocused = false;
@@ -78,6 +83,16 @@ bool ValidateOptions(const Options *options)
 	}
 
 
+	if (options->dynamicDetailMinScale < 0.25 ||
+		options->dynamicDetailMinScale > options->dynamicDetailMaxScale ||
+		options->dynamicDetailMaxScale > 2.0)
+	{
+		return false;
+	}
+	if (options->dynamicDetailHysteresis < 0 || options->dynamicDetailHysteresis > 0.5)
+	{
+		return false;
+	}
 	if (options->sfxVolume < 0 || options->sfxVolume > 1)
 	{
 		return false;
@@ -119,6 +134,11 @@ void LoadOptions(Options *options)
 		options->fov = KvGetFloat(list, "fov", 90.0f);
 		options->anisotropy = KvGetByte(list, "anisotropy", ANISOTROPY_16X);
 		options->maxFps = KvGetInt(list, "max_fps", 0);
+		options->textureBudgetMiB = KvGetInt(list, "texture_budget_mib", 512);
+		options->dynamicDetail = KvGetBool(list, "dynamic_detail", false);
+		options->dynamicDetailMinScale = KvGetFloat(list, "dynamic_detail_min_scale", 0.5f);
+		options->dynamicDetailMaxScale = KvGetFloat(list, "dynamic_detail_max_scale", 1.0f);
+		options->dynamicDetailHysteresis = KvGetFloat(list, "dynamic_detail_hysteresis", 0.1f);
 
 		options->musicVolume = KvGetFloat(list, "music_volume", 1.0f);
 		options->sfxVolume = KvGetFloat(list, "sfx_volume", 1.0f);
@@ -162,6 +182,11 @@ void SaveOptions(Options *options)
 	KvSetFloat(list, "fov", options->fov);
 	KvSetByte(list, "anisotropy", options->anisotropy);
 	KvSetInt(list, "max_fps", options->maxFps);
+	KvSetInt(list, "texture_budget_mib", options->textureBudgetMiB);
+	KvSetBool(list, "dynamic_detail", options->dynamicDetail);
+	KvSetFloat(list, "dynamic_detail_min_scale", options->dynamicDetailMinScale);
+	KvSetFloat(list, "dynamic_detail_max_scale", options->dynamicDetailMaxScale);
+	KvSetFloat(list, "dynamic_detail_hysteresis", options->dynamicDetailHysteresis);
 
 	KvSetFloat(list, "music_volume", options->musicVolume);
 	KvSetFloat(list, "sfx_volume", options->sfxVolume);
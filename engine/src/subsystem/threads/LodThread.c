@@ -49,7 +49,7 @@ int LodThreadMain(void * /*data*/)
 		const LockingList *actors = &state->map->actors;
 		ListLock(*actors);
 		const size_t actorCount = actors->length;
-		const float lodMultiplier = state->options.lodMultiplier;
+		const float lodMultiplier = state->options.lodMultiplier * state->detailScale;
 		bool shouldReloadActors = false;
 		Vector3 actorPosition = {};
 		Vector3 offsetFromCamera = {};
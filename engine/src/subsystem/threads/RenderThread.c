@@ -0,0 +1,157 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/graphics/RenderQueue.h>
+#include <engine/graphics/vulkan/Vulkan.h>
+#include <engine/helpers/Arguments.h>
+#include <engine/subsystem/Logging.h>
+#include <engine/subsystem/threads/RenderThread.h>
+#include <engine/subsystem/Timing.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// The renderer actions that reload resources the main thread uses, so the main thread has to wait while they run
+#define RENDER_THREAD_BLOCKING_ACTIONS (QUEUED_ACTION_CLEAR_ALL_TEXTURES | QUEUED_ACTION_CLEAR_ALL_MODELS)
+
+/// The most frames that can be handed to the render thread without having finished, which leaves one command buffer of
+/// the render queue for the main thread to record into
+#define RENDER_THREAD_MAX_QUEUED_FRAMES (RENDER_QUEUE_BUFFER_COUNT - 1)
+
+typedef struct SubmittedFrame SubmittedFrame;
+
+/// A frame that was handed to the render thread
+struct SubmittedFrame
+{
+	/// The commands of the frame
+	const RenderCommandBuffer *commands;
+	/// Whether the frame has to handle the queued renderer actions
+	bool handleQueuedActions;
+	/// The stats of the frame, which the render thread copies here once it has finished the frame
+	RenderStats stats;
+};
+
+static bool shouldExit;
+static bool serialRender;
+static SDL_Thread *renderThread;
+/// Signalled once for each frame that is handed to the render thread
+static SDL_Semaphore *frameSubmittedSemaphore;
+/// Signalled once for each frame that the render thread finishes
+static SDL_Semaphore *frameDoneSemaphore;
+/// The frames that were handed to the render thread, used as a circular queue
+static SubmittedFrame frameQueue[RENDER_THREAD_MAX_QUEUED_FRAMES];
+/// The number of frames handed to the render thread so far, which the main thread uses to pick the next entry of
+/// @c frameQueue
+static size_t submittedFrameCount;
+/// The number of frames the render thread has started so far, which the render thread uses to pick the next entry of
+/// @c frameQueue
+static size_t renderedFrameCount;
+/// The number of frames that have been handed to the render thread and that the main thread has not waited for yet
+static size_t queuedFrames;
+
+/**
+ * Render the oldest frame that was handed to the render thread and has not been rendered yet
+ */
+static void RenderFrame()
+{
+	const uint64_t startTime = GetTimeNs();
+	SubmittedFrame *frame = &frameQueue[renderedFrameCount++ % RENDER_THREAD_MAX_QUEUED_FRAMES];
+	memset(&renderStats, 0, sizeof(RenderStats));
+	if ((!frame->handleQueuedActions || VK_HandleQueuedActions()) && VK_FrameStart())
+	{
+		RenderQueueExecute(frame->commands);
+		VK_FrameEnd();
+	}
+	renderStats.frameNs = GetTimeNs() - startTime;
+	// The main thread may read the stats of this frame while the next one is rendered, so it reads this copy
+	frame->stats = renderStats;
+}
+
+// ReSharper disable once CppDFAConstantFunctionResult
+static int RenderThreadMain(void * /*data*/)
+{
+	while (true)
+	{
+		SDL_WaitSemaphore(frameSubmittedSemaphore);
+		if (shouldExit)
+		{
+			return 0;
+		}
+		RenderFrame();
+		SDL_SignalSemaphore(frameDoneSemaphore);
+	}
+}
+
+/**
+ * Wait for the oldest frame that was handed to the render thread to finish
+ */
+static void WaitForOldestFrame()
+{
+	SDL_WaitSemaphore(frameDoneSemaphore);
+	// Frames finish in the order they were handed over, and the entry of this frame is not reused until it is
+	// submitted again, which only this thread does
+	const size_t oldestFrame = submittedFrameCount - queuedFrames;
+	lastRenderStats = frameQueue[oldestFrame % RENDER_THREAD_MAX_QUEUED_FRAMES].stats;
+	queuedFrames--;
+}
+
+void RenderThreadInit()
+{
+	serialRender = HasCliArg("--serial-render");
+	LogDebug("Starting render thread%s...\n", serialRender ? " in serial mode" : "");
+	frameSubmittedSemaphore = SDL_CreateSemaphore(0);
+	frameDoneSemaphore = SDL_CreateSemaphore(0);
+	renderThread = SDL_CreateThread(RenderThreadMain, "GameRender", NULL);
+}
+
+void RenderThreadDestroy()
+{
+	if (renderThread == NULL)
+	{
+		return;
+	}
+	LogDebug("Terminating render thread...\n");
+	RenderThreadWaitIdle();
+	shouldExit = true;
+	SDL_SignalSemaphore(frameSubmittedSemaphore);
+	SDL_WaitThread(renderThread, NULL);
+	renderThread = NULL;
+	SDL_DestroySemaphore(frameSubmittedSemaphore);
+	SDL_DestroySemaphore(frameDoneSemaphore);
+	RenderQueueDestroy();
+}
+
+void RenderThreadSubmitFrame()
+{
+	const bool handleQueuedActions = (rendererQueuedActions & RENDER_THREAD_BLOCKING_ACTIONS) != 0;
+	if (handleQueuedActions)
+	{
+		RenderThreadWaitIdle();
+	} else if (queuedFrames == RENDER_THREAD_MAX_QUEUED_FRAMES)
+	{
+		// The command buffer that the next frame is recorded into is the one of the oldest frame
+		WaitForOldestFrame();
+	}
+	SubmittedFrame *frame = &frameQueue[submittedFrameCount++ % RENDER_THREAD_MAX_QUEUED_FRAMES];
+	frame->commands = RenderQueueSwap();
+	frame->handleQueuedActions = handleQueuedActions;
+	queuedFrames++;
+	SDL_SignalSemaphore(frameSubmittedSemaphore);
+	if (serialRender || handleQueuedActions)
+	{
+		RenderThreadWaitIdle();
+	}
+}
+
+void RenderThreadWaitIdle()
+{
+	while (queuedFrames != 0)
+	{
+		WaitForOldestFrame();
+	}
+}
@@ -0,0 +1,126 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/helpers/Arguments.h>
+#include <engine/helpers/MathEx.h>
+#include <engine/subsystem/Logging.h>
+#include <engine/subsystem/threads/RenderWorkers.h>
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+static bool shouldExit;
+static int threadCount;
+static SDL_Thread *threads[RENDER_WORKERS_MAX_THREADS];
+/// Signalled once for each worker that should take part in the current job
+static SDL_Semaphore *startSemaphore;
+/// Signalled by each worker that took part in the current job once it has stopped making calls of the job
+static SDL_Semaphore *doneSemaphore;
+
+static RenderJobFunction jobFunction;
+static void *jobData;
+static int jobCount;
+/// The next index of the current job to hand out
+static SDL_AtomicInt nextIndex;
+
+/**
+ * Make calls of the current job until every index has been handed out
+ */
+static void RunJobCalls()
+{
+	int index = SDL_AddAtomicInt(&nextIndex, 1);
+	while (index < jobCount)
+	{
+		jobFunction(jobData, index);
+		index = SDL_AddAtomicInt(&nextIndex, 1);
+	}
+}
+
+// ReSharper disable once CppDFAConstantFunctionResult
+static int RenderWorkerMain(void * /*data*/)
+{
+	while (true)
+	{
+		SDL_WaitSemaphore(startSemaphore);
+		if (shouldExit)
+		{
+			return 0;
+		}
+		RunJobCalls();
+		SDL_SignalSemaphore(doneSemaphore);
+	}
+}
+
+void RenderWorkersInit()
+{
+	const int defaultThreadCount = clamp(SDL_GetNumLogicalCPUCores() - 1, 1, RENDER_WORKERS_MAX_THREADS);
+	threadCount = clamp(GetCliArgInt("--render-workers", defaultThreadCount), 0, RENDER_WORKERS_MAX_THREADS);
+	LogInfo("Starting %d render worker threads\n", threadCount);
+	startSemaphore = SDL_CreateSemaphore(0);
+	doneSemaphore = SDL_CreateSemaphore(0);
+	for (int i = 0; i < threadCount; i++)
+	{
+		threads[i] = SDL_CreateThread(RenderWorkerMain, "GameRenderWorker", NULL);
+	}
+}
+
+void RenderWorkersDestroy()
+{
+	if (shouldExit)
+	{
+		return;
+	}
+	LogDebug("Terminating render worker threads...\n");
+	shouldExit = true;
+	for (int i = 0; i < threadCount; i++)
+	{
+		SDL_SignalSemaphore(startSemaphore);
+	}
+	for (int i = 0; i < threadCount; i++)
+	{
+		SDL_WaitThread(threads[i], NULL);
+	}
+	SDL_DestroySemaphore(startSemaphore);
+	SDL_DestroySemaphore(doneSemaphore);
+}
+
+void RenderWorkersRun(const RenderJobFunction function, void *data, const size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (threadCount == 0 || count == 1)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			function(data, i);
+		}
+		return;
+	}
+
+	// Every worker of the previous job has stopped making calls, so nothing reads the job while it is replaced, and
+	// signalling the start semaphore orders these writes before any worker reads them
+	jobCount = (int)count;
+	jobFunction = function;
+	jobData = data;
+	SDL_SetAtomicInt(&nextIndex, 0);
+	const int wakeCount = min((int)count - 1, threadCount);
+	for (int i = 0; i < wakeCount; i++)
+	{
+		SDL_SignalSemaphore(startSemaphore);
+	}
+
+	RunJobCalls();
+	// Each call finishes before the thread making it takes another index, so once every woken worker has stopped the
+	// job is done. Waiting for workers that wake up late also keeps them from taking an index of the next job while
+	// checking it against the count of this one.
+	for (int i = 0; i < wakeCount; i++)
+	{
+		SDL_WaitSemaphore(doneSemaphore);
+	}
+}
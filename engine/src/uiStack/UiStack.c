@@ -3,8 +3,10 @@
 //
 
 #include <engine/assets/AssetReader.h>
+#include <engine/assets/TextureLoader.h>
 #include <engine/graphics/Drawing.h>
 #include <engine/graphics/RenderingHelpers.h>
+#include <engine/graphics/RenderQueue.h>
 #include <engine/structs/List.h>
 #include <engine/structs/Vector2.h>
 #include <engine/subsystem/Error.h>
@@ -17,6 +19,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <engine/uiStack/controls/Button.h>
 #include <engine/uiStack/controls/CheckBox.h>
@@ -93,6 +96,8 @@ UiStack *CreateUiStack()
 	stack->activeControl = -1u;
 	stack->activeControlState = NORMAL;
 	stack->focusedControl = -1u;
+	stack->layoutWindowSize = v2s(0);
+	stack->layoutDirty = true;
 	UiStackResetFocus(stack);
 	return stack;
 }
@@ -101,8 +106,9 @@ void DestroyUiStack(UiStack *stack)
 {
 	for (size_t i = 0; i < stack->controls.length; i++)
 	{
-		const Control *c = ListGetPointer(stack->controls, i);
+		Control *c = ListGetPointer(stack->controls, i);
 		CONTROL_DESTROY_FUNCTIONS[c->type](c);
+		RenderQueueFreeBuffer(&c->geometry);
 	}
 	ListAndContentsFree(stack->controls);
 	free(stack);
@@ -136,11 +142,17 @@ bool ProcessUiStack(UiStack *stack)
 	}
 
 
-	for (size_t i = 0; i < stack->controls.length; i++)
+	const Vector2 windowSize = v2(ScaledWindowWidthFloat(), ScaledWindowHeightFloat());
+	if (stack->layoutDirty || windowSize.x != stack->layoutWindowSize.x || windowSize.y != stack->layoutWindowSize.y)
 	{
-		Control *c = ListGetPointer(stack->controls, i);
+		for (size_t i = 0; i < stack->controls.length; i++)
+		{
+			Control *c = ListGetPointer(stack->controls, i);
 
-		c->anchoredPosition = CalculateControlPosition(c);
+			c->anchoredPosition = CalculateControlPosition(c);
+		}
+		stack->layoutWindowSize = windowSize;
+		stack->layoutDirty = false;
 	}
 
 	if (IsMouseButtonPressed(mainThreadInput, SDL_BUTTON_LEFT) || IsButtonPressed(mainThreadInput, CONTROLLER_OK))
@@ -253,24 +265,61 @@ void SetFocusedControl(UiStack *stack, const uint32_t index)
 	}
 }
 
+/**
+ * Check whether the draw commands that a control last recorded are out of date
+ * @param c The control to check
+ * @param state The state that the control would be drawn with
+ * @param focused Whether the control has focus
+ * @param windowSize The scaled size of the window
+ * @return Whether the control has to be drawn again
+ */
+static inline bool ControlNeedsRedraw(const Control *c,
+									  const ControlState state,
+									  const bool focused,
+									  const Vector2 windowSize)
+{
+	return c->dirty ||
+		   c->drawnState != state ||
+		   c->drawnFocused != focused ||
+		   c->drawnPosition.x != c->anchoredPosition.x ||
+		   c->drawnPosition.y != c->anchoredPosition.y ||
+		   c->drawnWindowSize.x != windowSize.x ||
+		   c->drawnWindowSize.y != windowSize.y ||
+		   c->drawnTextureGeneration != textureLoaderGeneration;
+}
+
 void DrawUiStack(const UiStack *stack)
 {
+	const Vector2 windowSize = v2(ScaledWindowWidthFloat(), ScaledWindowHeightFloat());
 	for (size_t i = 0; i < stack->controls.length; i++)
 	{
-		const Control *c = ListGetPointer(stack->controls, i);
-		CONTROL_DRAW_FUNCTIONS[c->type](c,
-										i == stack->activeControl ? stack->activeControlState : NORMAL,
-										c->anchoredPosition);
-
-		// if this is the focused control, draw a border around it
-		if (i == stack->focusedControl)
+		Control *c = ListGetPointer(stack->controls, i);
+		const ControlState state = i == stack->activeControl ? stack->activeControlState : NORMAL;
+		const bool focused = i == stack->focusedControl;
+		if (ControlNeedsRedraw(c, state, focused, windowSize))
 		{
-			DrawNinePatchTexture(v2(c->anchoredPosition.x - 4, c->anchoredPosition.y - 4),
-								 v2(c->size.x + 8, c->size.y + 8),
-								 16,
-								 16,
-								 TEXTURE("interface/focus_rect"));
+			RenderQueueBeginCapture(&c->geometry);
+			CONTROL_DRAW_FUNCTIONS[c->type](c, state, c->anchoredPosition);
+
+			// if this is the focused control, draw a border around it
+			if (focused)
+			{
+				DrawNinePatchTexture(v2(c->anchoredPosition.x - 4, c->anchoredPosition.y - 4),
+									 v2(c->size.x + 8, c->size.y + 8),
+									 16,
+									 16,
+									 TEXTURE("interface/focus_rect"));
+			}
+			RenderQueueEndCapture();
+
+			c->dirty = false;
+			c->drawnState = state;
+			c->drawnFocused = focused;
+			c->drawnPosition = c->anchoredPosition;
+			c->drawnWindowSize = windowSize;
+			c->drawnTextureGeneration = textureLoaderGeneration;
 		}
+		RenderQueueReplay(&c->geometry);
 	}
 }
 
@@ -325,17 +374,26 @@ Control *CreateEmptyControl()
 	Control *c = malloc(sizeof(Control));
 	CheckAlloc(c);
 	c->controlData = NULL;
+	c->dirty = true;
+	memset(&c->geometry, 0, sizeof(RenderCommandBuffer));
 	return c;
 }
 
+inline void MarkControlDirty(Control *control)
+{
+	control->dirty = true;
+}
+
 void UiStackPush(UiStack *stack, Control *control)
 {
 	ListAdd(stack->controls, control);
+	stack->layoutDirty = true;
 }
 
-void UiStackRemove(UiStack *stack, const Control *control)
+void UiStackRemove(UiStack *stack, Control *control)
 {
 	CONTROL_DESTROY_FUNCTIONS[control->type](control);
+	RenderQueueFreeBuffer(&control->geometry);
 
 	ListRemoveAt(stack->controls, ListFind(stack->controls, control));
 }
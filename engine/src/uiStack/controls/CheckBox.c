@@ -56,6 +56,7 @@ void UpdateCheckbox(UiStack *stack, Control *c, Vector2 /*localMousePos*/, uint3
 	{
 		(void)PlaySound(SOUND("sfx/click"), SOUND_CATEGORY_UI);
 		data->checked = !data->checked;
+		MarkControlDirty(c);
 
 		ConsumeMouseButton(mainThreadInput, SDL_BUTTON_LEFT);
 		ConsumeKey(mainThreadInput, SDL_SCANCODE_SPACE);
@@ -67,17 +67,19 @@ void UpdateRadioButton(UiStack *stack, Control *c, Vector2 /*localMousePos*/, ui
 
 		(void)PlaySound(SOUND("sfx/click"), SOUND_CATEGORY_UI);
 		data->checked = true;
+		MarkControlDirty(c);
 
 		// Find all radio buttons with the same group id and uncheck them
 		for (uint32_t i = 0; i < stack->controls.length; i++)
 		{
-			const Control *control = ListGetPointer(stack->controls, i);
+			Control *control = ListGetPointer(stack->controls, i);
 			if (control->type == RADIO_BUTTON)
 			{
 				RadioButtonData *radioData = control->controlData;
-				if (radioData->groupId == data->groupId && radioData->id != data->id)
+				if (radioData->groupId == data->groupId && radioData->id != data->id && radioData->checked)
 				{
 					radioData->checked = false;
+					MarkControlDirty(control);
 				}
 			}
 		}
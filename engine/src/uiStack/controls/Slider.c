@@ -98,6 +98,7 @@ void DestroySlider(const Control *c)
 void UpdateSlider(UiStack *stack, Control *c, Vector2 /*localMousePos*/, const uint32_t ctlIndex)
 {
 	SliderData *data = c->controlData;
+	const double oldValue = data->value;
 
 	// handle l and r arrow keys
 	if (stack->focusedControl == ctlIndex)
@@ -140,6 +141,10 @@ void UpdateSlider(UiStack *stack, Control *c, Vector2 /*localMousePos*/, const u
 
 	if (stack->activeControl != ctlIndex)
 	{
+		if (data->value != oldValue)
+		{
+			MarkControlDirty(c);
+		}
 		return;
 	}
 
@@ -178,6 +183,10 @@ void UpdateSlider(UiStack *stack, Control *c, Vector2 /*localMousePos*/, const u
 	}
 
 	data->value = clamp(data->value, data->min, data->max);
+	if (data->value != oldValue)
+	{
+		MarkControlDirty(c);
+	}
 }
 
 void DrawSlider(const Control *c, const ControlState /*state*/, const Vector2 position)
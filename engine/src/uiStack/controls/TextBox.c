@@ -66,7 +66,7 @@ void DrawTextBox(const Control *control, ControlState /*state*/, const Vector2 p
 
 	const Vector2 textSize = MeasureTextNChars(data->text, 16, smallFont, data->input.cursor);
 
-	if (data->isActive && (GetTimeMs() % 1000) < 500)
+	if (data->isActive && data->cursorVisible)
 	{
 		DrawTextAligned("_",
 						16,
@@ -82,12 +82,18 @@ void DrawTextBox(const Control *control, ControlState /*state*/, const Vector2 p
 void UpdateTextBox(UiStack *stack, Control *control, Vector2 /*localMousePosition*/, const uint32_t controlIndex)
 {
 	TextBoxData *data = (TextBoxData *)control->controlData;
+	const bool wasActive = data->isActive;
 	if (stack->focusedControl != controlIndex)
 	{
 		data->isActive = false;
+		if (wasActive)
+		{
+			MarkControlDirty(control);
+		}
 		return;
 	}
 	data->isActive = true;
+	const size_t oldCursor = data->input.cursor;
 
 	if (IsKeyPressed(mainThreadInput, SDL_SCANCODE_LCTRL) || IsKeyPressed(mainThreadInput, SDL_SCANCODE_RCTRL))
 	{
@@ -150,6 +156,7 @@ void UpdateTextBox(UiStack *stack, Control *control, Vector2 /*localMousePositio
 					data->text + data->input.cursor,
 					strlen(data->text) - data->input.cursor + 1);
 			data->input.cursor -= 1;
+			MarkControlDirty(control);
 			if (data->callback != NULL)
 			{
 				data->callback(data->text);
@@ -161,11 +168,19 @@ void UpdateTextBox(UiStack *stack, Control *control, Vector2 /*localMousePositio
 		memmove(data->text + data->input.cursor,
 				data->text + data->input.cursor + 1,
 				strlen(data->text) - data->input.cursor);
+		MarkControlDirty(control);
 		if (data->callback != NULL)
 		{
 			data->callback(data->text);
 		}
 	}
+
+	const bool cursorVisible = (GetTimeMs() % 1000) < 500;
+	if (!wasActive || data->input.cursor != oldCursor || data->cursorVisible != cursorVisible)
+	{
+		data->cursorVisible = cursorVisible;
+		MarkControlDirty(control);
+	}
 }
 
 void DestroyTextBox(const Control *control)
@@ -180,8 +195,10 @@ void FocusTextBox(const Control *control)
 	SetTextInput(&((TextBoxData *)control->controlData)->input); // very readable yes
 }
 
-void UnfocusTextBox(const Control * /*control*/)
+void UnfocusTextBox(const Control *control)
 {
+	// The text box is not updated once it loses focus unless it is hovered, so the cursor has to be hidden here
+	((TextBoxData *)control->controlData)->isActive = false;
 	StopTextInput();
 }
 
@@ -205,6 +222,7 @@ void TextBoxTextInputCallback(TextInput *data, SDL_TextInputEvent *event)
 	memccpy(textBoxData->text + data->cursor, event->text, 0, insertLen);
 
 	data->cursor += insertLen;
+	MarkControlDirty(data->userData);
 	if (textBoxData->callback != NULL)
 	{
 		textBoxData->callback(textBoxData->text);
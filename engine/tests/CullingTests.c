@@ -0,0 +1,427 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <cglm/cglm.h>
+#include <cglm/clipspace/persp_lh_zo.h>
+#include <engine/graphics/Culling.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <joltc/Math/Vector3.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "TestSupport.h"
+
+#define RANDOM_BOX_COUNT 4000
+/// The aspect ratio of the test camera, which matches the occlusion buffer so that its pixels are square
+#define ASPECT_RATIO ((float)OCCLUSION_BUFFER_WIDTH / OCCLUSION_BUFFER_HEIGHT)
+/// The distance from the camera to the occluder quad
+#define OCCLUDER_DISTANCE 10.0f
+/// Half the width and height of the occluder quad
+#define OCCLUDER_HALF_SIZE 5.0f
+/// The number of points along each axis of a box that are checked against the occluder quad
+#define BOX_SAMPLES 9
+
+static OcclusionBuffer occlusionBuffer;
+
+static float RandomFloat(const float min, const float max)
+{
+	return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+/**
+ * Get the view projection matrix of a camera at the origin looking along +Z, with +X to the right and +Y up
+ */
+static void TestViewProjectionMatrix(mat4 viewProjectionMatrix)
+{
+	glm_perspective_lh_zo(glm_rad(90.0f), ASPECT_RATIO, NEAR_Z, FAR_Z, viewProjectionMatrix);
+}
+
+static void BoxCorner(const Vector3 *center, const Vector3 *extents, const int corner, vec4 result)
+{
+	result[0] = center->x + (corner & 1 ? extents->x : -extents->x);
+	result[1] = center->y + (corner & 2 ? extents->y : -extents->y);
+	result[2] = center->z + (corner & 4 ? extents->z : -extents->z);
+	result[3] = 1.0f;
+}
+
+/**
+ * Check whether every corner of a box is clearly outside of the same clip space plane. The near plane is at -w, the
+ * same as the planes from @c FrustumFromMatrix.
+ */
+static bool BoxClearlyOutside(mat4 viewProjectionMatrix, const Vector3 *center, const Vector3 *extents)
+{
+	int outsideFlags = ~0;
+	for (int i = 0; i < 8; i++)
+	{
+		vec4 corner;
+		vec4 clip;
+		BoxCorner(center, extents, i, corner);
+		glm_mat4_mulv(viewProjectionMatrix, corner, clip);
+		const float margin = 1e-3f * (fabsf(clip[3]) + 1.0f);
+		outsideFlags &= (clip[3] + clip[0] < -margin) |
+						(clip[3] - clip[0] < -margin) << 1 |
+						(clip[3] + clip[1] < -margin) << 2 |
+						(clip[3] - clip[1] < -margin) << 3 |
+						(clip[3] + clip[2] < -margin) << 4 |
+						(clip[3] - clip[2] < -margin) << 5;
+	}
+	return outsideFlags != 0;
+}
+
+/**
+ * Check whether any corner of a box is clearly inside of the view volume, using the real near plane at 0
+ */
+static bool BoxClearlyInside(mat4 viewProjectionMatrix, const Vector3 *center, const Vector3 *extents)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		vec4 corner;
+		vec4 clip;
+		BoxCorner(center, extents, i, corner);
+		glm_mat4_mulv(viewProjectionMatrix, corner, clip);
+		const float margin = 1e-3f * clip[3];
+		if (clip[0] > -clip[3] + margin &&
+			clip[0] < clip[3] - margin &&
+			clip[1] > -clip[3] + margin &&
+			clip[1] < clip[3] - margin &&
+			clip[2] > margin &&
+			clip[2] < clip[3] - margin)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void TestFrustumCulling()
+{
+	mat4 viewProjectionMatrix;
+	TestViewProjectionMatrix(viewProjectionMatrix);
+	Frustum frustum;
+	FrustumFromMatrix(viewProjectionMatrix, &frustum);
+
+	const Vector3 centers[] = {
+		{0.0f, 0.0f, 10.0f}, // In front of the camera
+		{0.0f, 0.0f, -10.0f}, // Behind the camera
+		{-40.0f, 0.0f, 10.0f}, // Left of the view
+		{0.0f, 30.0f, 10.0f}, // Above the view
+		{0.0f, 0.0f, FAR_Z + 20.0f}, // Past the far plane
+		{0.0f, 0.0f, 0.0f}, // Around the camera
+		{-22.0f, 0.0f, 10.0f}, // Crossing the left plane
+	};
+	const Vector3 extents[] = {
+		{1.0f, 1.0f, 1.0f},
+		{1.0f, 1.0f, 1.0f},
+		{1.0f, 1.0f, 1.0f},
+		{1.0f, 1.0f, 1.0f},
+		{10.0f, 10.0f, 10.0f},
+		{100.0f, 100.0f, 100.0f},
+		{3.0f, 1.0f, 1.0f},
+	};
+	const uint8_t expected[] = {1, 0, 0, 0, 0, 1, 1};
+	const size_t boxCount = sizeof(expected) / sizeof(*expected);
+
+	// One more box than is set, to check that the boxes added by a resize are culled
+	CullingBounds bounds = {0};
+	CullingBoundsResize(&bounds, boxCount + 1);
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		CullingBoundsSet(&bounds, i, centers + i, extents + i);
+	}
+	uint8_t visible[sizeof(expected) + 1];
+	const size_t visibleCount = CullBoundingBoxes(&frustum, &bounds, visible);
+	size_t expectedCount = 0;
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		TestCheckMessage(visible[i] == expected[i], "box %zu visibility was %d", i, visible[i]);
+		expectedCount += expected[i];
+	}
+	TestCheck(visible[boxCount] == 0);
+	TestCheck(visibleCount == expectedCount);
+
+	// Boxes that are clearly on one side of the frustum must get the same result as a test of their corners
+	CullingBoundsResize(&bounds, RANDOM_BOX_COUNT);
+	for (size_t i = 0; i < RANDOM_BOX_COUNT; i++)
+	{
+		const Vector3 center = {RandomFloat(-80.0f, 80.0f), RandomFloat(-40.0f, 40.0f), RandomFloat(-30.0f, 100.0f)};
+		const Vector3 boxExtents = {RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f)};
+		CullingBoundsSet(&bounds, i, &center, &boxExtents);
+	}
+	uint8_t *randomVisible = malloc(RANDOM_BOX_COUNT);
+	TestCheck(randomVisible != NULL);
+	CullBoundingBoxes(&frustum, &bounds, randomVisible);
+	size_t culledCount = 0;
+	for (size_t i = 0; i < RANDOM_BOX_COUNT; i++)
+	{
+		const Vector3 center = {bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]};
+		const Vector3 boxExtents = {bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]};
+		if (BoxClearlyInside(viewProjectionMatrix, &center, &boxExtents))
+		{
+			TestCheckMessage(randomVisible[i], "box %zu is inside of the frustum but was culled", i);
+		} else if (BoxClearlyOutside(viewProjectionMatrix, &center, &boxExtents))
+		{
+			TestCheckMessage(!randomVisible[i], "box %zu is outside of the frustum but was not culled", i);
+		}
+		culledCount += !randomVisible[i];
+	}
+	TestCheck(culledCount != 0 && culledCount != RANDOM_BOX_COUNT);
+
+	free(randomVisible);
+	CullingBoundsFree(&bounds);
+	TestCheck(bounds.centerX == NULL && bounds.capacity == 0);
+}
+
+static void TestTransformBoundingBox()
+{
+	// Scale, then rotate 30 degrees around Y and 45 degrees around X, then translate
+	const float cosY = cosf(glm_rad(30.0f));
+	const float sinY = sinf(glm_rad(30.0f));
+	const float cosX = cosf(glm_rad(45.0f));
+	const float sinX = sinf(glm_rad(45.0f));
+	const float scale[3] = {2.0f, 1.0f, 0.5f};
+	const float rotation[3][3] = {
+		{cosY, 0.0f, -sinY},
+		{sinY * sinX, cosX, cosY * sinX},
+		{sinY * cosX, -sinX, cosY * cosX},
+	};
+	mat4 transformMatrix = {{0}};
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			transformMatrix[column][row] = rotation[column][row] * scale[column];
+		}
+	}
+	transformMatrix[3][0] = 1.0f;
+	transformMatrix[3][1] = 2.0f;
+	transformMatrix[3][2] = 3.0f;
+	transformMatrix[3][3] = 1.0f;
+
+	const Vector3 origin = {0.5f, -1.0f, 2.0f};
+	const Vector3 extents = {1.0f, 2.0f, 3.0f};
+	Vector3 worldCenter;
+	Vector3 worldExtents;
+	TransformBoundingBox(transformMatrix, &origin, &extents, &worldCenter, &worldExtents);
+
+	// Every corner must be inside of the world box, and each face of the world box must touch a corner
+	float minimum[3] = {INFINITY, INFINITY, INFINITY};
+	float maximum[3] = {-INFINITY, -INFINITY, -INFINITY};
+	for (int i = 0; i < 8; i++)
+	{
+		vec4 corner;
+		vec3 worldCorner;
+		BoxCorner(&origin, &extents, i, corner);
+		glm_mat4_mulv3(transformMatrix, corner, 1.0f, worldCorner);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			minimum[axis] = fminf(minimum[axis], worldCorner[axis]);
+			maximum[axis] = fmaxf(maximum[axis], worldCorner[axis]);
+		}
+	}
+	const float center[3] = {worldCenter.x, worldCenter.y, worldCenter.z};
+	const float halfSize[3] = {worldExtents.x, worldExtents.y, worldExtents.z};
+	for (int axis = 0; axis < 3; axis++)
+	{
+		TestCheckMessage(fabsf(center[axis] - halfSize[axis] - minimum[axis]) < 1e-4f,
+						 "axis %d minimum is %f, expected %f",
+						 axis,
+						 center[axis] - halfSize[axis],
+						 minimum[axis]);
+		TestCheckMessage(fabsf(center[axis] + halfSize[axis] - maximum[axis]) < 1e-4f,
+						 "axis %d maximum is %f, expected %f",
+						 axis,
+						 center[axis] + halfSize[axis],
+						 maximum[axis]);
+	}
+}
+
+/**
+ * Get the two triangles of a square occluder facing the test camera, or facing away from it
+ */
+static void OccluderQuad(const bool facingCamera, Vector3 vertices[6])
+{
+	const float size = OCCLUDER_HALF_SIZE;
+	const Vector3 corners[4] = {
+		{-size, -size, OCCLUDER_DISTANCE},
+		{size, -size, OCCLUDER_DISTANCE},
+		{size, size, OCCLUDER_DISTANCE},
+		{-size, size, OCCLUDER_DISTANCE},
+	};
+	const int frontIndices[6] = {0, 2, 1, 0, 3, 2};
+	for (int i = 0; i < 6; i++)
+	{
+		vertices[i] = corners[frontIndices[facingCamera ? i : 5 - i]];
+	}
+}
+
+/**
+ * Check whether a point is hidden by the occluder quad from the test camera
+ */
+static bool PointBehindOccluder(const float x, const float y, const float z)
+{
+	if (z <= OCCLUDER_DISTANCE)
+	{
+		return false;
+	}
+	const float scale = OCCLUDER_DISTANCE / z;
+	return fabsf(x * scale) <= OCCLUDER_HALF_SIZE && fabsf(y * scale) <= OCCLUDER_HALF_SIZE;
+}
+
+/**
+ * Check whether any point of a box can be seen past the occluder quad
+ */
+static bool BoxPartlyVisible(const Vector3 *center, const Vector3 *extents)
+{
+	for (int i = 0; i < BOX_SAMPLES; i++)
+	{
+		const float x = center->x + extents->x * ((float)i / (BOX_SAMPLES - 1) * 2.0f - 1.0f);
+		for (int j = 0; j < BOX_SAMPLES; j++)
+		{
+			const float y = center->y + extents->y * ((float)j / (BOX_SAMPLES - 1) * 2.0f - 1.0f);
+			for (int k = 0; k < BOX_SAMPLES; k++)
+			{
+				const float z = center->z + extents->z * ((float)k / (BOX_SAMPLES - 1) * 2.0f - 1.0f);
+				if (!PointBehindOccluder(x, y, z))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Check whether a box is far enough behind the occluder quad, and far enough inside of its edges, that any level of the
+ * depth buffer that it is tested against only covers the quad
+ */
+static bool BoxClearlyHidden(const Vector3 *center, const Vector3 *extents)
+{
+	const float nearZ = center->z - extents->z;
+	if (nearZ < OCCLUDER_DISTANCE + 0.5f)
+	{
+		return false;
+	}
+	// With a 90 degree field of view and square pixels, a pixel covers this much of X/Z and Y/Z
+	const float pixelSize = 2.0f / OCCLUSION_BUFFER_HEIGHT;
+	const float minX = fminf((center->x - extents->x) / nearZ, (center->x - extents->x) / (center->z + extents->z));
+	const float maxX = fmaxf((center->x + extents->x) / nearZ, (center->x + extents->x) / (center->z + extents->z));
+	const float minY = fminf((center->y - extents->y) / nearZ, (center->y - extents->y) / (center->z + extents->z));
+	const float maxY = fmaxf((center->y + extents->y) / nearZ, (center->y + extents->y) / (center->z + extents->z));
+	// The level a box is tested at has texels up to the size of the box, so the box has to be two of its own sizes and
+	// a few pixels away from the edges of the quad
+	const float margin = 2.0f * fmaxf(maxX - minX, maxY - minY) + 4.0f * pixelSize;
+	const float edge = OCCLUDER_HALF_SIZE / OCCLUDER_DISTANCE;
+	return minX > -edge + margin && maxX < edge - margin && minY > -edge + margin && maxY < edge - margin;
+}
+
+static void TestOcclusionCulling()
+{
+	mat4 viewProjectionMatrix;
+	TestViewProjectionMatrix(viewProjectionMatrix);
+	Vector3 quad[6];
+
+	OccluderQuad(false, quad);
+	DrawOccluders(&occlusionBuffer, viewProjectionMatrix, quad, 2);
+	TestCheck(occlusionBuffer.trianglesDrawn == 0);
+
+	OccluderQuad(true, quad);
+	DrawOccluders(&occlusionBuffer, viewProjectionMatrix, quad, 2);
+	TestCheck(occlusionBuffer.trianglesDrawn == 2);
+
+	const Vector3 centers[] = {
+		{0.0f, 0.0f, 20.0f}, // Behind the quad
+		{0.0f, 0.0f, 5.0f}, // In front of the quad
+		{15.0f, 0.0f, 20.0f}, // Behind the quad, but to the side of it
+		{9.0f, 0.0f, 20.0f}, // Behind the edge of the quad
+		{0.0f, 0.0f, 10.0f}, // Through the quad
+		{0.0f, 0.0f, 0.0f}, // Around the camera
+		{0.0f, 0.0f, 1500.0f}, // Far behind the quad
+	};
+	const Vector3 extents[] = {
+		{1.0f, 1.0f, 1.0f},
+		{1.0f, 1.0f, 1.0f},
+		{1.0f, 1.0f, 1.0f},
+		{2.0f, 1.0f, 1.0f},
+		{0.5f, 0.5f, 0.5f},
+		{0.5f, 0.5f, 0.5f},
+		{50.0f, 50.0f, 50.0f},
+	};
+	const uint8_t expected[] = {0, 1, 1, 1, 1, 1, 0};
+	const size_t boxCount = sizeof(expected) / sizeof(*expected);
+
+	CullingBounds bounds = {0};
+	CullingBoundsResize(&bounds, boxCount);
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		CullingBoundsSet(&bounds, i, centers + i, extents + i);
+	}
+	uint8_t visible[sizeof(expected)];
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		visible[i] = 1;
+	}
+	size_t expectedHidden = 0;
+	const size_t hiddenCount = TestOcclusion(&occlusionBuffer, &bounds, visible);
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		TestCheckMessage(visible[i] == expected[i], "box %zu visibility was %d", i, visible[i]);
+		expectedHidden += !expected[i];
+	}
+	TestCheck(hiddenCount == expectedHidden);
+
+	// Boxes that are already culled are left alone
+	for (size_t i = 0; i < boxCount; i++)
+	{
+		visible[i] = 1;
+	}
+	visible[0] = 0;
+	TestCheck(TestOcclusion(&occlusionBuffer, &bounds, visible) == expectedHidden - 1);
+
+	// A box that can be seen past the quad must never be hidden, and a box well behind the quad must be
+	CullingBoundsResize(&bounds, RANDOM_BOX_COUNT);
+	for (size_t i = 0; i < RANDOM_BOX_COUNT; i++)
+	{
+		const float z = RandomFloat(2.0f, 40.0f);
+		const Vector3 center = {RandomFloat(-0.8f, 0.8f) * z, RandomFloat(-0.8f, 0.8f) * z, z};
+		const Vector3 boxExtents = {RandomFloat(0.05f, 2.0f), RandomFloat(0.05f, 2.0f), RandomFloat(0.05f, 2.0f)};
+		CullingBoundsSet(&bounds, i, &center, &boxExtents);
+	}
+	uint8_t *randomVisible = malloc(RANDOM_BOX_COUNT);
+	TestCheck(randomVisible != NULL);
+	for (size_t i = 0; i < RANDOM_BOX_COUNT; i++)
+	{
+		randomVisible[i] = 1;
+	}
+	TestOcclusion(&occlusionBuffer, &bounds, randomVisible);
+	size_t clearlyHiddenCount = 0;
+	for (size_t i = 0; i < RANDOM_BOX_COUNT; i++)
+	{
+		const Vector3 center = {bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]};
+		const Vector3 boxExtents = {bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]};
+		if (BoxPartlyVisible(&center, &boxExtents))
+		{
+			TestCheckMessage(randomVisible[i], "box %zu can be seen past the occluder but was hidden", i);
+		} else if (BoxClearlyHidden(&center, &boxExtents))
+		{
+			TestCheckMessage(!randomVisible[i], "box %zu is behind the occluder but was not hidden", i);
+			clearlyHiddenCount++;
+		}
+	}
+	TestCheck(clearlyHiddenCount != 0);
+
+	free(randomVisible);
+	CullingBoundsFree(&bounds);
+}
+
+int main()
+{
+	srand(1);
+	TestFrustumCulling();
+	TestTransformBoundingBox();
+	TestOcclusionCulling();
+	return TestFinish();
+}
@@ -0,0 +1,277 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/vulkan/DrawBatching.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan_core.h>
+#include "TestSupport.h"
+
+#define CLUSTER_COUNT 8
+#define DRAW_COUNT 12
+#define RANDOM_ROUNDS 2000
+/// The number of vertices that the triangles in the quad joining test are made of
+#define JOIN_VERTEX_COUNT 5
+
+/// The cluster drawn by each command. Clusters 2 and 5 have more than one command.
+static const uint32_t DRAW_INFO_CLUSTERS[DRAW_COUNT] = {0, 1, 2, 2, 3, 4, 5, 5, 5, 6, 7, 7};
+
+static VkDrawIndexedIndirectCommand drawInfo[DRAW_COUNT];
+
+static void InitDrawInfo()
+{
+	uint32_t firstIndex = 0;
+	for (size_t i = 0; i < DRAW_COUNT; i++)
+	{
+		drawInfo[i] = (VkDrawIndexedIndirectCommand){
+			.indexCount = 3 * (uint32_t)(i + 1),
+			.instanceCount = 1,
+			.firstIndex = firstIndex,
+		};
+		firstIndex += drawInfo[i].indexCount;
+	}
+}
+
+/**
+ * Pack the visible commands without using the last result, to compare against
+ * @param clustersVisible Whether each cluster is visible
+ * @param expected The packed commands
+ * @return The number of packed commands
+ */
+static size_t ExpectedDrawInfo(const uint8_t *clustersVisible, VkDrawIndexedIndirectCommand *expected)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < DRAW_COUNT; i++)
+	{
+		if (clustersVisible[DRAW_INFO_CLUSTERS[i]])
+		{
+			expected[count++] = drawInfo[i];
+		}
+	}
+	return count;
+}
+
+/**
+ * Pack the commands for a set of visible clusters and check the packed commands and the reported first change
+ * @param clustersVisible Whether each cluster is visible
+ * @param visibleDrawInfo The commands packed by the last call
+ * @param visibleDrawCount The number of commands packed by the last call
+ * @return The index of the first changed command
+ */
+static size_t CheckCompaction(const uint8_t *clustersVisible,
+							  VkDrawIndexedIndirectCommand *visibleDrawInfo,
+							  size_t *visibleDrawCount)
+{
+	VkDrawIndexedIndirectCommand previous[DRAW_COUNT];
+	const size_t previousCount = *visibleDrawCount;
+	memcpy(previous, visibleDrawInfo, sizeof(previous));
+
+	const size_t firstChanged = CompactDrawInfo(drawInfo,
+												DRAW_INFO_CLUSTERS,
+												DRAW_COUNT,
+												clustersVisible,
+												visibleDrawInfo,
+												visibleDrawCount);
+
+	VkDrawIndexedIndirectCommand expected[DRAW_COUNT];
+	const size_t expectedCount = ExpectedDrawInfo(clustersVisible, expected);
+	TestCheck(*visibleDrawCount == expectedCount);
+	TestCheck(memcmp(visibleDrawInfo, expected, expectedCount * sizeof(VkDrawIndexedIndirectCommand)) == 0);
+
+	// Every command before the first change must match the last call, and the first change itself must not
+	size_t expectedFirstChanged = SIZE_MAX;
+	for (size_t i = 0; i < expectedCount; i++)
+	{
+		if (i >= previousCount || previous[i].firstIndex != expected[i].firstIndex)
+		{
+			expectedFirstChanged = i;
+			break;
+		}
+	}
+	TestCheckMessage(firstChanged == expectedFirstChanged,
+					 "first changed command was %zu, expected %zu",
+					 firstChanged,
+					 expectedFirstChanged);
+	return firstChanged;
+}
+
+static void TestFixedVisibility()
+{
+	VkDrawIndexedIndirectCommand visibleDrawInfo[DRAW_COUNT] = {0};
+	size_t visibleDrawCount = 0;
+	uint8_t clustersVisible[CLUSTER_COUNT];
+
+	memset(clustersVisible, 1, sizeof(clustersVisible));
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == 0);
+	TestCheck(visibleDrawCount == DRAW_COUNT);
+
+	// Nothing changed, so nothing has to be written again
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == SIZE_MAX);
+
+	// Hiding cluster 2 moves everything after its two commands
+	clustersVisible[2] = 0;
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == 2);
+	TestCheck(visibleDrawCount == DRAW_COUNT - 2);
+
+	// Hiding the last cluster only shortens the list
+	clustersVisible[7] = 0;
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == SIZE_MAX);
+	TestCheck(visibleDrawCount == DRAW_COUNT - 4);
+
+	// Showing the last cluster again only appends to the list
+	clustersVisible[7] = 1;
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == DRAW_COUNT - 4);
+
+	memset(clustersVisible, 0, sizeof(clustersVisible));
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == SIZE_MAX);
+	TestCheck(visibleDrawCount == 0);
+
+	clustersVisible[5] = 1;
+	TestCheck(CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount) == 0);
+	TestCheck(visibleDrawCount == 3);
+}
+
+static void TestRandomVisibility()
+{
+	VkDrawIndexedIndirectCommand visibleDrawInfo[DRAW_COUNT] = {0};
+	size_t visibleDrawCount = 0;
+	uint8_t clustersVisible[CLUSTER_COUNT] = {0};
+
+	srand(1);
+	for (int round = 0; round < RANDOM_ROUNDS; round++)
+	{
+		// Change a few clusters at a time, like the camera moving between frames
+		for (int change = rand() % 3; change >= 0; change--)
+		{
+			clustersVisible[rand() % CLUSTER_COUNT] = (uint8_t)(rand() & 1);
+		}
+		CheckCompaction(clustersVisible, visibleDrawInfo, &visibleDrawCount);
+	}
+}
+
+/**
+ * Check whether two triangles are the same, allowing the vertices to be rotated but not reversed
+ */
+static bool SameTriangle(const uint32_t a[3], const uint32_t b[3])
+{
+	for (int rotation = 0; rotation < 3; rotation++)
+	{
+		if (a[0] == b[rotation] && a[1] == b[(rotation + 1) % 3] && a[2] == b[(rotation + 2) % 3])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Check whether two triangles have an edge that one of them goes along in the opposite direction to the other, which
+ * is the case for neighbouring triangles of a mesh that have the same winding
+ */
+static bool ShareReversedEdge(const uint32_t first[3], const uint32_t second[3])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			if (first[i] == second[(j + 1) % 3] && first[(i + 1) % 3] == second[j])
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Join two triangles and check that the quad draws exactly those two triangles
+ * @return Whether the triangles were joined
+ */
+static bool CheckJoin(const uint32_t first[3], const uint32_t second[3])
+{
+	uint32_t quad[4] = {0};
+	const bool joined = JoinTrianglesIntoQuad(first, second, quad);
+	TestCheckMessage(joined == ShareReversedEdge(first, second),
+					 "triangles %u %u %u and %u %u %u were %sjoined",
+					 first[0],
+					 first[1],
+					 first[2],
+					 second[0],
+					 second[1],
+					 second[2],
+					 joined ? "" : "not ");
+	if (joined)
+	{
+		const uint32_t quadFirst[3] = {quad[0], quad[1], quad[2]};
+		const uint32_t quadSecond[3] = {quad[0], quad[2], quad[3]};
+		TestCheckMessage(SameTriangle(quadFirst, first) && SameTriangle(quadSecond, second),
+						 "quad %u %u %u %u doesn't draw triangles %u %u %u and %u %u %u",
+						 quad[0],
+						 quad[1],
+						 quad[2],
+						 quad[3],
+						 first[0],
+						 first[1],
+						 first[2],
+						 second[0],
+						 second[1],
+						 second[2]);
+	}
+	return joined;
+}
+
+static void TestJoinTrianglesIntoQuad()
+{
+	const uint32_t first[3] = {0, 1, 2};
+	// The other half of the quad 0, 1, 2, 3, starting from each of its vertices
+	TestCheck(CheckJoin(first, (const uint32_t[3]){0, 2, 3}));
+	TestCheck(CheckJoin(first, (const uint32_t[3]){2, 3, 0}));
+	TestCheck(CheckJoin(first, (const uint32_t[3]){3, 0, 2}));
+	// Neighbours along the other two edges
+	TestCheck(CheckJoin(first, (const uint32_t[3]){1, 0, 4}));
+	TestCheck(CheckJoin(first, (const uint32_t[3]){2, 1, 4}));
+	// The same edge with the opposite winding, a shared vertex, and no shared vertices
+	TestCheck(!CheckJoin(first, (const uint32_t[3]){0, 3, 2}));
+	TestCheck(!CheckJoin(first, (const uint32_t[3]){0, 3, 4}));
+	TestCheck(!CheckJoin(first, (const uint32_t[3]){3, 4, 5}));
+
+	// Every pair of triangles made of a few vertices
+	uint32_t triangles[JOIN_VERTEX_COUNT * JOIN_VERTEX_COUNT * JOIN_VERTEX_COUNT][3];
+	size_t triangleCount = 0;
+	for (uint32_t a = 0; a < JOIN_VERTEX_COUNT; a++)
+	{
+		for (uint32_t b = 0; b < JOIN_VERTEX_COUNT; b++)
+		{
+			for (uint32_t c = 0; c < JOIN_VERTEX_COUNT; c++)
+			{
+				if (a != b && b != c && a != c)
+				{
+					triangles[triangleCount][0] = a;
+					triangles[triangleCount][1] = b;
+					triangles[triangleCount][2] = c;
+					triangleCount++;
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		for (size_t j = 0; j < triangleCount; j++)
+		{
+			CheckJoin(triangles[i], triangles[j]);
+		}
+	}
+}
+
+int main()
+{
+	InitDrawInfo();
+	TestFixedVisibility();
+	TestRandomVisibility();
+	TestJoinTrianglesIntoQuad();
+	return TestFinish();
+}
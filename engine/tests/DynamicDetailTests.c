@@ -0,0 +1,147 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/DynamicDetail.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "TestSupport.h"
+
+/// The frame time that every trace aims for, which is 60 frames per second
+#define TARGET_FRAME_NS 16666667ull
+/// The number of frames that the closed loop trace runs for
+#define CLOSED_LOOP_FRAMES 3000
+
+static const DynamicDetailSettings settings = {
+	.targetFrameNs = TARGET_FRAME_NS,
+	.minScale = 0.25f,
+	.maxScale = 1.0f,
+	.hysteresis = 0.1f,
+};
+
+/**
+ * Feed a controller the same frame time a number of times
+ * @return The scale after the last frame
+ */
+static float RunConstantTrace(DynamicDetailController *controller, const uint64_t frameNs, const size_t frames)
+{
+	float scale = controller->scale;
+	for (size_t i = 0; i < frames; i++)
+	{
+		scale = DynamicDetailUpdate(controller, &settings, frameNs);
+	}
+	return scale;
+}
+
+static void TestOnTarget()
+{
+	DynamicDetailController controller;
+	DynamicDetailInit(&controller, 0.5f);
+
+	// Frame times that stay inside the hysteresis band, even when they alternate every frame, never move the scale
+	for (size_t i = 0; i < 1000; i++)
+	{
+		const uint64_t frameNs = i % 2 == 0 ? TARGET_FRAME_NS * 108 / 100 : TARGET_FRAME_NS * 92 / 100;
+		TestCheck(DynamicDetailUpdate(&controller, &settings, frameNs) == 0.5f);
+	}
+}
+
+static void TestSlowTrace()
+{
+	DynamicDetailController controller;
+	DynamicDetailInit(&controller, 1.0f);
+
+	// Frames at 1.6 times the target scale the detail down by the same factor once they have been slow for
+	// DYNAMIC_DETAIL_DECREASE_FRAMES frames
+	const uint64_t slowFrameNs = TARGET_FRAME_NS * 8 / 5;
+	TestCheck(RunConstantTrace(&controller, slowFrameNs, DYNAMIC_DETAIL_DECREASE_FRAMES - 1) == 1.0f);
+	TestCheck(fabsf(RunConstantTrace(&controller, slowFrameNs, 1) - 0.625f) < 1e-6f);
+
+	// Staying slow keeps lowering the scale until it reaches the minimum, and never goes past it
+	TestCheck(RunConstantTrace(&controller, slowFrameNs, DYNAMIC_DETAIL_DECREASE_FRAMES * 10) == settings.minScale);
+}
+
+static void TestFastTrace()
+{
+	DynamicDetailController controller;
+	DynamicDetailInit(&controller, 0.5f);
+
+	// Detail comes back one step at a time, and only after DYNAMIC_DETAIL_INCREASE_FRAMES fast frames in a row
+	TestCheck(RunConstantTrace(&controller, TARGET_FRAME_NS / 2, DYNAMIC_DETAIL_INCREASE_FRAMES - 1) == 0.5f);
+	TestCheck(fabsf(RunConstantTrace(&controller, TARGET_FRAME_NS / 2, 1) - (0.5f + DYNAMIC_DETAIL_INCREASE_STEP)) <
+			  1e-6f);
+	TestCheck(RunConstantTrace(&controller, TARGET_FRAME_NS / 2, DYNAMIC_DETAIL_INCREASE_FRAMES * 100) ==
+			  settings.maxScale);
+}
+
+static void TestSpikes()
+{
+	DynamicDetailController controller;
+	DynamicDetailInit(&controller, 1.0f);
+	RunConstantTrace(&controller, TARGET_FRAME_NS, 100);
+
+	// A single hitch, like a texture upload, is smoothed out and does not cost any detail
+	for (size_t i = 0; i < 600; i++)
+	{
+		const uint64_t frameNs = i % 120 == 0 ? TARGET_FRAME_NS * 3 : TARGET_FRAME_NS;
+		TestCheck(DynamicDetailUpdate(&controller, &settings, frameNs) == 1.0f);
+	}
+
+	// Slow frames that are interrupted before the controller acts on them start the count over
+	DynamicDetailInit(&controller, 1.0f);
+	RunConstantTrace(&controller, TARGET_FRAME_NS, 100);
+	for (size_t i = 0; i < 20; i++)
+	{
+		RunConstantTrace(&controller, TARGET_FRAME_NS * 3 / 2, 3);
+		RunConstantTrace(&controller, TARGET_FRAME_NS / 2, 4);
+	}
+	TestCheck(controller.scale == 1.0f);
+}
+
+static void TestClosedLoop()
+{
+	DynamicDetailController controller;
+	DynamicDetailInit(&controller, 1.0f);
+
+	// A scene whose frame time grows with the detail scale, which needs a scale of about 0.5 to hit the target
+	const double fixedNs = (double)TARGET_FRAME_NS * 0.5;
+	const double scaledNs = (double)TARGET_FRAME_NS;
+	size_t directionChanges = 0;
+	float lastScale = controller.scale;
+	float lastChange = 0.0f;
+	srand(1);
+	for (size_t i = 0; i < CLOSED_LOOP_FRAMES; i++)
+	{
+		// Up to 5% of noise on every frame
+		const double noise = 1.0 + ((double)rand() / RAND_MAX - 0.5) * 0.1;
+		const uint64_t frameNs = (uint64_t)((fixedNs + scaledNs * controller.scale) * noise);
+		const float scale = DynamicDetailUpdate(&controller, &settings, frameNs);
+		const float change = scale - lastScale;
+		if (change != 0.0f)
+		{
+			directionChanges += lastChange != 0.0f && (change > 0.0f) != (lastChange > 0.0f);
+			lastChange = change;
+		}
+		lastScale = scale;
+	}
+
+	// The scale settles where the frame time is inside the hysteresis band, without going back and forth
+	const double settledNs = fixedNs + scaledNs * controller.scale;
+	TestCheckMessage(fabs(settledNs / (double)TARGET_FRAME_NS - 1.0) <= settings.hysteresis,
+					 "settled at a frame time of %f ms with a scale of %f",
+					 settledNs / 1000000.0,
+					 (double)controller.scale);
+	TestCheckMessage(directionChanges <= 2, "the scale changed direction %zu times", directionChanges);
+}
+
+int main()
+{
+	TestOnTarget();
+	TestSlowTrace();
+	TestFastTrace();
+	TestSpikes();
+	TestClosedLoop();
+	return TestFinish();
+}
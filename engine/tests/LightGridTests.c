@@ -0,0 +1,285 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <cglm/cglm.h>
+#include <cglm/clipspace/persp_lh_zo.h>
+#include <engine/graphics/LightGrid.h>
+#include <engine/graphics/RenderingHelpers.h>
+#include <engine/structs/Light.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestSupport.h"
+
+#define RANDOM_LIGHT_COUNT 300
+/// The number of points along each axis of a cell that are checked against each light
+#define CELL_SAMPLES 4
+/// How much the squared distance from a light to a cell can be off by before the cell is required to match
+#define DISTANCE_TOLERANCE 1e-3f
+
+typedef struct Froxel Froxel;
+
+/// The view space bounds of a light grid cell, computed separately from the grid
+struct Froxel
+{
+	/// The normalized device coordinates that the cell covers
+	float ndcMinimumX;
+	float ndcMaximumX;
+	float ndcMinimumY;
+	float ndcMaximumY;
+	/// The view space depths that the cell covers
+	float nearZ;
+	float farZ;
+	/// The view space bounding box of the cell
+	vec3 minimum;
+	vec3 maximum;
+};
+
+static LightGrid grid;
+static Froxel froxels[LIGHT_GRID_CELLS];
+static PointLight lights[RANDOM_LIGHT_COUNT];
+
+static float RandomFloat(const float min, const float max)
+{
+	return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void ComputeFroxels(const float projectionScaleX, const float projectionScaleY)
+{
+	for (size_t slice = 0; slice < LIGHT_GRID_DEPTH; slice++)
+	{
+		// The first slice ends at LIGHT_GRID_NEAR_Z, and the rest split the depth up to FAR_Z into exponential steps
+		const double ratio = (double)FAR_Z / LIGHT_GRID_NEAR_Z;
+		const double nearZ = slice == 0 ? 0.0
+										: LIGHT_GRID_NEAR_Z * pow(ratio, (double)(slice - 1) / (LIGHT_GRID_DEPTH - 1));
+		const double farZ = LIGHT_GRID_NEAR_Z * pow(ratio, (double)slice / (LIGHT_GRID_DEPTH - 1));
+		for (size_t row = 0; row < LIGHT_GRID_HEIGHT; row++)
+		{
+			for (size_t column = 0; column < LIGHT_GRID_WIDTH; column++)
+			{
+				Froxel *froxel = &froxels[(slice * LIGHT_GRID_HEIGHT + row) * LIGHT_GRID_WIDTH + column];
+				froxel->ndcMinimumX = (float)column / LIGHT_GRID_WIDTH * 2.0f - 1.0f;
+				froxel->ndcMaximumX = (float)(column + 1) / LIGHT_GRID_WIDTH * 2.0f - 1.0f;
+				froxel->ndcMinimumY = (float)row / LIGHT_GRID_HEIGHT * 2.0f - 1.0f;
+				froxel->ndcMaximumY = (float)(row + 1) / LIGHT_GRID_HEIGHT * 2.0f - 1.0f;
+				froxel->nearZ = (float)nearZ;
+				froxel->farZ = (float)farZ;
+
+				// The cell is a piece of a pyramid, so its bounds are at the corners of its near and far ends
+				const float nearX = (float)nearZ / projectionScaleX;
+				const float farX = (float)farZ / projectionScaleX;
+				const float nearY = (float)nearZ / projectionScaleY;
+				const float farY = (float)farZ / projectionScaleY;
+				froxel->minimum[0] = fminf(froxel->ndcMinimumX * nearX, froxel->ndcMinimumX * farX);
+				froxel->maximum[0] = fmaxf(froxel->ndcMaximumX * nearX, froxel->ndcMaximumX * farX);
+				froxel->minimum[1] = fminf(froxel->ndcMinimumY * nearY, froxel->ndcMinimumY * farY);
+				froxel->maximum[1] = fmaxf(froxel->ndcMaximumY * nearY, froxel->ndcMaximumY * farY);
+				froxel->minimum[2] = (float)nearZ;
+				froxel->maximum[2] = (float)farZ;
+			}
+		}
+	}
+}
+
+/**
+ * Get the squared distance from a point to the bounding box of a cell
+ */
+static float BoxDistanceSquared(const Froxel *froxel, const vec3 point)
+{
+	float distanceSquared = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float distance = fmaxf(fmaxf(froxel->minimum[axis] - point[axis], point[axis] - froxel->maximum[axis]),
+									 0.0f);
+		distanceSquared += distance * distance;
+	}
+	return distanceSquared;
+}
+
+/**
+ * Check whether a point inside of a cell is within the range of a light, by testing points spread through the cell
+ */
+static bool SampleInRange(const Froxel *froxel,
+						  const float projectionScaleX,
+						  const float projectionScaleY,
+						  const vec3 center,
+						  const float range)
+{
+	const float rangeSquared = range * range * (1.0f - DISTANCE_TOLERANCE);
+	for (int i = 0; i <= CELL_SAMPLES; i++)
+	{
+		const float z = froxel->nearZ + (froxel->farZ - froxel->nearZ) * (float)i / CELL_SAMPLES;
+		for (int j = 0; j <= CELL_SAMPLES; j++)
+		{
+			const float ndcX = froxel->ndcMinimumX +
+							   (froxel->ndcMaximumX - froxel->ndcMinimumX) * (float)j / CELL_SAMPLES;
+			for (int k = 0; k <= CELL_SAMPLES; k++)
+			{
+				const float ndcY = froxel->ndcMinimumY +
+								   (froxel->ndcMaximumY - froxel->ndcMinimumY) * (float)k / CELL_SAMPLES;
+				const float x = ndcX * z / projectionScaleX - center[0];
+				const float y = ndcY * z / projectionScaleY - center[1];
+				if (x * x + y * y + (z - center[2]) * (z - center[2]) < rangeSquared)
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+static bool CellHasLight(const size_t cell, const uint32_t light)
+{
+	for (uint32_t i = 0; i < grid.cells[cell].lightCount; i++)
+	{
+		if (grid.indices[grid.cells[cell].firstIndex + i] == light)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void TestSlices()
+{
+	TestCheck(LightGridSlice(-1.0f) == 0);
+	TestCheck(LightGridSlice(0.0f) == 0);
+	TestCheck(LightGridSlice(LIGHT_GRID_NEAR_Z * 0.99f) == 0);
+	TestCheck(LightGridSlice(LIGHT_GRID_NEAR_Z * 1.01f) == 1);
+	TestCheck(LightGridSlice((float)FAR_Z * 0.99f) == LIGHT_GRID_DEPTH - 1);
+	TestCheck(LightGridSlice((float)FAR_Z * 2.0f) == LIGHT_GRID_DEPTH - 1);
+	// The middle of every slice must fall into that slice
+	for (size_t slice = 0; slice < LIGHT_GRID_DEPTH; slice++)
+	{
+		const Froxel *froxel = &froxels[slice * LIGHT_GRID_WIDTH * LIGHT_GRID_HEIGHT];
+		const float middle = (froxel->nearZ + froxel->farZ) / 2.0f;
+		TestCheckMessage(LightGridSlice(middle) == slice, "depth %f is in slice %zu", middle, LightGridSlice(middle));
+	}
+}
+
+static void TestCellBounds()
+{
+	for (size_t cell = 0; cell < LIGHT_GRID_CELLS; cell++)
+	{
+		const Froxel *froxel = &froxels[cell];
+		const float tolerance = 1e-4f * (1.0f + froxel->farZ);
+		const bool matches = fabsf(grid.cellMinimumX[cell] - froxel->minimum[0]) < tolerance &&
+							 fabsf(grid.cellMaximumX[cell] - froxel->maximum[0]) < tolerance &&
+							 fabsf(grid.cellMinimumY[cell] - froxel->minimum[1]) < tolerance &&
+							 fabsf(grid.cellMaximumY[cell] - froxel->maximum[1]) < tolerance &&
+							 fabsf(grid.cellMinimumZ[cell] - froxel->minimum[2]) < tolerance &&
+							 fabsf(grid.cellMaximumZ[cell] - froxel->maximum[2]) < tolerance;
+		TestCheckMessage(matches, "cell %zu has the wrong bounding box", cell);
+	}
+}
+
+static void TestRandomLights(mat4 viewMatrix, const float projectionScaleX, const float projectionScaleY)
+{
+	size_t expectedIndexCount = 0;
+	for (uint32_t light = 0; light < RANDOM_LIGHT_COUNT; light++)
+	{
+		const LightGridLight *gridLight = &grid.lights[light];
+		TestCheck(memcmp(gridLight->positionRange, lights[light].position, sizeof(vec3)) == 0);
+		TestCheck(gridLight->positionRange[3] == lights[light].range);
+		TestCheck(fabsf(gridLight->colorAttenuation[0] - lights[light].color[0] * lights[light].brightnessScale) <
+				  1e-5f);
+		TestCheck(gridLight->colorAttenuation[3] == lights[light].attenuation);
+
+		vec3 center;
+		glm_mat4_mulv3(viewMatrix, lights[light].position, 1.0f, center);
+		const float range = lights[light].range;
+		const float rangeSquared = range * range;
+		for (size_t cell = 0; cell < LIGHT_GRID_CELLS; cell++)
+		{
+			const bool assigned = CellHasLight(cell, light);
+			expectedIndexCount += assigned;
+
+			// Any light that reaches into the cell must be assigned to it, which the sampled points check
+			// independently of the bounding boxes. Lights are allowed to be assigned to cells that they don't reach as
+			// long as they reach the bounding box of the cell, since the bounding box is wider than the cell.
+			if (SampleInRange(&froxels[cell], projectionScaleX, projectionScaleY, center, range))
+			{
+				TestCheckMessage(assigned, "light %u reaches cell %zu but was not assigned to it", light, cell);
+			} else if (BoxDistanceSquared(&froxels[cell], center) > rangeSquared * (1.0f + DISTANCE_TOLERANCE) + 1e-6f)
+			{
+				TestCheckMessage(!assigned, "light %u was assigned to cell %zu, which it doesn't reach", light, cell);
+			}
+		}
+	}
+	TestCheck(grid.indexCount == expectedIndexCount);
+	TestCheck(grid.droppedIndexCount == 0);
+
+	// The cells must cover the indices in order without gaps, and keep the lights of each cell in the order given
+	uint32_t nextIndex = 0;
+	for (size_t cell = 0; cell < LIGHT_GRID_CELLS; cell++)
+	{
+		TestCheck(grid.cells[cell].firstIndex == nextIndex);
+		for (uint32_t i = 1; i < grid.cells[cell].lightCount; i++)
+		{
+			TestCheck(grid.indices[nextIndex + i - 1] < grid.indices[nextIndex + i]);
+		}
+		nextIndex += grid.cells[cell].lightCount;
+	}
+	TestCheck(nextIndex == grid.indexCount);
+}
+
+static void TestOverflow(mat4 viewMatrix, mat4 projectionMatrix)
+{
+	// Lights that each cover the whole grid fill the indices, and the rest of the pairs are counted as dropped
+	const size_t lightCount = LIGHT_GRID_MAX_INDICES / LIGHT_GRID_CELLS + 2;
+	PointLight bigLights[LIGHT_GRID_MAX_INDICES / LIGHT_GRID_CELLS + 2];
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		bigLights[i] = (PointLight){
+			.position = {0.0f, 0.0f, 0.0f},
+			.range = (float)FAR_Z * 4.0f,
+		};
+	}
+	LightGridBuild(&grid, viewMatrix, projectionMatrix, bigLights, lightCount);
+	TestCheck(grid.indexCount == LIGHT_GRID_MAX_INDICES);
+	TestCheck(grid.droppedIndexCount == lightCount * LIGHT_GRID_CELLS - LIGHT_GRID_MAX_INDICES);
+
+	// Lights with no range and lights entirely behind the camera are left out of every cell
+	bigLights[0].range = 0.0f;
+	bigLights[1].position[2] = -100.0f;
+	bigLights[1].range = 10.0f;
+	LightGridBuild(&grid, viewMatrix, projectionMatrix, bigLights, 2);
+	TestCheck(grid.lightCount == 2);
+	TestCheck(grid.indexCount == 0);
+}
+
+int main()
+{
+	srand(1);
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	glm_translate_make(viewMatrix, (vec3){3.0f, -2.0f, 5.0f});
+	glm_perspective_lh_zo(glm_rad(75.0f), 16.0f / 9.0f, NEAR_Z, FAR_Z, projectionMatrix);
+	ComputeFroxels(projectionMatrix[0][0], projectionMatrix[1][1]);
+
+	for (size_t i = 0; i < RANDOM_LIGHT_COUNT; i++)
+	{
+		// Mostly small lights in front of the camera, with some behind it, past the far plane, or very large
+		const float z = i % 10 == 0 ? RandomFloat(-50.0f, (float)FAR_Z * 1.1f) : RandomFloat(-10.0f, 150.0f);
+		lights[i] = (PointLight){
+			.position = {RandomFloat(-60.0f, 60.0f), RandomFloat(-40.0f, 40.0f), z},
+			.color = {RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f)},
+			.brightnessScale = RandomFloat(0.5f, 2.0f),
+			.range = i % 25 == 0 ? RandomFloat(50.0f, 200.0f) : RandomFloat(0.1f, 15.0f),
+			.attenuation = RandomFloat(0.0f, 1.0f),
+		};
+	}
+	LightGridBuild(&grid, viewMatrix, projectionMatrix, lights, RANDOM_LIGHT_COUNT);
+	TestCheck(grid.lightCount == RANDOM_LIGHT_COUNT);
+
+	TestSlices();
+	TestCellBounds();
+	TestRandomLights(viewMatrix, projectionMatrix[0][0], projectionMatrix[1][1]);
+	TestOverflow(viewMatrix, projectionMatrix);
+	return TestFinish();
+}
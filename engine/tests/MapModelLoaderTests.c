@@ -0,0 +1,238 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/assets/DataReader.h>
+#include <engine/assets/DataWriter.h>
+#include <engine/assets/MapModelLoader.h>
+#include <engine/structs/Map.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "TestSupport.h"
+
+#define VERTEX_COUNT 257
+
+/**
+ * The largest error that a value in a range of the given size may have after being quantized and expanded again, which
+ * is half of a quantization step plus the rounding of the float math
+ */
+static float QuantizationErrorBound(const float range)
+{
+	return range * (0.5f / UINT16_MAX + 4 * FLT_EPSILON);
+}
+
+/// A texture UV that tiles outside of [0, 1], like the UVs of map faces do
+static float TestUv(const uint32_t vertex, const uint32_t axis)
+{
+	return axis == 0 ? -3.0f + 8.0f * (float)vertex / (VERTEX_COUNT - 1)
+					 : 2.0f - 3.0f * (float)((vertex * 37) % VERTEX_COUNT) / (VERTEX_COUNT - 1);
+}
+
+/// A lightmap UV, which is always in [0, 1]
+static float TestLightmapUv(const uint32_t vertex, const uint32_t axis)
+{
+	return axis == 0 ? (float)vertex / (VERTEX_COUNT - 1) : 0.123456f + 0.75f * (float)(vertex % 100) / 100.0f;
+}
+
+/**
+ * Read one map model from what a writer has written
+ * @param writer The writer holding the model
+ * @param quantized Whether to read the model with @c ReadQuantizedMapModel instead of @c ReadFloatMapModel
+ * @param model The model to read into
+ * @return Whether the model was read successfully and every written byte was read
+ */
+static bool ReadWrittenModel(const DataWriter *writer, const bool quantized, MapModel *model)
+{
+	size_t bytesRemaining = DataWriterGetBufferSize(writer);
+	DataReader *reader = CreateDataReader((void *)DataWriterGetBuffer(writer), bytesRemaining, 0);
+	const bool modelRead = quantized ? ReadQuantizedMapModel(reader, model, &bytesRemaining)
+									 : ReadFloatMapModel(reader, model, &bytesRemaining);
+	DestroyDataReader(reader);
+	return modelRead && bytesRemaining == 0;
+}
+
+static void FreeModel(const MapModel *model)
+{
+	free(model->vertices);
+	free(model->indices);
+}
+
+static void TestQuantizeRoundTrip()
+{
+	TestCheck(QuantizeUnorm16(-1.0f) == 0);
+	TestCheck(QuantizeUnorm16(0.0f) == 0);
+	TestCheck(QuantizeUnorm16(1.0f) == UINT16_MAX);
+	TestCheck(QuantizeUnorm16(2.0f) == UINT16_MAX);
+	TestCheck(DequantizeUnorm16(0, -3.0f, 5.0f) == -3.0f);
+	TestCheck(DequantizeUnorm16(UINT16_MAX, -3.0f, 5.0f) == 5.0f);
+
+	// Every value has to round to the nearest step, which truncating would break for half of the values
+	float worstError = 0;
+	for (uint32_t i = 0; i <= 100000; i++)
+	{
+		const float value = (float)i / 100000.0f;
+		worstError = fmaxf(worstError, fabsf(DequantizeUnorm16(QuantizeUnorm16(value), 0, 1) - value));
+	}
+	TestCheckMessage(worstError <= QuantizationErrorBound(1),
+					 "worst unorm16 round trip error %g is larger than %g",
+					 (double)worstError,
+					 (double)QuantizationErrorBound(1));
+}
+
+static void TestFloatModel()
+{
+	// Version 1 maps store every UV as a float, and the lightmap UVs are quantized when they are loaded
+	DataWriter *writer = CreateDataWriter();
+	WriteUint32(writer, VERTEX_COUNT);
+	for (uint32_t i = 0; i < VERTEX_COUNT; i++)
+	{
+		WriteFloat(writer, (float)i);
+		WriteFloat(writer, 1.5f);
+		WriteFloat(writer, -(float)i);
+		WriteFloat(writer, TestUv(i, 0));
+		WriteFloat(writer, TestUv(i, 1));
+		WriteFloat(writer, TestLightmapUv(i, 0));
+		WriteFloat(writer, TestLightmapUv(i, 1));
+	}
+	WriteUint32(writer, 3);
+	WriteUint32(writer, 0);
+	WriteUint32(writer, 1);
+	WriteUint32(writer, VERTEX_COUNT - 1);
+
+	MapModel model;
+	TestCheck(ReadWrittenModel(writer, false, &model));
+	FreeDataWriter(writer);
+	TestCheck(model.vertexCount == VERTEX_COUNT);
+	TestCheck(model.indexCount == 3);
+	TestCheck(model.indices[2] == VERTEX_COUNT - 1);
+	TestCheck(model.shortIndices);
+	float worstError = 0;
+	for (uint32_t i = 0; i < VERTEX_COUNT; i++)
+	{
+		const MapVertex *vertex = model.vertices + i;
+		TestCheck(vertex->position.x == (float)i && vertex->position.y == 1.5f && vertex->position.z == -(float)i);
+		TestCheck(vertex->uv.x == TestUv(i, 0) && vertex->uv.y == TestUv(i, 1));
+		for (uint32_t axis = 0; axis < 2; axis++)
+		{
+			const float lightmapUv = (float)vertex->lightmapUv[axis] / UINT16_MAX;
+			worstError = fmaxf(worstError, fabsf(lightmapUv - TestLightmapUv(i, axis)));
+		}
+	}
+	TestCheckMessage(worstError <= QuantizationErrorBound(1),
+					 "worst lightmap UV error %g is larger than %g",
+					 (double)worstError,
+					 (double)QuantizationErrorBound(1));
+	FreeModel(&model);
+
+	// A model that is cut short fails to load instead of reading past the end of the asset
+	writer = CreateDataWriter();
+	WriteUint32(writer, 2);
+	WriteFloat(writer, 0);
+	size_t bytesRemaining = DataWriterGetBufferSize(writer);
+	DataReader *reader = CreateDataReader((void *)DataWriterGetBuffer(writer), bytesRemaining, 0);
+	TestCheck(!ReadFloatMapModel(reader, &model, &bytesRemaining));
+	free(model.vertices);
+	DestroyDataReader(reader);
+	FreeDataWriter(writer);
+}
+
+/**
+ * Write a version 2 map model with the test vertices
+ * @param indexSize The size of each index in bytes
+ * @return The writer holding the model
+ */
+static DataWriter *WriteQuantizedModel(const uint8_t indexSize)
+{
+	const float uvMin[2] = {-3.0f, -1.0f};
+	const float uvMax[2] = {5.0f, 2.0f};
+	DataWriter *writer = CreateDataWriter();
+	WriteUint32(writer, VERTEX_COUNT);
+	WriteFloat(writer, uvMin[0]);
+	WriteFloat(writer, uvMin[1]);
+	WriteFloat(writer, uvMax[0]);
+	WriteFloat(writer, uvMax[1]);
+	for (uint32_t i = 0; i < VERTEX_COUNT; i++)
+	{
+		WriteFloat(writer, (float)i);
+		WriteFloat(writer, 0);
+		WriteFloat(writer, 0);
+		for (uint32_t axis = 0; axis < 2; axis++)
+		{
+			WriteUint16(writer, QuantizeUnorm16((TestUv(i, axis) - uvMin[axis]) / (uvMax[axis] - uvMin[axis])));
+		}
+		WriteUint16(writer, QuantizeUnorm16(TestLightmapUv(i, 0)));
+		WriteUint16(writer, QuantizeUnorm16(TestLightmapUv(i, 1)));
+	}
+	WriteUint8(writer, indexSize);
+	WriteUint32(writer, 3);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const uint32_t index = i * (VERTEX_COUNT - 1) / 2;
+		if (indexSize == sizeof(uint16_t))
+		{
+			WriteUint16(writer, (uint16_t)index);
+		} else
+		{
+			WriteUint32(writer, index);
+		}
+	}
+	return writer;
+}
+
+static void TestQuantizedModel()
+{
+	const uint8_t indexSizes[2] = {sizeof(uint16_t), sizeof(uint32_t)};
+	for (size_t i = 0; i < 2; i++)
+	{
+		DataWriter *writer = WriteQuantizedModel(indexSizes[i]);
+		MapModel model;
+		TestCheck(ReadWrittenModel(writer, true, &model));
+		FreeDataWriter(writer);
+		TestCheck(model.vertexCount == VERTEX_COUNT);
+		TestCheck(model.indexCount == 3);
+		TestCheck(model.indices[0] == 0);
+		TestCheck(model.indices[1] == (VERTEX_COUNT - 1) / 2);
+		TestCheck(model.indices[2] == VERTEX_COUNT - 1);
+		TestCheck(model.shortIndices);
+
+		// Texture UVs are expanded from the model's bounds, so their error is relative to the size of the bounds
+		float worstUvError[2] = {0};
+		for (uint32_t j = 0; j < VERTEX_COUNT; j++)
+		{
+			const MapVertex *vertex = model.vertices + j;
+			TestCheck(vertex->position.x == (float)j);
+			worstUvError[0] = fmaxf(worstUvError[0], fabsf(vertex->uv.x - TestUv(j, 0)));
+			worstUvError[1] = fmaxf(worstUvError[1], fabsf(vertex->uv.y - TestUv(j, 1)));
+			TestCheck(vertex->lightmapUv[0] == QuantizeUnorm16(TestLightmapUv(j, 0)));
+			TestCheck(vertex->lightmapUv[1] == QuantizeUnorm16(TestLightmapUv(j, 1)));
+		}
+		TestCheckMessage(worstUvError[0] <= QuantizationErrorBound(8.0f),
+						 "worst U error %g is larger than %g",
+						 (double)worstUvError[0],
+						 (double)QuantizationErrorBound(8.0f));
+		TestCheckMessage(worstUvError[1] <= QuantizationErrorBound(3.0f),
+						 "worst V error %g is larger than %g",
+						 (double)worstUvError[1],
+						 (double)QuantizationErrorBound(3.0f));
+		FreeModel(&model);
+	}
+
+	// An index size that is neither 16 nor 32 bits is rejected
+	DataWriter *writer = WriteQuantizedModel(3);
+	MapModel model;
+	TestCheck(!ReadWrittenModel(writer, true, &model));
+	FreeModel(&model);
+	FreeDataWriter(writer);
+}
+
+int main()
+{
+	TestQuantizeRoundTrip();
+	TestFloatModel();
+	TestQuantizedModel();
+	return TestFinish();
+}
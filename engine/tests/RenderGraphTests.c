@@ -0,0 +1,535 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/vulkan/RenderGraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan_core.h>
+#include "TestSupport.h"
+
+#define RANDOM_GRAPH_COUNT 3000
+
+#define FRAGMENT_TESTS (VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT)
+
+typedef struct ExpectedAccess ExpectedAccess;
+
+/// How each access type is expected to use an image, written out separately from the render graph's own table
+struct ExpectedAccess
+{
+	VkPipelineStageFlags stageMask;
+	VkAccessFlags accessMask;
+	VkImageLayout layout;
+	bool write;
+	bool attachment;
+};
+
+static const ExpectedAccess EXPECTED_ACCESS[] = {
+	[RENDER_GRAPH_ACCESS_COLOR_WRITE] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+										 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+										 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+										 true,
+										 true},
+	[RENDER_GRAPH_ACCESS_DEPTH_WRITE] = {FRAGMENT_TESTS,
+										 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+										 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+										 true,
+										 true},
+	[RENDER_GRAPH_ACCESS_DEPTH_READ] = {FRAGMENT_TESTS,
+										VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+										VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+										false,
+										true},
+	[RENDER_GRAPH_ACCESS_RESOLVE_WRITE] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+										   VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+										   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+										   true,
+										   true},
+	[RENDER_GRAPH_ACCESS_SAMPLED_READ] = {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+										  VK_ACCESS_SHADER_READ_BIT,
+										  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+										  false,
+										  false},
+	[RENDER_GRAPH_ACCESS_PRESENT] = {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+									 0,
+									 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+									 false,
+									 false},
+};
+
+static RenderGraph graph;
+
+static void CheckBarrier(const size_t index,
+						 const uint8_t pass,
+						 const uint8_t resource,
+						 const VkPipelineStageFlags srcStageMask,
+						 const VkAccessFlags srcAccessMask,
+						 const VkPipelineStageFlags dstStageMask,
+						 const VkAccessFlags dstAccessMask,
+						 const VkImageLayout oldLayout,
+						 const VkImageLayout newLayout)
+{
+	if (!TestCheckMessage(index < graph.barrierCount, "barrier %zu is missing", index))
+	{
+		return;
+	}
+	const RenderGraphBarrier *barrier = &graph.barriers[index];
+	TestCheckMessage(barrier->pass == pass && barrier->resource == resource,
+					 "barrier %zu is before pass %u for resource %u",
+					 index,
+					 barrier->pass,
+					 barrier->resource);
+	TestCheckMessage(barrier->srcStageMask == srcStageMask && barrier->dstStageMask == dstStageMask,
+					 "barrier %zu has stages 0x%x -> 0x%x",
+					 index,
+					 barrier->srcStageMask,
+					 barrier->dstStageMask);
+	TestCheckMessage(barrier->srcAccessMask == srcAccessMask && barrier->dstAccessMask == dstAccessMask,
+					 "barrier %zu has access 0x%x -> 0x%x",
+					 index,
+					 barrier->srcAccessMask,
+					 barrier->dstAccessMask);
+	TestCheckMessage(barrier->oldLayout == oldLayout && barrier->newLayout == newLayout,
+					 "barrier %zu has layouts %d -> %d",
+					 index,
+					 barrier->oldLayout,
+					 barrier->newLayout);
+}
+
+/// The frame that the Vulkan renderer declares with multisampling enabled
+static void TestFrameGraph()
+{
+	RenderGraphInit(&graph);
+	const uint8_t swapchain = RenderGraphAddResource(&graph,
+													 "swapchain",
+													 VK_FORMAT_B8G8R8A8_UNORM,
+													 VK_SAMPLE_COUNT_1_BIT,
+													 false);
+	const uint8_t color = RenderGraphAddResource(&graph,
+												 "color",
+												 VK_FORMAT_B8G8R8A8_UNORM,
+												 VK_SAMPLE_COUNT_4_BIT,
+												 true);
+	const uint8_t depth = RenderGraphAddResource(&graph,
+												 "depth",
+												 VK_FORMAT_D24_UNORM_S8_UINT,
+												 VK_SAMPLE_COUNT_4_BIT,
+												 true);
+	const uint8_t sky = RenderGraphAddPass(&graph, "sky");
+	RenderGraphPassAccess(&graph, sky, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t map = RenderGraphAddPass(&graph, "map");
+	RenderGraphPassAccess(&graph, map, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, map, depth, RENDER_GRAPH_ACCESS_DEPTH_WRITE);
+	const uint8_t actors = RenderGraphAddPass(&graph, "actors");
+	RenderGraphPassAccess(&graph, actors, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, actors, depth, RENDER_GRAPH_ACCESS_DEPTH_WRITE);
+	const uint8_t ui = RenderGraphAddPass(&graph, "ui");
+	RenderGraphPassAccess(&graph, ui, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t resolve = RenderGraphAddPass(&graph, "resolve");
+	RenderGraphPassAccess(&graph, resolve, swapchain, RENDER_GRAPH_ACCESS_RESOLVE_WRITE);
+	const uint8_t present = RenderGraphAddPass(&graph, "present");
+	RenderGraphPassAccess(&graph, present, swapchain, RENDER_GRAPH_ACCESS_PRESENT);
+	RenderGraphCompile(&graph);
+
+	// Everything up to the resolve is one render pass, and the only barrier is the transition for presenting
+	TestCheck(graph.groupCount == 2);
+	TestCheck(graph.passes[resolve].group == 0 && graph.passes[present].group == 1);
+	TestCheck(graph.barrierCount == 1);
+	TestCheck(graph.conservativeBarrierCount == 5);
+	CheckBarrier(0,
+				 present,
+				 swapchain,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				 0,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+	const VkSubpassDependency *dependency = &graph.externalDependency;
+	TestCheck(dependency->srcSubpass == VK_SUBPASS_EXTERNAL && dependency->dstSubpass == 0);
+	TestCheck(dependency->srcStageMask == (VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | FRAGMENT_TESTS));
+	TestCheck(dependency->dstStageMask == (VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | FRAGMENT_TESTS));
+	TestCheck(dependency->srcAccessMask ==
+			  (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT));
+	TestCheck(dependency->dstAccessMask ==
+			  (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT));
+
+	// The color and depth images have different formats, and the swapchain image is never aliased
+	TestCheck(graph.memoryCount == 3);
+	TestCheck(graph.resourceMemory[swapchain] != graph.resourceMemory[color]);
+	TestCheck(graph.resourceMemory[color] != graph.resourceMemory[depth]);
+
+	char schedule[2048];
+	const size_t length = RenderGraphDumpSchedule(&graph, schedule, sizeof(schedule));
+	TestCheck(length == strlen(schedule));
+	TestCheck(strstr(schedule, "barrier swapchain: color-attachment -> present") != NULL);
+	char shortSchedule[16];
+	TestCheck(RenderGraphDumpSchedule(&graph, shortSchedule, sizeof(shortSchedule)) == length);
+	TestCheck(strlen(shortSchedule) == sizeof(shortSchedule) - 1);
+}
+
+/// A chain of full screen passes that each sample the image written by the pass before them
+static void TestPostProcessChain()
+{
+	RenderGraphInit(&graph);
+	const VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+	const uint8_t scene = RenderGraphAddResource(&graph, "scene", format, VK_SAMPLE_COUNT_1_BIT, true);
+	const uint8_t bloom = RenderGraphAddResource(&graph, "bloom", format, VK_SAMPLE_COUNT_1_BIT, true);
+	const uint8_t blur = RenderGraphAddResource(&graph, "blur", format, VK_SAMPLE_COUNT_1_BIT, true);
+	const uint8_t history = RenderGraphAddResource(&graph, "history", format, VK_SAMPLE_COUNT_1_BIT, false);
+	const uint8_t composite = RenderGraphAddResource(&graph, "composite", format, VK_SAMPLE_COUNT_1_BIT, true);
+	const uint8_t multisampled = RenderGraphAddResource(&graph, "multisampled", format, VK_SAMPLE_COUNT_4_BIT, true);
+	const uint8_t output = RenderGraphAddResource(&graph,
+												  "output",
+												  VK_FORMAT_B8G8R8A8_UNORM,
+												  VK_SAMPLE_COUNT_1_BIT,
+												  false);
+
+	const uint8_t draw = RenderGraphAddPass(&graph, "draw");
+	RenderGraphPassAccess(&graph, draw, scene, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t threshold = RenderGraphAddPass(&graph, "threshold");
+	RenderGraphPassAccess(&graph, threshold, scene, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphPassAccess(&graph, threshold, bloom, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t blurPass = RenderGraphAddPass(&graph, "blur");
+	RenderGraphPassAccess(&graph, blurPass, bloom, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphPassAccess(&graph, blurPass, blur, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t combine = RenderGraphAddPass(&graph, "combine");
+	RenderGraphPassAccess(&graph, combine, scene, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphPassAccess(&graph, combine, blur, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphPassAccess(&graph, combine, history, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t overlay = RenderGraphAddPass(&graph, "overlay");
+	RenderGraphPassAccess(&graph, overlay, history, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphPassAccess(&graph, overlay, composite, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, overlay, multisampled, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	const uint8_t reuse = RenderGraphAddPass(&graph, "reuse");
+	RenderGraphPassAccess(&graph, reuse, multisampled, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphPassAccess(&graph, reuse, scene, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, reuse, output, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphCompile(&graph);
+
+	// Every pass samples something, so none of them can share a render pass
+	TestCheck(graph.groupCount == graph.passCount);
+	TestCheck(graph.conservativeBarrierCount == 7);
+	TestCheck(graph.barrierCount == 6);
+	CheckBarrier(0,
+				 threshold,
+				 scene,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	CheckBarrier(1,
+				 blurPass,
+				 bloom,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	// The second read of the scene is already covered by the barrier before the first read
+	CheckBarrier(2,
+				 combine,
+				 blur,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	CheckBarrier(3,
+				 overlay,
+				 history,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	CheckBarrier(4,
+				 reuse,
+				 multisampled,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	// Writing the scene again has to wait for both of the passes that sampled it
+	CheckBarrier(5,
+				 reuse,
+				 scene,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	// The composite image starts after the bloom image is done, so it takes its memory. The blur image starts in the
+	// pass that last samples the bloom image, and the scene is used until the end, so neither of them can share. The
+	// history and output images are not transient, and the multisampled image has a different sample count.
+	TestCheck(graph.memoryCount == 6);
+	TestCheck(graph.resourceMemory[composite] == graph.resourceMemory[bloom]);
+	TestCheck(graph.resourceMemory[blur] != graph.resourceMemory[bloom]);
+	TestCheck(graph.resourceMemory[scene] != graph.resourceMemory[bloom]);
+	TestCheck(graph.resourceMemory[scene] != graph.resourceMemory[blur]);
+	TestCheck(graph.resourceMemory[history] != graph.resourceMemory[bloom]);
+	TestCheck(graph.resourceMemory[multisampled] != graph.resourceMemory[bloom]);
+	TestCheck(graph.resourceMemory[output] != graph.resourceMemory[history]);
+}
+
+/// A depth prepass, followed by passes that test against the depth without writing it
+static void TestDepthReadOnly()
+{
+	RenderGraphInit(&graph);
+	const uint8_t color = RenderGraphAddResource(&graph,
+												 "color",
+												 VK_FORMAT_B8G8R8A8_UNORM,
+												 VK_SAMPLE_COUNT_1_BIT,
+												 false);
+	const uint8_t depth = RenderGraphAddResource(&graph, "depth", VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, true);
+	const uint8_t prepass = RenderGraphAddPass(&graph, "prepass");
+	RenderGraphPassAccess(&graph, prepass, depth, RENDER_GRAPH_ACCESS_DEPTH_WRITE);
+	const uint8_t opaque = RenderGraphAddPass(&graph, "opaque");
+	RenderGraphPassAccess(&graph, opaque, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, opaque, depth, RENDER_GRAPH_ACCESS_DEPTH_READ);
+	const uint8_t decals = RenderGraphAddPass(&graph, "decals");
+	RenderGraphPassAccess(&graph, decals, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, decals, depth, RENDER_GRAPH_ACCESS_DEPTH_READ);
+	const uint8_t fog = RenderGraphAddPass(&graph, "fog");
+	RenderGraphPassAccess(&graph, fog, color, RENDER_GRAPH_ACCESS_COLOR_WRITE);
+	RenderGraphPassAccess(&graph, fog, depth, RENDER_GRAPH_ACCESS_SAMPLED_READ);
+	RenderGraphCompile(&graph);
+
+	// The depth layout changes after the prepass, so the opaque pass starts a new render pass that the decals join
+	TestCheck(graph.groupCount == 3);
+	TestCheck(graph.passes[opaque].group == graph.passes[decals].group);
+	TestCheck(graph.passes[fog].group != graph.passes[decals].group);
+	TestCheck(graph.conservativeBarrierCount == 5);
+	TestCheck(graph.barrierCount == 3);
+	CheckBarrier(0,
+				 opaque,
+				 depth,
+				 FRAGMENT_TESTS,
+				 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				 FRAGMENT_TESTS,
+				 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+				 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+	// The fog pass is in its own render pass, so its color writes have to wait for the ones before it
+	CheckBarrier(1,
+				 fog,
+				 color,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	// The transition for sampling has to wait for the depth tests that read the old layout
+	CheckBarrier(2,
+				 fog,
+				 depth,
+				 FRAGMENT_TESTS,
+				 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+/**
+ * Check whether the barriers of the graph order one access to a resource before a later one, following chains of
+ * barriers whose stages overlap
+ * @param resource The resource
+ * @param firstPass The pass of the earlier access
+ * @param first How the earlier access uses the resource
+ * @param secondPass The pass of the later access
+ * @param second How the later access uses the resource
+ */
+static bool AccessesOrdered(const uint8_t resource,
+							const size_t firstPass,
+							const ExpectedAccess *first,
+							const size_t secondPass,
+							const ExpectedAccess *second)
+{
+	// The stages reached so far by a dependency chain that starts at the earlier access, and whether its writes are
+	// available yet
+	VkPipelineStageFlags chainStages = 0;
+	bool available = !first->write;
+	bool started = false;
+	for (size_t i = 0; i < graph.barrierCount; i++)
+	{
+		const RenderGraphBarrier *barrier = &graph.barriers[i];
+		if (barrier->resource != resource || barrier->pass <= firstPass || barrier->pass > secondPass)
+		{
+			continue;
+		}
+		const bool startsChain = (barrier->srcStageMask & first->stageMask) == first->stageMask;
+		if (startsChain || (started && (barrier->srcStageMask & chainStages) != 0))
+		{
+			if (startsChain && (barrier->srcAccessMask & first->accessMask) == first->accessMask)
+			{
+				available = true;
+			}
+			started = true;
+			chainStages |= barrier->dstStageMask;
+			if (available &&
+				(barrier->dstStageMask & second->stageMask) == second->stageMask &&
+				(barrier->dstAccessMask & second->accessMask) == second->accessMask)
+			{
+				return true;
+			}
+		}
+	}
+	// An access with no memory access only needs an execution dependency
+	return started && second->accessMask == 0 && (chainStages & second->stageMask) == second->stageMask;
+}
+
+/// Compile random graphs and check that every hazard between two accesses is covered by the barriers
+static void TestRandomGraphs()
+{
+	const VkFormat formats[] = {VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT};
+	for (int round = 0; round < RANDOM_GRAPH_COUNT; round++)
+	{
+		RenderGraphInit(&graph);
+		const size_t resourceCount = 1 + rand() % 6;
+		for (size_t i = 0; i < resourceCount; i++)
+		{
+			RenderGraphAddResource(&graph,
+								   "resource",
+								   formats[rand() % 2],
+								   rand() % 4 == 0 ? VK_SAMPLE_COUNT_4_BIT : VK_SAMPLE_COUNT_1_BIT,
+								   rand() % 4 != 0);
+		}
+		const size_t passCount = 1 + rand() % 12;
+		for (size_t i = 0; i < passCount; i++)
+		{
+			const uint8_t pass = RenderGraphAddPass(&graph, "pass");
+			bool accessed[RENDER_GRAPH_MAX_RESOURCES] = {0};
+			for (int j = 1 + rand() % 3; j > 0; j--)
+			{
+				const uint8_t resource = rand() % resourceCount;
+				if (!accessed[resource])
+				{
+					accessed[resource] = true;
+					RenderGraphPassAccess(&graph, pass, resource, rand() % (RENDER_GRAPH_ACCESS_PRESENT + 1));
+				}
+			}
+		}
+		RenderGraphCompile(&graph);
+		TestCheck(graph.barrierCount <= graph.conservativeBarrierCount);
+
+		size_t firstPass[RENDER_GRAPH_MAX_RESOURCES];
+		size_t lastPass[RENDER_GRAPH_MAX_RESOURCES];
+		VkImageLayout layouts[RENDER_GRAPH_MAX_RESOURCES];
+		VkPipelineStageFlags firstStages = 0;
+		VkAccessFlags firstAccess = 0;
+		for (size_t i = 0; i < resourceCount; i++)
+		{
+			firstPass[i] = SIZE_MAX;
+			layouts[i] = VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+		size_t barrier = 0;
+		for (size_t i = 0; i < passCount; i++)
+		{
+			const RenderGraphPass *pass = &graph.passes[i];
+			const bool joinedGroup = i > 0 && pass->group == graph.passes[i - 1].group;
+			TestCheck(pass->group == (i == 0 ? 0 : graph.passes[i - 1].group + !joinedGroup));
+
+			// Barriers must be in pass order, can only be recorded outside of a render pass, and must transition from
+			// the layout that the resource is in
+			for (; barrier < graph.barrierCount && graph.barriers[barrier].pass == i; barrier++)
+			{
+				const RenderGraphBarrier *renderGraphBarrier = &graph.barriers[barrier];
+				TestCheck(!joinedGroup);
+				TestCheck(renderGraphBarrier->oldLayout == layouts[renderGraphBarrier->resource]);
+				layouts[renderGraphBarrier->resource] = renderGraphBarrier->newLayout;
+			}
+
+			for (uint8_t j = 0; j < pass->accessCount; j++)
+			{
+				const uint8_t resource = pass->resources[j];
+				const ExpectedAccess *access = &EXPECTED_ACCESS[pass->accessTypes[j]];
+				TestCheck(!joinedGroup || access->attachment);
+				if (firstPass[resource] == SIZE_MAX)
+				{
+					firstPass[resource] = i;
+					firstStages |= access->stageMask;
+					firstAccess |= access->accessMask;
+				} else
+				{
+					TestCheck(layouts[resource] == access->layout);
+				}
+				layouts[resource] = access->layout;
+				lastPass[resource] = i;
+
+				// Every earlier access that conflicts with this one must be ordered before it, unless both are in the
+				// same render pass
+				for (size_t k = firstPass[resource]; k < i; k++)
+				{
+					const RenderGraphPass *earlierPass = &graph.passes[k];
+					for (uint8_t l = 0; l < earlierPass->accessCount; l++)
+					{
+						const ExpectedAccess *earlier = &EXPECTED_ACCESS[earlierPass->accessTypes[l]];
+						if (earlierPass->resources[l] != resource ||
+							earlierPass->group == pass->group ||
+							(!earlier->write && !access->write && earlier->layout == access->layout))
+						{
+							continue;
+						}
+						TestCheckMessage(AccessesOrdered(resource, k, earlier, i, access),
+										 "graph %d: access of resource %u in pass %zu is not ordered after pass %zu",
+										 round,
+										 resource,
+										 i,
+										 k);
+					}
+				}
+			}
+		}
+		TestCheck(barrier == graph.barrierCount);
+		TestCheck(graph.externalDependency.dstStageMask == firstStages);
+		TestCheck(graph.externalDependency.dstAccessMask == firstAccess);
+
+		// Resources may only share memory with transient resources that have the same format and sample count and that
+		// are done before they start
+		for (size_t i = 0; i < resourceCount; i++)
+		{
+			TestCheck(graph.resourceMemory[i] < graph.memoryCount);
+			for (size_t j = i + 1; j < resourceCount; j++)
+			{
+				if (graph.resourceMemory[i] != graph.resourceMemory[j])
+				{
+					continue;
+				}
+				const RenderGraphResource *a = &graph.resources[i];
+				const RenderGraphResource *b = &graph.resources[j];
+				TestCheck(a->transient && b->transient);
+				TestCheck(a->format == b->format && a->samples == b->samples);
+				// Resources that no pass uses don't need their memory
+				if (firstPass[i] != SIZE_MAX && firstPass[j] != SIZE_MAX)
+				{
+					TestCheck(lastPass[i] < firstPass[j] || lastPass[j] < firstPass[i]);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	srand(1);
+	TestFrameGraph();
+	TestPostProcessChain();
+	TestDepthReadOnly();
+	TestRandomGraphs();
+	return TestFinish();
+}
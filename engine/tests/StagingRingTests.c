@@ -0,0 +1,157 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/graphics/StagingRing.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "TestSupport.h"
+
+#define RANDOM_RING_CAPACITY 4096
+#define RANDOM_UPLOAD_COUNT 20000
+/// How many uploads may be in flight at once in the random test, like the upload command buffer ring
+#define RANDOM_PENDING_UPLOADS 8
+
+typedef struct LiveAllocation LiveAllocation;
+
+/// An allocation that the random test filled with a known pattern and has not released yet
+struct LiveAllocation
+{
+	uint8_t *memory;
+	size_t bytes;
+	uint64_t serial;
+};
+
+static void TestWrapAround()
+{
+	StagingRing ring;
+	StagingRingInit(&ring, 256);
+
+	// Allocations are rounded up to the alignment and handed out front to back
+	uint8_t *first = StagingRingAllocate(&ring, 100, 0);
+	uint8_t *second = StagingRingAllocate(&ring, 100, 1);
+	TestCheck(first == ring.memory);
+	TestCheck(second == ring.memory + 112);
+
+	// The third allocation does not fit before the end of the memory, and the start is still in use by upload 0
+	TestCheck(StagingRingAllocate(&ring, 100, 2) == NULL);
+	TestCheck(ring.regionCount == 2);
+
+	// Once upload 0 has completed, the third allocation wraps around to the start
+	StagingRingRelease(&ring, 1);
+	TestCheck(ring.regionCount == 1);
+	TestCheck(StagingRingAllocate(&ring, 100, 2) == ring.memory);
+
+	// Upload 1 still holds the middle of the memory
+	TestCheck(StagingRingAllocate(&ring, 100, 3) == NULL);
+
+	// Releasing everything starts the ring over, so even an allocation of the whole ring fits
+	StagingRingRelease(&ring, 3);
+	TestCheck(ring.regionCount == 0);
+	TestCheck(StagingRingAllocate(&ring, 256, 3) == ring.memory);
+
+	StagingRingDestroy(&ring);
+}
+
+static void TestLimits()
+{
+	StagingRing ring;
+	StagingRingInit(&ring, 1024);
+
+	TestCheck(StagingRingAllocate(&ring, 0, 0) == NULL);
+	TestCheck(StagingRingAllocate(&ring, 1025, 0) == NULL);
+	TestCheck(ring.regionCount == 0);
+
+	// Once every region is live, further allocations fail even when there is space left
+	for (uint64_t i = 0; i < STAGING_RING_MAX_REGIONS; i++)
+	{
+		TestCheck(StagingRingAllocate(&ring, 1, i) != NULL);
+	}
+	TestCheck(StagingRingAllocate(&ring, 1, STAGING_RING_MAX_REGIONS) == NULL);
+	StagingRingRelease(&ring, 1);
+	TestCheck(StagingRingAllocate(&ring, 1, STAGING_RING_MAX_REGIONS) != NULL);
+
+	StagingRingDestroy(&ring);
+}
+
+static bool PatternIntact(const LiveAllocation *allocation)
+{
+	for (size_t i = 0; i < allocation->bytes; i++)
+	{
+		if (allocation->memory[i] != (uint8_t)(allocation->serial + i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void TestRandomUploads()
+{
+	StagingRing ring;
+	StagingRingInit(&ring, RANDOM_RING_CAPACITY);
+	LiveAllocation live[STAGING_RING_MAX_REGIONS];
+	size_t liveCount = 0;
+	size_t stagedCount = 0;
+
+	for (uint64_t serial = 0; serial < RANDOM_UPLOAD_COUNT; serial++)
+	{
+		// Uploads from more than RANDOM_PENDING_UPLOADS ago have completed, so their memory has to be intact and can
+		// then be reused
+		const uint64_t pendingSerial = serial > RANDOM_PENDING_UPLOADS ? serial - RANDOM_PENDING_UPLOADS : 0;
+		size_t remaining = 0;
+		for (size_t i = 0; i < liveCount; i++)
+		{
+			if (live[i].serial < pendingSerial)
+			{
+				TestCheckMessage(PatternIntact(&live[i]),
+								 "upload %llu was overwritten",
+								 (unsigned long long)live[i].serial);
+			} else
+			{
+				live[remaining++] = live[i];
+			}
+		}
+		liveCount = remaining;
+		StagingRingRelease(&ring, pendingSerial);
+
+		const size_t bytes = 1 + (size_t)rand() % (RANDOM_RING_CAPACITY / 3);
+		uint8_t *memory = StagingRingAllocate(&ring, bytes, serial);
+		if (memory == NULL)
+		{
+			continue;
+		}
+		TestCheck(memory >= ring.memory && memory + bytes <= ring.memory + ring.capacity);
+		TestCheck((size_t)(memory - ring.memory) % STAGING_RING_ALIGNMENT == 0);
+		live[liveCount] = (LiveAllocation){
+			.memory = memory,
+			.bytes = bytes,
+			.serial = serial,
+		};
+		for (size_t i = 0; i < bytes; i++)
+		{
+			memory[i] = (uint8_t)(serial + i);
+		}
+		liveCount++;
+		stagedCount++;
+	}
+	for (size_t i = 0; i < liveCount; i++)
+	{
+		TestCheckMessage(PatternIntact(&live[i]), "upload %llu was overwritten", (unsigned long long)live[i].serial);
+	}
+	// Most uploads fit, since the ring is large enough for several uploads to be pending at once
+	TestCheck(stagedCount > RANDOM_UPLOAD_COUNT / 2);
+
+	StagingRingDestroy(&ring);
+}
+
+int main()
+{
+	srand(1);
+	TestWrapAround();
+	TestLimits();
+	TestRandomUploads();
+	return TestFinish();
+}
@@ -0,0 +1,76 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include "TestSupport.h"
+#include <engine/subsystem/Error.h>
+#include <engine/subsystem/Logging.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int checkCount;
+static int failureCount;
+
+bool TestCheckInternal(const bool condition, const char *expression, const char *file, const int line)
+{
+	checkCount++;
+	if (!condition)
+	{
+		failureCount++;
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+	}
+	return condition;
+}
+
+bool TestCheckMessageInternal(const bool condition, const char *file, const int line, const char *format, ...)
+{
+	checkCount++;
+	if (!condition)
+	{
+		failureCount++;
+		fprintf(stderr, "%s:%d: check failed: ", file, line);
+		va_list args;
+		va_start(args, format);
+		vfprintf(stderr, format, args);
+		va_end(args);
+		fputc('\n', stderr);
+	}
+	return condition;
+}
+
+int TestFinish()
+{
+	printf("%d of %d checks failed\n", failureCount, checkCount);
+	return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// The engine sources under test only use these to report errors, so the tests provide them instead of linking the
+// rest of the engine.
+
+_Noreturn void _GameAllocFailure()
+{
+	fprintf(stderr, "Memory allocation failed\n");
+	abort();
+}
+
+_Noreturn void _ErrorInternal(char *error, const char *file, const int line, const char *function)
+{
+	fprintf(stderr, "%s:%d (%s): %s\n", file, line, function, error);
+	abort();
+}
+
+void LogInternal(const char *type, const int color, const bool flush, const char *message, ...)
+{
+	(void)color;
+	(void)flush;
+	if (type != NULL)
+	{
+		fprintf(stderr, "[%s] ", type);
+	}
+	va_list args;
+	va_start(args, message);
+	vfprintf(stderr, message, args);
+	va_end(args);
+}
@@ -0,0 +1,51 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#ifndef GAME_TESTSUPPORT_H
+#define GAME_TESTSUPPORT_H
+
+#include <stdbool.h>
+
+/**
+ * Check a condition, and record a failure with its location if it is false. The test keeps running after a failure.
+ * @param condition The condition that should be true
+ */
+#define TestCheck(condition) TestCheckInternal((condition), #condition, __FILE_NAME__, __LINE__)
+
+/**
+ * Check a condition, and record a failure with a formatted message if it is false
+ * @param condition The condition that should be true
+ * @param ... A printf format string and its arguments
+ */
+#define TestCheckMessage(condition, ...) TestCheckMessageInternal((condition), __FILE_NAME__, __LINE__, __VA_ARGS__)
+
+/**
+ * Record the result of a check
+ * @param condition The result of the check
+ * @param expression The text of the checked expression
+ * @param file The file name of the check
+ * @param line The line number of the check
+ * @return The value of @c condition
+ * @warning Do not use this function directly, use the @c TestCheck macro instead
+ */
+bool TestCheckInternal(bool condition, const char *expression, const char *file, int line);
+
+/**
+ * Record the result of a check with a formatted failure message
+ * @param condition The result of the check
+ * @param file The file name of the check
+ * @param line The line number of the check
+ * @param format The printf format string of the failure message
+ * @return The value of @c condition
+ * @warning Do not use this function directly, use the @c TestCheckMessage macro instead
+ */
+bool TestCheckMessageInternal(bool condition, const char *file, int line, const char *format, ...);
+
+/**
+ * Print the number of failed checks
+ * @return The exit code of the test, which is nonzero if any check failed
+ */
+int TestFinish();
+
+#endif //GAME_TESTSUPPORT_H
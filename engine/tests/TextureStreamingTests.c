@@ -0,0 +1,182 @@
+//
+// Created by NBT22 on 10/18/26.
+//
+
+#include <engine/assets/TextureLoader.h>
+#include <engine/graphics/TextureStreaming.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "TestSupport.h"
+
+/// The size of the textures in the tests, which gives 11 levels with level 4 being the always resident 64x64 level
+#define TEXTURE_SIZE 1024
+#define TEXTURE_LEVELS 11
+#define RESIDENT_LEVEL 4
+
+static void InitTexture(StreamedTexture *texture, const float screenSize)
+{
+	StreamedTextureInit(texture, PIXEL_FORMAT_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_LEVELS, true);
+	StreamedTextureSeen(texture, screenSize);
+}
+
+/// The number of bytes that a texture needs for one more level than its current target level
+static size_t NextLevelBytes(const StreamedTexture *texture)
+{
+	return texture->chainBytes[texture->targetLevel - 1] - texture->chainBytes[texture->targetLevel];
+}
+
+static void TestInit()
+{
+	StreamedTexture texture;
+	InitTexture(&texture, 0);
+	TestCheck(texture.levelCount == TEXTURE_LEVELS);
+	TestCheck(texture.lowestLevel == RESIDENT_LEVEL);
+	TestCheck(texture.residentLevel == RESIDENT_LEVEL);
+	TestCheck(texture.chainBytes[0] > texture.chainBytes[1]);
+
+	// A texture that is not streamed always has its whole chain resident
+	StreamedTexture unstreamed;
+	StreamedTextureInit(&unstreamed, PIXEL_FORMAT_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_LEVELS, false);
+	TestCheck(unstreamed.lowestLevel == 0);
+	TestCheck(unstreamed.chainBytes[0] == texture.chainBytes[0]);
+
+	// The wanted level is the smallest level that is still at least as large as the screen size
+	InitTexture(&texture, TEXTURE_SIZE);
+	TestCheck(StreamedTextureWantedLevel(&texture) == 0);
+	InitTexture(&texture, TEXTURE_SIZE / 4);
+	TestCheck(StreamedTextureWantedLevel(&texture) == 2);
+	InitTexture(&texture, TEXTURE_SIZE / 4 + 1);
+	TestCheck(StreamedTextureWantedLevel(&texture) == 1);
+	InitTexture(&texture, 1);
+	TestCheck(StreamedTextureWantedLevel(&texture) == RESIDENT_LEVEL);
+}
+
+static void TestScreenSizeOrder()
+{
+	StreamedTexture textures[4];
+	InitTexture(&textures[0], 10);
+	InitTexture(&textures[1], 800);
+	InitTexture(&textures[2], 0);
+	InitTexture(&textures[3], 200);
+	uint32_t order[4];
+	TextureStreamingPlan(textures, 4, 0, order);
+	TestCheck(order[0] == 1);
+	TestCheck(order[1] == 3);
+	TestCheck(order[2] == 0);
+	TestCheck(order[3] == 2);
+
+	// When the budget only has room for one more level, it goes to the texture that covers the most of the screen
+	InitTexture(&textures[0], 10);
+	InitTexture(&textures[1], 800);
+	InitTexture(&textures[2], 0);
+	InitTexture(&textures[3], 200);
+	size_t budget = 0;
+	for (size_t i = 0; i < 4; i++)
+	{
+		budget += textures[i].chainBytes[RESIDENT_LEVEL];
+	}
+	budget += NextLevelBytes(&textures[1]);
+	TextureStreamingPlan(textures, 4, budget, order);
+	TestCheck(textures[1].targetLevel == RESIDENT_LEVEL - 1);
+	TestCheck(textures[3].targetLevel == RESIDENT_LEVEL);
+	TestCheck(textures[0].targetLevel == RESIDENT_LEVEL);
+
+	// Screen sizes decay, so a texture that stops being seen slowly loses its priority
+	TestCheck(textures[1].screenSize < 800.0f);
+	TestCheck(textures[1].screenSize > 700.0f);
+}
+
+static void TestOneLevelPerStep()
+{
+	StreamedTexture textures[2];
+	InitTexture(&textures[0], 2000);
+	InitTexture(&textures[1], 1000);
+	const size_t oneLevelBytes = NextLevelBytes(&textures[0]);
+	const size_t secondLevelBytes = textures[0].chainBytes[RESIDENT_LEVEL - 2] -
+									textures[0].chainBytes[RESIDENT_LEVEL - 1];
+
+	// There is room for one more level on each texture, or for two more on the first one. Handing out the whole budget
+	// in screen size order would give both levels to the first texture, so both getting one shows that levels are
+	// handed out one per texture per step.
+	const size_t budget = textures[0].chainBytes[RESIDENT_LEVEL] +
+						  textures[1].chainBytes[RESIDENT_LEVEL] +
+						  oneLevelBytes * 2 +
+						  secondLevelBytes -
+						  1;
+	uint32_t order[2];
+	const size_t residentBytes = TextureStreamingPlan(textures, 2, budget, order);
+	TestCheck(textures[0].targetLevel == RESIDENT_LEVEL - 1);
+	TestCheck(textures[1].targetLevel == RESIDENT_LEVEL - 1);
+	TestCheck(residentBytes == budget - secondLevelBytes + 1);
+
+	// With one more byte, the next step has room for the second level of the first texture
+	InitTexture(&textures[0], 2000);
+	InitTexture(&textures[1], 1000);
+	TextureStreamingPlan(textures, 2, budget + 1, order);
+	TestCheck(textures[0].targetLevel == RESIDENT_LEVEL - 2);
+	TestCheck(textures[1].targetLevel == RESIDENT_LEVEL - 1);
+}
+
+static void TestEviction()
+{
+	// A texture that has every level resident but is no longer seen keeps them while the budget allows
+	StreamedTexture textures[2];
+	InitTexture(&textures[0], 0);
+	textures[0].residentLevel = 0;
+	InitTexture(&textures[1], 0);
+	uint32_t order[2];
+	size_t budget = textures[0].chainBytes[0] + textures[1].chainBytes[RESIDENT_LEVEL];
+	size_t residentBytes = TextureStreamingPlan(textures, 2, budget, order);
+	TestCheck(textures[0].targetLevel == 0);
+	TestCheck(residentBytes == budget);
+
+	// A budget of 0, which is what texture_budget_mib = 0 gives, has no limit, so nothing is ever evicted
+	InitTexture(&textures[1], TEXTURE_SIZE);
+	residentBytes = TextureStreamingPlan(textures, 2, 0, order);
+	TestCheck(textures[0].targetLevel == 0);
+	TestCheck(textures[1].targetLevel == 0);
+	TestCheck(residentBytes == textures[0].chainBytes[0] + textures[1].chainBytes[0]);
+
+	// Once the other texture needs the space, the unseen texture is evicted, but only by as many levels as it takes
+	InitTexture(&textures[1], TEXTURE_SIZE);
+	const size_t keptLevelBytes = textures[0].chainBytes[RESIDENT_LEVEL - 1] - textures[0].chainBytes[RESIDENT_LEVEL];
+	budget = textures[0].chainBytes[RESIDENT_LEVEL] + keptLevelBytes + textures[1].chainBytes[0];
+	residentBytes = TextureStreamingPlan(textures, 2, budget, order);
+	TestCheck(textures[1].targetLevel == 0);
+	TestCheck(textures[0].targetLevel == RESIDENT_LEVEL - 1);
+	TestCheck(residentBytes == budget);
+
+	// The always resident levels are kept even when the budget is too small for them
+	InitTexture(&textures[0], TEXTURE_SIZE);
+	textures[0].residentLevel = 0;
+	InitTexture(&textures[1], TEXTURE_SIZE);
+	residentBytes = TextureStreamingPlan(textures, 2, 1, order);
+	TestCheck(textures[0].targetLevel == RESIDENT_LEVEL);
+	TestCheck(textures[1].targetLevel == RESIDENT_LEVEL);
+	TestCheck(residentBytes == textures[0].chainBytes[RESIDENT_LEVEL] + textures[1].chainBytes[RESIDENT_LEVEL]);
+}
+
+static void TestBoundsScreenSize()
+{
+	const Vector3 camera = {0, 0, 0};
+	const Vector3 extents = {1, 1, 1};
+	const Vector3 near = {0, 0, 10};
+	const Vector3 far = {0, 0, 20};
+	const float nearSize = BoundsScreenSize(&camera, 500, &near, &extents);
+	const float farSize = BoundsScreenSize(&camera, 500, &far, &extents);
+	TestCheck(nearSize > farSize);
+
+	// A camera inside the box is capped at the size of the box seen from its own radius away
+	const float insideSize = BoundsScreenSize(&camera, 500, &camera, &extents);
+	TestCheck(insideSize == 1000.0f);
+}
+
+int main()
+{
+	TestInit();
+	TestScreenSizeOrder();
+	TestOneLevelPerStep();
+	TestEviction();
+	TestBoundsScreenSize();
+	return TestFinish();
+}
@@ -9,7 +9,10 @@
 #include <engine/debug/DPrint.h>
 #include <engine/Engine.h>
 #include <engine/graphics/Drawing.h>
+#include <engine/graphics/Font.h>
+#include <engine/graphics/LightGrid.h>
 #include <engine/graphics/RenderingHelpers.h>
+#include <engine/helpers/MathEx.h>
 #include <engine/physics/MapPhysics.h>
 #include <engine/structs/Actor.h>
 #include <engine/structs/ActorDefinition.h>
@@ -104,6 +107,51 @@ void MainStateRender(GlobalState *state, const double delta)
 
 #ifdef ENABLE_DEBUG_PRINT
 	DPrintF("Actors: %d", false, COLOR_WHITE, state->map->actors.length);
+	DPrintF("Instances Written: %u", false, COLOR_WHITE, lastRenderStats.instancesWritten);
+	DPrintF("Instance Bytes Written: %u", false, COLOR_WHITE, lastRenderStats.instanceBytesWritten);
+	DPrintF("Actors Visible: %u, Culled: %u, Occluded: %u",
+			false,
+			COLOR_WHITE,
+			lastRenderStats.visibleActors,
+			lastRenderStats.culledActors,
+			lastRenderStats.occludedActors);
+	DPrintF("Map Clusters Visible: %u, Culled: %u, Occluded: %u",
+			false,
+			COLOR_WHITE,
+			lastRenderStats.visibleMapClusters,
+			lastRenderStats.culledMapClusters,
+			lastRenderStats.occludedMapClusters);
+	DPrintF("Occluders: %u tris, draw %.3lf ms, test %.3lf ms",
+			false,
+			COLOR_WHITE,
+			lastRenderStats.occluderTriangles,
+			(double)lastRenderStats.occluderDrawNs / 1000000.0,
+			(double)lastRenderStats.occlusionTestNs / 1000000.0);
+	DPrintF("Light Grid: %u/%u lights, %u indices, build %.3lf ms",
+			false,
+			COLOR_WHITE,
+			(uint32_t)min(state->map->numPointLights, LIGHT_GRID_MAX_LIGHTS),
+			state->map->numPointLights,
+			lastRenderStats.lightGridIndices,
+			(double)lastRenderStats.lightGridBuildNs / 1000000.0);
+	DPrintF("Texture Uploads: %u, %.2lf MiB, %.3lf ms",
+			false,
+			COLOR_WHITE,
+			lastRenderStats.textureUploads,
+			(double)lastRenderStats.textureUploadBytes / (1024.0 * 1024.0),
+			(double)lastRenderStats.textureUploadNs / 1000000.0);
+	DPrintF("Texture Memory: %.1lf/%u MiB",
+			false,
+			COLOR_WHITE,
+			(double)lastRenderStats.textureResidentBytes / (1024.0 * 1024.0),
+			state->options.textureBudgetMiB);
+	DPrintF("Text Layouts: %zu, Hits: %zu, Misses: %zu",
+			false,
+			COLOR_WHITE,
+			textLayoutCacheStats.layouts,
+			textLayoutCacheStats.hits,
+			textLayoutCacheStats.misses);
+	DPrintF("Detail Scale: %.2f", false, COLOR_WHITE, state->detailScale);
 	DPrintF("Frame Delta: %.3lf", false, COLOR_WHITE, delta);
 	DPrintF("Tick Delta: %.3lf", false, COLOR_WHITE, lastTickDelta);
 #endif